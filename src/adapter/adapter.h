@@ -46,6 +46,12 @@ ADAPTER_API void stdcall DumpOrder(
 	const fx::price_t commission,
 	const fx::price_t swap,
 	const fx::price_t profit);
+// called after all the orders of the account were dumped
+ADAPTER_API void stdcall DumpOrdersEnd();
+
+// prints the allocation probes of the dll into the session log, returns
+// false if any of them went over its budget
+ADAPTER_API bool stdcall CheckAllocSites();
 
 ADAPTER_API void stdcall LogWrite(const wchar_t* msg);
 ADAPTER_API void stdcall LogWriteln(const wchar_t* msg);
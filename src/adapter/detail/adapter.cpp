@@ -10,6 +10,7 @@
 #include "common/transmission.h"
 #include "common/types.h"
 #include "common/utils.h"
+#include "cpp/allocTracker.h"
 #include "cpp/streams.h"
 #include "cpp/strUtils.h"
 
@@ -192,6 +193,8 @@ ADAPTER_API void stdcall DumpTick(
 	fx::KAdapter& adapter = fx::KAdapter::get();
 	const std::string& symbol = cpp::su::w2str(wsymbol);
 	const fx::STick tick(symbol.c_str(), time, bid, ask, last);
+	// the node of the tick queue, the conversion of the symbol is left out
+	CPP_ALLOC_PROBE("DumpTick send", 1);
 	adapter.sendTick(tick);
 }
 
@@ -268,6 +271,18 @@ ADAPTER_API void stdcall DumpOrder(
 	adapter.dumpOrder(order);
 }
 
+ADAPTER_API void stdcall DumpOrdersEnd()
+{
+	fx::KAdapter& adapter = fx::KAdapter::get();
+	adapter.dumpOrder(fx::SOrder::makeDumpEnd());
+}
+
+ADAPTER_API bool stdcall CheckAllocSites()
+{
+	const bool result = cpp::checkAllocSites(cpp::cout);
+	return result;
+}
+
 ADAPTER_API void stdcall LogWrite(const wchar_t* wmsg)
 {
 	const std::string& msg = cpp::su::w2str(wmsg);
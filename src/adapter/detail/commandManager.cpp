@@ -7,6 +7,7 @@
 #include "common/consts.h"
 #include "common/namedPipe.h"
 #include "common/utils.h"
+#include "cpp/allocTracker.h"
 #include "cpp/streams.h"
 #include "cpp/strUtils.h"
 
@@ -53,6 +54,13 @@ class KCommandManager : public ICommandManager
 		command_queue m_cmdQueue;
 		std::atomic<bool> m_executionPending = false;
 
+		// the cmd loop answers a command by the result of its execution, so
+		// the backend learns about the rejected ones
+		std::mutex m_resultMutex;
+		std::condition_variable m_onResult;
+		std::string m_result;
+		bool m_resultReady = false;
+
 };
 
 // ---------------------------------------------------------------------------
@@ -95,8 +103,11 @@ void KCommandManager::cmdLoop()
 					HCommand command = fx::parseTraderCommand(rawCommand, &parseError);
 					if (command)
 					{
+						std::unique_lock<std::mutex> lock(m_resultMutex);
+						m_resultReady = false;
 						m_cmdQueue.push(command);
-						cmdPipe.write(consts::CmdSendSuccess);
+						m_onResult.wait(lock, [this]{ return m_resultReady; });
+						cmdPipe.write(m_result);
 					}
 					else
 					{
@@ -119,7 +130,14 @@ bool KCommandManager::getCommand(wchar_t* wcmdName, int* argCount, MqlStr* wargs
 	bool rt = false;
 	if (m_executionPending.compare_exchange_weak(rt, true))
 	{
-		HCommand command = m_cmdQueue.try_pop();
+		HCommand command;
+		{
+			// taking a command off the queue is free, passing it over to MQL
+			// is left out
+			CPP_ALLOC_PROBE("GetCommand poll", 0);
+			command = m_cmdQueue.try_pop();
+		}
+
 		if (command)
 		{
 			cpp::cout << "wcmdName  " << std::hex << (void*)wcmdName << std::endl;
@@ -166,6 +184,11 @@ void KCommandManager::onCommandCompleted(const wchar_t* wresult)
 	auto_clear_atomic clearExecutionPending(m_executionPending);
 	const std::string& result = cpp::su::w2str(wresult);
 	cpp::cout << "KCommandManager::onCommandCompleted: " << result << std::endl;
+
+	std::lock_guard<std::mutex> lock(m_resultMutex);
+	m_result = result;
+	m_resultReady = true;
+	m_onResult.notify_one();
 }
 
 } // anonymous namespace
@@ -0,0 +1,235 @@
+// author: Darek Slusarczyk alias marines marinesovitch 2012-2013, 2022
+#include "ph.h"
+#include "adapter/adapter.h"
+#include "backend/accountManager.h"
+#include "backend/connection.h"
+#include "backend/executor.h"
+#include "backend/instance.h"
+#include "backend/tickStore.h"
+#include "backend/tradeManager.h"
+#include "backend/trader.h"
+#include "common/traderCommandParser.h"
+#include "cpp/allocTracker.h"
+
+// the executable plays MetaTrader for the backend running in the same
+// process, so ticks and commands go through all the probes: the parser
+// linked in here, DumpTick and GetCommand in mtfxcolt.dll, the tick loop and
+// the parser of the command line in backend.dll; it exits with 1 if any
+// probe went over its budget or couldn't be reached
+
+namespace
+{
+
+const wchar_t* Broker = L"AllocTestBroker";
+const fx::account_login_t AccountLogin(87654321);
+const wchar_t* Symbol = L"EURUSD";
+const char* SymbolName = "EURUSD";
+
+const int TickCount = 1000;
+const int WaitTimeout = 30000;
+const int WaitStep = 10;
+
+const char* RawCommands[] = {
+	"o EURUSD b 0.1 0",
+	"o EURUSD SellLimit 0.25 1.2345 1.25 1.2 1700000000",
+	"c 123456",
+	"m 1.1 1.0 1.2 0 123456",
+	"sl 1.1 123456 123457 123458",
+	"g",
+	"ca"
+};
+
+// the backend sends these to the adapter, after the get sent by the trader
+// when it is connected
+const char* AccountCommands[] = {
+	"g",
+	"o EURUSD b 0.1 0"
+};
+
+template<typename TPredicate>
+bool waitFor(TPredicate predicate)
+{
+	int waited = 0;
+	while (!predicate() && (waited < WaitTimeout))
+	{
+		std::this_thread::sleep_for(std::chrono::milliseconds(WaitStep));
+		waited += WaitStep;
+	}
+	const bool result = predicate();
+	return result;
+}
+
+bool parseCommands()
+{
+	bool result = true;
+	std::string error;
+	for (const char* rawCommand : RawCommands)
+	{
+		if (!fx::parseTraderCommand(rawCommand, &error))
+		{
+			std::cerr << "cannot parse '" << rawCommand << "': " << error << std::endl;
+			result = false;
+		}
+	}
+	return result;
+}
+
+bool waitForAccount(fx::KInstance& instance, fx::account_key_t* key, fx::HTrader* trader)
+{
+	fx::account_keys_t keys;
+	const bool detected = waitFor([&]{ return instance.accountManager().getKeys(&keys) && !keys.empty(); });
+	if (!detected)
+	{
+		std::cerr << "the account was not detected" << std::endl;
+		return false;
+	}
+
+	*key = keys.front();
+	const bool connected = waitFor([&]{
+		*trader = instance.tradeManager().getTrader(*key);
+		fx::HConnection connection = *trader ? (*trader)->getConnection() : fx::HConnection();
+		return connection && connection->isConnected();
+	});
+	if (!connected)
+	{
+		std::cerr << "the account was not connected" << std::endl;
+	}
+	return connected;
+}
+
+bool sendTicks(const fx::HTrader& trader)
+{
+	const fx::datetime_t start = std::time(nullptr);
+	for (int i = 0; i < TickCount; ++i)
+	{
+		const double bid = 1.1 + 0.0001 * (i % 10);
+		DumpTick(Symbol, start + i, bid, bid + 0.0002, 0.0);
+	}
+
+	const fx::ITickStore& tickStore = trader->getTickStore();
+	const bool result = waitFor([&]{ return tickStore.tickCount(SymbolName) == TickCount; });
+	if (!result)
+	{
+		std::cerr << "the ticks didn't reach the backend" << std::endl;
+	}
+	return result;
+}
+
+bool executeCommands(fx::KInstance& instance, const fx::account_key_t& key)
+{
+	const int MaxCmdArgCount = GetMaxCmdArgCount();
+	const int MaxCmdStringLen = GetMaxCmdStringLen();
+	std::vector<std::vector<wchar_t>> argBuffers(MaxCmdArgCount, std::vector<wchar_t>(MaxCmdStringLen));
+	std::vector<fx::MqlStr> cmdArgs(MaxCmdArgCount);
+	for (int i = 0; i < MaxCmdArgCount; ++i)
+	{
+		cmdArgs[i].m_length = MaxCmdStringLen;
+		cmdArgs[i].m_data = argBuffers[i].data();
+		cmdArgs[i].reserved = 0;
+	}
+	std::vector<int> cmdTickets(GetMaxCmdTicketCount());
+	std::vector<wchar_t> cmd(MaxCmdStringLen);
+	int cmdArgCount = 0;
+	int cmdTicketCount = 0;
+
+	auto getCommand = [&]{
+		return GetCommand(cmd.data(), &cmdArgCount, cmdArgs.data(), &cmdTicketCount, cmdTickets.data());
+	};
+
+	bool result = true;
+	std::string error;
+	for (const char* accountCommand : AccountCommands)
+	{
+		const std::string cmdLine = std::to_string(key) + ' ' + accountCommand;
+		if (!instance.executor().executeCommand(cmdLine, &error))
+		{
+			std::cerr << "cannot execute '" << cmdLine << "': " << error << std::endl;
+			result = false;
+		}
+	}
+
+	// the backend sends the next command when the previous one is completed
+	const std::size_t expectedCount = 1 + std::size(AccountCommands);
+	std::size_t servedCount = 0;
+	const bool served = waitFor([&]{
+		while (getCommand())
+		{
+			OnCommandCompleted(L"success");
+			++servedCount;
+		}
+		return expectedCount <= servedCount;
+	});
+	if (!served)
+	{
+		std::cerr << "only " << servedCount << " of " << expectedCount << " commands reached the adapter" << std::endl;
+		result = false;
+	}
+
+	// the polls of the empty queue
+	for (int i = 0; i < TickCount; ++i)
+	{
+		getCommand();
+	}
+	return result;
+}
+
+bool checkAllocSites(fx::KInstance& instance)
+{
+	bool result = true;
+
+	std::cout << "alloctest.exe" << std::endl;
+	if (!cpp::checkAllocSites(std::cout))
+	{
+		result = false;
+	}
+
+	std::cout << "mtfxcolt.dll: see c:/fxcolt/session.log" << std::endl;
+	if (!CheckAllocSites())
+	{
+		result = false;
+	}
+
+	std::cout << "backend.dll" << std::endl;
+	std::string error;
+	if (!instance.executor().executeCommand("allocs", &error))
+	{
+		std::cerr << error << std::endl;
+		result = false;
+	}
+
+	return result;
+}
+
+}
+
+int main()
+{
+	if (!cpp::isAllocTrackingEnabled())
+	{
+		std::cout << "allocation tracking is disabled, build all projects with CPP_TRACK_ALLOCATIONS" << std::endl;
+		return 0;
+	}
+
+	fx::KInstance instance(&std::cout, &std::cerr);
+	instance.run();
+
+	RegisterSymbol(Broker, AccountLogin, Symbol);
+	DumpSymbol(Symbol);
+
+	fx::account_key_t key;
+	fx::HTrader trader;
+	bool result = parseCommands();
+	if (waitForAccount(instance, &key, &trader))
+	{
+		result = sendTicks(trader) && result;
+		result = executeCommands(instance, key) && result;
+	}
+	else
+	{
+		result = false;
+	}
+
+	result = checkAllocSites(instance) && result;
+	std::cout << (result ? "all probes within budget" : "FAILED") << std::endl;
+	return result ? 0 : 1;
+}
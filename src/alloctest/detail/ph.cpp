@@ -0,0 +1,2 @@
+// author: Darek Slusarczyk alias marines marinesovitch 2012-2013, 2022
+#include "ph.h"
@@ -0,0 +1,10 @@
+// author: Darek Slusarczyk alias marines marinesovitch 2012-2013, 2022
+#ifndef INC_COMMON_PH_H
+#define INC_COMMON_PH_H
+
+#include "includes/phDef.h"
+#include "includes/phStd.h"
+#include "includes/phBoost.h"
+#include "includes/phWin.h"
+
+#endif
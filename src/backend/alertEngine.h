@@ -0,0 +1,86 @@
+// author: Darek Slusarczyk alias marines marinesovitch 2012-2013, 2022
+#ifndef INC_BACKEND_ALERTENGINE_H
+#define INC_BACKEND_ALERTENGINE_H
+
+#include "common/baseTypes.h"
+
+namespace fx
+{
+
+struct STick;
+
+// fires once, when the bid of the symbol reaches the price from below
+// (above) or from above (below), then it is removed
+struct SAlert
+{
+	public:
+		std::string toString() const;
+
+	public:
+		uint32_t m_id = 0;
+		std::string m_symbol;
+		bool m_above = true;
+		price_t m_price = 0;
+};
+
+struct SAlertEvent
+{
+	SAlert m_alert;
+	datetime_t m_time = 0;
+	price_t m_bid = 0;
+};
+
+typedef std::vector<SAlertEvent> alert_events_t;
+
+// ---------------------------------------------------------------------------
+
+struct SAlertStats
+{
+	std::size_t m_alertCount = 0;
+	uint64_t m_tickCount = 0;
+	uint64_t m_firedCount = 0;
+	// the deliveries to the sink, one per tick which fired any alert
+	uint64_t m_batchCount = 0;
+};
+
+// ---------------------------------------------------------------------------
+
+struct IAlertSink
+{
+	// all the alerts fired by a tick at once, called without the lock of the
+	// engine, so it may add new alerts
+	virtual void onAlerts(const alert_events_t& events) = 0;
+};
+
+// ---------------------------------------------------------------------------
+
+// the price alerts of an account; the thresholds of each symbol are kept in
+// two sorted arrays, the ones above the price in descending and the ones
+// below in ascending order, so the alerts fired by a tick are always at
+// their ends, found by a binary search and cut off at once; a tick which
+// fires nothing costs two comparisons
+struct IAlertEngine
+{
+	public:
+		virtual ~IAlertEngine();
+
+	public:
+		virtual uint32_t add(const std::string& symbol, const bool above, const price_t price) = 0;
+		virtual bool remove(const uint32_t id) = 0;
+		// sorted by id
+		virtual void getAlerts(std::vector<SAlert>* alerts) const = 0;
+
+		virtual void onTick(const STick& tick) = 0;
+
+		// the definitions are saved as lines 'symbol above|below price', the
+		// loaded ones are added to the current alerts with new ids
+		virtual bool save(const std::string& path, std::string* error) const = 0;
+		virtual bool load(const std::string& path, std::string* error) = 0;
+
+		virtual SAlertStats getStats() const = 0;
+
+};
+
+} // namespace fx
+
+#endif
@@ -0,0 +1,78 @@
+// author: Darek Slusarczyk alias marines marinesovitch 2012-2013, 2022
+#ifndef INC_BACKEND_BACKTEST_H
+#define INC_BACKEND_BACKTEST_H
+
+#include "executionSimulator.h"
+#include "common/order.h"
+
+namespace fx
+{
+
+struct SBacktestParams
+{
+	SExecutionParams m_execution;
+	volume_t m_initialBalance = 10000;
+	// the equity curve gets a point at least once per interval with ticks
+	// and after each closed trade
+	datetime_t m_equityInterval = 60;
+	// without details the report contains only the summary, it is enough to
+	// compare many runs
+	bool m_details = true;
+	// only the ticks in [from, to) are replayed
+	datetime_t m_from = std::numeric_limits<datetime_t>::min();
+	datetime_t m_to = std::numeric_limits<datetime_t>::max();
+};
+
+// ---------------------------------------------------------------------------
+
+struct SEquityPoint
+{
+	datetime_t m_time;
+	volume_t m_balance;
+	volume_t m_equity;
+};
+
+// ---------------------------------------------------------------------------
+
+struct SBacktestReport
+{
+	public:
+		// the summary statistics
+		void printSummary(std::ostream& os) const;
+		// the equity curve and the trades as csv, throws std::runtime_error
+		void save(const std::string& path) const;
+
+		// the profit of a closed trade with commission and swap
+		static volume_t netProfit(const SOrder& trade);
+
+	public:
+		std::string m_symbol;
+		std::string m_strategy;
+		uint64_t m_tickCount = 0;
+		datetime_t m_firstTime = 0;
+		datetime_t m_lastTime = 0;
+
+		std::vector<SEquityPoint> m_equityCurve;
+		// closed orders in the order of closing, cancelled pending orders
+		// are not included
+		std::vector<SOrder> m_trades;
+
+		volume_t m_initialBalance = 0;
+		volume_t m_finalBalance = 0;
+		volume_t m_finalEquity = 0;
+		volume_t m_grossProfit = 0;
+		volume_t m_grossLoss = 0;
+		std::size_t m_winCount = 0;
+		std::size_t m_lossCount = 0;
+		std::size_t m_rejectedCount = 0;
+		// the largest drop of equity from its peak
+		volume_t m_maxDrawdown = 0;
+		double m_maxDrawdownPercent = 0;
+
+		double m_seconds = 0;
+
+};
+
+} // namespace fx
+
+#endif
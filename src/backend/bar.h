@@ -0,0 +1,56 @@
+// author: Darek Slusarczyk alias marines marinesovitch 2012-2013, 2022
+#ifndef INC_BACKEND_BAR_H
+#define INC_BACKEND_BAR_H
+
+#include "common/baseTypes.h"
+
+namespace fx
+{
+
+namespace timeframe
+{
+
+// each timeframe is a multiple of the previous one and all of them are
+// aligned to the day boundary, so a bar of a lower timeframe always fits
+// into a single bar of the higher ones
+enum ETimeframe
+{
+	M1,
+	M5,
+	M15,
+	H1,
+	H4,
+	D1,
+	Count
+};
+
+// logical OR of flags of timeframes
+typedef uint32_t mask_t;
+
+const mask_t None = 0;
+const mask_t All = (1 << Count) - 1;
+
+mask_t flag(const ETimeframe timeframe);
+datetime_t seconds(const ETimeframe timeframe);
+const std::string& name(const ETimeframe timeframe);
+bool parse(const std::string& name, ETimeframe* timeframe);
+// the timeframe of bars with the given period in seconds
+bool fromSeconds(const datetime_t period, ETimeframe* timeframe);
+
+} // namespace timeframe
+
+// ---------------------------------------------------------------------------
+
+struct SBar
+{
+	datetime_t m_openTime = 0;
+	price_t m_open = 0;
+	price_t m_high = 0;
+	price_t m_low = 0;
+	price_t m_close = 0;
+	uint64_t m_tickVolume = 0;
+};
+
+} // namespace fx
+
+#endif
@@ -0,0 +1,40 @@
+// author: Darek Slusarczyk alias marines marinesovitch 2012-2013, 2022
+#ifndef INC_BACKEND_BARENGINE_H
+#define INC_BACKEND_BARENGINE_H
+
+#include "bar.h"
+
+namespace fx
+{
+
+struct STick;
+
+struct IBarSink
+{
+	virtual void onBarClosed(const std::string& symbol, const timeframe::ETimeframe timeframe, const SBar& bar) = 0;
+};
+
+// ---------------------------------------------------------------------------
+
+// builds the bars of all timeframes of all symbols from the ticks of an
+// account, like MetaTrader there are no bars for periods without ticks, so a
+// bar is closed by the first tick of a later period; it is not synchronized,
+// it is fed and queried in the tick loop of the account
+struct IBarEngine
+{
+	public:
+		virtual ~IBarEngine();
+
+	public:
+		// closed bars are passed to the sink before the tick is added to the
+		// new ones, from the lowest timeframe
+		virtual void onTick(const STick& tick) = 0;
+
+		// the bar which is being built, returns false if there were no ticks
+		virtual bool getCurrentBar(const std::string& symbol, const timeframe::ETimeframe timeframe, SBar* bar) const = 0;
+
+};
+
+} // namespace fx
+
+#endif
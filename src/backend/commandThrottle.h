@@ -0,0 +1,104 @@
+// author: Darek Slusarczyk alias marines marinesovitch 2012-2013, 2022
+#ifndef INC_BACKEND_COMMANDTHROTTLE_H
+#define INC_BACKEND_COMMANDTHROTTLE_H
+
+#include "common/command.h"
+#include "common/smartTypes.h"
+#include <array>
+
+namespace fx
+{
+
+namespace cmdclass
+{
+
+// the commands are limited per class, the brokers mind mostly the trade
+// requests, the queries are cheap
+enum ECmdClass
+{
+	Query,
+	Trade,
+	Modify,
+	Count
+};
+
+ECmdClass fromOperation(const KCommand::EOperation operation);
+const std::string& name(const ECmdClass cmdClass);
+bool parse(const std::string& name, ECmdClass* cmdClass);
+
+} // namespace cmdclass
+
+// ---------------------------------------------------------------------------
+
+// a token bucket, the commands may come in bursts of up to m_burst, then
+// m_rate per second
+struct SThrottleLimit
+{
+	// 0 means no limit
+	double m_rate = 0;
+	double m_burst = 1;
+};
+
+struct SThrottleLimits
+{
+	public:
+		SThrottleLimits();
+
+		void print(std::ostream& os) const;
+
+	public:
+		std::array<SThrottleLimit, cmdclass::Count> m_classes;
+
+};
+
+// ---------------------------------------------------------------------------
+
+struct SThrottleClassStats
+{
+	uint64_t m_sentCount = 0;
+	// the commands which waited for a token
+	uint64_t m_throttledCount = 0;
+	// the commands which replaced a queued one of the same operation and
+	// tickets, so the replaced one was never sent
+	uint64_t m_coalescedCount = 0;
+	double m_waitSeconds = 0.0;
+};
+
+struct SThrottleStats
+{
+	public:
+		void print(std::ostream& os) const;
+
+	public:
+		std::array<SThrottleClassStats, cmdclass::Count> m_classes;
+		std::size_t m_queueDepth = 0;
+		std::size_t m_maxQueueDepth = 0;
+
+};
+
+// ---------------------------------------------------------------------------
+
+// the queue of commands of an account on their way to MetaTrader; the
+// commands leave it in the order they came, the first one waits until its
+// class has a token; a modification of the same tickets as a queued one
+// (modify, set_stop_loss, set_take_profit) takes the place of the queued
+// one, so a burst of them collapses into the latest one
+struct ICommandThrottle
+{
+	public:
+		virtual ~ICommandThrottle();
+
+	public:
+		virtual void push(HCommand command) = 0;
+		// blocks until there is a command and its class has a token
+		virtual HCommand pop() = 0;
+
+		virtual void setLimits(const SThrottleLimits& limits) = 0;
+		virtual SThrottleLimits getLimits() const = 0;
+		virtual SThrottleStats getStats() const = 0;
+
+};
+
+} // namespace fx
+
+#endif
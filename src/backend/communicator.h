@@ -5,6 +5,7 @@
 #include "common/notes.h"
 #include "common/types.h"
 #include "connection.h"
+#include "sessionRecorder.h"
 
 namespace fx
 {
@@ -30,6 +31,12 @@ struct ICommunicator
 
 		virtual HConnection connect(const account_key_t& key, ITraderSink* sink) = 0;
 
+		virtual void startRecording(HSessionRecorder recorder) = 0;
+		virtual HSessionRecorder stopRecording() = 0;
+
+		virtual void startReplay(const std::string& path, const double speed, std::ostream* cout) = 0;
+		virtual void stopReplay() = 0;
+
 };
 
 } // namespace fx
@@ -0,0 +1,122 @@
+// author: Darek Slusarczyk alias marines marinesovitch 2012-2013, 2022
+#ifndef INC_BACKEND_CONDITIONALORDERS_H
+#define INC_BACKEND_CONDITIONALORDERS_H
+
+#include "common/order.h"
+
+namespace fx
+{
+
+class KCommand;
+struct STick;
+
+// an order kept only in the backend, MetaTrader and the broker see just the
+// commands sent when its price levels are crossed
+struct SConditionalOrder
+{
+	public:
+		enum EKind
+		{
+			// a stop loss and take profit of an open order, it is closed
+			// when the price crosses either of them
+			VirtualStops,
+			// two entries, the first one crossed is opened at the market,
+			// the other one is cancelled
+			Oco,
+			// an entry which is opened at the market when crossed, then its
+			// stop loss and take profit are virtual stops of the new order
+			Bracket
+		};
+
+		enum EState
+		{
+			// the levels are watched
+			Active,
+			// the bracket was opened, it waits for the order from MetaTrader
+			Filling,
+			// the close was sent, it waits until MetaTrader closes the order
+			Closing
+		};
+
+	public:
+		std::string toString() const;
+
+	public:
+		uint32_t m_id = 0;
+		EKind m_kind = VirtualStops;
+		EState m_state = Active;
+		std::string m_symbol;
+
+		// the order of the virtual stops, of a bracket once it is filled
+		ticket_t m_ticket;
+		bool m_buy = true;
+		price_t m_stopLoss = 0;
+		price_t m_takeProfit = 0;
+
+		// one entry for a bracket, two for OCO
+		std::vector<SNewOrder> m_entries;
+
+};
+
+// ---------------------------------------------------------------------------
+
+struct SConditionalStats
+{
+	std::size_t m_orderCount = 0;
+	uint64_t m_tickCount = 0;
+	uint64_t m_firedCount = 0;
+	// the closes refused or rejected, their stops are watched again
+	uint64_t m_failedCloseCount = 0;
+	// from the arrival of the tick which crossed a level until the command
+	// is handed to the connection
+	double m_lastLatency = 0.0;
+	double m_maxLatency = 0.0;
+	double m_totalLatency = 0.0;
+};
+
+// ---------------------------------------------------------------------------
+
+// the conditional orders of an account; their price levels are indexed per
+// symbol in sorted maps, separately for levels crossed by the bid or the
+// ask from below or from above, so a tick visits only the levels it
+// crosses; the commands are sent through the host like the ones of the
+// strategies; all methods but the queries return the id of the new order,
+// or 0 with the reason
+struct IConditionalOrders
+{
+	public:
+		virtual ~IConditionalOrders();
+
+	public:
+		// the order has to be an open buy or sell, either level may be 0
+		virtual uint32_t addVirtualStops(
+			const SOrder& order,
+			const price_t stopLoss,
+			const price_t takeProfit,
+			std::string* error) = 0;
+		// the entries are pending types (limit or stop) of the same symbol,
+		// their open prices are the levels, they are opened as market
+		// orders with their own stop loss and take profit
+		virtual uint32_t addOco(const SNewOrder& first, const SNewOrder& second, std::string* error) = 0;
+		// the entry is a pending type, its stop loss and take profit become
+		// virtual, MetaTrader gets a market order without them
+		virtual uint32_t addBracket(const SNewOrder& entry, std::string* error) = 0;
+
+		virtual bool cancel(const uint32_t id) = 0;
+		// sorted by id
+		virtual void getOrders(std::vector<SConditionalOrder>* orders) const = 0;
+
+		virtual void onTick(const STick& tick) = 0;
+		virtual void onOrder(const SOrder& order) = 0;
+		// the result of a command executed by MetaTrader, a bracket whose
+		// entry was rejected is dropped, the stops whose close was rejected
+		// are watched again
+		virtual void onCmdResult(const KCommand& command, const bool success) = 0;
+
+		virtual SConditionalStats getStats() const = 0;
+
+};
+
+} // namespace fx
+
+#endif
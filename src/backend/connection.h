@@ -8,6 +8,7 @@ namespace fx
 {
 
 struct ITraderSink;
+struct ICommandThrottle;
 
 struct IConnection
 {
@@ -16,7 +17,10 @@ struct IConnection
 
 	public:
 		virtual bool isConnected() const = 0;
+		// the command is queued, it is sent when the limits of its class
+		// allow it
 		virtual void sendCommand( HCommand command ) = 0;
+		virtual ICommandThrottle& getThrottle() = 0;
 		//virtual void disconnect() = 0;
 
 };
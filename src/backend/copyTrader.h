@@ -0,0 +1,79 @@
+// author: Darek Slusarczyk alias marines marinesovitch 2012-2013, 2022
+#ifndef INC_BACKEND_COPYTRADER_H
+#define INC_BACKEND_COPYTRADER_H
+
+#include "traderSink.h"
+
+namespace fx
+{
+
+// an account which mirrors the orders of the master
+struct SCopyFollower
+{
+	public:
+		void print(std::ostream& os) const;
+
+	public:
+		account_key_t m_key;
+		// the lots of the master are multiplied by it and rounded to 0.01,
+		// the orders smaller than 0.01 lots aren't copied
+		double m_scale = 1.0;
+		// the symbols of the master to the ones of the follower, e.g. if the
+		// broker adds a suffix, the symbols not mapped are the same
+		std::map<std::string, std::string> m_symbols;
+
+		uint64_t m_sentCount = 0;
+		uint64_t m_failedCount = 0;
+};
+
+// ---------------------------------------------------------------------------
+
+struct SCopyStats
+{
+	public:
+		void print(std::ostream& os) const;
+
+	public:
+		// the orders of the master which made any follower command
+		uint64_t m_eventCount = 0;
+		uint64_t m_commandCount = 0;
+		// the queueing latency: from the arrival of the order of the master
+		// until the last command of its followers is queued by the throttles
+		// of their connections; the time the commands wait there and travel
+		// to MetaTrader is not counted
+		double m_lastQueueLatency = 0.0;
+		double m_maxQueueLatency = 0.0;
+		double m_totalQueueLatency = 0.0;
+};
+
+// ---------------------------------------------------------------------------
+
+// mirrors the orders of the master account on the followers: the new orders
+// are opened, the changes of stop loss, take profit or pending price are
+// modified and the closed orders are closed; the orders of a follower are
+// bound to the ones of the master when the follower reports them; the
+// commands of the followers of an order are sent in parallel, each through
+// its trader, so they pass its risk limits and throttle; the orders the
+// master had before it was set are not copied
+struct ICopyTrader : public IOrderObserver
+{
+	public:
+		virtual ~ICopyTrader();
+
+	public:
+		// the null key stops copying, the followers are kept
+		virtual void setMaster(const account_key_t& key) = 0;
+		virtual account_key_t getMaster() const = 0;
+
+		// adds or replaces the follower
+		virtual bool setFollower(const SCopyFollower& follower, std::string* error) = 0;
+		virtual bool removeFollower(const account_key_t& key) = 0;
+		virtual void getFollowers(std::vector<SCopyFollower>* followers) const = 0;
+
+		virtual SCopyStats getStats() const = 0;
+
+};
+
+} // namespace fx
+
+#endif
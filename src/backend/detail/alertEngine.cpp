@@ -0,0 +1,21 @@
+// author: Darek Slusarczyk alias marines marinesovitch 2012-2013, 2022
+#include "ph.h"
+#include "alertEngine.h"
+
+namespace fx
+{
+
+std::string SAlert::toString() const
+{
+	std::ostringstream os;
+	os << m_id << ' ' << m_symbol << ' ' << (m_above ? "above" : "below") << ' ' << m_price;
+	return os.str();
+}
+
+// ---------------------------------------------------------------------------
+
+IAlertEngine::~IAlertEngine()
+{
+}
+
+} // namespace fx
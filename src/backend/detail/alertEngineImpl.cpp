@@ -0,0 +1,287 @@
+// author: Darek Slusarczyk alias marines marinesovitch 2012-2013, 2022
+#include "ph.h"
+#include "alertEngineImpl.h"
+#include "alertEngine.h"
+#include "common/types.h"
+#include <fstream>
+#include <iomanip>
+#include <string_view>
+
+namespace fx
+{
+
+namespace
+{
+
+struct SThreshold
+{
+	price_t m_price;
+	uint32_t m_id;
+};
+
+typedef std::vector<SThreshold> thresholds_t;
+
+// the alerts above the price are sorted in descending and the ones below in
+// ascending order, so the fired ones are at the end of the arrays
+struct SSymbolAlerts
+{
+	thresholds_t m_above;
+	thresholds_t m_below;
+};
+
+bool isHigher(const SThreshold& lhs, const SThreshold& rhs)
+{
+	const bool result = (rhs.m_price < lhs.m_price)
+		|| ((lhs.m_price == rhs.m_price) && (lhs.m_id < rhs.m_id));
+	return result;
+}
+
+bool isLower(const SThreshold& lhs, const SThreshold& rhs)
+{
+	const bool result = (lhs.m_price < rhs.m_price)
+		|| ((lhs.m_price == rhs.m_price) && (lhs.m_id < rhs.m_id));
+	return result;
+}
+
+// ---------------------------------------------------------------------------
+
+class KAlertEngine : public IAlertEngine
+{
+	public:
+		KAlertEngine(IAlertSink* sink);
+
+	public:
+		// IAlertEngine
+		virtual uint32_t add(const std::string& symbol, const bool above, const price_t price);
+		virtual bool remove(const uint32_t id);
+		virtual void getAlerts(std::vector<SAlert>* alerts) const;
+
+		virtual void onTick(const STick& tick);
+
+		virtual bool save(const std::string& path, std::string* error) const;
+		virtual bool load(const std::string& path, std::string* error);
+
+		virtual SAlertStats getStats() const;
+
+	private:
+		// must be called with locked m_mutex
+		void fire(thresholds_t* thresholds, thresholds_t::iterator first, const STick& tick, alert_events_t* events);
+
+	private:
+		IAlertSink& m_sink;
+
+		mutable std::mutex m_mutex;
+		uint32_t m_nextId = 1;
+		std::map<uint32_t, SAlert> m_id2alert;
+		std::map<std::string, SSymbolAlerts, std::less<>> m_symbol2alerts;
+
+		SAlertStats m_stats;
+
+};
+
+// ---------------------------------------------------------------------------
+
+KAlertEngine::KAlertEngine(IAlertSink* sink)
+	: m_sink(*sink)
+{
+}
+
+// ---------------------------------------------------------------------------
+// IAlertEngine
+
+uint32_t KAlertEngine::add(const std::string& symbol, const bool above, const price_t price)
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+	const uint32_t id = m_nextId++;
+	SAlert& alert = m_id2alert[id];
+	alert.m_id = id;
+	alert.m_symbol = symbol;
+	alert.m_above = above;
+	alert.m_price = price;
+
+	SSymbolAlerts& symbolAlerts = m_symbol2alerts[symbol];
+	const SThreshold threshold{ price, id };
+	if (above)
+	{
+		thresholds_t& thresholds = symbolAlerts.m_above;
+		thresholds.insert(std::upper_bound(thresholds.begin(), thresholds.end(), threshold, isHigher), threshold);
+	}
+	else
+	{
+		thresholds_t& thresholds = symbolAlerts.m_below;
+		thresholds.insert(std::upper_bound(thresholds.begin(), thresholds.end(), threshold, isLower), threshold);
+	}
+	m_stats.m_alertCount = m_id2alert.size();
+	return id;
+}
+
+bool KAlertEngine::remove(const uint32_t id)
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+	auto it = m_id2alert.find(id);
+	if (it == m_id2alert.end())
+	{
+		return false;
+	}
+
+	const SAlert& alert = it->second;
+	SSymbolAlerts& symbolAlerts = m_symbol2alerts.find(alert.m_symbol)->second;
+	const SThreshold threshold{ alert.m_price, id };
+	thresholds_t& thresholds = alert.m_above ? symbolAlerts.m_above : symbolAlerts.m_below;
+	thresholds.erase(std::lower_bound(thresholds.begin(), thresholds.end(), threshold, alert.m_above ? isHigher : isLower));
+	m_id2alert.erase(it);
+	m_stats.m_alertCount = m_id2alert.size();
+	return true;
+}
+
+void KAlertEngine::getAlerts(std::vector<SAlert>* alerts) const
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+	for (const auto& id2alert : m_id2alert)
+	{
+		alerts->push_back(id2alert.second);
+	}
+}
+
+void KAlertEngine::onTick(const STick& tick)
+{
+	// the vector allocates only if an alert fires, the sink gets the batch
+	// without the lock
+	alert_events_t events;
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		auto it = m_symbol2alerts.find(std::string_view(tick.m_symbolName));
+		if (it == m_symbol2alerts.end())
+		{
+			return;
+		}
+
+		++m_stats.m_tickCount;
+		const price_t bid = tick.m_bid.m_value;
+		thresholds_t& above = it->second.m_above;
+		if (!above.empty() && (above.back().m_price <= bid))
+		{
+			// the first threshold not higher than the bid
+			const SThreshold key{ bid, 0 };
+			fire(&above, std::lower_bound(above.begin(), above.end(), key, isHigher), tick, &events);
+		}
+
+		thresholds_t& below = it->second.m_below;
+		if (!below.empty() && (bid <= below.back().m_price))
+		{
+			// the first threshold not lower than the bid
+			const SThreshold key{ bid, 0 };
+			fire(&below, std::lower_bound(below.begin(), below.end(), key, isLower), tick, &events);
+		}
+
+		if (events.empty())
+		{
+			return;
+		}
+
+		m_stats.m_firedCount += events.size();
+		++m_stats.m_batchCount;
+		m_stats.m_alertCount = m_id2alert.size();
+	}
+
+	m_sink.onAlerts(events);
+}
+
+bool KAlertEngine::save(const std::string& path, std::string* error) const
+{
+	std::vector<SAlert> alerts;
+	getAlerts(&alerts);
+
+	std::ofstream os(path, std::ios::trunc);
+	if (!os)
+	{
+		*error = "cannot create " + path;
+		return false;
+	}
+
+	os << std::setprecision(10);
+	for (const SAlert& alert : alerts)
+	{
+		os << alert.m_symbol << ' ' << (alert.m_above ? "above" : "below") << ' ' << alert.m_price << '\n';
+	}
+
+	if (!os.flush())
+	{
+		*error = "cannot write " + path;
+		return false;
+	}
+	return true;
+}
+
+bool KAlertEngine::load(const std::string& path, std::string* error)
+{
+	std::ifstream is(path);
+	if (!is)
+	{
+		*error = "cannot open " + path;
+		return false;
+	}
+
+	// the whole file is parsed first, so a broken one adds nothing
+	std::vector<SAlert> alerts;
+	std::string line;
+	for (std::size_t lineNo = 1; std::getline(is, line); ++lineNo)
+	{
+		std::istringstream ls(line);
+		SAlert alert;
+		std::string direction;
+		if (!(ls >> alert.m_symbol))
+		{
+			continue;
+		}
+
+		if (!(ls >> direction >> alert.m_price) || ((direction != "above") && (direction != "below")))
+		{
+			*error = path + ':' + std::to_string(lineNo) + ": expected 'symbol above|below price'";
+			return false;
+		}
+		alert.m_above = (direction == "above");
+		alerts.push_back(alert);
+	}
+
+	for (const SAlert& alert : alerts)
+	{
+		add(alert.m_symbol, alert.m_above, alert.m_price);
+	}
+	return true;
+}
+
+SAlertStats KAlertEngine::getStats() const
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+	return m_stats;
+}
+
+// ---------------------------------------------------------------------------
+
+void KAlertEngine::fire(thresholds_t* thresholds, thresholds_t::iterator first, const STick& tick, alert_events_t* events)
+{
+	for (auto it = first; it != thresholds->end(); ++it)
+	{
+		auto alertIt = m_id2alert.find(it->m_id);
+		SAlertEvent event;
+		event.m_alert = alertIt->second;
+		event.m_time = tick.m_time.m_value;
+		event.m_bid = tick.m_bid.m_value;
+		events->push_back(event);
+		m_id2alert.erase(alertIt);
+	}
+	thresholds->erase(first, thresholds->end());
+}
+
+} // anonymous namespace
+
+// ---------------------------------------------------------------------------
+
+IAlertEngine* createAlertEngine(IAlertSink* sink)
+{
+	IAlertEngine* alertEngine = new KAlertEngine(sink);
+	return alertEngine;
+}
+
+} // namespace fx
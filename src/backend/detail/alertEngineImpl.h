@@ -0,0 +1,15 @@
+// author: Darek Slusarczyk alias marines marinesovitch 2012-2013, 2022
+#ifndef INC_BACKEND_ALERTENGINEIMPL_H
+#define INC_BACKEND_ALERTENGINEIMPL_H
+
+namespace fx
+{
+
+struct IAlertEngine;
+struct IAlertSink;
+
+IAlertEngine* createAlertEngine(IAlertSink* sink);
+
+} // namespace fx
+
+#endif
@@ -0,0 +1,110 @@
+// author: Darek Slusarczyk alias marines marinesovitch 2012-2013, 2022
+#include "ph.h"
+#include "backtest.h"
+
+namespace fx
+{
+
+namespace
+{
+
+std::string formatTime(const datetime_t time)
+{
+	const std::time_t rawTime = static_cast<std::time_t>(time);
+	const std::tm* tm = std::gmtime(&rawTime);
+	std::ostringstream os;
+	if (tm != nullptr)
+	{
+		os << std::put_time(tm, "%Y.%m.%d %H:%M:%S");
+	}
+	else
+	{
+		os << time;
+	}
+	return os.str();
+}
+
+} // anonymous namespace
+
+// ---------------------------------------------------------------------------
+
+void SBacktestReport::printSummary(std::ostream& os) const
+{
+	const std::size_t tradeCount = m_trades.size();
+	const double winRate = tradeCount ? 100.0 * m_winCount / tradeCount : 0.0;
+	const double seconds = std::max(m_seconds, 0.001);
+
+	os << m_strategy << ' ' << m_symbol << ' '
+		<< formatTime(m_firstTime) << " - " << formatTime(m_lastTime) << ", "
+		<< m_tickCount << " ticks in " << std::fixed << std::setprecision(2) << seconds << "s ("
+		<< std::setprecision(0) << (m_tickCount / seconds) << " ticks/s)\n";
+
+	os << std::setprecision(2)
+		<< "balance " << m_initialBalance << " -> " << m_finalBalance
+		<< ", net profit " << (m_finalBalance - m_initialBalance)
+		<< ", equity " << m_finalEquity << '\n';
+
+	os << "trades " << tradeCount << ": " << m_winCount << " won, " << m_lossCount << " lost"
+		<< ", win rate " << std::setprecision(1) << winRate << '%'
+		<< ", gross profit " << std::setprecision(2) << m_grossProfit
+		<< ", gross loss " << m_grossLoss
+		<< ", profit factor ";
+	if (m_grossLoss < 0.0)
+	{
+		os << (m_grossProfit / -m_grossLoss);
+	}
+	else
+	{
+		os << '-';
+	}
+	os << '\n';
+
+	os << "max drawdown " << m_maxDrawdown << " (" << std::setprecision(1) << m_maxDrawdownPercent << "%)"
+		<< ", rejected commands " << m_rejectedCount
+		<< std::defaultfloat << std::endl;
+}
+
+void SBacktestReport::save(const std::string& path) const
+{
+	std::ofstream os(path, std::ios::trunc);
+	if (!os)
+	{
+		throw std::runtime_error("cannot create file " + path);
+	}
+
+	os << std::setprecision(10);
+	os << "time,balance,equity\n";
+	for (const SEquityPoint& point : m_equityCurve)
+	{
+		os << formatTime(point.m_time) << ',' << point.m_balance << ',' << point.m_equity << '\n';
+	}
+
+	os << "\nticket,type,lots,open time,open price,close time,close price,stop loss,take profit,commission,profit\n";
+	for (const SOrder& trade : m_trades)
+	{
+		os << trade.m_ticket << ','
+			<< SOrder::type2str(trade.m_type) << ','
+			<< trade.m_lots.m_value << ','
+			<< formatTime(trade.m_openTime.m_value) << ','
+			<< trade.m_openPrice.m_value << ','
+			<< formatTime(trade.m_closeTime.m_value) << ','
+			<< trade.m_closePrice.m_value << ','
+			<< trade.m_stopLoss.m_value << ','
+			<< trade.m_takeProfit.m_value << ','
+			<< trade.m_commission.m_value << ','
+			<< trade.m_profit.m_value << '\n';
+	}
+
+	if (!os.flush())
+	{
+		throw std::runtime_error("cannot write file " + path);
+	}
+}
+
+volume_t SBacktestReport::netProfit(const SOrder& trade)
+{
+	const volume_t result = trade.m_profit.m_value + trade.m_commission.m_value + trade.m_swap.m_value;
+	return result;
+}
+
+} // namespace fx
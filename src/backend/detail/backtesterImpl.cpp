@@ -0,0 +1,260 @@
+// author: Darek Slusarczyk alias marines marinesovitch 2012-2013, 2022
+#include "ph.h"
+#include "backtesterImpl.h"
+#include "barEngine.h"
+#include "barEngineImpl.h"
+#include "executionSimulatorImpl.h"
+#include "orderCache.h"
+#include "orderCacheImpl.h"
+#include "positionEngine.h"
+#include "positionEngineImpl.h"
+#include "strategyHost.h"
+#include "tickFeed.h"
+#include "tradingStrategy.h"
+#include "common/consts.h"
+#include "common/types.h"
+#include <chrono>
+
+namespace fx
+{
+
+namespace
+{
+
+class KBacktester : public IStrategyHost, IExecutionSink, IBarSink, ITickFeedSink
+{
+	public:
+		KBacktester(ITradingStrategy* strategy, const SBacktestParams& params, SBacktestReport* report);
+
+	public:
+		void run(const ITickFeed& feed, const std::string& strategyCmdLine);
+
+	public:
+		// IStrategyHost
+		virtual void executeCommand(HCommand command);
+		virtual const IOrderCache& getOrders() const;
+		virtual const IPositionEngine& getPositions() const;
+
+	public:
+		// IExecutionSink
+		virtual void onOrder(const SOrder& order);
+		virtual void onCmdResult(HCommand command, const std::string& output);
+
+	public:
+		// IBarSink
+		virtual void onBarClosed(const std::string& symbol, const timeframe::ETimeframe timeframe, const SBar& bar);
+
+	public:
+		// ITickFeedSink
+		virtual void onTick(const datetime_t time, const price_t bid, const price_t ask, const price_t last);
+
+	private:
+		void addEquityPoint(const datetime_t time);
+
+	private:
+		ITradingStrategy& m_strategy;
+		const SBacktestParams m_params;
+		SBacktestReport& m_report;
+		const timeframe::mask_t m_barTimeframes;
+
+		std::unique_ptr<IExecutionSimulator> m_simulator;
+		std::unique_ptr<IBarEngine> m_barEngine;
+		std::unique_ptr<IOrderCache> m_orders;
+		std::unique_ptr<IPositionEngine> m_positions;
+
+		STick m_tick;
+		datetime_t m_nextEquityTime = std::numeric_limits<datetime_t>::min();
+		volume_t m_equityPeak = 0;
+		bool m_tradeClosed = false;
+
+};
+
+// ---------------------------------------------------------------------------
+
+KBacktester::KBacktester(ITradingStrategy* strategy, const SBacktestParams& params, SBacktestReport* report)
+	: m_strategy(*strategy)
+	, m_params(params)
+	, m_report(*report)
+	, m_barTimeframes(strategy->getBarTimeframes())
+	, m_simulator(createExecutionSimulator(params.m_execution, this))
+	, m_barEngine(createBarEngine(this))
+	, m_orders(createOrderCache())
+	, m_positions(createPositionEngine(params.m_execution.m_contractSize))
+{
+	// the simulator reports every order, so no ticket is missing
+	m_orders->setComplete();
+}
+
+void KBacktester::run(const ITickFeed& feed, const std::string& strategyCmdLine)
+{
+	const auto start = std::chrono::steady_clock::now();
+	const std::string& symbol = feed.getSymbol();
+	symbol.copy(m_tick.m_symbolName, sizeof(m_tick.m_symbolName) - 1);
+	m_tick.m_symbolName[std::min(symbol.size(), sizeof(m_tick.m_symbolName) - 1)] = 0;
+	m_report.m_symbol = symbol;
+	m_report.m_strategy = m_strategy.getName();
+	m_report.m_initialBalance = m_params.m_initialBalance;
+	m_equityPeak = m_params.m_initialBalance;
+
+	m_strategy.setHost(this);
+	if (!strategyCmdLine.empty())
+	{
+		std::istringstream cmdLine(strategyCmdLine);
+		m_strategy.executeCommand(cmdLine);
+	}
+
+	feed.replay(this, m_params.m_from, m_params.m_to);
+
+	if (m_params.m_details)
+	{
+		addEquityPoint(m_report.m_lastTime);
+	}
+	m_report.m_finalBalance = m_params.m_initialBalance + m_simulator->getBalance();
+	m_report.m_finalEquity = m_params.m_initialBalance + m_simulator->getEquity();
+	m_report.m_seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+// ---------------------------------------------------------------------------
+// IStrategyHost
+
+void KBacktester::executeCommand(HCommand command)
+{
+	m_simulator->sendCommand(command);
+}
+
+const IOrderCache& KBacktester::getOrders() const
+{
+	return *m_orders;
+}
+
+const IPositionEngine& KBacktester::getPositions() const
+{
+	return *m_positions;
+}
+
+// ---------------------------------------------------------------------------
+// IExecutionSink
+
+void KBacktester::onOrder(const SOrder& order)
+{
+	// the cache of the backtest is complete from the start
+	if (order.isDumpEnd())
+	{
+		return;
+	}
+
+	// cancelled pending orders are not trades
+	if ((order.m_status == SOrder::Closed) && ((order.m_type == SOrder::Buy) || (order.m_type == SOrder::Sell)))
+	{
+		if (m_params.m_details)
+		{
+			m_report.m_trades.push_back(order);
+		}
+		const volume_t profit = SBacktestReport::netProfit(order);
+		if (0.0 < profit)
+		{
+			++m_report.m_winCount;
+			m_report.m_grossProfit += profit;
+		}
+		else
+		{
+			++m_report.m_lossCount;
+			m_report.m_grossLoss += profit;
+		}
+		m_tradeClosed = true;
+	}
+
+	m_orders->update(order);
+	m_positions->onOrder(order);
+	m_strategy.onOrder(order);
+}
+
+void KBacktester::onCmdResult(HCommand /*command*/, const std::string& output)
+{
+	if (output != consts::CmdResultSuccess)
+	{
+		++m_report.m_rejectedCount;
+	}
+}
+
+// ---------------------------------------------------------------------------
+// IBarSink
+
+void KBacktester::onBarClosed(const std::string& /*symbol*/, const timeframe::ETimeframe timeframe, const SBar& bar)
+{
+	if (m_barTimeframes & timeframe::flag(timeframe))
+	{
+		m_strategy.onBar(timeframe, bar);
+	}
+}
+
+// ---------------------------------------------------------------------------
+// ITickFeedSink
+
+void KBacktester::onTick(const datetime_t time, const price_t bid, const price_t ask, const price_t last)
+{
+	// the ticks made of bars have no ask, the positions, bars and strategy
+	// see the same one as the simulator
+	m_tick.m_time = time;
+	m_tick.m_bid = bid;
+	m_tick.m_ask = std::max(ask, bid + m_params.m_execution.m_spread);
+	m_tick.m_last = last;
+
+	if (m_report.m_tickCount == 0)
+	{
+		m_report.m_firstTime = time;
+	}
+	m_report.m_lastTime = time;
+	++m_report.m_tickCount;
+
+	// the same order as in the trader: orders, bars and then the tick
+	m_simulator->onTick(m_tick);
+	m_positions->onTick(m_tick);
+	m_barEngine->onTick(m_tick);
+	m_strategy.onTick(m_tick);
+
+	const volume_t equity = m_params.m_initialBalance + m_simulator->getEquity();
+	m_equityPeak = std::max(m_equityPeak, equity);
+	const volume_t drawdown = m_equityPeak - equity;
+	if (m_report.m_maxDrawdown < drawdown)
+	{
+		m_report.m_maxDrawdown = drawdown;
+		m_report.m_maxDrawdownPercent = (0.0 < m_equityPeak) ? 100.0 * drawdown / m_equityPeak : 0.0;
+	}
+
+	if (m_params.m_details && (m_tradeClosed || (m_nextEquityTime <= time)))
+	{
+		addEquityPoint(time);
+	}
+}
+
+void KBacktester::addEquityPoint(const datetime_t time)
+{
+	const SEquityPoint point = {
+		time,
+		m_params.m_initialBalance + m_simulator->getBalance(),
+		m_params.m_initialBalance + m_simulator->getEquity() };
+	m_report.m_equityCurve.push_back(point);
+
+	const datetime_t interval = std::max<datetime_t>(m_params.m_equityInterval, 1);
+	m_nextEquityTime = (time / interval + 1) * interval;
+	m_tradeClosed = false;
+}
+
+} // anonymous namespace
+
+// ---------------------------------------------------------------------------
+
+SBacktestReport runBacktest(
+	const ITickFeed& feed,
+	ITradingStrategy* strategy,
+	const std::string& strategyCmdLine,
+	const SBacktestParams& params)
+{
+	SBacktestReport report;
+	KBacktester backtester(strategy, params, &report);
+	backtester.run(feed, strategyCmdLine);
+	return report;
+}
+
+} // namespace fx
@@ -0,0 +1,25 @@
+// author: Darek Slusarczyk alias marines marinesovitch 2012-2013, 2022
+#ifndef INC_BACKEND_BACKTESTERIMPL_H
+#define INC_BACKEND_BACKTESTERIMPL_H
+
+#include "backtest.h"
+
+namespace fx
+{
+
+struct ITickFeed;
+struct ITradingStrategy;
+
+// runs the strategy against the ticks of feed, the strategy gets the host
+// and then strategyCmdLine (if not empty) before the first tick; the feed
+// is only read, so many backtests may share it; the strategy may throw
+// std::exception from its command
+SBacktestReport runBacktest(
+	const ITickFeed& feed,
+	ITradingStrategy* strategy,
+	const std::string& strategyCmdLine,
+	const SBacktestParams& params);
+
+} // namespace fx
+
+#endif
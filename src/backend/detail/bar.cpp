@@ -0,0 +1,79 @@
+// author: Darek Slusarczyk alias marines marinesovitch 2012-2013, 2022
+#include "ph.h"
+#include "bar.h"
+
+namespace fx
+{
+
+namespace timeframe
+{
+
+namespace
+{
+
+struct STimeframeInfo
+{
+	datetime_t m_seconds;
+	std::string m_name;
+};
+
+const STimeframeInfo s_timeframes[Count] =
+{
+	{ 60, "M1" },
+	{ 5 * 60, "M5" },
+	{ 15 * 60, "M15" },
+	{ 60 * 60, "H1" },
+	{ 4 * 60 * 60, "H4" },
+	{ 24 * 60 * 60, "D1" }
+};
+
+} // anonymous namespace
+
+// ---------------------------------------------------------------------------
+
+mask_t flag(const ETimeframe timeframe)
+{
+	return mask_t(1) << timeframe;
+}
+
+datetime_t seconds(const ETimeframe timeframe)
+{
+	assert((M1 <= timeframe) && (timeframe < Count));
+	return s_timeframes[timeframe].m_seconds;
+}
+
+const std::string& name(const ETimeframe timeframe)
+{
+	assert((M1 <= timeframe) && (timeframe < Count));
+	return s_timeframes[timeframe].m_name;
+}
+
+bool parse(const std::string& name, ETimeframe* timeframe)
+{
+	for (int i = M1; i < Count; ++i)
+	{
+		if (s_timeframes[i].m_name == name)
+		{
+			*timeframe = static_cast<ETimeframe>(i);
+			return true;
+		}
+	}
+	return false;
+}
+
+bool fromSeconds(const datetime_t period, ETimeframe* timeframe)
+{
+	for (int i = M1; i < Count; ++i)
+	{
+		if (s_timeframes[i].m_seconds == period)
+		{
+			*timeframe = static_cast<ETimeframe>(i);
+			return true;
+		}
+	}
+	return false;
+}
+
+} // namespace timeframe
+
+} // namespace fx
@@ -0,0 +1,189 @@
+// author: Darek Slusarczyk alias marines marinesovitch 2012-2013, 2022
+#include "ph.h"
+#include "barEngineImpl.h"
+#include "barEngine.h"
+#include "common/types.h"
+#include <string_view>
+
+namespace fx
+{
+
+namespace
+{
+
+datetime_t periodStart(const datetime_t time, const datetime_t period)
+{
+	datetime_t remainder = time % period;
+	if (remainder < 0)
+	{
+		remainder += period;
+	}
+	return time - remainder;
+}
+
+// ---------------------------------------------------------------------------
+
+struct SSymbolBars
+{
+	SSymbolBars(const std::string& symbol);
+
+	const std::string m_symbol;
+	SBar m_bars[timeframe::Count];
+	// the current bars of all timeframes are valid for ticks before the end
+	// of the current M1 bar
+	datetime_t m_validUntil;
+	bool m_started = false;
+};
+
+SSymbolBars::SSymbolBars(const std::string& symbol)
+	: m_symbol(symbol)
+	, m_validUntil(std::numeric_limits<datetime_t>::min())
+{
+}
+
+// ---------------------------------------------------------------------------
+
+class KBarEngine : public IBarEngine
+{
+	public:
+		KBarEngine(IBarSink* sink);
+		virtual ~KBarEngine();
+
+	public:
+		// IBarEngine
+		virtual void onTick(const STick& tick);
+		virtual bool getCurrentBar(const std::string& symbol, const timeframe::ETimeframe timeframe, SBar* bar) const;
+
+	private:
+		SSymbolBars& getBars(const std::string_view& symbol);
+
+		void updateBars(SSymbolBars* bars, const price_t price);
+		void rollBars(SSymbolBars* bars, const datetime_t time, const price_t price);
+
+		static void openBar(SBar* bar, const datetime_t openTime, const price_t price);
+		static void updateBar(SBar* bar, const price_t price);
+
+	private:
+		typedef std::map<std::string, SSymbolBars, std::less<>> symbol2bars_t;
+
+		IBarSink& m_sink;
+		symbol2bars_t m_symbol2bars;
+
+};
+
+// ---------------------------------------------------------------------------
+
+KBarEngine::KBarEngine(IBarSink* sink)
+	: m_sink(*sink)
+{
+}
+
+KBarEngine::~KBarEngine()
+{
+}
+
+void KBarEngine::onTick(const STick& tick)
+{
+	SSymbolBars& bars = getBars(tick.m_symbolName);
+	const datetime_t time = tick.m_time.m_value;
+	// like in MetaTrader the bars are built from bid prices
+	const price_t price = tick.m_bid.m_value;
+	if (bars.m_started && (time < bars.m_validUntil))
+	{
+		// most of the ticks, including the late ones, fall into current bars
+		updateBars(&bars, price);
+	}
+	else
+	{
+		rollBars(&bars, time, price);
+	}
+}
+
+bool KBarEngine::getCurrentBar(const std::string& symbol, const timeframe::ETimeframe timeframe, SBar* bar) const
+{
+	bool result = false;
+	auto it = m_symbol2bars.find(symbol);
+	if ((it != m_symbol2bars.end()) && it->second.m_started)
+	{
+		*bar = it->second.m_bars[timeframe];
+		result = true;
+	}
+	return result;
+}
+
+// ---------------------------------------------------------------------------
+
+SSymbolBars& KBarEngine::getBars(const std::string_view& symbol)
+{
+	auto it = m_symbol2bars.find(symbol);
+	if (it == m_symbol2bars.end())
+	{
+		const std::string symbolName(symbol);
+		it = m_symbol2bars.emplace(symbolName, SSymbolBars(symbolName)).first;
+	}
+	return it->second;
+}
+
+void KBarEngine::updateBars(SSymbolBars* bars, const price_t price)
+{
+	for (SBar& bar : bars->m_bars)
+	{
+		updateBar(&bar, price);
+	}
+}
+
+void KBarEngine::rollBars(SSymbolBars* bars, const datetime_t time, const price_t price)
+{
+	for (int i = timeframe::M1; i < timeframe::Count; ++i)
+	{
+		const timeframe::ETimeframe tf = static_cast<timeframe::ETimeframe>(i);
+		SBar& bar = bars->m_bars[tf];
+		const datetime_t openTime = periodStart(time, timeframe::seconds(tf));
+		if (!bars->m_started)
+		{
+			openBar(&bar, openTime, price);
+		}
+		else if (bar.m_openTime < openTime)
+		{
+			m_sink.onBarClosed(bars->m_symbol, tf, bar);
+			openBar(&bar, openTime, price);
+		}
+		else
+		{
+			updateBar(&bar, price);
+		}
+	}
+
+	bars->m_validUntil = bars->m_bars[timeframe::M1].m_openTime + timeframe::seconds(timeframe::M1);
+	bars->m_started = true;
+}
+
+void KBarEngine::openBar(SBar* bar, const datetime_t openTime, const price_t price)
+{
+	bar->m_openTime = openTime;
+	bar->m_open = price;
+	bar->m_high = price;
+	bar->m_low = price;
+	bar->m_close = price;
+	bar->m_tickVolume = 1;
+}
+
+void KBarEngine::updateBar(SBar* bar, const price_t price)
+{
+	bar->m_high = std::max(bar->m_high, price);
+	bar->m_low = std::min(bar->m_low, price);
+	bar->m_close = price;
+	++bar->m_tickVolume;
+}
+
+} // anonymous namespace
+
+// ---------------------------------------------------------------------------
+
+IBarEngine* createBarEngine(IBarSink* sink)
+{
+	IBarEngine* barEngine = new KBarEngine(sink);
+	return barEngine;
+}
+
+} // namespace fx
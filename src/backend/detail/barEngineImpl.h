@@ -0,0 +1,15 @@
+// author: Darek Slusarczyk alias marines marinesovitch 2012-2013, 2022
+#ifndef INC_BACKEND_BARENGINEIMPL_H
+#define INC_BACKEND_BARENGINEIMPL_H
+
+namespace fx
+{
+
+struct IBarEngine;
+struct IBarSink;
+
+IBarEngine* createBarEngine(IBarSink* sink);
+
+} // namespace fx
+
+#endif
@@ -1,8 +1,12 @@
 // author: Darek Slusarczyk alias marines marinesovitch 2012-2013, 2022
 #include "ph.h"
 #include "climber.h"
+#include "strategyHost.h"
 #include "tradingStrategy.h"
 #include "tradingStrategyFactory.h"
+#include "common/command.h"
+#include "common/commandParserBase.h"
+#include "common/order.h"
 #include "common/types.h"
 
 namespace fx
@@ -13,8 +17,16 @@ namespace
 
 const std::string ClimberStrategyName = "climber";
 
+const std::string CmdStart = "start";
+const std::string CmdStop = "stop";
+
+// if the order of a step isn't confirmed in this time (e.g. it was
+// rejected), the step is sent again
+const datetime_t StepTimeout = 60;
+
 struct SClimberParams
 {
+	SOrder::EType m_type = SOrder::None;
 	SPrice m_openPrice;
 	SPrice m_stopLoss;
 	SVolume m_stepSize;
@@ -23,6 +35,61 @@ struct SClimberParams
 
 // ---------------------------------------------------------------------------
 
+// start <b|s> <open-price> <stop-loss> <step-size> <profit-margin>
+// stop
+class KClimberCommandParser : public KCommandParserBase
+{
+	public:
+		KClimberCommandParser(std::istringstream& cmdLine);
+
+	public:
+		// returns false for stop
+		bool run(SClimberParams* params);
+
+};
+
+KClimberCommandParser::KClimberCommandParser(std::istringstream& cmdLine)
+	: KCommandParserBase(cmdLine)
+{
+}
+
+bool KClimberCommandParser::run(SClimberParams* params)
+{
+	const std::string& cmd = getNextToken();
+	if (cmd == CmdStop)
+	{
+		return false;
+	}
+
+	if (cmd != CmdStart)
+	{
+		parseError("unknown command");
+	}
+
+	params->m_type = parseOrderType();
+	if ((params->m_type != SOrder::Buy) && (params->m_type != SOrder::Sell))
+	{
+		parseError("climber opens only buy or sell orders");
+	}
+
+	params->m_openPrice = parsePrice();
+	params->m_stopLoss = parsePrice();
+	params->m_stepSize = parseVolume();
+	params->m_profitMargin = parsePrice();
+	if ((params->m_stepSize.m_value <= 0.0) || (params->m_profitMargin.m_value <= 0.0))
+	{
+		parseError("step size and profit margin have to be positive");
+	}
+	return true;
+}
+
+// ---------------------------------------------------------------------------
+
+// it opens the first step once the price reaches the open price, then every
+// time the price moves by the profit margin from the last step it opens
+// the next one and moves the stop loss of all steps to the open price of
+// the previous step, so the position climbs with the trend until the stop
+// loss closes it
 class KClimber : public ITradingStrategy
 {
 	public:
@@ -30,11 +97,40 @@ class KClimber : public ITradingStrategy
 
 	public:
 		virtual const std::string& getName() const;
+		virtual void setHost(IStrategyHost* host);
 
+		virtual bool warmUp(const STickSeries& history);
 		virtual void onTick(const STick& tick);
 		virtual void onOrder(const SOrder& order);
 
+		virtual timeframe::mask_t getBarTimeframes() const;
+		virtual void onBar(const timeframe::ETimeframe timeframe, const SBar& bar);
+
 		virtual void executeCommand(std::istringstream& cmdLine);
+
+	private:
+		enum EState
+		{
+			Idle,
+			Waiting,
+			Opening,
+			Climbing
+		};
+
+		void openStep(const STick& tick);
+		bool isBuy() const;
+
+	private:
+		IStrategyHost* m_host = nullptr;
+		SClimberParams m_params;
+		EState m_state = Idle;
+
+		std::string m_symbol;
+		tickets_t m_tickets;
+		price_t m_lastStepPrice = 0;
+		datetime_t m_stepSentTime = 0;
+		EState m_stepSentState = Idle;
+
 };
 
 // ---------------------------------------------------------------------------
@@ -48,16 +144,142 @@ const std::string& KClimber::getName() const
 	return ClimberStrategyName;
 }
 
+void KClimber::setHost(IStrategyHost* host)
+{
+	m_host = host;
+}
+
+bool KClimber::warmUp(const STickSeries& /*history*/)
+{
+	// the steps depend only on the prices after start, there is nothing to
+	// replay
+	return true;
+}
+
 void KClimber::onTick(const STick& tick)
 {
+	const price_t bid = tick.m_bid.m_value;
+	const price_t ask = tick.m_ask.m_value;
+	switch (m_state)
+	{
+		case Idle:
+			break;
+
+		case Waiting:
+			if (isBuy() ? (m_params.m_openPrice.m_value <= ask) : (bid <= m_params.m_openPrice.m_value))
+			{
+				m_symbol = tick.m_symbolName;
+				openStep(tick);
+			}
+			break;
+
+		case Opening:
+			if (m_stepSentTime + StepTimeout <= tick.m_time.m_value)
+			{
+				m_state = m_stepSentState;
+			}
+			break;
+
+		case Climbing:
+		{
+			const price_t margin = m_params.m_profitMargin.m_value;
+			if (isBuy() ? (m_lastStepPrice + margin <= bid) : (ask <= m_lastStepPrice - margin))
+			{
+				const SPrice stopLoss(m_lastStepPrice);
+				m_host->executeCommand(std::make_shared<KCmdSetStopLoss>(stopLoss, m_tickets));
+				openStep(tick);
+			}
+			break;
+		}
+	}
 }
 
 void KClimber::onOrder(const SOrder& order)
+{
+	if (m_symbol != order.m_symbolName)
+	{
+		return;
+	}
+
+	auto it = std::find(m_tickets.begin(), m_tickets.end(), order.m_ticket);
+	if (order.m_status == SOrder::Open)
+	{
+		if ((it == m_tickets.end()) && (m_state == Opening))
+		{
+			m_tickets.push_back(order.m_ticket);
+			m_lastStepPrice = order.m_openPrice.m_value;
+			m_state = Climbing;
+		}
+	}
+	else if ((order.m_status == SOrder::Closed) && (it != m_tickets.end()))
+	{
+		m_tickets.erase(it);
+		if (m_tickets.empty() && (m_state == Climbing))
+		{
+			// the stop loss closed the position
+			m_state = Idle;
+		}
+	}
+}
+
+timeframe::mask_t KClimber::getBarTimeframes() const
+{
+	return timeframe::None;
+}
+
+void KClimber::onBar(const timeframe::ETimeframe timeframe, const SBar& bar)
 {
 }
 
 void KClimber::executeCommand(std::istringstream& cmdLine)
 {
+	KClimberCommandParser parser(cmdLine);
+	SClimberParams params;
+	const bool start = parser.run(&params);
+
+	if (!m_tickets.empty())
+	{
+		assert(m_host != nullptr);
+		m_host->executeCommand(std::make_shared<KCmdClose>(m_tickets));
+		m_tickets.clear();
+	}
+
+	if (start)
+	{
+		m_params = params;
+		m_state = Waiting;
+	}
+	else
+	{
+		m_state = Idle;
+	}
+}
+
+// ---------------------------------------------------------------------------
+
+void KClimber::openStep(const STick& tick)
+{
+	// the first step is protected by the stop loss from params, the next ones
+	// by the open price of the previous step
+	const SPrice stopLoss = m_tickets.empty() ? m_params.m_stopLoss : SPrice(m_lastStepPrice);
+	const SNewOrder newOrder(
+		m_symbol,
+		m_params.m_type,
+		m_params.m_stepSize,
+		isBuy() ? tick.m_ask : tick.m_bid,
+		stopLoss,
+		SPrice(),
+		SDateTime());
+	m_host->executeCommand(std::make_shared<KCmdOpen>(newOrder));
+
+	m_stepSentState = m_state;
+	m_stepSentTime = tick.m_time.m_value;
+	m_state = Opening;
+}
+
+bool KClimber::isBuy() const
+{
+	return m_params.m_type == SOrder::Buy;
 }
 
 // ---------------------------------------------------------------------------
@@ -0,0 +1,106 @@
+// author: Darek Slusarczyk alias marines marinesovitch 2012-2013, 2022
+#include "ph.h"
+#include "commandThrottle.h"
+
+namespace fx
+{
+
+namespace cmdclass
+{
+
+namespace
+{
+
+const std::string s_names[Count] =
+{
+	"query",
+	"trade",
+	"modify"
+};
+
+} // anonymous namespace
+
+// ---------------------------------------------------------------------------
+
+ECmdClass fromOperation(const KCommand::EOperation operation)
+{
+	switch (operation)
+	{
+		case KCommand::Open:
+		case KCommand::Close:
+		case KCommand::CloseAll:
+			return Trade;
+
+		case KCommand::Modify:
+		case KCommand::SetStopLoss:
+		case KCommand::SetTakeProfit:
+			return Modify;
+
+		default:
+			return Query;
+	}
+}
+
+const std::string& name(const ECmdClass cmdClass)
+{
+	assert((Query <= cmdClass) && (cmdClass < Count));
+	return s_names[cmdClass];
+}
+
+bool parse(const std::string& name, ECmdClass* cmdClass)
+{
+	for (int i = Query; i < Count; ++i)
+	{
+		if (s_names[i] == name)
+		{
+			*cmdClass = static_cast<ECmdClass>(i);
+			return true;
+		}
+	}
+	return false;
+}
+
+} // namespace cmdclass
+
+// ---------------------------------------------------------------------------
+
+SThrottleLimits::SThrottleLimits()
+{
+	m_classes[cmdclass::Query] = { 20, 20 };
+	m_classes[cmdclass::Trade] = { 5, 10 };
+	m_classes[cmdclass::Modify] = { 5, 10 };
+}
+
+void SThrottleLimits::print(std::ostream& os) const
+{
+	for (int i = cmdclass::Query; i < cmdclass::Count; ++i)
+	{
+		const SThrottleLimit& limit = m_classes[i];
+		os << cmdclass::name(static_cast<cmdclass::ECmdClass>(i)) << '=' << limit.m_rate << '/' << limit.m_burst
+			<< ((i + 1 < cmdclass::Count) ? ' ' : '\n');
+	}
+	os << std::flush;
+}
+
+// ---------------------------------------------------------------------------
+
+void SThrottleStats::print(std::ostream& os) const
+{
+	os << "queue " << m_queueDepth << " (max " << m_maxQueueDepth << ")\n";
+	for (int i = cmdclass::Query; i < cmdclass::Count; ++i)
+	{
+		const SThrottleClassStats& stats = m_classes[i];
+		os << cmdclass::name(static_cast<cmdclass::ECmdClass>(i)) << ": " << stats.m_sentCount << " sent, "
+			<< stats.m_throttledCount << " throttled, " << stats.m_coalescedCount << " coalesced, waited "
+			<< std::fixed << std::setprecision(3) << stats.m_waitSeconds << 's' << std::defaultfloat << '\n';
+	}
+	os << std::flush;
+}
+
+// ---------------------------------------------------------------------------
+
+ICommandThrottle::~ICommandThrottle()
+{
+}
+
+} // namespace fx
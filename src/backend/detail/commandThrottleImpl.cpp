@@ -0,0 +1,285 @@
+// author: Darek Slusarczyk alias marines marinesovitch 2012-2013, 2022
+#include "ph.h"
+#include "commandThrottleImpl.h"
+#include "commandThrottle.h"
+#include <chrono>
+
+namespace fx
+{
+
+namespace
+{
+
+typedef std::chrono::steady_clock clock_t;
+
+struct STokenBucket
+{
+	public:
+		// returns 0 if a token was taken, otherwise the seconds until the
+		// next one
+		double take(const SThrottleLimit& limit, const clock_t::time_point now);
+		void clamp(const SThrottleLimit& limit);
+
+	public:
+		double m_tokens = -1;
+		clock_t::time_point m_lastRefill;
+
+};
+
+double STokenBucket::take(const SThrottleLimit& limit, const clock_t::time_point now)
+{
+	if (limit.m_rate <= 0)
+	{
+		return 0;
+	}
+
+	if (m_tokens < 0)
+	{
+		// the first command, the bucket starts full
+		m_tokens = limit.m_burst;
+	}
+	else
+	{
+		const double elapsed = std::chrono::duration<double>(now - m_lastRefill).count();
+		m_tokens = std::min(limit.m_burst, m_tokens + elapsed * limit.m_rate);
+	}
+	m_lastRefill = now;
+
+	if (1 <= m_tokens)
+	{
+		m_tokens -= 1;
+		return 0;
+	}
+
+	const double result = (1 - m_tokens) / limit.m_rate;
+	return result;
+}
+
+void STokenBucket::clamp(const SThrottleLimit& limit)
+{
+	m_tokens = std::min(m_tokens, limit.m_burst);
+}
+
+// ---------------------------------------------------------------------------
+
+// the modifications are coalesced by their operation and tickets
+struct SCoalesceKey
+{
+	KCommand::EOperation m_operation;
+	tickets_t m_tickets;
+
+	bool operator<(const SCoalesceKey& rhs) const
+	{
+		if (m_operation != rhs.m_operation)
+		{
+			return m_operation < rhs.m_operation;
+		}
+		return m_tickets < rhs.m_tickets;
+	}
+};
+
+struct SQueuedCommand
+{
+	HCommand m_command;
+	cmdclass::ECmdClass m_class = cmdclass::Query;
+	bool m_coalescable = false;
+	bool m_throttled = false;
+	clock_t::time_point m_throttledSince;
+};
+
+typedef std::list<SQueuedCommand> commands_t;
+
+// ---------------------------------------------------------------------------
+
+class KCommandThrottle : public ICommandThrottle
+{
+	public:
+		KCommandThrottle(const SThrottleLimits& limits);
+
+	public:
+		// ICommandThrottle
+		virtual void push(HCommand command);
+		virtual HCommand pop();
+
+		virtual void setLimits(const SThrottleLimits& limits);
+		virtual SThrottleLimits getLimits() const;
+		virtual SThrottleStats getStats() const;
+
+	private:
+		static bool isCoalescable(const KCommand& command);
+		bool isTouchedLater(commands_t::const_iterator queued, const tickets_t& tickets) const;
+
+	private:
+		mutable std::mutex m_mutex;
+		std::condition_variable m_onChange;
+
+		SThrottleLimits m_limits;
+		std::array<STokenBucket, cmdclass::Count> m_buckets;
+
+		commands_t m_commands;
+		std::map<SCoalesceKey, commands_t::iterator> m_key2command;
+
+		SThrottleStats m_stats;
+
+};
+
+// ---------------------------------------------------------------------------
+
+KCommandThrottle::KCommandThrottle(const SThrottleLimits& limits)
+	: m_limits(limits)
+{
+}
+
+// ---------------------------------------------------------------------------
+// ICommandThrottle
+
+void KCommandThrottle::push(HCommand command)
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+	const cmdclass::ECmdClass cmdClass = cmdclass::fromOperation(command->operation());
+	const bool coalescable = isCoalescable(*command);
+	if (coalescable)
+	{
+		const SCoalesceKey key = { command->operation(), command->tickets() };
+		auto it = m_key2command.find(key);
+		if (it != m_key2command.end())
+		{
+			// the queued one hasn't been sent yet, the latest values win
+			++m_stats.m_classes[cmdClass].m_coalescedCount;
+			const commands_t::iterator queued = it->second;
+			if (!isTouchedLater(queued, command->tickets()))
+			{
+				queued->m_command = command;
+				return;
+			}
+
+			// a later command touches the orders too, the latest values must
+			// follow it, so they take the tail of the queue
+			m_commands.erase(queued);
+			m_key2command.erase(it);
+		}
+	}
+
+	SQueuedCommand queued;
+	queued.m_command = command;
+	queued.m_class = cmdClass;
+	queued.m_coalescable = coalescable;
+	m_commands.push_back(queued);
+	if (coalescable)
+	{
+		const SCoalesceKey key = { command->operation(), command->tickets() };
+		m_key2command.emplace(key, std::prev(m_commands.end()));
+	}
+
+	m_stats.m_maxQueueDepth = std::max(m_stats.m_maxQueueDepth, m_commands.size());
+	m_onChange.notify_one();
+}
+
+HCommand KCommandThrottle::pop()
+{
+	std::unique_lock<std::mutex> lock(m_mutex);
+	for (;;)
+	{
+		m_onChange.wait(lock, [this]{ return !m_commands.empty(); });
+
+		SQueuedCommand& head = m_commands.front();
+		const auto now = clock_t::now();
+		const double waitSeconds = m_buckets[head.m_class].take(m_limits.m_classes[head.m_class], now);
+		SThrottleClassStats& stats = m_stats.m_classes[head.m_class];
+		if (waitSeconds == 0)
+		{
+			HCommand result = head.m_command;
+			if (head.m_throttled)
+			{
+				stats.m_waitSeconds += std::chrono::duration<double>(now - head.m_throttledSince).count();
+			}
+			if (head.m_coalescable)
+			{
+				m_key2command.erase(SCoalesceKey{ result->operation(), result->tickets() });
+			}
+			m_commands.pop_front();
+			++stats.m_sentCount;
+			return result;
+		}
+
+		if (!head.m_throttled)
+		{
+			head.m_throttled = true;
+			head.m_throttledSince = now;
+			++stats.m_throttledCount;
+		}
+		// woken up earlier by a change of the limits
+		m_onChange.wait_for(lock, std::chrono::duration<double>(waitSeconds));
+	}
+}
+
+void KCommandThrottle::setLimits(const SThrottleLimits& limits)
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+	m_limits = limits;
+	for (int i = cmdclass::Query; i < cmdclass::Count; ++i)
+	{
+		m_buckets[i].clamp(m_limits.m_classes[i]);
+	}
+	m_onChange.notify_all();
+}
+
+SThrottleLimits KCommandThrottle::getLimits() const
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+	return m_limits;
+}
+
+SThrottleStats KCommandThrottle::getStats() const
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+	SThrottleStats stats = m_stats;
+	stats.m_queueDepth = m_commands.size();
+	return stats;
+}
+
+// ---------------------------------------------------------------------------
+
+bool KCommandThrottle::isCoalescable(const KCommand& command)
+{
+	switch (command.operation())
+	{
+		case KCommand::Modify:
+		case KCommand::SetStopLoss:
+		case KCommand::SetTakeProfit:
+			return true;
+
+		default:
+			return false;
+	}
+}
+
+bool KCommandThrottle::isTouchedLater(commands_t::const_iterator queued, const tickets_t& tickets) const
+{
+	for (auto it = std::next(queued); it != m_commands.end(); ++it)
+	{
+		const KCommand& command = *it->m_command;
+		const tickets_t& laterTickets = command.tickets();
+		const bool touchesAll = (command.operation() == KCommand::CloseAll)
+			|| ((command.operation() == KCommand::Get) && laterTickets.empty());
+		if (touchesAll
+			|| (std::find_first_of(laterTickets.begin(), laterTickets.end(), tickets.begin(), tickets.end())
+				!= laterTickets.end()))
+		{
+			return true;
+		}
+	}
+	return false;
+}
+
+} // anonymous namespace
+
+// ---------------------------------------------------------------------------
+
+ICommandThrottle* createCommandThrottle(const SThrottleLimits& limits)
+{
+	ICommandThrottle* throttle = new KCommandThrottle(limits);
+	return throttle;
+}
+
+} // namespace fx
@@ -0,0 +1,15 @@
+// author: Darek Slusarczyk alias marines marinesovitch 2012-2013, 2022
+#ifndef INC_BACKEND_COMMANDTHROTTLEIMPL_H
+#define INC_BACKEND_COMMANDTHROTTLEIMPL_H
+
+namespace fx
+{
+
+struct ICommandThrottle;
+struct SThrottleLimits;
+
+ICommandThrottle* createCommandThrottle(const SThrottleLimits& limits);
+
+} // namespace fx
+
+#endif
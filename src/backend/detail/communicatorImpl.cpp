@@ -2,10 +2,14 @@
 #include "ph.h"
 #include "communicator.h"
 #include "accountManager.h"
+#include "commandThrottle.h"
+#include "commandThrottleImpl.h"
 #include "connection.h"
+#include "sessionRecorder.h"
+#include "sessionReplayer.h"
+#include "sessionReplayerImpl.h"
 #include "traderSink.h"
 #include "common/command.h"
-#include "common/commandQueue.h"
 #include "common/consts.h"
 #include "common/fileUtils.h"
 #include "common/mailSlot.h"
@@ -15,6 +19,7 @@
 #include "common/symbolInfo.h"
 #include "common/types.h"
 #include "common/utils.h"
+#include "cpp/allocTracker.h"
 #include "cpp/strUtils.h"
 
 namespace fx
@@ -392,18 +397,24 @@ void KNoteProcessor::processSymbolNote(const SSymbolNote& symbolNote)
 class KConnection : public IConnection
 {
 	public:
-		KConnection(ITraderSink* sink);
+		KConnection(const account_key_t& key, ITraderSink* sink);
 		virtual ~KConnection();
 
 	public:
 		// IConnection
 		virtual bool isConnected() const;
 		virtual void sendCommand( HCommand command );
+		virtual ICommandThrottle& getThrottle();
 
 	public:
 		bool isChannelConnected(const SChannelInfo::EKind channelKind) const;
+		// any of the channel loops runs, so the sink is fed by MetaTrader
+		bool isAnyChannelConnected() const;
 		void runChannelLoop(const SChannelInfo::EKind channelKind, KNamedPipeClient* rawTickChannel);
 
+		ITraderSink* sink() const;
+		void setRecorder(HSessionRecorder recorder);
+
 	private:
 		void tickLoop(KNamedPipeClient* rawChannelPipe);
 		void symbolLoop(KNamedPipeClient* rawChannelPipe);
@@ -413,13 +424,20 @@ class KConnection : public IConnection
 		void setChannelConnected(const SChannelInfo::EKind channelKind);
 		void setChannelDisconnected(const SChannelInfo::EKind channelKind);
 
+		HSessionRecorder getRecorder() const;
+
 	private:
+		const account_key_t m_key;
 		ITraderSink* m_sink;
 
+		// accessed atomically, because it is set while the channel loops are running
+		HSessionRecorder m_recorder;
+
 		// logical OR of SChannelInfo::EKind flags
 		std::atomic<int> m_disconnectedChannels = SChannelInfo::All;
 
-		command_queue m_cmdQueue;
+		// the commands wait there for the cmd loop, limited by rate
+		std::unique_ptr<ICommandThrottle> m_cmdQueue;
 
 };
 
@@ -427,7 +445,10 @@ typedef std::shared_ptr< KConnection > HKConnection;
 
 // ---------------------------------------------------------------------------
 
-KConnection::KConnection(ITraderSink* sink) : m_sink(sink)
+KConnection::KConnection(const account_key_t& key, ITraderSink* sink)
+	: m_key(key)
+	, m_sink(sink)
+	, m_cmdQueue(createCommandThrottle(SThrottleLimits()))
 {
 }
 
@@ -444,7 +465,12 @@ bool KConnection::isConnected() const
 
 void KConnection::sendCommand(HCommand command)
 {
-	m_cmdQueue.push(command);
+	m_cmdQueue->push(command);
+}
+
+ICommandThrottle& KConnection::getThrottle()
+{
+	return *m_cmdQueue;
 }
 
 // ---------------------------------------------------------------------------
@@ -455,6 +481,12 @@ bool KConnection::isChannelConnected(const SChannelInfo::EKind channelKind) cons
 	return result;
 }
 
+bool KConnection::isAnyChannelConnected() const
+{
+	const bool result = (m_disconnectedChannels != SChannelInfo::All);
+	return result;
+}
+
 void KConnection::runChannelLoop(const SChannelInfo::EKind channelKind, KNamedPipeClient* channelPipe)
 {
 	typedef void (KConnection::*TChannelLoopRoutine)(KNamedPipeClient* /*channelPipe*/);
@@ -474,6 +506,16 @@ void KConnection::runChannelLoop(const SChannelInfo::EKind channelKind, KNamedPi
 	cmdLoopThread.detach();
 }
 
+ITraderSink* KConnection::sink() const
+{
+	return m_sink;
+}
+
+void KConnection::setRecorder(HSessionRecorder recorder)
+{
+	std::atomic_store(&m_recorder, recorder);
+}
+
 void KConnection::tickLoop(KNamedPipeClient* rawChannelPipe)
 {
 	std::unique_ptr< KNamedPipeClient > channelPipe(rawChannelPipe);
@@ -482,7 +524,23 @@ void KConnection::tickLoop(KNamedPipeClient* rawChannelPipe)
 	STick tick;
 	while (channelPipe->isValid())
 	{
-		if (channelPipe->read(&tick))
+		bool received = false;
+		{
+			// receiving and recording a tick is not expected to touch the heap,
+			// the sink is left out as the strategies and engines behind it
+			// allocate as they need
+			CPP_ALLOC_PROBE("KConnection::tickLoop receive", 0);
+			received = channelPipe->read(&tick);
+			if (received)
+			{
+				if (HSessionRecorder recorder = getRecorder())
+				{
+					recorder->recordTick(m_key, tick);
+				}
+			}
+		}
+
+		if (received)
 		{
 			m_sink->onTick(tick);
 		}
@@ -501,6 +559,10 @@ void KConnection::symbolLoop(KNamedPipeClient* rawChannelPipe)
 	{
 		if (channelPipe->read(&symbol))
 		{
+			if (HSessionRecorder recorder = getRecorder())
+			{
+				recorder->recordSymbol(m_key, symbol);
+			}
 			m_sink->onSymbol(symbol);
 		}
 	}
@@ -518,6 +580,10 @@ void KConnection::orderLoop(KNamedPipeClient* rawChannelPipe)
 	{
 		if (channelPipe->read(&order))
 		{
+			if (HSessionRecorder recorder = getRecorder())
+			{
+				recorder->recordOrder(m_key, order);
+			}
 			m_sink->onOrder(order);
 		}
 	}
@@ -534,21 +600,31 @@ void KConnection::cmdLoop(KNamedPipeClient* rawChannelPipe)
 	std::string output;
 	while (channelPipe->isValid())
 	{
-		command = m_cmdQueue.pop();
+		command = m_cmdQueue->pop();
 		const std::string& cmdStr = command->toString();
+		bool received = false;
 		if (channelPipe->write(cmdStr))
 		{
-			if (channelPipe->read(&output))
+			HSessionRecorder recorder = getRecorder();
+			if (recorder)
 			{
-				m_sink->onCmdResult(output);
+				recorder->recordCommand(m_key, cmdStr);
 			}
-			else
+
+			received = channelPipe->read(&output);
+			if (received && recorder)
 			{
+				recorder->recordCmdResult(m_key, output);
 			}
 		}
+
+		// the sink releases what it keeps for the command, like the
+		// reservation of the risk limits, even if the output was lost
+		m_sink->onCmdResult(command, received ? output : consts::CmdResultLost);
 	}
 
 	setChannelDisconnected(SChannelInfo::Cmd);
+	m_sink->onDisconnected();
 }
 
 void KConnection::setChannelConnected(const SChannelInfo::EKind channelKind)
@@ -561,6 +637,11 @@ void KConnection::setChannelDisconnected(const SChannelInfo::EKind channelKind)
 	m_disconnectedChannels |= channelKind;
 }
 
+HSessionRecorder KConnection::getRecorder() const
+{
+	return std::atomic_load(&m_recorder);
+}
+
 // ---------------------------------------------------------------------------
 // ---------------------------------------------------------------------------
 
@@ -647,7 +728,7 @@ KNamedPipeClient* KConnector::findPipe( const SChannelInfo::EKind kind )
 
 typedef std::map< account_key_t, HKConnection > connections_t;
 
-class KCommunicator : public ICommunicator, public INoteObserver
+class KCommunicator : public ICommunicator, public INoteObserver, public ISessionReplayTarget
 {
 	public:
 		KCommunicator(IAccountManager* accountManager);
@@ -659,12 +740,26 @@ class KCommunicator : public ICommunicator, public INoteObserver
 		virtual void run();
 		virtual HConnection connect(const account_key_t& key, ITraderSink* sink);
 
+		virtual void startRecording(HSessionRecorder recorder);
+		virtual HSessionRecorder stopRecording();
+
+		virtual void startReplay(const std::string& path, const double speed, std::ostream* cout);
+		virtual void stopReplay();
+
 	public:
 		// INoteObserver
 		virtual void onSymbolNote(const SSymbolNote& symbolNote);
 
+	public:
+		// ISessionReplayTarget
+		virtual account_key_t replayAccount(const SAccountInfo& accountInfo);
+		virtual void replayNote(const account_key_t& key, const note::EKind noteKind, const std::string& symbol);
+		virtual ITraderSink* replaySink(const account_key_t& key);
+
 	private:
 		bool isConnected( const account_key_t& accountKey ) const;
+		// the channel loops of the account run, a replay would race with them
+		bool isLive( const account_key_t& accountKey ) const;
 		bool detectChannels();
 		void connectChannels(const account_key_t& key, HKConnection connection);
 
@@ -673,8 +768,17 @@ class KCommunicator : public ICommunicator, public INoteObserver
 		IAccountManager& m_accountManager;
 		ICommunicatorObserver* m_observer = nullptr;
 		KChannelsManager m_channels;
+
+		// the accounts are detected by the note thread and the replay thread,
+		// both reach the observer which connects the new ones, so the
+		// connections and the calls of the observer are serialized; it is
+		// recursive, because connect is called back by the observer
+		std::recursive_mutex m_mutex;
 		connections_t m_connections;
 
+		HSessionRecorder m_recorder;
+		HSessionReplayer m_replayer;
+
 };
 
 // ---------------------------------------------------------------------------
@@ -700,23 +804,92 @@ void KCommunicator::setObserver(ICommunicatorObserver* observer)
 
 void KCommunicator::run()
 {
-	detectChannels();
+	{
+		std::lock_guard<std::recursive_mutex> lock(m_mutex);
+		detectChannels();
+	}
 	m_noteProcessor.run();
 }
 
 HConnection KCommunicator::connect(const account_key_t& key, ITraderSink* sink)
 {
+	std::lock_guard<std::recursive_mutex> lock(m_mutex);
 	assert(m_connections.count(key) == 0);
-	HKConnection connection( new KConnection(sink) );
+	HKConnection connection( new KConnection(key, sink) );
 	m_connections.insert( std::make_pair( key, connection ) );
+
+	if (HSessionRecorder recorder = std::atomic_load(&m_recorder))
+	{
+		recorder->recordAccount(key, m_accountManager.get(key));
+		connection->setRecorder(recorder);
+	}
+
 	connectChannels( key, connection );
 	return connection;
 }
 
+void KCommunicator::startRecording(HSessionRecorder recorder)
+{
+	std::lock_guard<std::recursive_mutex> lock(m_mutex);
+	if (std::atomic_load(&m_recorder))
+	{
+		throw std::logic_error("session is already recorded");
+	}
+
+	for ( auto it : m_connections )
+	{
+		const account_key_t& key = it.first;
+		recorder->recordAccount(key, m_accountManager.get(key));
+	}
+
+	std::atomic_store(&m_recorder, recorder);
+
+	for ( auto it : m_connections )
+	{
+		HKConnection connection = it.second;
+		connection->setRecorder(recorder);
+	}
+}
+
+HSessionRecorder KCommunicator::stopRecording()
+{
+	std::lock_guard<std::recursive_mutex> lock(m_mutex);
+	for ( auto it : m_connections )
+	{
+		HKConnection connection = it.second;
+		connection->setRecorder(HSessionRecorder());
+	}
+
+	HSessionRecorder result = std::atomic_exchange(&m_recorder, HSessionRecorder());
+	return result;
+}
+
+void KCommunicator::startReplay(const std::string& path, const double speed, std::ostream* cout)
+{
+	if (m_replayer && m_replayer->isRunning())
+	{
+		throw std::logic_error("session is already replayed");
+	}
+
+	// release the previous replayer before the new one opens the file
+	m_replayer.reset();
+	m_replayer.reset( createSessionReplayer(path, speed, this, cout) );
+	m_replayer->run();
+}
+
+void KCommunicator::stopReplay()
+{
+	if (m_replayer)
+	{
+		m_replayer->stop();
+	}
+}
+
 // ---------------------------------------------------------------------------
 
 void KCommunicator::onSymbolNote(const SSymbolNote& symbolNote)
 {
+	std::lock_guard<std::recursive_mutex> lock(m_mutex);
 	const note::EKind noteKind = symbolNote.m_note;
 	assert( (noteKind == note::RegisterSymbol) || (noteKind == note::UnregisterSymbol) );
 	const SAccountInfo& accountInfo = symbolNote.m_accountInfo;
@@ -732,12 +905,66 @@ void KCommunicator::onSymbolNote(const SSymbolNote& symbolNote)
 	if ( accountKey.isValid() )
 	{
 		const std::string& symbolLabel = symbolNote.m_label;
+		if (HSessionRecorder recorder = std::atomic_load(&m_recorder))
+		{
+			recorder->recordNote(accountKey, noteKind, symbolLabel);
+		}
 		m_observer->onSymbolNote(accountKey, noteKind, symbolLabel);
 	}
 }
 
 // ---------------------------------------------------------------------------
 
+account_key_t KCommunicator::replayAccount(const SAccountInfo& accountInfo)
+{
+	std::lock_guard<std::recursive_mutex> lock(m_mutex);
+	account_key_t result = m_accountManager.getKey(accountInfo);
+	if ( result.isNull() )
+	{
+		result = m_accountManager.add(accountInfo);
+		m_observer->onNewAccountDetected(result);
+	}
+	else if ( isLive( result ) )
+	{
+		result = account_key_t();
+	}
+	return result;
+}
+
+void KCommunicator::replayNote(const account_key_t& key, const note::EKind noteKind, const std::string& symbol)
+{
+	std::lock_guard<std::recursive_mutex> lock(m_mutex);
+	m_observer->onSymbolNote(key, noteKind, symbol);
+}
+
+ITraderSink* KCommunicator::replaySink(const account_key_t& key)
+{
+	std::lock_guard<std::recursive_mutex> lock(m_mutex);
+	ITraderSink* result = nullptr;
+	auto it = m_connections.find( key );
+	// the account may have been connected by MetaTrader since the replay started
+	if ( ( it != m_connections.end() ) && !it->second->isAnyChannelConnected() )
+	{
+		HKConnection connection = it->second;
+		result = connection->sink();
+	}
+	return result;
+}
+
+// ---------------------------------------------------------------------------
+
+bool KCommunicator::isLive( const account_key_t& accountKey ) const
+{
+	bool result = false;
+	auto it = m_connections.find( accountKey );
+	if ( it != m_connections.end() )
+	{
+		HKConnection connection = it->second;
+		result = connection->isAnyChannelConnected();
+	}
+	return result;
+}
+
 bool KCommunicator::isConnected( const account_key_t& accountKey ) const
 {
 	bool result = false;
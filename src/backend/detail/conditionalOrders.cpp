@@ -0,0 +1,70 @@
+// author: Darek Slusarczyk alias marines marinesovitch 2012-2013, 2022
+#include "ph.h"
+#include "conditionalOrders.h"
+
+namespace fx
+{
+
+namespace
+{
+
+const char* kind2str(const SConditionalOrder::EKind kind)
+{
+	switch (kind)
+	{
+		case SConditionalOrder::VirtualStops:
+			return "vstop";
+
+		case SConditionalOrder::Oco:
+			return "oco";
+
+		default:
+			return "bracket";
+	}
+}
+
+const char* state2str(const SConditionalOrder::EState state)
+{
+	switch (state)
+	{
+		case SConditionalOrder::Active:
+			return "active";
+
+		case SConditionalOrder::Filling:
+			return "filling";
+
+		default:
+			return "closing";
+	}
+}
+
+} // anonymous namespace
+
+// ---------------------------------------------------------------------------
+
+std::string SConditionalOrder::toString() const
+{
+	std::ostringstream os;
+	os << m_id << ' ' << kind2str(m_kind) << ' ' << state2str(m_state) << ' ' << m_symbol;
+	for (const SNewOrder& entry : m_entries)
+	{
+		os << ' ' << SOrder::type2str(entry.m_type) << ' ' << entry.m_lots.m_value << '@' << entry.m_openPrice.m_value;
+	}
+	if (m_ticket.isValid())
+	{
+		os << " order " << m_ticket;
+	}
+	if ((m_stopLoss != 0) || (m_takeProfit != 0))
+	{
+		os << " sl " << m_stopLoss << " tp " << m_takeProfit;
+	}
+	return os.str();
+}
+
+// ---------------------------------------------------------------------------
+
+IConditionalOrders::~IConditionalOrders()
+{
+}
+
+} // namespace fx
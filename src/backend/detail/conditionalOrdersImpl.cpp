@@ -0,0 +1,626 @@
+// author: Darek Slusarczyk alias marines marinesovitch 2012-2013, 2022
+#include "ph.h"
+#include "conditionalOrdersImpl.h"
+#include "conditionalOrders.h"
+#include "strategyHost.h"
+#include "common/command.h"
+#include "common/order.h"
+#include <array>
+#include <chrono>
+#include <string_view>
+#include <unordered_map>
+
+namespace fx
+{
+
+namespace
+{
+
+typedef std::chrono::steady_clock clock_t;
+
+// the side of the quote which crosses a level and the direction it comes
+// from; the levels crossed from above are kept negated, so in each index
+// the crossed levels are at the beginning
+enum EIndex
+{
+	BidAbove,
+	BidBelow,
+	AskAbove,
+	AskBelow,
+	IndexCount
+};
+
+enum ERole
+{
+	FirstEntry,
+	SecondEntry,
+	StopLoss,
+	TakeProfit
+};
+
+struct SLevel
+{
+	uint32_t m_id;
+	ERole m_role;
+};
+
+typedef std::multimap<price_t, SLevel> levels_t;
+
+struct SSymbolLevels
+{
+	std::array<levels_t, IndexCount> m_indexes;
+};
+
+// a level of an order in the index, so it may be removed in O(log n)
+struct SLevelRef
+{
+	levels_t* m_levels = nullptr;
+	levels_t::iterator m_it;
+};
+
+struct SEntry
+{
+	SConditionalOrder m_order;
+	SSymbolLevels* m_symbolLevels = nullptr;
+	// at most two levels are watched at once: both entries of OCO, or the
+	// stop loss and take profit
+	std::array<SLevelRef, 2> m_levels;
+	// the time of the tick which opened a bracket, its order is not older
+	datetime_t m_fireTime = 0;
+	// the entry of a filling bracket or the close of a closing order, kept to
+	// recognize its result
+	HCommand m_command;
+};
+
+// a command prepared under the lock and sent after it
+struct SFired
+{
+	uint32_t m_id;
+	HCommand m_command;
+};
+
+// ---------------------------------------------------------------------------
+
+bool isPendingType(const SOrder::EType type)
+{
+	const bool result = (type == SOrder::BuyLimit)
+		|| (type == SOrder::SellLimit)
+		|| (type == SOrder::BuyStop)
+		|| (type == SOrder::SellStop);
+	return result;
+}
+
+bool isBuyType(const SOrder::EType type)
+{
+	const bool result = (type == SOrder::Buy)
+		|| (type == SOrder::BuyLimit)
+		|| (type == SOrder::BuyStop);
+	return result;
+}
+
+EIndex entryIndex(const SOrder::EType type)
+{
+	switch (type)
+	{
+		case SOrder::BuyLimit:
+			return AskBelow;
+
+		case SOrder::SellLimit:
+			return BidAbove;
+
+		case SOrder::BuyStop:
+			return AskAbove;
+
+		default:
+			return BidBelow;
+	}
+}
+
+bool validateEntry(const SNewOrder& entry, std::string* error)
+{
+	if (!isPendingType(entry.m_type))
+	{
+		*error = "the entry has to be a limit or stop order";
+		return false;
+	}
+
+	if ((entry.m_lots.m_value <= 0) || (entry.m_openPrice.m_value <= 0))
+	{
+		*error = "incorrect lots or price of the entry";
+		return false;
+	}
+
+	const price_t price = entry.m_openPrice.m_value;
+	const price_t stopLoss = entry.m_stopLoss.m_value;
+	const price_t takeProfit = entry.m_takeProfit.m_value;
+	const bool buy = isBuyType(entry.m_type);
+	const bool wrongStopLoss = (stopLoss != 0) && (buy ? (price <= stopLoss) : (stopLoss <= price));
+	const bool wrongTakeProfit = (takeProfit != 0) && (buy ? (takeProfit <= price) : (price <= takeProfit));
+	if (wrongStopLoss || wrongTakeProfit)
+	{
+		*error = "the stop loss or take profit is on the wrong side of the entry";
+		return false;
+	}
+	return true;
+}
+
+// ---------------------------------------------------------------------------
+
+class KConditionalOrders : public IConditionalOrders
+{
+	public:
+		KConditionalOrders(IStrategyHost* host, std::ostream* cerr);
+
+	public:
+		// IConditionalOrders
+		virtual uint32_t addVirtualStops(
+			const SOrder& order,
+			const price_t stopLoss,
+			const price_t takeProfit,
+			std::string* error);
+		virtual uint32_t addOco(const SNewOrder& first, const SNewOrder& second, std::string* error);
+		virtual uint32_t addBracket(const SNewOrder& entry, std::string* error);
+
+		virtual bool cancel(const uint32_t id);
+		virtual void getOrders(std::vector<SConditionalOrder>* orders) const;
+
+		virtual void onTick(const STick& tick);
+		virtual void onOrder(const SOrder& order);
+		virtual void onCmdResult(const KCommand& command, const bool success);
+
+		virtual SConditionalStats getStats() const;
+
+	private:
+		// must be called with locked m_mutex
+		SEntry& insertEntry(const SConditionalOrder::EKind kind, const std::string& symbol);
+		void insertLevel(SEntry* entry, const EIndex index, const price_t price, const ERole role);
+		void insertStops(SEntry* entry);
+		void eraseLevels(SEntry* entry);
+		void eraseEntry(std::map<uint32_t, SEntry>::iterator it);
+		void reopen(SEntry* entry);
+
+		void trigger(levels_t* levels, const price_t price, const STick& tick, std::vector<SFired>* fired);
+		HCommand fire(SEntry* entry, const ERole role, const STick& tick);
+
+	private:
+		IStrategyHost& m_host;
+		std::ostream& m_cerr;
+
+		mutable std::mutex m_mutex;
+		uint32_t m_nextId = 1;
+		std::map<uint32_t, SEntry> m_id2entry;
+		std::map<std::string, SSymbolLevels, std::less<>> m_symbol2levels;
+		// the orders watched by the virtual stops
+		std::unordered_map<int32_t, uint32_t> m_ticket2id;
+		// the brackets opened, but not reported by MetaTrader yet
+		std::vector<uint32_t> m_filling;
+
+		SConditionalStats m_stats;
+
+};
+
+// ---------------------------------------------------------------------------
+
+KConditionalOrders::KConditionalOrders(IStrategyHost* host, std::ostream* cerr)
+	: m_host(*host)
+	, m_cerr(*cerr)
+{
+}
+
+// ---------------------------------------------------------------------------
+// IConditionalOrders
+
+uint32_t KConditionalOrders::addVirtualStops(
+	const SOrder& order,
+	const price_t stopLoss,
+	const price_t takeProfit,
+	std::string* error)
+{
+	if ((order.m_status != SOrder::Open) || ((order.m_type != SOrder::Buy) && (order.m_type != SOrder::Sell)))
+	{
+		*error = "order " + std::to_string(order.m_ticket) + " is not an open buy or sell";
+		return 0;
+	}
+
+	if ((stopLoss < 0) || (takeProfit < 0) || ((stopLoss == 0) && (takeProfit == 0)))
+	{
+		*error = "incorrect stop loss or take profit";
+		return 0;
+	}
+
+	std::lock_guard<std::mutex> lock(m_mutex);
+	// the new stops replace the previous ones of the order
+	auto ticketIt = m_ticket2id.find(order.m_ticket);
+	if (ticketIt != m_ticket2id.end())
+	{
+		eraseEntry(m_id2entry.find(ticketIt->second));
+	}
+
+	SEntry& entry = insertEntry(SConditionalOrder::VirtualStops, order.m_symbolName);
+	SConditionalOrder& conditional = entry.m_order;
+	conditional.m_ticket = order.m_ticket;
+	conditional.m_buy = (order.m_type == SOrder::Buy);
+	conditional.m_stopLoss = stopLoss;
+	conditional.m_takeProfit = takeProfit;
+	insertStops(&entry);
+	return conditional.m_id;
+}
+
+uint32_t KConditionalOrders::addOco(const SNewOrder& first, const SNewOrder& second, std::string* error)
+{
+	if (!validateEntry(first, error) || !validateEntry(second, error))
+	{
+		return 0;
+	}
+
+	if (first.m_symbolName != second.m_symbolName)
+	{
+		*error = "both entries have to be of the same symbol";
+		return 0;
+	}
+
+	std::lock_guard<std::mutex> lock(m_mutex);
+	SEntry& entry = insertEntry(SConditionalOrder::Oco, first.m_symbolName);
+	entry.m_order.m_entries = { first, second };
+	insertLevel(&entry, entryIndex(first.m_type), first.m_openPrice.m_value, FirstEntry);
+	insertLevel(&entry, entryIndex(second.m_type), second.m_openPrice.m_value, SecondEntry);
+	return entry.m_order.m_id;
+}
+
+uint32_t KConditionalOrders::addBracket(const SNewOrder& newOrder, std::string* error)
+{
+	if (!validateEntry(newOrder, error))
+	{
+		return 0;
+	}
+
+	std::lock_guard<std::mutex> lock(m_mutex);
+	SEntry& entry = insertEntry(SConditionalOrder::Bracket, newOrder.m_symbolName);
+	SConditionalOrder& conditional = entry.m_order;
+	conditional.m_entries = { newOrder };
+	conditional.m_buy = isBuyType(newOrder.m_type);
+	conditional.m_stopLoss = newOrder.m_stopLoss.m_value;
+	conditional.m_takeProfit = newOrder.m_takeProfit.m_value;
+	insertLevel(&entry, entryIndex(newOrder.m_type), newOrder.m_openPrice.m_value, FirstEntry);
+	return conditional.m_id;
+}
+
+bool KConditionalOrders::cancel(const uint32_t id)
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+	auto it = m_id2entry.find(id);
+	if (it == m_id2entry.end())
+	{
+		return false;
+	}
+
+	eraseEntry(it);
+	return true;
+}
+
+void KConditionalOrders::getOrders(std::vector<SConditionalOrder>* orders) const
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+	for (const auto& id2entry : m_id2entry)
+	{
+		orders->push_back(id2entry.second.m_order);
+	}
+}
+
+void KConditionalOrders::onTick(const STick& tick)
+{
+	const clock_t::time_point arrival = clock_t::now();
+	// the commands are sent without the lock, the vector allocates only if
+	// a level is crossed
+	std::vector<SFired> fired;
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		auto it = m_symbol2levels.find(std::string_view(tick.m_symbolName));
+		if (it == m_symbol2levels.end())
+		{
+			return;
+		}
+
+		++m_stats.m_tickCount;
+		std::array<levels_t, IndexCount>& indexes = it->second.m_indexes;
+		const price_t bid = tick.m_bid.m_value;
+		const price_t ask = tick.m_ask.m_value;
+		trigger(&indexes[BidAbove], bid, tick, &fired);
+		trigger(&indexes[BidBelow], -bid, tick, &fired);
+		trigger(&indexes[AskAbove], ask, tick, &fired);
+		trigger(&indexes[AskBelow], -ask, tick, &fired);
+	}
+
+	if (fired.empty())
+	{
+		return;
+	}
+
+	std::vector<uint32_t> refused;
+	for (SFired& command : fired)
+	{
+		try
+		{
+			m_host.executeCommand(command.m_command);
+		}
+		catch (const std::exception& e)
+		{
+			m_cerr << "conditional order " << command.m_id << ": " << e.what() << std::endl;
+			refused.push_back(command.m_id);
+		}
+	}
+
+	// the commands may be still queued by the throttle of the connection, so
+	// it is the latency of the backend only
+	const double latency = std::chrono::duration<double>(clock_t::now() - arrival).count();
+	std::lock_guard<std::mutex> lock(m_mutex);
+	m_stats.m_firedCount += fired.size();
+	m_stats.m_lastLatency = latency;
+	m_stats.m_maxLatency = (std::max)(m_stats.m_maxLatency, latency);
+	m_stats.m_totalLatency += latency * fired.size();
+	for (const uint32_t id : refused)
+	{
+		// a refused bracket would wait for its order forever, a refused close
+		// watches its stops again
+		auto it = m_id2entry.find(id);
+		if (it == m_id2entry.end())
+		{
+			continue;
+		}
+
+		const SConditionalOrder::EState state = it->second.m_order.m_state;
+		if (state == SConditionalOrder::Filling)
+		{
+			eraseEntry(it);
+		}
+		else if (state == SConditionalOrder::Closing)
+		{
+			reopen(&it->second);
+		}
+	}
+}
+
+void KConditionalOrders::onOrder(const SOrder& order)
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+	auto ticketIt = m_ticket2id.find(order.m_ticket);
+	if (ticketIt != m_ticket2id.end())
+	{
+		if (order.m_status != SOrder::Open)
+		{
+			eraseEntry(m_id2entry.find(ticketIt->second));
+		}
+		return;
+	}
+
+	if (m_filling.empty() || (order.m_status != SOrder::Open))
+	{
+		return;
+	}
+
+	// the order opened by a bracket is the first new one which matches it
+	for (auto fillingIt = m_filling.begin(); fillingIt != m_filling.end(); ++fillingIt)
+	{
+		SEntry& entry = m_id2entry.find(*fillingIt)->second;
+		SConditionalOrder& conditional = entry.m_order;
+		const SNewOrder& newOrder = conditional.m_entries.front();
+		const bool matches = (conditional.m_symbol == order.m_symbolName)
+			&& ((order.m_type == SOrder::Buy) == conditional.m_buy)
+			&& (order.m_lots.m_value == newOrder.m_lots.m_value)
+			&& (entry.m_fireTime <= order.m_openTime.m_value);
+		if (matches)
+		{
+			m_filling.erase(fillingIt);
+			entry.m_command.reset();
+			conditional.m_state = SConditionalOrder::Active;
+			conditional.m_ticket = order.m_ticket;
+			if ((conditional.m_stopLoss == 0) && (conditional.m_takeProfit == 0))
+			{
+				eraseEntry(m_id2entry.find(conditional.m_id));
+			}
+			else
+			{
+				insertStops(&entry);
+			}
+			return;
+		}
+	}
+}
+
+void KConditionalOrders::onCmdResult(const KCommand& command, const bool success)
+{
+	if (success)
+	{
+		// the executed entry or close is taken by its order
+		return;
+	}
+
+	std::lock_guard<std::mutex> lock(m_mutex);
+	if (command.operation() == KCommand::Close)
+	{
+		// the closing order is still watched by its ticket
+		for (const ticket_t& ticket : command.tickets())
+		{
+			auto ticketIt = m_ticket2id.find(ticket);
+			if (ticketIt == m_ticket2id.end())
+			{
+				continue;
+			}
+
+			SEntry& entry = m_id2entry.find(ticketIt->second)->second;
+			if ((entry.m_order.m_state == SConditionalOrder::Closing) && (entry.m_command.get() == &command))
+			{
+				m_cerr << "conditional order " << entry.m_order.m_id << ": the close was rejected" << std::endl;
+				reopen(&entry);
+				return;
+			}
+		}
+		return;
+	}
+
+	if (command.operation() != KCommand::Open)
+	{
+		return;
+	}
+
+	for (const uint32_t id : m_filling)
+	{
+		auto it = m_id2entry.find(id);
+		if (it->second.m_command.get() == &command)
+		{
+			// it would wait for its order forever
+			m_cerr << "conditional order " << id << ": the entry was rejected" << std::endl;
+			eraseEntry(it);
+			return;
+		}
+	}
+}
+
+SConditionalStats KConditionalOrders::getStats() const
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+	return m_stats;
+}
+
+// ---------------------------------------------------------------------------
+
+SEntry& KConditionalOrders::insertEntry(const SConditionalOrder::EKind kind, const std::string& symbol)
+{
+	auto symbolIt = m_symbol2levels.find(std::string_view(symbol));
+	if (symbolIt == m_symbol2levels.end())
+	{
+		symbolIt = m_symbol2levels.emplace(symbol, SSymbolLevels()).first;
+	}
+
+	const uint32_t id = m_nextId++;
+	SEntry& entry = m_id2entry[id];
+	entry.m_order.m_id = id;
+	entry.m_order.m_kind = kind;
+	entry.m_order.m_symbol = symbol;
+	entry.m_symbolLevels = &symbolIt->second;
+	m_stats.m_orderCount = m_id2entry.size();
+	return entry;
+}
+
+void KConditionalOrders::insertLevel(SEntry* entry, const EIndex index, const price_t price, const ERole role)
+{
+	levels_t& levels = entry->m_symbolLevels->m_indexes[index];
+	const bool negated = (index == BidBelow) || (index == AskBelow);
+	const SLevel level{ entry->m_order.m_id, role };
+	SLevelRef& ref = entry->m_levels[entry->m_levels[0].m_levels == nullptr ? 0 : 1];
+	ref.m_levels = &levels;
+	ref.m_it = levels.emplace(negated ? -price : price, level);
+}
+
+void KConditionalOrders::insertStops(SEntry* entry)
+{
+	const SConditionalOrder& conditional = entry->m_order;
+	if (conditional.m_stopLoss != 0)
+	{
+		insertLevel(entry, conditional.m_buy ? BidBelow : AskAbove, conditional.m_stopLoss, StopLoss);
+	}
+	if (conditional.m_takeProfit != 0)
+	{
+		insertLevel(entry, conditional.m_buy ? BidAbove : AskBelow, conditional.m_takeProfit, TakeProfit);
+	}
+	m_ticket2id[conditional.m_ticket] = conditional.m_id;
+}
+
+void KConditionalOrders::eraseLevels(SEntry* entry)
+{
+	for (SLevelRef& ref : entry->m_levels)
+	{
+		if (ref.m_levels != nullptr)
+		{
+			ref.m_levels->erase(ref.m_it);
+			ref.m_levels = nullptr;
+		}
+	}
+}
+
+void KConditionalOrders::eraseEntry(std::map<uint32_t, SEntry>::iterator it)
+{
+	SEntry& entry = it->second;
+	eraseLevels(&entry);
+	const SConditionalOrder& conditional = entry.m_order;
+	if (conditional.m_ticket.isValid())
+	{
+		m_ticket2id.erase(conditional.m_ticket);
+	}
+	if (conditional.m_state == SConditionalOrder::Filling)
+	{
+		m_filling.erase(std::find(m_filling.begin(), m_filling.end(), conditional.m_id));
+	}
+	m_id2entry.erase(it);
+	m_stats.m_orderCount = m_id2entry.size();
+}
+
+void KConditionalOrders::reopen(SEntry* entry)
+{
+	// the order is still open, so the stops fire again when the next tick
+	// crosses them
+	entry->m_order.m_state = SConditionalOrder::Active;
+	entry->m_command.reset();
+	insertStops(entry);
+	++m_stats.m_failedCloseCount;
+}
+
+void KConditionalOrders::trigger(levels_t* levels, const price_t price, const STick& tick, std::vector<SFired>* fired)
+{
+	// a fired order removes all its levels, so the loop visits each order at
+	// most once
+	while (!levels->empty() && (levels->begin()->first <= price))
+	{
+		const SLevel level = levels->begin()->second;
+		auto it = m_id2entry.find(level.m_id);
+		HCommand command = fire(&it->second, level.m_role, tick);
+		fired->push_back(SFired{ level.m_id, command });
+		if (it->second.m_order.m_kind == SConditionalOrder::Oco)
+		{
+			eraseEntry(it);
+		}
+	}
+}
+
+HCommand KConditionalOrders::fire(SEntry* entry, const ERole role, const STick& tick)
+{
+	eraseLevels(entry);
+	SConditionalOrder& conditional = entry->m_order;
+	if ((role == StopLoss) || (role == TakeProfit))
+	{
+		conditional.m_state = SConditionalOrder::Closing;
+		const tickets_t tickets(1, conditional.m_ticket);
+		entry->m_command = std::make_shared<KCmdClose>(tickets);
+		return entry->m_command;
+	}
+
+	// the entry is opened at the market, the levels of a bracket are kept
+	// in the backend
+	SNewOrder newOrder = conditional.m_entries[role == FirstEntry ? 0 : 1];
+	const bool buy = isBuyType(newOrder.m_type);
+	newOrder.m_type = buy ? SOrder::Buy : SOrder::Sell;
+	newOrder.m_openPrice = buy ? tick.m_ask : tick.m_bid;
+	if (conditional.m_kind == SConditionalOrder::Bracket)
+	{
+		newOrder.m_stopLoss = SPrice();
+		newOrder.m_takeProfit = SPrice();
+		conditional.m_state = SConditionalOrder::Filling;
+		entry->m_fireTime = tick.m_time.m_value;
+		entry->m_command = std::make_shared<KCmdOpen>(newOrder);
+		m_filling.push_back(conditional.m_id);
+		return entry->m_command;
+	}
+	return std::make_shared<KCmdOpen>(newOrder);
+}
+
+} // anonymous namespace
+
+// ---------------------------------------------------------------------------
+
+IConditionalOrders* createConditionalOrders(IStrategyHost* host, std::ostream* cerr)
+{
+	IConditionalOrders* conditionalOrders = new KConditionalOrders(host, cerr);
+	return conditionalOrders;
+}
+
+} // namespace fx
@@ -0,0 +1,15 @@
+// author: Darek Slusarczyk alias marines marinesovitch 2012-2013, 2022
+#ifndef INC_BACKEND_CONDITIONALORDERSIMPL_H
+#define INC_BACKEND_CONDITIONALORDERSIMPL_H
+
+namespace fx
+{
+
+struct IConditionalOrders;
+struct IStrategyHost;
+
+IConditionalOrders* createConditionalOrders(IStrategyHost* host, std::ostream* cerr);
+
+} // namespace fx
+
+#endif
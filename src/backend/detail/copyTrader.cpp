@@ -0,0 +1,35 @@
+// author: Darek Slusarczyk alias marines marinesovitch 2012-2013, 2022
+#include "ph.h"
+#include "copyTrader.h"
+
+namespace fx
+{
+
+void SCopyFollower::print(std::ostream& os) const
+{
+	os << "follower " << m_key << " scale " << m_scale;
+	for (const auto& symbols : m_symbols)
+	{
+		os << ' ' << symbols.first << '=' << symbols.second;
+	}
+	os << ", " << m_sentCount << " sent, " << m_failedCount << " failed" << std::endl;
+}
+
+// ---------------------------------------------------------------------------
+
+void SCopyStats::print(std::ostream& os) const
+{
+	const double avgQueueLatency = (m_eventCount != 0) ? (m_totalQueueLatency / m_eventCount) : 0.0;
+	os << m_eventCount << " orders copied by " << m_commandCount << " commands"
+		<< ", queueing latency avg " << avgQueueLatency * 1e6
+		<< "us max " << m_maxQueueLatency * 1e6
+		<< "us last " << m_lastQueueLatency * 1e6 << "us" << std::endl;
+}
+
+// ---------------------------------------------------------------------------
+
+ICopyTrader::~ICopyTrader()
+{
+}
+
+} // namespace fx
@@ -0,0 +1,627 @@
+// author: Darek Slusarczyk alias marines marinesovitch 2012-2013, 2022
+#include "ph.h"
+#include "copyTraderImpl.h"
+#include "copyTrader.h"
+#include "orderCache.h"
+#include "tickStore.h"
+#include "tradeManager.h"
+#include "trader.h"
+#include "common/command.h"
+#include "common/order.h"
+#include "cpp/workStealingPool.h"
+#include <chrono>
+#include <cmath>
+#include <unordered_map>
+#include <unordered_set>
+
+namespace fx
+{
+
+namespace
+{
+
+typedef std::chrono::steady_clock clock_t;
+
+const volume_t LotStep = 0.01;
+
+volume_t roundLots(const volume_t lots)
+{
+	const volume_t result = std::round(lots / LotStep) * LotStep;
+	return result;
+}
+
+bool isSameLots(const volume_t lhs, const volume_t rhs)
+{
+	const bool result = std::fabs(lhs - rhs) < (LotStep / 2);
+	return result;
+}
+
+// ---------------------------------------------------------------------------
+
+// a copy sent to a follower, but not reported by it yet
+struct SPendingCopy
+{
+	int32_t m_master;
+	std::string m_symbol;
+	SOrder::EType m_type;
+	volume_t m_lots;
+	// its open command, if MetaTrader rejects it the copy never comes
+	HCommand m_command;
+};
+
+typedef std::vector<SPendingCopy> pending_copies_t;
+
+struct SFollowerState
+{
+	SCopyFollower m_follower;
+	// the tickets of the follower seen so far, a new one may be a copy
+	std::unordered_set<int32_t> m_known;
+	pending_copies_t m_pending;
+	std::unordered_map<int32_t, int32_t> m_master2copy;
+	std::unordered_map<int32_t, int32_t> m_copy2master;
+};
+
+// the commands of a follower are sent in their order, the followers in
+// parallel
+struct SFollowerCommands
+{
+	account_key_t m_key;
+	std::vector<HCommand> m_commands;
+	// the open commands with the tickets of their master orders, a refused
+	// one drops its pending copy
+	std::vector<std::pair<HCommand, int32_t>> m_opens;
+	std::vector<int32_t> m_refused;
+	uint64_t m_sentCount = 0;
+	uint64_t m_failedCount = 0;
+};
+
+typedef std::vector<SFollowerCommands> follower_commands_t;
+
+// ---------------------------------------------------------------------------
+
+class KCopyTrader : public ICopyTrader
+{
+	public:
+		KCopyTrader(ITradeManager* tradeManager, std::ostream* cerr, const unsigned int workerCount);
+
+	public:
+		// IOrderObserver
+		virtual void onOrder(const account_key_t& key, const SOrder& order);
+		virtual void onCmdResult(const account_key_t& key, const KCommand& command, const bool success);
+
+	public:
+		// ICopyTrader
+		virtual void setMaster(const account_key_t& key);
+		virtual account_key_t getMaster() const;
+
+		virtual bool setFollower(const SCopyFollower& follower, std::string* error);
+		virtual bool removeFollower(const account_key_t& key);
+		virtual void getFollowers(std::vector<SCopyFollower>* followers) const;
+
+		virtual SCopyStats getStats() const;
+
+	private:
+		// must be called with locked m_mutex
+		void onMasterOrder(const SOrder& order, follower_commands_t* commands);
+		void onFollowerOrder(SFollowerState* state, const SOrder& order, follower_commands_t* commands);
+		HCommand openCopy(SFollowerState* state, const SOrder& master);
+		void syncCopy(const SOrder& master, const SOrder& previous, const ticket_t copy, std::vector<HCommand>* commands) const;
+		void eraseClosedMaster(const int32_t ticket);
+		void dropRefused(SFollowerState* state, const std::vector<int32_t>& refused);
+		void dropPending(SFollowerState* state, pending_copies_t::iterator pendingIt);
+		SFollowerCommands& getCommands(const account_key_t& key, follower_commands_t* commands) const;
+
+		void send(follower_commands_t* commands);
+
+	private:
+		ITradeManager& m_tradeManager;
+		std::ostream& m_cerr;
+
+		mutable std::mutex m_mutex;
+		account_key_t m_master;
+		// the last state of the orders of the master, the closed ones are
+		// kept until their copies are reported
+		std::unordered_map<int32_t, SOrder> m_masterOrders;
+		// the orders of the master before it was set
+		std::unordered_set<int32_t> m_ignored;
+		std::map<account_key_t, SFollowerState> m_followers;
+		SCopyStats m_stats;
+
+		// the pool is not reentrant, the order loops of the accounts send
+		// one after another
+		std::mutex m_sendMutex;
+		cpp::KWorkStealingPool m_pool;
+
+};
+
+// ---------------------------------------------------------------------------
+
+KCopyTrader::KCopyTrader(ITradeManager* tradeManager, std::ostream* cerr, const unsigned int workerCount)
+	: m_tradeManager(*tradeManager)
+	, m_cerr(*cerr)
+	, m_pool(workerCount)
+{
+}
+
+// ---------------------------------------------------------------------------
+// IOrderObserver
+
+void KCopyTrader::onOrder(const account_key_t& key, const SOrder& order)
+{
+	const clock_t::time_point arrival = clock_t::now();
+	follower_commands_t commands;
+	bool masterEvent = false;
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		if (key == m_master)
+		{
+			onMasterOrder(order, &commands);
+			masterEvent = true;
+		}
+		else
+		{
+			auto it = m_followers.find(key);
+			if (it == m_followers.end())
+			{
+				return;
+			}
+			onFollowerOrder(&it->second, order, &commands);
+		}
+	}
+
+	if (commands.empty())
+	{
+		return;
+	}
+
+	send(&commands);
+
+	// the commands are in the throttles now, the cmd loops write them later
+	const double queueLatency = std::chrono::duration<double>(clock_t::now() - arrival).count();
+	std::lock_guard<std::mutex> lock(m_mutex);
+	for (const SFollowerCommands& followerCommands : commands)
+	{
+		auto it = m_followers.find(followerCommands.m_key);
+		if (it != m_followers.end())
+		{
+			it->second.m_follower.m_sentCount += followerCommands.m_sentCount;
+			it->second.m_follower.m_failedCount += followerCommands.m_failedCount;
+			dropRefused(&it->second, followerCommands.m_refused);
+		}
+		m_stats.m_commandCount += followerCommands.m_sentCount;
+	}
+
+	// the commands caused by the reports of the followers are late copies,
+	// they don't count into the latency
+	if (masterEvent)
+	{
+		++m_stats.m_eventCount;
+		m_stats.m_lastQueueLatency = queueLatency;
+		m_stats.m_maxQueueLatency = (std::max)(m_stats.m_maxQueueLatency, queueLatency);
+		m_stats.m_totalQueueLatency += queueLatency;
+	}
+}
+
+void KCopyTrader::onCmdResult(const account_key_t& key, const KCommand& command, const bool success)
+{
+	if (success || (command.operation() != KCommand::Open))
+	{
+		return;
+	}
+
+	std::lock_guard<std::mutex> lock(m_mutex);
+	auto it = m_followers.find(key);
+	if (it == m_followers.end())
+	{
+		return;
+	}
+
+	// a rejected copy mustn't bind a later order of the same symbol, type
+	// and lots to its master
+	SFollowerState& state = it->second;
+	auto pendingIt = std::find_if(state.m_pending.begin(), state.m_pending.end(),
+		[&command](const SPendingCopy& pending) { return pending.m_command.get() == &command; });
+	if (pendingIt != state.m_pending.end())
+	{
+		++state.m_follower.m_failedCount;
+		dropPending(&state, pendingIt);
+	}
+}
+
+// ---------------------------------------------------------------------------
+// ICopyTrader
+
+void KCopyTrader::setMaster(const account_key_t& key)
+{
+	std::vector<SOrder> orders;
+	if (key.isValid())
+	{
+		if (HTrader trader = m_tradeManager.getTrader(key))
+		{
+			trader->getOrders().find(SOrderFilter(), &orders);
+		}
+	}
+
+	std::lock_guard<std::mutex> lock(m_mutex);
+	m_master = key;
+	m_followers.erase(key);
+	m_masterOrders.clear();
+	m_ignored.clear();
+	for (const SOrder& order : orders)
+	{
+		m_ignored.insert(order.m_ticket);
+	}
+
+	// the copies of the previous master aren't followed any more
+	for (auto& key2follower : m_followers)
+	{
+		SFollowerState& state = key2follower.second;
+		state.m_pending.clear();
+		state.m_master2copy.clear();
+		state.m_copy2master.clear();
+	}
+}
+
+account_key_t KCopyTrader::getMaster() const
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+	return m_master;
+}
+
+bool KCopyTrader::setFollower(const SCopyFollower& follower, std::string* error)
+{
+	if (follower.m_scale <= 0)
+	{
+		*error = "incorrect scale";
+		return false;
+	}
+
+	HTrader trader = m_tradeManager.getTrader(follower.m_key);
+	if (!trader)
+	{
+		*error = "unknown account " + std::to_string(follower.m_key);
+		return false;
+	}
+
+	std::vector<SOrder> orders;
+	trader->getOrders().find(SOrderFilter(), &orders);
+
+	std::lock_guard<std::mutex> lock(m_mutex);
+	if (follower.m_key == m_master)
+	{
+		*error = "the master can't follow itself";
+		return false;
+	}
+
+	SFollowerState& state = m_followers[follower.m_key];
+	state.m_follower.m_key = follower.m_key;
+	state.m_follower.m_scale = follower.m_scale;
+	state.m_follower.m_symbols = follower.m_symbols;
+	for (const SOrder& order : orders)
+	{
+		state.m_known.insert(order.m_ticket);
+	}
+	return true;
+}
+
+bool KCopyTrader::removeFollower(const account_key_t& key)
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+	const bool result = (m_followers.erase(key) != 0);
+	return result;
+}
+
+void KCopyTrader::getFollowers(std::vector<SCopyFollower>* followers) const
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+	for (const auto& key2follower : m_followers)
+	{
+		followers->push_back(key2follower.second.m_follower);
+	}
+}
+
+SCopyStats KCopyTrader::getStats() const
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+	return m_stats;
+}
+
+// ---------------------------------------------------------------------------
+
+void KCopyTrader::onMasterOrder(const SOrder& order, follower_commands_t* commands)
+{
+	const int32_t ticket = order.m_ticket;
+	if (m_ignored.count(ticket) != 0)
+	{
+		return;
+	}
+
+	auto it = m_masterOrders.find(ticket);
+	if (it == m_masterOrders.end())
+	{
+		if (order.m_status == SOrder::Closed)
+		{
+			return;
+		}
+
+		m_masterOrders.emplace(ticket, order);
+		for (auto& key2follower : m_followers)
+		{
+			if (HCommand command = openCopy(&key2follower.second, order))
+			{
+				SFollowerCommands& followerCommands = getCommands(key2follower.first, commands);
+				followerCommands.m_commands.push_back(command);
+				followerCommands.m_opens.emplace_back(command, ticket);
+			}
+		}
+		return;
+	}
+
+	const SOrder previous = it->second;
+	it->second = order;
+	for (auto& key2follower : m_followers)
+	{
+		const SFollowerState& state = key2follower.second;
+		auto copyIt = state.m_master2copy.find(ticket);
+		if (copyIt != state.m_master2copy.end())
+		{
+			std::vector<HCommand> followerCommands;
+			syncCopy(order, previous, ticket_t(copyIt->second), &followerCommands);
+			if (!followerCommands.empty())
+			{
+				std::vector<HCommand>& target = getCommands(key2follower.first, commands).m_commands;
+				target.insert(target.end(), followerCommands.begin(), followerCommands.end());
+			}
+		}
+	}
+
+	if (order.m_status == SOrder::Closed)
+	{
+		eraseClosedMaster(ticket);
+	}
+}
+
+void KCopyTrader::onFollowerOrder(SFollowerState* state, const SOrder& order, follower_commands_t* commands)
+{
+	const int32_t ticket = order.m_ticket;
+	if (!state->m_known.insert(ticket).second)
+	{
+		if (order.m_status == SOrder::Closed)
+		{
+			auto it = state->m_copy2master.find(ticket);
+			if (it != state->m_copy2master.end())
+			{
+				state->m_master2copy.erase(it->second);
+				state->m_copy2master.erase(it);
+			}
+		}
+		return;
+	}
+
+	if (order.m_status == SOrder::Closed)
+	{
+		return;
+	}
+
+	// a new order of the follower is the copy of the oldest pending one of
+	// the same symbol, type and lots
+	auto pendingIt = std::find_if(state->m_pending.begin(), state->m_pending.end(),
+		[&order](const SPendingCopy& pending)
+		{
+			return (pending.m_symbol == order.m_symbolName)
+				&& (pending.m_type == order.m_type)
+				&& isSameLots(pending.m_lots, order.m_lots.m_value);
+		});
+	if (pendingIt == state->m_pending.end())
+	{
+		return;
+	}
+
+	const int32_t masterTicket = pendingIt->m_master;
+	state->m_pending.erase(pendingIt);
+	state->m_master2copy.emplace(masterTicket, ticket);
+	state->m_copy2master.emplace(ticket, masterTicket);
+
+	// the master may have changed or closed its order meanwhile
+	auto masterIt = m_masterOrders.find(masterTicket);
+	if (masterIt != m_masterOrders.end())
+	{
+		std::vector<HCommand> followerCommands;
+		syncCopy(masterIt->second, order, order.m_ticket, &followerCommands);
+		if (!followerCommands.empty())
+		{
+			getCommands(state->m_follower.m_key, commands).m_commands = followerCommands;
+		}
+		if (masterIt->second.m_status == SOrder::Closed)
+		{
+			eraseClosedMaster(masterTicket);
+		}
+	}
+}
+
+HCommand KCopyTrader::openCopy(SFollowerState* state, const SOrder& master)
+{
+	const SCopyFollower& follower = state->m_follower;
+	const volume_t lots = roundLots(master.m_lots.m_value * follower.m_scale);
+	if (lots < LotStep)
+	{
+		return HCommand();
+	}
+
+	auto symbolIt = follower.m_symbols.find(master.m_symbolName);
+	const std::string symbol = (symbolIt != follower.m_symbols.end()) ? symbolIt->second : std::string(master.m_symbolName);
+
+	// a market order is sent at the last quote of the follower, if it has
+	// none yet at the price of the master
+	price_t price = master.m_openPrice.m_value;
+	const bool market = (master.m_type == SOrder::Buy) || (master.m_type == SOrder::Sell);
+	if (market)
+	{
+		STickSeries series;
+		HTrader trader = m_tradeManager.getTrader(follower.m_key);
+		if (trader && trader->getTickStore().getLastTicks(symbol, 1, &series))
+		{
+			price = (master.m_type == SOrder::Buy) ? series.m_asks.back() : series.m_bids.back();
+		}
+	}
+
+	const SNewOrder newOrder(
+		symbol,
+		master.m_type,
+		lots,
+		price,
+		master.m_stopLoss,
+		master.m_takeProfit,
+		master.m_expirationTime);
+	HCommand result = std::make_shared<KCmdOpen>(newOrder);
+	state->m_pending.push_back(SPendingCopy{ master.m_ticket, symbol, master.m_type, lots, result });
+	return result;
+}
+
+void KCopyTrader::syncCopy(const SOrder& master, const SOrder& previous, const ticket_t copy, std::vector<HCommand>* commands) const
+{
+	const tickets_t tickets(1, copy);
+	if (master.m_status == SOrder::Closed)
+	{
+		// it deletes a pending order too
+		commands->push_back(std::make_shared<KCmdClose>(tickets));
+		return;
+	}
+
+	if (master.m_status == SOrder::Pending)
+	{
+		const bool changed = (master.m_openPrice.m_value != previous.m_openPrice.m_value)
+			|| (master.m_stopLoss.m_value != previous.m_stopLoss.m_value)
+			|| (master.m_takeProfit.m_value != previous.m_takeProfit.m_value)
+			|| (master.m_expirationTime.m_value != previous.m_expirationTime.m_value);
+		if (changed)
+		{
+			const SModifyOrder modifyOrder(master.m_openPrice, master.m_stopLoss, master.m_takeProfit, master.m_expirationTime);
+			commands->push_back(std::make_shared<KCmdModify>(modifyOrder, tickets));
+		}
+		return;
+	}
+
+	if (master.m_stopLoss.m_value != previous.m_stopLoss.m_value)
+	{
+		commands->push_back(std::make_shared<KCmdSetStopLoss>(master.m_stopLoss, tickets));
+	}
+	if (master.m_takeProfit.m_value != previous.m_takeProfit.m_value)
+	{
+		commands->push_back(std::make_shared<KCmdSetTakeProfit>(master.m_takeProfit, tickets));
+	}
+}
+
+void KCopyTrader::eraseClosedMaster(const int32_t ticket)
+{
+	for (const auto& key2follower : m_followers)
+	{
+		const pending_copies_t& pending = key2follower.second.m_pending;
+		const bool waiting = std::any_of(pending.begin(), pending.end(),
+			[ticket](const SPendingCopy& copy) { return copy.m_master == ticket; });
+		if (waiting)
+		{
+			return;
+		}
+	}
+	m_masterOrders.erase(ticket);
+}
+
+void KCopyTrader::dropRefused(SFollowerState* state, const std::vector<int32_t>& refused)
+{
+	for (const int32_t masterTicket : refused)
+	{
+		auto it = std::find_if(state->m_pending.begin(), state->m_pending.end(),
+			[masterTicket](const SPendingCopy& pending) { return pending.m_master == masterTicket; });
+		if (it != state->m_pending.end())
+		{
+			dropPending(state, it);
+		}
+	}
+}
+
+void KCopyTrader::dropPending(SFollowerState* state, pending_copies_t::iterator pendingIt)
+{
+	const int32_t masterTicket = pendingIt->m_master;
+	state->m_pending.erase(pendingIt);
+
+	// the closed master waited only for its copies
+	auto masterIt = m_masterOrders.find(masterTicket);
+	if ((masterIt != m_masterOrders.end()) && (masterIt->second.m_status == SOrder::Closed))
+	{
+		eraseClosedMaster(masterTicket);
+	}
+}
+
+SFollowerCommands& KCopyTrader::getCommands(const account_key_t& key, follower_commands_t* commands) const
+{
+	auto it = std::find_if(commands->begin(), commands->end(),
+		[&key](const SFollowerCommands& followerCommands) { return followerCommands.m_key == key; });
+	if (it == commands->end())
+	{
+		commands->push_back(SFollowerCommands());
+		commands->back().m_key = key;
+		return commands->back();
+	}
+	return *it;
+}
+
+void KCopyTrader::send(follower_commands_t* commands)
+{
+	auto sendFollower = [this, commands](const std::size_t index, const unsigned int /*worker*/)
+	{
+		SFollowerCommands& followerCommands = (*commands)[index];
+		HTrader trader = m_tradeManager.getTrader(followerCommands.m_key);
+		if (!trader)
+		{
+			followerCommands.m_failedCount += followerCommands.m_commands.size();
+			return;
+		}
+
+		for (HCommand command : followerCommands.m_commands)
+		{
+			try
+			{
+				trader->executeCommand(command);
+				++followerCommands.m_sentCount;
+			}
+			catch (const std::exception& e)
+			{
+				m_cerr << "copy to account " << followerCommands.m_key << ": " << e.what() << std::endl;
+				++followerCommands.m_failedCount;
+				for (const auto& open : followerCommands.m_opens)
+				{
+					if (open.first == command)
+					{
+						followerCommands.m_refused.push_back(open.second);
+					}
+				}
+			}
+		}
+	};
+
+	// a single follower doesn't need to wake the pool
+	if (commands->size() == 1)
+	{
+		sendFollower(0, 0);
+		return;
+	}
+
+	std::lock_guard<std::mutex> lock(m_sendMutex);
+	m_pool.run(commands->size(), sendFollower);
+}
+
+} // anonymous namespace
+
+// ---------------------------------------------------------------------------
+
+ICopyTrader* createCopyTrader(
+	ITradeManager* tradeManager,
+	std::ostream* cerr,
+	const unsigned int workerCount)
+{
+	ICopyTrader* copyTrader = new KCopyTrader(tradeManager, cerr, workerCount);
+	return copyTrader;
+}
+
+} // namespace fx
@@ -0,0 +1,21 @@
+// author: Darek Slusarczyk alias marines marinesovitch 2012-2013, 2022
+#ifndef INC_BACKEND_COPYTRADERIMPL_H
+#define INC_BACKEND_COPYTRADERIMPL_H
+
+namespace fx
+{
+
+struct ICopyTrader;
+struct ITradeManager;
+
+// the followers' commands are sent by a pool of the given count of workers
+const unsigned int DefaultCopyWorkerCount = 4;
+
+ICopyTrader* createCopyTrader(
+	ITradeManager* tradeManager,
+	std::ostream* cerr,
+	const unsigned int workerCount = DefaultCopyWorkerCount);
+
+} // namespace fx
+
+#endif
@@ -0,0 +1,26 @@
+// author: Darek Slusarczyk alias marines marinesovitch 2012-2013, 2022
+#include "ph.h"
+#include "equityTracker.h"
+
+namespace fx
+{
+
+void SEquityStats::print(std::ostream& os) const
+{
+	os << "equity " << m_current.m_equity
+		<< ", realized " << m_current.m_realizedProfit
+		<< ", unrealized " << m_current.m_unrealizedProfit
+		<< ", open " << m_current.m_openCount << '\n';
+	os << "peak " << m_current.m_peakEquity
+		<< ", drawdown " << m_current.m_drawdown
+		<< ", max drawdown " << m_maxDrawdown << " at " << m_maxDrawdownTime << '\n';
+	os << m_updateCount << " updates, " << m_snapshotCount << " snapshots" << std::endl;
+}
+
+// ---------------------------------------------------------------------------
+
+IEquityTracker::~IEquityTracker()
+{
+}
+
+} // namespace fx
@@ -0,0 +1,143 @@
+// author: Darek Slusarczyk alias marines marinesovitch 2012-2013, 2022
+#include "ph.h"
+#include "equityTrackerImpl.h"
+#include "equityTracker.h"
+#include "common/position.h"
+
+namespace fx
+{
+
+namespace
+{
+
+class KEquityTracker : public IEquityTracker
+{
+	public:
+		KEquityTracker(const datetime_t interval, const std::size_t historyCapacity);
+
+	public:
+		// IEquityTracker
+		virtual void onTick(const datetime_t time, const SAccountPosition& account);
+		virtual void onOrder(const SAccountPosition& account);
+
+		virtual SEquityStats getStats() const;
+		virtual std::size_t getHistory(const std::size_t count, std::vector<SEquitySnapshot>* history) const;
+
+	private:
+		// must be called with locked m_mutex
+		void update(const SAccountPosition& account);
+		void addSnapshot();
+
+	private:
+		const datetime_t m_interval;
+
+		mutable std::mutex m_mutex;
+
+		SEquityStats m_stats;
+		bool m_started = false;
+		uint64_t m_version = 0;
+		datetime_t m_nextSnapshotTime = std::numeric_limits<datetime_t>::min();
+
+		// a ring, m_snapshotCount of the stats tells where the next one goes
+		std::vector<SEquitySnapshot> m_history;
+
+};
+
+// ---------------------------------------------------------------------------
+
+KEquityTracker::KEquityTracker(const datetime_t interval, const std::size_t historyCapacity)
+	: m_interval(std::max<datetime_t>(interval, 1))
+	, m_history(std::max<std::size_t>(historyCapacity, 1))
+{
+}
+
+// ---------------------------------------------------------------------------
+// IEquityTracker
+
+void KEquityTracker::onTick(const datetime_t time, const SAccountPosition& account)
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+	m_stats.m_current.m_time = std::max(m_stats.m_current.m_time, time);
+	update(account);
+}
+
+void KEquityTracker::onOrder(const SAccountPosition& account)
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+	update(account);
+}
+
+SEquityStats KEquityTracker::getStats() const
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+	return m_stats;
+}
+
+std::size_t KEquityTracker::getHistory(const std::size_t count, std::vector<SEquitySnapshot>* history) const
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+	const uint64_t end = m_stats.m_snapshotCount;
+	const uint64_t available = std::min<uint64_t>(end, m_history.size());
+	const std::size_t result = static_cast<std::size_t>(std::min<uint64_t>(count, available));
+	history->reserve(history->size() + result);
+	for (uint64_t i = end - result; i < end; ++i)
+	{
+		history->push_back(m_history[i % m_history.size()]);
+	}
+	return result;
+}
+
+// ---------------------------------------------------------------------------
+
+void KEquityTracker::update(const SAccountPosition& account)
+{
+	if (m_started && (account.m_version <= m_version))
+	{
+		// the other loop has already passed a newer state
+		return;
+	}
+	m_version = account.m_version;
+
+	SEquitySnapshot& current = m_stats.m_current;
+	current.m_realizedProfit = account.m_realizedProfit;
+	current.m_unrealizedProfit = account.m_unrealizedProfit;
+	current.m_equity = account.m_realizedProfit + account.m_unrealizedProfit;
+	current.m_openCount = account.m_openCount;
+	if (!m_started || (current.m_peakEquity < current.m_equity))
+	{
+		current.m_peakEquity = current.m_equity;
+	}
+	current.m_drawdown = current.m_peakEquity - current.m_equity;
+	if (m_stats.m_maxDrawdown < current.m_drawdown)
+	{
+		m_stats.m_maxDrawdown = current.m_drawdown;
+		m_stats.m_maxDrawdownTime = current.m_time;
+	}
+	m_started = true;
+	++m_stats.m_updateCount;
+
+	if (m_nextSnapshotTime <= current.m_time)
+	{
+		addSnapshot();
+	}
+}
+
+void KEquityTracker::addSnapshot()
+{
+	const SEquitySnapshot& current = m_stats.m_current;
+	m_history[m_stats.m_snapshotCount % m_history.size()] = current;
+	++m_stats.m_snapshotCount;
+	m_nextSnapshotTime = (current.m_time / m_interval + 1) * m_interval;
+}
+
+} // anonymous namespace
+
+// ---------------------------------------------------------------------------
+
+IEquityTracker* createEquityTracker(const datetime_t interval, const std::size_t historyCapacity)
+{
+	IEquityTracker* tracker = new KEquityTracker(interval, historyCapacity);
+	return tracker;
+}
+
+} // namespace fx
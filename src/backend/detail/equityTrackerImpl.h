@@ -0,0 +1,23 @@
+// author: Darek Slusarczyk alias marines marinesovitch 2012-2013, 2022
+#ifndef INC_BACKEND_EQUITYTRACKERIMPL_H
+#define INC_BACKEND_EQUITYTRACKERIMPL_H
+
+#include "common/baseTypes.h"
+
+namespace fx
+{
+
+struct IEquityTracker;
+
+// in seconds of tick time
+const datetime_t DefaultEquityInterval = 10;
+// a day of snapshots
+const std::size_t DefaultEquityHistoryCapacity = 24 * 60 * 60 / DefaultEquityInterval;
+
+IEquityTracker* createEquityTracker(
+	const datetime_t interval = DefaultEquityInterval,
+	const std::size_t historyCapacity = DefaultEquityHistoryCapacity);
+
+} // namespace fx
+
+#endif
@@ -0,0 +1,59 @@
+// author: Darek Slusarczyk alias marines marinesovitch 2012-2013, 2022
+#include "ph.h"
+#include "executionAlgos.h"
+
+namespace fx
+{
+
+namespace
+{
+
+const char* state2str(const SAlgoReport::EState state)
+{
+	switch (state)
+	{
+		case SAlgoReport::Running:
+			return "running";
+
+		case SAlgoReport::Done:
+			return "done";
+
+		default:
+			return "cancelled";
+	}
+}
+
+} // anonymous namespace
+
+// ---------------------------------------------------------------------------
+
+void SAlgoReport::print(std::ostream& os) const
+{
+	const SNewOrder& order = m_params.m_order;
+	os << m_id << ' ' << (m_params.m_kind == SAlgoParams::Twap ? "twap" : "vwap")
+		<< ' ' << state2str(m_state) << ' ' << order.m_symbolName
+		<< ' ' << SOrder::type2str(order.m_type) << ' ' << order.m_lots.m_value
+		<< ", slices " << m_sliceIndex << '/' << m_params.m_sliceCount
+		<< ", sent " << m_sentLots << " in " << m_childCount
+		<< ", filled " << m_filledLots << " in " << m_filledCount
+		<< " at " << m_averagePrice
+		<< ", failed " << m_failedCount
+		<< ", " << m_seconds << "s" << std::endl;
+	if (!m_tickets.empty())
+	{
+		os << "orders";
+		for (const ticket_t ticket : m_tickets)
+		{
+			os << ' ' << ticket;
+		}
+		os << std::endl;
+	}
+}
+
+// ---------------------------------------------------------------------------
+
+IExecutionAlgos::~IExecutionAlgos()
+{
+}
+
+} // namespace fx
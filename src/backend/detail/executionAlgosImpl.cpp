@@ -0,0 +1,509 @@
+// author: Darek Slusarczyk alias marines marinesovitch 2012-2013, 2022
+#include "ph.h"
+#include "executionAlgosImpl.h"
+#include "executionAlgos.h"
+#include "strategyHost.h"
+#include "common/command.h"
+#include "common/types.h"
+#include "cpp/timerWheel.h"
+#include <chrono>
+#include <cmath>
+#include <string_view>
+#include <unordered_set>
+
+namespace fx
+{
+
+namespace
+{
+
+typedef cpp::KTimerWheel::clock_t clock_t;
+
+// a turn of the wheel is a minute, the longer slices wait for more turns
+const clock_t::duration TimerResolution = std::chrono::milliseconds(100);
+const std::size_t TimerSlotCount = 600;
+
+// the children are rounded down to the step, the rest goes with the last one
+const volume_t LotStep = 0.01;
+
+// a slice due before the first quote of the symbol is retried after
+const clock_t::duration NoQuoteRetry = std::chrono::seconds(1);
+
+volume_t floorLots(const volume_t lots)
+{
+	const volume_t result = std::floor(lots / LotStep + 1e-6) * LotStep;
+	return result;
+}
+
+volume_t roundLots(const volume_t lots)
+{
+	const volume_t result = std::round(lots / LotStep) * LotStep;
+	return result;
+}
+
+bool isSameLots(const volume_t lhs, const volume_t rhs)
+{
+	const bool result = std::fabs(lhs - rhs) < (LotStep / 2);
+	return result;
+}
+
+// ---------------------------------------------------------------------------
+
+// a child sent, but not reported by MetaTrader yet
+struct SChild
+{
+	volume_t m_lots;
+	// of the last tick before it was sent, its order is not older
+	datetime_t m_time;
+	// kept to recognize its result
+	HCommand m_command;
+};
+
+struct SAlgo
+{
+	SAlgoReport m_report;
+	clock_t::time_point m_start;
+	clock_t::duration m_interval;
+	// 0 if no slice is scheduled
+	cpp::KTimerWheel::timer_id_t m_timer = 0;
+
+	// the last quote of the symbol and the ticks counted for VWAP
+	price_t m_bid = 0;
+	price_t m_ask = 0;
+	datetime_t m_time = 0;
+	uint64_t m_sliceTicks = 0;
+	uint64_t m_totalTicks = 0;
+
+	std::vector<SChild> m_pending;
+};
+
+// a child prepared under the lock and sent after it
+struct SChildCommand
+{
+	uint32_t m_id;
+	HCommand m_command;
+};
+
+// ---------------------------------------------------------------------------
+
+class KExecutionAlgos : public IExecutionAlgos
+{
+	public:
+		KExecutionAlgos(IStrategyHost* host, std::ostream* cerr);
+		virtual ~KExecutionAlgos();
+
+	public:
+		// IExecutionAlgos
+		virtual uint32_t start(const SAlgoParams& params, std::string* error);
+		virtual bool cancel(const uint32_t id);
+		virtual void getReports(std::vector<SAlgoReport>* reports) const;
+
+		virtual void onTick(const STick& tick);
+		virtual void onOrder(const SOrder& order);
+		virtual void onCmdResult(const KCommand& command, const bool success);
+
+	private:
+		void timerLoop();
+
+		// must be called with locked m_mutex
+		void slice(SAlgo* algo, std::vector<SChildCommand>* commands);
+		volume_t getSliceLots(const SAlgo& algo, const clock_t::time_point now) const;
+		void onFailed(const uint32_t id, const KCommand& command);
+		void removeFromSymbol(const SAlgo& algo);
+		void finishIfDone(SAlgo* algo);
+
+	private:
+		IStrategyHost& m_host;
+		std::ostream& m_cerr;
+
+		mutable std::mutex m_mutex;
+		std::condition_variable m_onChange;
+		bool m_stop = false;
+
+		cpp::KTimerWheel m_wheel;
+		uint32_t m_nextId = 1;
+		std::map<uint32_t, SAlgo> m_id2algo;
+		// the algos which still send children get the ticks of their symbol
+		std::map<std::string, std::vector<uint32_t>, std::less<>> m_symbol2algos;
+		// the orders already taken for children
+		std::unordered_set<int32_t> m_tickets;
+		std::size_t m_pendingCount = 0;
+
+		std::thread m_thread;
+
+};
+
+// ---------------------------------------------------------------------------
+
+KExecutionAlgos::KExecutionAlgos(IStrategyHost* host, std::ostream* cerr)
+	: m_host(*host)
+	, m_cerr(*cerr)
+	, m_wheel(TimerResolution, TimerSlotCount)
+{
+	m_thread = std::thread(&KExecutionAlgos::timerLoop, this);
+}
+
+KExecutionAlgos::~KExecutionAlgos()
+{
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		m_stop = true;
+	}
+	m_onChange.notify_all();
+	m_thread.join();
+}
+
+// ---------------------------------------------------------------------------
+// IExecutionAlgos
+
+uint32_t KExecutionAlgos::start(const SAlgoParams& params, std::string* error)
+{
+	const SNewOrder& order = params.m_order;
+	if ((order.m_type != SOrder::Buy) && (order.m_type != SOrder::Sell))
+	{
+		*error = "the parent order has to be a buy or sell";
+		return 0;
+	}
+
+	if (order.m_lots.m_value < LotStep)
+	{
+		*error = "incorrect lots of the parent order";
+		return 0;
+	}
+
+	if ((params.m_duration <= 0) || (params.m_sliceCount == 0))
+	{
+		*error = "incorrect duration or count of slices";
+		return 0;
+	}
+
+	const clock_t::time_point now = clock_t::now();
+	std::lock_guard<std::mutex> lock(m_mutex);
+	const uint32_t id = m_nextId++;
+	SAlgo& algo = m_id2algo[id];
+	algo.m_report.m_id = id;
+	algo.m_report.m_params = params;
+	algo.m_report.m_params.m_order.m_lots = roundLots(order.m_lots.m_value);
+	algo.m_start = now;
+	algo.m_interval = std::chrono::duration_cast<clock_t::duration>(std::chrono::seconds(params.m_duration)) / params.m_sliceCount;
+	algo.m_timer = m_wheel.schedule(now + algo.m_interval, id);
+	m_symbol2algos[order.m_symbolName].push_back(id);
+	m_onChange.notify_one();
+	return id;
+}
+
+bool KExecutionAlgos::cancel(const uint32_t id)
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+	auto it = m_id2algo.find(id);
+	if ((it == m_id2algo.end()) || (it->second.m_report.m_state != SAlgoReport::Running))
+	{
+		return false;
+	}
+
+	SAlgo& algo = it->second;
+	if (algo.m_timer != 0)
+	{
+		m_wheel.cancel(algo.m_timer);
+		algo.m_timer = 0;
+		removeFromSymbol(algo);
+	}
+	algo.m_report.m_state = SAlgoReport::Cancelled;
+	algo.m_report.m_seconds = std::chrono::duration<double>(clock_t::now() - algo.m_start).count();
+	return true;
+}
+
+void KExecutionAlgos::getReports(std::vector<SAlgoReport>* reports) const
+{
+	const clock_t::time_point now = clock_t::now();
+	std::lock_guard<std::mutex> lock(m_mutex);
+	for (const auto& id2algo : m_id2algo)
+	{
+		const SAlgo& algo = id2algo.second;
+		reports->push_back(algo.m_report);
+		if (algo.m_report.m_state == SAlgoReport::Running)
+		{
+			reports->back().m_seconds = std::chrono::duration<double>(now - algo.m_start).count();
+		}
+	}
+}
+
+void KExecutionAlgos::onTick(const STick& tick)
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+	auto it = m_symbol2algos.find(std::string_view(tick.m_symbolName));
+	if (it == m_symbol2algos.end())
+	{
+		return;
+	}
+
+	for (const uint32_t id : it->second)
+	{
+		SAlgo& algo = m_id2algo.find(id)->second;
+		algo.m_bid = tick.m_bid.m_value;
+		algo.m_ask = tick.m_ask.m_value;
+		algo.m_time = tick.m_time.m_value;
+		++algo.m_sliceTicks;
+		++algo.m_totalTicks;
+	}
+}
+
+void KExecutionAlgos::onOrder(const SOrder& order)
+{
+	if ((order.m_status != SOrder::Open) || ((order.m_type != SOrder::Buy) && (order.m_type != SOrder::Sell)))
+	{
+		return;
+	}
+
+	std::lock_guard<std::mutex> lock(m_mutex);
+	if ((m_pendingCount == 0) || (m_tickets.count(order.m_ticket) != 0))
+	{
+		return;
+	}
+
+	// the oldest child of the same symbol, type and lots takes the order
+	for (auto& id2algo : m_id2algo)
+	{
+		SAlgo& algo = id2algo.second;
+		const SNewOrder& parent = algo.m_report.m_params.m_order;
+		if (algo.m_pending.empty() || (parent.m_type != order.m_type) || (parent.m_symbolName != order.m_symbolName))
+		{
+			continue;
+		}
+
+		auto childIt = std::find_if(algo.m_pending.begin(), algo.m_pending.end(),
+			[&order](const SChild& child)
+			{
+				return isSameLots(child.m_lots, order.m_lots.m_value) && (child.m_time <= order.m_openTime.m_value);
+			});
+		if (childIt == algo.m_pending.end())
+		{
+			continue;
+		}
+
+		algo.m_pending.erase(childIt);
+		--m_pendingCount;
+		m_tickets.insert(order.m_ticket);
+
+		SAlgoReport& report = algo.m_report;
+		const volume_t lots = order.m_lots.m_value;
+		report.m_averagePrice = (report.m_averagePrice * report.m_filledLots + order.m_openPrice.m_value * lots) / (report.m_filledLots + lots);
+		report.m_filledLots += lots;
+		++report.m_filledCount;
+		report.m_tickets.push_back(order.m_ticket);
+		std::cout << "algo " << report.m_id << ": filled " << report.m_filledLots
+			<< " of " << report.m_params.m_order.m_lots.m_value
+			<< " at " << report.m_averagePrice << ", order " << order.m_ticket << std::endl;
+		finishIfDone(&algo);
+		return;
+	}
+}
+
+void KExecutionAlgos::onCmdResult(const KCommand& command, const bool success)
+{
+	if (success || (command.operation() != KCommand::Open))
+	{
+		// the executed child is taken by its order
+		return;
+	}
+
+	std::lock_guard<std::mutex> lock(m_mutex);
+	if (m_pendingCount == 0)
+	{
+		return;
+	}
+
+	for (auto& id2algo : m_id2algo)
+	{
+		const std::vector<SChild>& pending = id2algo.second.m_pending;
+		const bool found = std::any_of(pending.begin(), pending.end(),
+			[&command](const SChild& child) { return child.m_command.get() == &command; });
+		if (found)
+		{
+			m_cerr << "algo " << id2algo.first << ": the child was rejected" << std::endl;
+			onFailed(id2algo.first, command);
+			return;
+		}
+	}
+}
+
+// ---------------------------------------------------------------------------
+
+void KExecutionAlgos::timerLoop()
+{
+	std::vector<uint64_t> expired;
+	std::vector<SChildCommand> commands;
+	std::unique_lock<std::mutex> lock(m_mutex);
+	while (!m_stop)
+	{
+		if (m_wheel.empty())
+		{
+			m_onChange.wait(lock);
+			continue;
+		}
+
+		m_onChange.wait_for(lock, m_wheel.resolution());
+		expired.clear();
+		m_wheel.advance(clock_t::now(), &expired);
+		for (const uint64_t id : expired)
+		{
+			auto it = m_id2algo.find(static_cast<uint32_t>(id));
+			if (it != m_id2algo.end())
+			{
+				slice(&it->second, &commands);
+			}
+		}
+
+		if (commands.empty())
+		{
+			continue;
+		}
+
+		// the children are sent without the lock, like the commands of the
+		// strategies they may be refused by the risk limits
+		lock.unlock();
+		std::vector<SChildCommand> failed;
+		for (const SChildCommand& command : commands)
+		{
+			try
+			{
+				m_host.executeCommand(command.m_command);
+			}
+			catch (const std::exception& e)
+			{
+				m_cerr << "algo " << command.m_id << ": " << e.what() << std::endl;
+				failed.push_back(command);
+			}
+		}
+		commands.clear();
+		lock.lock();
+
+		for (const SChildCommand& command : failed)
+		{
+			onFailed(command.m_id, *command.m_command);
+		}
+	}
+}
+
+void KExecutionAlgos::slice(SAlgo* algo, std::vector<SChildCommand>* commands)
+{
+	algo->m_timer = 0;
+	SAlgoReport& report = algo->m_report;
+	const clock_t::time_point now = clock_t::now();
+	if ((algo->m_bid == 0) || (algo->m_ask == 0))
+	{
+		algo->m_timer = m_wheel.schedule(now + NoQuoteRetry, report.m_id);
+		return;
+	}
+
+	const volume_t lots = getSliceLots(*algo, now);
+	++report.m_sliceIndex;
+	algo->m_sliceTicks = 0;
+	if (lots >= LotStep)
+	{
+		SNewOrder child = report.m_params.m_order;
+		child.m_lots = lots;
+		child.m_openPrice = (child.m_type == SOrder::Buy) ? algo->m_ask : algo->m_bid;
+		HCommand command = std::make_shared<KCmdOpen>(child);
+		commands->push_back(SChildCommand{ report.m_id, command });
+		algo->m_pending.push_back(SChild{ lots, algo->m_time, command });
+		++m_pendingCount;
+		report.m_sentLots += lots;
+		++report.m_childCount;
+	}
+
+	if (report.m_sliceIndex < report.m_params.m_sliceCount)
+	{
+		const clock_t::time_point due = algo->m_start + algo->m_interval * (report.m_sliceIndex + 1);
+		algo->m_timer = m_wheel.schedule(due, report.m_id);
+	}
+	else
+	{
+		removeFromSymbol(*algo);
+		finishIfDone(algo);
+	}
+}
+
+volume_t KExecutionAlgos::getSliceLots(const SAlgo& algo, const clock_t::time_point now) const
+{
+	const SAlgoReport& report = algo.m_report;
+	const volume_t remaining = report.m_params.m_order.m_lots.m_value - report.m_sentLots;
+	const std::size_t slicesLeft = report.m_params.m_sliceCount - report.m_sliceIndex;
+	if (slicesLeft == 1)
+	{
+		return roundLots(remaining);
+	}
+
+	if (report.m_params.m_kind == SAlgoParams::Twap)
+	{
+		return floorLots(remaining / slicesLeft);
+	}
+
+	// the share of the ticks of this slice in the ticks expected until the
+	// end at the rate observed so far
+	const double elapsed = std::chrono::duration<double>(now - algo.m_start).count();
+	const double timeLeft = std::chrono::duration<double>(algo.m_interval * (slicesLeft - 1)).count();
+	const double rate = (elapsed > 0) ? (algo.m_totalTicks / elapsed) : 0;
+	const double expected = algo.m_sliceTicks + rate * timeLeft;
+	const volume_t result = (expected > 0) ? floorLots(remaining * algo.m_sliceTicks / expected) : 0;
+	return result;
+}
+
+void KExecutionAlgos::onFailed(const uint32_t id, const KCommand& command)
+{
+	SAlgo& algo = m_id2algo.find(id)->second;
+	auto childIt = std::find_if(algo.m_pending.begin(), algo.m_pending.end(),
+		[&command](const SChild& child) { return child.m_command.get() == &command; });
+	if (childIt == algo.m_pending.end())
+	{
+		// already taken by an order
+		return;
+	}
+
+	SAlgoReport& report = algo.m_report;
+	report.m_sentLots -= childIt->m_lots;
+	++report.m_failedCount;
+	algo.m_pending.erase(childIt);
+	--m_pendingCount;
+	finishIfDone(&algo);
+}
+
+void KExecutionAlgos::removeFromSymbol(const SAlgo& algo)
+{
+	auto it = m_symbol2algos.find(algo.m_report.m_params.m_order.m_symbolName);
+	std::vector<uint32_t>& ids = it->second;
+	ids.erase(std::find(ids.begin(), ids.end(), algo.m_report.m_id));
+	if (ids.empty())
+	{
+		m_symbol2algos.erase(it);
+	}
+}
+
+void KExecutionAlgos::finishIfDone(SAlgo* algo)
+{
+	SAlgoReport& report = algo->m_report;
+	const bool done = (report.m_state == SAlgoReport::Running)
+		&& (report.m_sliceIndex == report.m_params.m_sliceCount)
+		&& algo->m_pending.empty();
+	if (done)
+	{
+		report.m_state = SAlgoReport::Done;
+		report.m_seconds = std::chrono::duration<double>(clock_t::now() - algo->m_start).count();
+		std::ostringstream os;
+		os << "algo ";
+		report.print(os);
+		std::cout << os.str() << std::flush;
+	}
+}
+
+} // anonymous namespace
+
+// ---------------------------------------------------------------------------
+
+IExecutionAlgos* createExecutionAlgos(IStrategyHost* host, std::ostream* cerr)
+{
+	IExecutionAlgos* executionAlgos = new KExecutionAlgos(host, cerr);
+	return executionAlgos;
+}
+
+} // namespace fx
@@ -0,0 +1,15 @@
+// author: Darek Slusarczyk alias marines marinesovitch 2012-2013, 2022
+#ifndef INC_BACKEND_EXECUTIONALGOSIMPL_H
+#define INC_BACKEND_EXECUTIONALGOSIMPL_H
+
+namespace fx
+{
+
+struct IExecutionAlgos;
+struct IStrategyHost;
+
+IExecutionAlgos* createExecutionAlgos(IStrategyHost* host, std::ostream* cerr);
+
+} // namespace fx
+
+#endif
@@ -0,0 +1,12 @@
+// author: Darek Slusarczyk alias marines marinesovitch 2012-2013, 2022
+#include "ph.h"
+#include "executionSimulator.h"
+
+namespace fx
+{
+
+IExecutionSimulator::~IExecutionSimulator()
+{
+}
+
+} // namespace fx
@@ -0,0 +1,678 @@
+// author: Darek Slusarczyk alias marines marinesovitch 2012-2013, 2022
+#include "ph.h"
+#include "executionSimulatorImpl.h"
+#include "executionSimulator.h"
+#include "common/command.h"
+#include "common/consts.h"
+#include "common/order.h"
+#include "common/types.h"
+#include <deque>
+#include <string_view>
+
+namespace fx
+{
+
+namespace
+{
+
+bool isBuy(const SOrder::EType type)
+{
+	const bool result = (type == SOrder::Buy) || (type == SOrder::BuyLimit) || (type == SOrder::BuyStop);
+	return result;
+}
+
+// the stops have to be on the proper side of the reference price, the empty
+// ones are not checked
+bool areStopsValid(const SOrder::EType type, const price_t price, const SPrice& stopLoss, const SPrice& takeProfit)
+{
+	bool result = true;
+	if (isBuy(type))
+	{
+		result = (stopLoss.isNull() || (stopLoss.m_value < price))
+			&& (takeProfit.isNull() || (price < takeProfit.m_value));
+	}
+	else
+	{
+		result = (stopLoss.isNull() || (price < stopLoss.m_value))
+			&& (takeProfit.isNull() || (takeProfit.m_value < price));
+	}
+	return result;
+}
+
+price_t parsePriceArg(const cpp::strings_t& args, const std::size_t index)
+{
+	const price_t result = (index < args.size()) ? std::stod(args[index]) : 0.0;
+	return result;
+}
+
+// ---------------------------------------------------------------------------
+
+class KExecutionSimulator : public IExecutionSimulator
+{
+	public:
+		KExecutionSimulator(const SExecutionParams& params, IExecutionSink* sink);
+		virtual ~KExecutionSimulator();
+
+	public:
+		// IExecutionSimulator
+		virtual void sendCommand(HCommand command);
+		virtual void onTick(const STick& tick);
+
+		virtual volume_t getBalance() const;
+		virtual volume_t getEquity() const;
+		virtual std::size_t getOrderCount() const;
+
+	private:
+		typedef std::map<ticket_t, SOrder> orders_t;
+
+		// the last tick of a symbol and its orders, so a tick visits only
+		// the orders of its symbol without looking them up
+		struct SSymbol
+		{
+			STick m_tick;
+			std::vector<orders_t::iterator> m_orders;
+		};
+
+		typedef std::map<std::string, SSymbol, std::less<>> symbols_t;
+
+		struct SQueuedCommand
+		{
+			datetime_t m_dueTime;
+			HCommand m_command;
+		};
+
+		void executeCommand(HCommand command);
+		void dispatchCommand(const KCommand& command);
+		void openOrder(const KCommand& command);
+		void closeOrders(const KCommand& command);
+		void closeAllOrders();
+		void modifyOrders(const KCommand& command);
+		void setStops(const KCommand& command);
+		void getOrders(const KCommand& command);
+
+		void processOrders(SSymbol* symbol);
+		bool fillPendingOrder(SOrder* order, const STick& tick);
+		bool hitStops(const SOrder& order, const STick& tick, price_t* closePrice) const;
+		void closeOrder(orders_t::iterator it, const price_t closePrice);
+		void unlinkOrder(orders_t::iterator it);
+
+		SSymbol* findSymbol(const std::string_view& symbol);
+		const STick* findTick(const std::string_view& symbol) const;
+		price_t closePrice(const SOrder& order, const STick& tick) const;
+		volume_t calcProfit(const SOrder& order, const price_t closePrice) const;
+		void reject(const KCommand& command, const std::string& reason);
+
+	private:
+		const SExecutionParams m_params;
+		IExecutionSink& m_sink;
+
+		std::deque<SQueuedCommand> m_commands;
+		orders_t m_orders;
+		symbols_t m_symbols;
+		int32_t m_nextTicket = 1;
+		datetime_t m_time = 0;
+		volume_t m_balance = 0;
+		// the rejections of the executed command
+		std::string m_cmdResult;
+
+};
+
+// ---------------------------------------------------------------------------
+
+KExecutionSimulator::KExecutionSimulator(const SExecutionParams& params, IExecutionSink* sink)
+	: m_params(params)
+	, m_sink(*sink)
+{
+}
+
+KExecutionSimulator::~KExecutionSimulator()
+{
+}
+
+// ---------------------------------------------------------------------------
+// IExecutionSimulator
+
+void KExecutionSimulator::sendCommand(HCommand command)
+{
+	m_commands.push_back({ m_time + m_params.m_latency, command });
+}
+
+void KExecutionSimulator::onTick(const STick& rawTick)
+{
+	auto it = m_symbols.find(std::string_view(rawTick.m_symbolName));
+	if (it == m_symbols.end())
+	{
+		it = m_symbols.emplace(rawTick.m_symbolName, SSymbol()).first;
+	}
+
+	SSymbol& symbol = it->second;
+	STick& tick = symbol.m_tick;
+	tick = rawTick;
+	tick.m_ask.m_value = std::max(tick.m_ask.m_value, tick.m_bid.m_value + m_params.m_spread);
+	m_time = tick.m_time.m_value;
+
+	while (!m_commands.empty() && (m_commands.front().m_dueTime <= m_time))
+	{
+		HCommand command = m_commands.front().m_command;
+		m_commands.pop_front();
+		executeCommand(command);
+	}
+
+	processOrders(&symbol);
+}
+
+volume_t KExecutionSimulator::getBalance() const
+{
+	return m_balance;
+}
+
+volume_t KExecutionSimulator::getEquity() const
+{
+	volume_t result = m_balance;
+	for (const auto& [ticket, order] : m_orders)
+	{
+		if (order.m_status == SOrder::Open)
+		{
+			const STick* tick = findTick(order.m_symbolName);
+			assert(tick != nullptr);
+			result += calcProfit(order, closePrice(order, *tick)) - order.m_lots.m_value * m_params.m_commission;
+		}
+	}
+	return result;
+}
+
+std::size_t KExecutionSimulator::getOrderCount() const
+{
+	return m_orders.size();
+}
+
+// ---------------------------------------------------------------------------
+
+void KExecutionSimulator::executeCommand(HCommand command)
+{
+	m_cmdResult.clear();
+	dispatchCommand(*command);
+	m_sink.onCmdResult(command, m_cmdResult.empty() ? consts::CmdResultSuccess : m_cmdResult);
+}
+
+void KExecutionSimulator::dispatchCommand(const KCommand& command)
+{
+	try
+	{
+		switch (command.operation())
+		{
+			case KCommand::Open:
+				openOrder(command);
+				break;
+
+			case KCommand::Close:
+				closeOrders(command);
+				break;
+
+			case KCommand::CloseAll:
+				closeAllOrders();
+				break;
+
+			case KCommand::Modify:
+				modifyOrders(command);
+				break;
+
+			case KCommand::SetStopLoss:
+			case KCommand::SetTakeProfit:
+				setStops(command);
+				break;
+
+			case KCommand::Get:
+				getOrders(command);
+				break;
+
+			default:
+				reject(command, "not supported");
+		}
+	}
+	catch (std::exception& e)
+	{
+		reject(command, e.what());
+	}
+}
+
+void KExecutionSimulator::openOrder(const KCommand& command)
+{
+	// see newOrder2args
+	const cpp::strings_t& args = command.args();
+	if (args.size() < 7)
+	{
+		reject(command, "too few arguments");
+		return;
+	}
+
+	const std::string& symbol = args[0];
+	const SOrder::EType type = SOrder::str2type(args[1]);
+	const volume_t lots = std::stod(args[2]);
+	const SPrice requestedPrice = parsePriceArg(args, 3);
+	const SPrice stopLoss = parsePriceArg(args, 4);
+	const SPrice takeProfit = parsePriceArg(args, 5);
+	const datetime_t expirationTime = std::stoll(args[6]);
+
+	SSymbol* symbolState = findSymbol(symbol);
+	if (symbolState == nullptr)
+	{
+		reject(command, "no prices of " + symbol);
+		return;
+	}
+
+	if ((type == SOrder::None) || (lots <= 0.0) || (symbol.size() >= consts::MaxSymbolNameLen))
+	{
+		reject(command, "invalid order");
+		return;
+	}
+
+	const price_t ask = symbolState->m_tick.m_ask.m_value;
+	const price_t bid = symbolState->m_tick.m_bid.m_value;
+	price_t openPrice = requestedPrice.m_value;
+	bool validPrice = true;
+	switch (type)
+	{
+		case SOrder::Buy:
+			openPrice = ask + m_params.m_slippage;
+			break;
+
+		case SOrder::Sell:
+			openPrice = bid - m_params.m_slippage;
+			break;
+
+		case SOrder::BuyLimit:
+			validPrice = (openPrice < ask);
+			break;
+
+		case SOrder::BuyStop:
+			validPrice = (ask < openPrice);
+			break;
+
+		case SOrder::SellLimit:
+			validPrice = (bid < openPrice);
+			break;
+
+		case SOrder::SellStop:
+			validPrice = (openPrice < bid);
+			break;
+
+		default:
+			assert(!"unexpected order type!");
+	}
+
+	if (!validPrice)
+	{
+		reject(command, "invalid price");
+		return;
+	}
+
+	// the stops of market orders are checked against the close price
+	const bool marketOrder = (type == SOrder::Buy) || (type == SOrder::Sell);
+	const price_t stopsPrice = marketOrder ? (type == SOrder::Buy ? bid : ask) : openPrice;
+	if (!areStopsValid(type, stopsPrice, stopLoss, takeProfit))
+	{
+		reject(command, "invalid stops");
+		return;
+	}
+
+	const ticket_t ticket(m_nextTicket++);
+	const SOrder order(
+		symbol,
+		ticket,
+		type,
+		lots,
+		openPrice,
+		0.0,
+		stopLoss.m_value,
+		takeProfit.m_value,
+		m_time,
+		expirationTime,
+		0,
+		0.0,
+		0.0,
+		0.0);
+	auto it = m_orders.emplace(ticket, order).first;
+	symbolState->m_orders.push_back(it);
+	m_sink.onOrder(it->second);
+}
+
+void KExecutionSimulator::closeOrders(const KCommand& command)
+{
+	for (const ticket_t ticket : command.tickets())
+	{
+		auto it = m_orders.find(ticket);
+		if (it == m_orders.end())
+		{
+			reject(command, "unknown ticket " + std::to_string(ticket));
+			continue;
+		}
+
+		const SOrder& order = it->second;
+		const STick* tick = findTick(order.m_symbolName);
+		assert(tick != nullptr);
+		unlinkOrder(it);
+		closeOrder(it, closePrice(order, *tick));
+	}
+}
+
+void KExecutionSimulator::closeAllOrders()
+{
+	for (auto& [name, symbol] : m_symbols)
+	{
+		symbol.m_orders.clear();
+	}
+
+	while (!m_orders.empty())
+	{
+		auto it = m_orders.begin();
+		const SOrder& order = it->second;
+		const STick* tick = findTick(order.m_symbolName);
+		assert(tick != nullptr);
+		closeOrder(it, closePrice(order, *tick));
+	}
+}
+
+void KExecutionSimulator::modifyOrders(const KCommand& command)
+{
+	// see modifyOrder2args
+	const cpp::strings_t& args = command.args();
+	const SPrice openPrice = parsePriceArg(args, 0);
+	const SPrice stopLoss = parsePriceArg(args, 1);
+	const SPrice takeProfit = parsePriceArg(args, 2);
+	const datetime_t expirationTime = (3 < args.size()) ? std::stoll(args[3]) : 0;
+
+	for (const ticket_t ticket : command.tickets())
+	{
+		auto it = m_orders.find(ticket);
+		if (it == m_orders.end())
+		{
+			reject(command, "unknown ticket " + std::to_string(ticket));
+			continue;
+		}
+
+		SOrder& order = it->second;
+		const STick* tick = findTick(order.m_symbolName);
+		assert(tick != nullptr);
+		const bool pending = (order.m_status == SOrder::Pending);
+		const price_t stopsPrice = pending ? openPrice.m_value : closePrice(order, *tick);
+		if (!areStopsValid(order.m_type, stopsPrice, stopLoss, takeProfit))
+		{
+			reject(command, "invalid stops");
+			continue;
+		}
+
+		if (pending)
+		{
+			order.m_openPrice = openPrice;
+			order.m_expirationTime = expirationTime;
+		}
+		order.m_stopLoss = stopLoss;
+		order.m_takeProfit = takeProfit;
+		m_sink.onOrder(order);
+	}
+}
+
+void KExecutionSimulator::setStops(const KCommand& command)
+{
+	const bool stopLoss = (command.operation() == KCommand::SetStopLoss);
+	const SPrice price = parsePriceArg(command.args(), 0);
+	for (const ticket_t ticket : command.tickets())
+	{
+		auto it = m_orders.find(ticket);
+		if (it == m_orders.end())
+		{
+			reject(command, "unknown ticket " + std::to_string(ticket));
+			continue;
+		}
+
+		SOrder& order = it->second;
+		const STick* tick = findTick(order.m_symbolName);
+		assert(tick != nullptr);
+		const price_t stopsPrice = (order.m_status == SOrder::Pending) ? order.m_openPrice.m_value : closePrice(order, *tick);
+		const SPrice newStopLoss = stopLoss ? price : order.m_stopLoss;
+		const SPrice newTakeProfit = stopLoss ? order.m_takeProfit : price;
+		if (!areStopsValid(order.m_type, stopsPrice, newStopLoss, newTakeProfit))
+		{
+			reject(command, "invalid stops");
+			continue;
+		}
+
+		order.m_stopLoss = newStopLoss;
+		order.m_takeProfit = newTakeProfit;
+		m_sink.onOrder(order);
+	}
+}
+
+void KExecutionSimulator::getOrders(const KCommand& command)
+{
+	const tickets_t& tickets = command.tickets();
+	for (const auto& [ticket, order] : m_orders)
+	{
+		if (tickets.empty() || (std::find(tickets.begin(), tickets.end(), ticket) != tickets.end()))
+		{
+			m_sink.onOrder(order);
+		}
+	}
+
+	if (tickets.empty())
+	{
+		m_sink.onOrder(SOrder::makeDumpEnd());
+	}
+}
+
+// ---------------------------------------------------------------------------
+
+void KExecutionSimulator::processOrders(SSymbol* symbol)
+{
+	// the orders are in the order of opening, the ones still alive are
+	// moved to the front
+	const STick& tick = symbol->m_tick;
+	std::vector<orders_t::iterator>& orders = symbol->m_orders;
+	std::size_t aliveCount = 0;
+	for (const orders_t::iterator it : orders)
+	{
+		SOrder& order = it->second;
+		if ((order.m_status == SOrder::Pending) && !fillPendingOrder(&order, tick))
+		{
+			const datetime_t expirationTime = order.m_expirationTime.m_value;
+			if ((expirationTime != 0) && (expirationTime <= tick.m_time.m_value))
+			{
+				// cancelled, the close price of a pending order is irrelevant
+				closeOrder(it, order.m_openPrice.m_value);
+			}
+			else
+			{
+				orders[aliveCount++] = it;
+			}
+			continue;
+		}
+
+		price_t price = 0.0;
+		if (hitStops(order, tick, &price))
+		{
+			closeOrder(it, price);
+		}
+		else
+		{
+			orders[aliveCount++] = it;
+		}
+	}
+	orders.resize(aliveCount);
+}
+
+bool KExecutionSimulator::fillPendingOrder(SOrder* order, const STick& tick)
+{
+	// the price may jump over the price of order, a limit order is filled at
+	// the better price, a stop order at the worse one with slippage
+	const price_t ask = tick.m_ask.m_value;
+	const price_t bid = tick.m_bid.m_value;
+	const price_t price = order->m_openPrice.m_value;
+	SOrder::EType type = SOrder::None;
+	price_t fillPrice = 0.0;
+	switch (order->m_type)
+	{
+		case SOrder::BuyLimit:
+			if (ask <= price)
+			{
+				type = SOrder::Buy;
+				fillPrice = ask;
+			}
+			break;
+
+		case SOrder::BuyStop:
+			if (price <= ask)
+			{
+				type = SOrder::Buy;
+				fillPrice = ask + m_params.m_slippage;
+			}
+			break;
+
+		case SOrder::SellLimit:
+			if (price <= bid)
+			{
+				type = SOrder::Sell;
+				fillPrice = bid;
+			}
+			break;
+
+		case SOrder::SellStop:
+			if (bid <= price)
+			{
+				type = SOrder::Sell;
+				fillPrice = bid - m_params.m_slippage;
+			}
+			break;
+
+		default:
+			assert(!"unexpected order type!");
+	}
+
+	if (type == SOrder::None)
+	{
+		return false;
+	}
+
+	order->m_type = type;
+	order->m_status = SOrder::Open;
+	order->m_openPrice = fillPrice;
+	order->m_openTime = tick.m_time;
+	// like MetaTrader, an open order is reported with its current close
+	// price and the profit at it
+	order->m_closePrice = closePrice(*order, tick);
+	order->m_profit = calcProfit(*order, order->m_closePrice.m_value);
+	m_sink.onOrder(*order);
+	return true;
+}
+
+bool KExecutionSimulator::hitStops(const SOrder& order, const STick& tick, price_t* closePrice) const
+{
+	const SPrice& stopLoss = order.m_stopLoss;
+	const SPrice& takeProfit = order.m_takeProfit;
+	if (order.m_type == SOrder::Buy)
+	{
+		const price_t bid = tick.m_bid.m_value;
+		if (!stopLoss.isNull() && (bid <= stopLoss.m_value))
+		{
+			*closePrice = bid - m_params.m_slippage;
+			return true;
+		}
+
+		if (!takeProfit.isNull() && (takeProfit.m_value <= bid))
+		{
+			*closePrice = bid;
+			return true;
+		}
+	}
+	else
+	{
+		const price_t ask = tick.m_ask.m_value;
+		if (!stopLoss.isNull() && (stopLoss.m_value <= ask))
+		{
+			*closePrice = ask + m_params.m_slippage;
+			return true;
+		}
+
+		if (!takeProfit.isNull() && (ask <= takeProfit.m_value))
+		{
+			*closePrice = ask;
+			return true;
+		}
+	}
+	return false;
+}
+
+void KExecutionSimulator::closeOrder(orders_t::iterator it, const price_t closePrice)
+{
+	SOrder& order = it->second;
+	if (order.m_status == SOrder::Open)
+	{
+		order.m_closePrice = closePrice;
+		order.m_profit = calcProfit(order, closePrice);
+		order.m_commission = -order.m_lots.m_value * m_params.m_commission;
+		m_balance += order.m_profit.m_value + order.m_commission.m_value;
+	}
+	order.m_status = SOrder::Closed;
+	order.m_closeTime = m_time;
+	m_sink.onOrder(order);
+	m_orders.erase(it);
+}
+
+void KExecutionSimulator::unlinkOrder(orders_t::iterator it)
+{
+	SSymbol* symbol = findSymbol(it->second.m_symbolName);
+	assert(symbol != nullptr);
+	std::vector<orders_t::iterator>& orders = symbol->m_orders;
+	orders.erase(std::find(orders.begin(), orders.end(), it));
+}
+
+// ---------------------------------------------------------------------------
+
+KExecutionSimulator::SSymbol* KExecutionSimulator::findSymbol(const std::string_view& symbol)
+{
+	auto it = m_symbols.find(symbol);
+	SSymbol* result = (it != m_symbols.end()) ? &it->second : nullptr;
+	return result;
+}
+
+const STick* KExecutionSimulator::findTick(const std::string_view& symbol) const
+{
+	auto it = m_symbols.find(symbol);
+	const STick* result = (it != m_symbols.end()) ? &it->second.m_tick : nullptr;
+	return result;
+}
+
+price_t KExecutionSimulator::closePrice(const SOrder& order, const STick& tick) const
+{
+	const price_t result = (order.m_type == SOrder::Buy)
+		? tick.m_bid.m_value - m_params.m_slippage
+		: tick.m_ask.m_value + m_params.m_slippage;
+	return result;
+}
+
+volume_t KExecutionSimulator::calcProfit(const SOrder& order, const price_t closePrice) const
+{
+	const price_t move = (order.m_type == SOrder::Buy)
+		? closePrice - order.m_openPrice.m_value
+		: order.m_openPrice.m_value - closePrice;
+	const volume_t result = move * order.m_lots.m_value * m_params.m_contractSize;
+	return result;
+}
+
+void KExecutionSimulator::reject(const KCommand& command, const std::string& reason)
+{
+	// like MetaTrader, the errors are separated by semicolons
+	m_cmdResult += command.toString() + ": " + reason + ';';
+}
+
+} // anonymous namespace
+
+// ---------------------------------------------------------------------------
+
+IExecutionSimulator* createExecutionSimulator(const SExecutionParams& params, IExecutionSink* sink)
+{
+	IExecutionSimulator* simulator = new KExecutionSimulator(params, sink);
+	return simulator;
+}
+
+} // namespace fx
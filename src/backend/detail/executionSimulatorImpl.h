@@ -0,0 +1,16 @@
+// author: Darek Slusarczyk alias marines marinesovitch 2012-2013, 2022
+#ifndef INC_BACKEND_EXECUTIONSIMULATORIMPL_H
+#define INC_BACKEND_EXECUTIONSIMULATORIMPL_H
+
+namespace fx
+{
+
+struct IExecutionSimulator;
+struct IExecutionSink;
+struct SExecutionParams;
+
+IExecutionSimulator* createExecutionSimulator(const SExecutionParams& params, IExecutionSink* sink);
+
+} // namespace fx
+
+#endif
@@ -2,17 +2,40 @@
 #include "ph.h"
 #include "executorImpl.h"
 #include "executor.h"
+#include "bar.h"
 #include "accountManager.h"
+#include "backtest.h"
+#include "backtesterImpl.h"
+#include "commandThrottle.h"
+#include "communicator.h"
+#include "connection.h"
+#include "copyTrader.h"
+#include "paperConnection.h"
+#include "historyImporter.h"
+#include "monteCarlo.h"
+#include "monteCarloImpl.h"
+#include "optimizer.h"
+#include "optimizerImpl.h"
+#include "sessionRecorder.h"
+#include "sessionRecorderImpl.h"
+#include "tickFeed.h"
+#include "tickFeedImpl.h"
+#include "tickArchive.h"
+#include "tickArchiveImpl.h"
 #include "tradeManager.h"
 #include "trader.h"
 #include "tradingStrategyFactory.h"
+#include "walkForward.h"
+#include "walkForwardImpl.h"
 #include "common/command.h"
 #include "common/commandQueue.h"
 #include "common/commandParserBase.h"
 #include "common/traderCommandParser.h"
 #include "common/namedPipe.h"
 #include "common/utils.h"
+#include "cpp/allocTracker.h"
 #include "cpp/strUtils.h"
+#include "cpp/workStealingPool.h"
 
 namespace fx
 {
@@ -22,18 +45,117 @@ namespace
 
 typedef std::map<std::string, ITradingStrategyFactory*> strategy2factory_t;
 
+// returns false if name isn't a limit, throws std::logic_error for an
+// incorrect value; it is used by the parser to validate the options and by
+// the executor to apply them to the current limits of each account
+bool setRiskLimit( const std::string& name, const std::string& value, SRiskLimits* limits )
+{
+	const double limit = std::stod( value );
+	if ( limit < 0 )
+	{
+		throw std::invalid_argument( "negative limit" );
+	}
+
+	if ( name == "lots" )
+	{
+		limits->m_maxOrderLots = limit;
+	}
+	else if ( name == "symbol" )
+	{
+		limits->m_maxSymbolLots = limit;
+	}
+	else if ( name == "account" )
+	{
+		limits->m_maxAccountLots = limit;
+	}
+	else if ( name == "orders" )
+	{
+		limits->m_maxOrderCount = static_cast< std::size_t >( limit );
+	}
+	else if ( name == "band" )
+	{
+		limits->m_priceBand = limit;
+	}
+	else
+	{
+		return false;
+	}
+	return true;
+}
+
+// the same for the limits of a class of commands, the value is rate[/burst]
+bool setThrottleLimit( const std::string& name, const std::string& value, SThrottleLimits* limits )
+{
+	cmdclass::ECmdClass cmdClass = cmdclass::Query;
+	if ( !cmdclass::parse( name, &cmdClass ) )
+	{
+		return false;
+	}
+
+	SThrottleLimit& limit = limits->m_classes[ cmdClass ];
+	const std::size_t separator = value.find( '/' );
+	const double rate = std::stod( value.substr( 0, separator ) );
+	const double burst = ( separator != std::string::npos ) ? std::stod( value.substr( separator + 1 ) ) : limit.m_burst;
+	if ( ( rate < 0 ) || ( burst < 1 ) )
+	{
+		throw std::invalid_argument( "incorrect limit" );
+	}
+
+	limit.m_rate = rate;
+	limit.m_burst = burst;
+	return true;
+}
+
 // ---------------------------------------------------------------------------
 // ---------------------------------------------------------------------------
 
 struct SListAccountsCommand;
 struct SSelectCommand;
 struct SHelpCommand;
+struct SRecordCommand;
+struct SReplayCommand;
+struct SAllocsCommand;
+struct SStrategiesCommand;
+struct SPositionsCommand;
+struct SEquityCommand;
+struct SRiskCommand;
+struct SThrottleCommand;
+struct STrailCommand;
+struct SConditionalCommand;
+struct SAlertCommand;
+struct SAlgoCommand;
+struct SCopyCommand;
+struct SPaperCommand;
+struct SArchiveCommand;
+struct SImportCommand;
+struct SBacktestCommand;
+struct SOptimizeCommand;
+struct SWalkForwardCommand;
 
 struct IExecutorCommandVisitor
 {
 	virtual void visitListAccountsCommand( const SListAccountsCommand& cmd ) = 0;
 	virtual void visitSelectCommand( const SSelectCommand& cmd ) = 0;
 	virtual void visitHelpCommand( const SHelpCommand& cmd ) = 0;
+	virtual void visitRecordCommand( const SRecordCommand& cmd ) = 0;
+	virtual void visitReplayCommand( const SReplayCommand& cmd ) = 0;
+	virtual void visitAllocsCommand( const SAllocsCommand& cmd ) = 0;
+	virtual void visitStrategiesCommand( const SStrategiesCommand& cmd ) = 0;
+	virtual void visitPositionsCommand( const SPositionsCommand& cmd ) = 0;
+	virtual void visitEquityCommand( const SEquityCommand& cmd ) = 0;
+	virtual void visitRiskCommand( const SRiskCommand& cmd ) = 0;
+	virtual void visitThrottleCommand( const SThrottleCommand& cmd ) = 0;
+	virtual void visitTrailCommand( const STrailCommand& cmd ) = 0;
+	virtual void visitConditionalCommand( const SConditionalCommand& cmd ) = 0;
+	virtual void visitAlertCommand( const SAlertCommand& cmd ) = 0;
+	virtual void visitAlgoCommand( const SAlgoCommand& cmd ) = 0;
+	virtual void visitCopyCommand( const SCopyCommand& cmd ) = 0;
+	virtual void visitPaperCommand( const SPaperCommand& cmd ) = 0;
+	virtual void visitArchiveCommand( const SArchiveCommand& cmd ) = 0;
+	virtual void visitImportCommand( const SImportCommand& cmd ) = 0;
+	virtual void visitBacktestCommand( const SBacktestCommand& cmd ) = 0;
+	virtual void visitOptimizeCommand( const SOptimizeCommand& cmd ) = 0;
+	virtual void visitWalkForwardCommand( const SWalkForwardCommand& cmd ) = 0;
 };
 
 // ---------------------------------------------------------------------------
@@ -85,6 +207,317 @@ struct SHelpCommand : public SExecutorCommand
 
 };
 
+struct SRecordCommand : public SExecutorCommand
+{
+	// empty path means stop recording
+	SRecordCommand( const std::string& path )
+		: m_path( path )
+	{
+	}
+
+	virtual void accept( IExecutorCommandVisitor* visitor )
+	{
+		visitor->visitRecordCommand( *this );
+	}
+
+	std::string m_path;
+
+};
+
+struct SReplayCommand : public SExecutorCommand
+{
+	// empty path means stop replaying
+	SReplayCommand( const std::string& path, const double speed )
+		: m_path( path )
+		, m_speed( speed )
+	{
+	}
+
+	virtual void accept( IExecutorCommandVisitor* visitor )
+	{
+		visitor->visitReplayCommand( *this );
+	}
+
+	std::string m_path;
+	double m_speed;
+
+};
+
+struct SAllocsCommand : public SExecutorCommand
+{
+	virtual void accept( IExecutorCommandVisitor* visitor )
+	{
+		visitor->visitAllocsCommand( *this );
+	}
+
+};
+
+struct SStrategiesCommand : public SExecutorCommand
+{
+	virtual void accept( IExecutorCommandVisitor* visitor )
+	{
+		visitor->visitStrategiesCommand( *this );
+	}
+
+};
+
+struct SPositionsCommand : public SExecutorCommand
+{
+	virtual void accept( IExecutorCommandVisitor* visitor )
+	{
+		visitor->visitPositionsCommand( *this );
+	}
+
+};
+
+struct SEquityCommand : public SExecutorCommand
+{
+	SEquityCommand( const std::size_t historyCount )
+		: m_historyCount( historyCount )
+	{
+	}
+
+	virtual void accept( IExecutorCommandVisitor* visitor )
+	{
+		visitor->visitEquityCommand( *this );
+	}
+
+	std::size_t m_historyCount;
+
+};
+
+struct SRiskCommand : public SExecutorCommand
+{
+	virtual void accept( IExecutorCommandVisitor* visitor )
+	{
+		visitor->visitRiskCommand( *this );
+	}
+
+	// the options given by the user, the other limits stay as they are
+	cpp::strings_t m_options;
+
+};
+
+struct SThrottleCommand : public SExecutorCommand
+{
+	virtual void accept( IExecutorCommandVisitor* visitor )
+	{
+		visitor->visitThrottleCommand( *this );
+	}
+
+	// the same as of SRiskCommand
+	cpp::strings_t m_options;
+
+};
+
+struct STrailCommand : public SExecutorCommand
+{
+	virtual void accept( IExecutorCommandVisitor* visitor )
+	{
+		visitor->visitTrailCommand( *this );
+	}
+
+	// the null ticket means print the rules
+	ticket_t m_ticket;
+	bool m_stop = false;
+	price_t m_distance = 0;
+	price_t m_step = 0;
+
+};
+
+struct SConditionalCommand : public SExecutorCommand
+{
+	virtual void accept( IExecutorCommandVisitor* visitor )
+	{
+		visitor->visitConditionalCommand( *this );
+	}
+
+	enum EAction
+	{
+		List,
+		VirtualStops,
+		Oco,
+		Bracket,
+		Cancel
+	};
+
+	EAction m_action = List;
+	// of the virtual stops
+	ticket_t m_ticket;
+	price_t m_stopLoss = 0;
+	price_t m_takeProfit = 0;
+	// of OCO and bracket
+	std::vector< SNewOrder > m_entries;
+	// of cancel
+	uint32_t m_id = 0;
+
+};
+
+struct SAlertCommand : public SExecutorCommand
+{
+	virtual void accept( IExecutorCommandVisitor* visitor )
+	{
+		visitor->visitAlertCommand( *this );
+	}
+
+	enum EAction
+	{
+		List,
+		Add,
+		Cancel,
+		Save,
+		Load
+	};
+
+	EAction m_action = List;
+	std::string m_symbol;
+	bool m_above = true;
+	price_t m_price = 0;
+	uint32_t m_id = 0;
+	std::string m_path;
+
+};
+
+struct SAlgoCommand : public SExecutorCommand
+{
+	virtual void accept( IExecutorCommandVisitor* visitor )
+	{
+		visitor->visitAlgoCommand( *this );
+	}
+
+	enum EAction
+	{
+		List,
+		Start,
+		Cancel
+	};
+
+	EAction m_action = List;
+	SAlgoParams m_params;
+	uint32_t m_id = 0;
+
+};
+
+struct SCopyCommand : public SExecutorCommand
+{
+	virtual void accept( IExecutorCommandVisitor* visitor )
+	{
+		visitor->visitCopyCommand( *this );
+	}
+
+	enum EAction
+	{
+		List,
+		Master,
+		Follow,
+		Unfollow
+	};
+
+	EAction m_action = List;
+	// the null key of master stops copying
+	account_key_t m_key;
+	SCopyFollower m_follower;
+
+};
+
+struct SPaperCommand : public SExecutorCommand
+{
+	virtual void accept( IExecutorCommandVisitor* visitor )
+	{
+		visitor->visitPaperCommand( *this );
+	}
+
+};
+
+struct SArchiveCommand : public SExecutorCommand
+{
+	// empty directory means stop archiving
+	SArchiveCommand( const std::string& directory )
+		: m_directory( directory )
+	{
+	}
+
+	virtual void accept( IExecutorCommandVisitor* visitor )
+	{
+		visitor->visitArchiveCommand( *this );
+	}
+
+	std::string m_directory;
+
+};
+
+struct SImportCommand : public SExecutorCommand
+{
+	// empty symbol means the symbol is taken from the input
+	SImportCommand( const std::string& path, const std::string& directory, const std::string& symbol )
+		: m_path( path )
+		, m_directory( directory )
+		, m_symbol( symbol )
+	{
+	}
+
+	virtual void accept( IExecutorCommandVisitor* visitor )
+	{
+		visitor->visitImportCommand( *this );
+	}
+
+	std::string m_path;
+	std::string m_directory;
+	std::string m_symbol;
+
+};
+
+struct SBacktestCommand : public SExecutorCommand
+{
+	virtual void accept( IExecutorCommandVisitor* visitor )
+	{
+		visitor->visitBacktestCommand( *this );
+	}
+
+	std::string m_path;
+	SBacktestParams m_params;
+	// of the trades, the run count is 0 by default
+	SMonteCarloParams m_monteCarlo;
+	// empty if the report isn't saved
+	std::string m_reportPath;
+	std::string m_strategy;
+	std::string m_strategyCmdLine;
+
+};
+
+struct SOptimizeCommand : public SExecutorCommand
+{
+	virtual void accept( IExecutorCommandVisitor* visitor )
+	{
+		visitor->visitOptimizeCommand( *this );
+	}
+
+	std::string m_path;
+	SOptimizerParams m_params;
+	std::size_t m_topCount = 10;
+	// empty if the results aren't saved
+	std::string m_reportPath;
+	std::string m_strategy;
+	std::string m_cmdLineTemplate;
+
+};
+
+struct SWalkForwardCommand : public SExecutorCommand
+{
+	virtual void accept( IExecutorCommandVisitor* visitor )
+	{
+		visitor->visitWalkForwardCommand( *this );
+	}
+
+	std::string m_path;
+	SWalkForwardParams m_params;
+	// empty if the windows aren't saved
+	std::string m_reportPath;
+	std::string m_strategy;
+	std::string m_cmdLineTemplate;
+
+};
+
 // ---------------------------------------------------------------------------
 // ---------------------------------------------------------------------------
 
@@ -106,6 +539,43 @@ class KExecutorCommandParser : public KCommandParserBase
 		void parseListAccountsCommand();
 		void parseSelectCommand();
 		void parseHelpCommand();
+		void parseRecordCommand();
+		void parseReplayCommand();
+		void parseAllocsCommand();
+		void parseStrategiesCommand();
+		void parsePositionsCommand();
+		void parseEquityCommand();
+		void parseRiskCommand();
+		void parseThrottleCommand();
+		void parseTrailCommand();
+		void parseConditionalCommand();
+		void parseAlertCommand();
+		void parseAlgoCommand();
+		void parseCopyCommand();
+		void parsePaperCommand();
+		void parseArchiveCommand();
+		void parseImportCommand();
+		void parseBacktestCommand();
+		void parseOptimizeCommand();
+		void parseWalkForwardCommand();
+
+		// the options are shared by backtest, optimize and walkforward; each
+		// returns false if name isn't its option and throws std::logic_error
+		// for an incorrect value
+		static bool parseBacktestOption(
+			const std::string& name,
+			const std::string& value,
+			SBacktestParams* params );
+		static bool parseOptimizerOption(
+			const std::string& name,
+			const std::string& value,
+			SOptimizerParams* params );
+		static bool parseMonteCarloOption(
+			const std::string& name,
+			const std::string& value,
+			SMonteCarloParams* params );
+		// seconds or a number with the suffix m, h or d
+		static datetime_t parseDuration( const std::string& value );
 
 	private:
 		static const std::map< std::string, TCommandParseRoutine > s_cmd2parser;
@@ -200,56 +670,792 @@ void KExecutorCommandParser::parseHelpCommand()
 const std::string CmdNameListAccounts = "accounts";
 const std::string CmdNameSelect = "select";
 const std::string CmdNameHelp = "help";
-
-const std::map< std::string, KExecutorCommandParser::TCommandParseRoutine > KExecutorCommandParser::s_cmd2parser =
+const std::string CmdNameRecord = "record";
+const std::string CmdNameReplay = "replay";
+const std::string CmdNameAllocs = "allocs";
+const std::string CmdNameStrategies = "strategies";
+const std::string CmdNamePositions = "positions";
+const std::string CmdNameEquity = "equity";
+const std::string CmdNameRisk = "risk";
+const std::string CmdNameThrottle = "throttle";
+const std::string CmdNameTrail = "trail";
+const std::string CmdNameConditional = "conditional";
+const std::string CmdNameAlert = "alert";
+const std::string CmdNameAlgo = "algo";
+const std::string CmdNameCopy = "copy";
+const std::string CmdNamePaper = "paper";
+const std::string CmdNameArchive = "archive";
+const std::string CmdNameImport = "import";
+const std::string CmdNameBacktest = "backtest";
+const std::string CmdNameOptimize = "optimize";
+const std::string CmdNameWalkForward = "walkforward";
+
+const std::string CmdArgStop = "stop";
+
+void KExecutorCommandParser::parseRecordCommand()
 {
-	{CmdNameListAccounts, &KExecutorCommandParser::parseListAccountsCommand},
-	{CmdNameSelect, &KExecutorCommandParser::parseSelectCommand},
-	{CmdNameHelp, &KExecutorCommandParser::parseHelpCommand},
-};
+	const std::string& path = getNextToken();
+	m_result = new SRecordCommand( path == CmdArgStop ? std::string() : path );
+}
 
-const std::map<std::string, std::string> KExecutorCommandParser::s_alias2cmd =
+void KExecutorCommandParser::parseReplayCommand()
 {
-	{"la", CmdNameListAccounts},
-	{"sel", CmdNameSelect},
-	{"h", CmdNameHelp},
-};
+	const std::string& path = getNextToken();
+	if ( path == CmdArgStop )
+	{
+		m_result = new SReplayCommand( std::string(), 0.0 );
+		return;
+	}
 
-// ---------------------------------------------------------------------------
-// ---------------------------------------------------------------------------
+	const std::string& speedStr = getNextToken( false, "1" );
+	double speed = 0.0;
+	try
+	{
+		speed = std::stod( speedStr );
+	}
+	catch ( std::exception& )
+	{
+		parseError( "incorrect speed" );
+	}
 
-struct SGenericTraderCommand;
-struct SGenericStrategyCommand;
-struct SGenericExecutorCommand;
+	if ( speed < 0.0 )
+	{
+		parseError( "incorrect speed" );
+	}
 
-struct IGenericCommandVisitor
+	m_result = new SReplayCommand( path, speed );
+}
+
+void KExecutorCommandParser::parseAllocsCommand()
 {
-	virtual void visitTraderCommand( SGenericTraderCommand* cmd ) = 0;
-	virtual void visitStrategyCommand( SGenericStrategyCommand* cmd ) = 0;
-	virtual void visitExecutorCommand( SGenericExecutorCommand* cmd ) = 0;
-};
+	m_result = new SAllocsCommand();
+}
 
-// ---------------------------------------------------------------------------
+void KExecutorCommandParser::parseStrategiesCommand()
+{
+	m_result = new SStrategiesCommand();
+}
 
-struct SGenericCommand
+void KExecutorCommandParser::parsePositionsCommand()
 {
-	SGenericCommand( const account_key_t& key )
-		: m_key( key )
+	m_result = new SPositionsCommand();
+}
+
+void KExecutorCommandParser::parseEquityCommand()
+{
+	const std::string& countStr = getNextToken( false, "10" );
+	std::size_t count = 0;
+	try
 	{
+		count = std::stoul( countStr );
 	}
-
-	virtual ~SGenericCommand()
+	catch ( std::exception& )
 	{
+		parseError( "incorrect count of snapshots" );
 	}
 
-	virtual void accept( IGenericCommandVisitor* visitor ) = 0;
-
-	const account_key_t m_key;
-};
+	m_result = new SEquityCommand( count );
+}
 
-struct SGenericTraderCommand : public SGenericCommand
+void KExecutorCommandParser::parseRiskCommand()
 {
-	SGenericTraderCommand(
+	std::unique_ptr< SRiskCommand > cmd( new SRiskCommand() );
+	std::string token;
+	while ( getNextToken( &token ) )
+	{
+		const std::size_t separator = token.find( '=' );
+		if ( separator == std::string::npos )
+		{
+			parseError( "expected option=value" );
+		}
+
+		// validated here, so a wrong option changes none of the limits
+		SRiskLimits limits;
+		bool knownOption = true;
+		try
+		{
+			knownOption = setRiskLimit( token.substr( 0, separator ), token.substr( separator + 1 ), &limits );
+		}
+		catch ( std::logic_error& )
+		{
+			parseError( "incorrect value" );
+		}
+
+		if ( !knownOption )
+		{
+			parseError( "unknown option" );
+		}
+		cmd->m_options.push_back( token );
+	}
+	m_result = cmd.release();
+}
+
+void KExecutorCommandParser::parseThrottleCommand()
+{
+	std::unique_ptr< SThrottleCommand > cmd( new SThrottleCommand() );
+	std::string token;
+	while ( getNextToken( &token ) )
+	{
+		const std::size_t separator = token.find( '=' );
+		if ( separator == std::string::npos )
+		{
+			parseError( "expected class=rate[/burst]" );
+		}
+
+		SThrottleLimits limits;
+		bool knownClass = true;
+		try
+		{
+			knownClass = setThrottleLimit( token.substr( 0, separator ), token.substr( separator + 1 ), &limits );
+		}
+		catch ( std::logic_error& )
+		{
+			parseError( "incorrect value" );
+		}
+
+		if ( !knownClass )
+		{
+			parseError( "unknown class of commands" );
+		}
+		cmd->m_options.push_back( token );
+	}
+	m_result = cmd.release();
+}
+
+void KExecutorCommandParser::parseTrailCommand()
+{
+	std::unique_ptr< STrailCommand > cmd( new STrailCommand() );
+	std::string token;
+	if ( getNextToken( &token ) )
+	{
+		try
+		{
+			cmd->m_ticket = ticket_t( std::stoi( token ) );
+			const std::string& distanceStr = getNextToken();
+			if ( distanceStr == CmdArgStop )
+			{
+				cmd->m_stop = true;
+			}
+			else
+			{
+				cmd->m_distance = std::stod( distanceStr );
+				cmd->m_step = std::stod( getNextToken( false, "0" ) );
+			}
+		}
+		catch ( std::logic_error& )
+		{
+			parseError( "incorrect ticket, distance or step" );
+		}
+	}
+	m_result = cmd.release();
+}
+
+void KExecutorCommandParser::parseConditionalCommand()
+{
+	std::unique_ptr< SConditionalCommand > cmd( new SConditionalCommand() );
+	std::string action;
+	if ( getNextToken( &action ) )
+	{
+		if ( action == "vstop" )
+		{
+			cmd->m_action = SConditionalCommand::VirtualStops;
+			const std::string& ticketStr = getNextToken();
+			try
+			{
+				cmd->m_ticket = ticket_t( std::stoi( ticketStr ) );
+			}
+			catch ( std::logic_error& )
+			{
+				parseError( "incorrect ticket" );
+			}
+			cmd->m_stopLoss = parsePrice().m_value;
+			cmd->m_takeProfit = parsePrice( false ).m_value;
+		}
+		else if ( action == "oco" )
+		{
+			// symbol type lots price sl tp type lots price [sl tp]
+			cmd->m_action = SConditionalCommand::Oco;
+			const std::string& symbol = getNextToken();
+			for ( int i = 0; i < 2; ++i )
+			{
+				SNewOrder entry;
+				entry.m_symbolName = symbol;
+				entry.m_type = parseOrderType();
+				entry.m_lots = parseVolume();
+				entry.m_openPrice = parsePrice();
+				entry.m_stopLoss = parsePrice( i == 0 );
+				entry.m_takeProfit = parsePrice( i == 0 );
+				cmd->m_entries.push_back( entry );
+			}
+		}
+		else if ( action == "bracket" )
+		{
+			cmd->m_action = SConditionalCommand::Bracket;
+			cmd->m_entries.push_back( parseNewOrder() );
+		}
+		else if ( action == "cancel" )
+		{
+			cmd->m_action = SConditionalCommand::Cancel;
+			const std::string& idStr = getNextToken();
+			try
+			{
+				cmd->m_id = static_cast< uint32_t >( std::stoul( idStr ) );
+			}
+			catch ( std::logic_error& )
+			{
+				parseError( "incorrect id" );
+			}
+		}
+		else
+		{
+			parseError( "unknown action, expected vstop, oco, bracket or cancel" );
+		}
+	}
+	m_result = cmd.release();
+}
+
+void KExecutorCommandParser::parseAlertCommand()
+{
+	std::unique_ptr< SAlertCommand > cmd( new SAlertCommand() );
+	std::string token;
+	if ( getNextToken( &token ) )
+	{
+		if ( token == "cancel" )
+		{
+			cmd->m_action = SAlertCommand::Cancel;
+			const std::string& idStr = getNextToken();
+			try
+			{
+				cmd->m_id = static_cast< uint32_t >( std::stoul( idStr ) );
+			}
+			catch ( std::logic_error& )
+			{
+				parseError( "incorrect id" );
+			}
+		}
+		else if ( ( token == "save" ) || ( token == "load" ) )
+		{
+			cmd->m_action = ( token == "save" ) ? SAlertCommand::Save : SAlertCommand::Load;
+			cmd->m_path = getNextToken();
+		}
+		else
+		{
+			cmd->m_action = SAlertCommand::Add;
+			cmd->m_symbol = token;
+			const std::string& direction = getNextToken();
+			if ( ( direction != "above" ) && ( direction != "below" ) )
+			{
+				parseError( "expected above or below" );
+			}
+			cmd->m_above = ( direction == "above" );
+			cmd->m_price = parsePrice().m_value;
+		}
+	}
+	m_result = cmd.release();
+}
+
+void KExecutorCommandParser::parseAlgoCommand()
+{
+	std::unique_ptr< SAlgoCommand > cmd( new SAlgoCommand() );
+	std::string token;
+	if ( getNextToken( &token ) )
+	{
+		if ( token == "cancel" )
+		{
+			cmd->m_action = SAlgoCommand::Cancel;
+			const std::string& idStr = getNextToken();
+			try
+			{
+				cmd->m_id = static_cast< uint32_t >( std::stoul( idStr ) );
+			}
+			catch ( std::logic_error& )
+			{
+				parseError( "incorrect id" );
+			}
+		}
+		else if ( ( token == "twap" ) || ( token == "vwap" ) )
+		{
+			// symbol type lots duration slices [sl tp]
+			cmd->m_action = SAlgoCommand::Start;
+			SAlgoParams& params = cmd->m_params;
+			params.m_kind = ( token == "twap" ) ? SAlgoParams::Twap : SAlgoParams::Vwap;
+			SNewOrder& order = params.m_order;
+			order.m_symbolName = getNextToken();
+			order.m_type = parseOrderType();
+			order.m_lots = parseVolume();
+			const std::string& durationStr = getNextToken();
+			const std::string& slicesStr = getNextToken();
+			try
+			{
+				params.m_duration = parseDuration( durationStr );
+				params.m_sliceCount = std::stoul( slicesStr );
+			}
+			catch ( std::logic_error& )
+			{
+				parseError( "incorrect duration or count of slices" );
+			}
+			order.m_stopLoss = parsePrice( false );
+			order.m_takeProfit = parsePrice( false );
+		}
+		else
+		{
+			parseError( "unknown action, expected twap, vwap or cancel" );
+		}
+	}
+	m_result = cmd.release();
+}
+
+void KExecutorCommandParser::parseCopyCommand()
+{
+	std::unique_ptr< SCopyCommand > cmd( new SCopyCommand() );
+	std::string action;
+	if ( getNextToken( &action ) )
+	{
+		if ( action == "master" )
+		{
+			cmd->m_action = SCopyCommand::Master;
+			const std::string& keyStr = getNextToken();
+			if ( keyStr != CmdArgStop )
+			{
+				try
+				{
+					cmd->m_key = account_key_t( std::stoi( keyStr ) );
+				}
+				catch ( std::logic_error& )
+				{
+					parseError( "incorrect account" );
+				}
+			}
+		}
+		else if ( action == "follow" )
+		{
+			// account [scale] [symbol=mapped ...]
+			cmd->m_action = SCopyCommand::Follow;
+			SCopyFollower& follower = cmd->m_follower;
+			const std::string& keyStr = getNextToken();
+			try
+			{
+				follower.m_key = account_key_t( std::stoi( keyStr ) );
+			}
+			catch ( std::logic_error& )
+			{
+				parseError( "incorrect account" );
+			}
+
+			std::string token;
+			while ( getNextToken( &token ) )
+			{
+				const std::size_t separator = token.find( '=' );
+				if ( separator != std::string::npos )
+				{
+					if ( ( separator == 0 ) || ( separator + 1 == token.size() ) )
+					{
+						parseError( "expected symbol=mapped" );
+					}
+					follower.m_symbols[ token.substr( 0, separator ) ] = token.substr( separator + 1 );
+					continue;
+				}
+
+				try
+				{
+					follower.m_scale = std::stod( token );
+				}
+				catch ( std::logic_error& )
+				{
+					parseError( "incorrect scale" );
+				}
+			}
+		}
+		else if ( action == "unfollow" )
+		{
+			cmd->m_action = SCopyCommand::Unfollow;
+			const std::string& keyStr = getNextToken();
+			try
+			{
+				cmd->m_key = account_key_t( std::stoi( keyStr ) );
+			}
+			catch ( std::logic_error& )
+			{
+				parseError( "incorrect account" );
+			}
+		}
+		else
+		{
+			parseError( "unknown action, expected master, follow or unfollow" );
+		}
+	}
+	m_result = cmd.release();
+}
+
+void KExecutorCommandParser::parsePaperCommand()
+{
+	m_result = new SPaperCommand();
+}
+
+void KExecutorCommandParser::parseArchiveCommand()
+{
+	const std::string& directory = getNextToken();
+	m_result = new SArchiveCommand( directory == CmdArgStop ? std::string() : directory );
+}
+
+void KExecutorCommandParser::parseImportCommand()
+{
+	const std::string& path = getNextToken();
+	const std::string& directory = getNextToken();
+	const std::string& symbol = getNextToken( false );
+	m_result = new SImportCommand( path, directory, symbol );
+}
+
+void KExecutorCommandParser::parseBacktestCommand()
+{
+	std::unique_ptr< SBacktestCommand > cmd( new SBacktestCommand() );
+	cmd->m_path = getNextToken();
+	cmd->m_monteCarlo.m_runCount = 0;
+
+	// the options are name=value, the first other token is the strategy
+	std::string token = getNextToken();
+	for ( std::size_t separator = token.find( '=' ); separator != std::string::npos; separator = token.find( '=' ) )
+	{
+		const std::string& name = token.substr( 0, separator );
+		const std::string& value = token.substr( separator + 1 );
+		bool knownOption = true;
+		try
+		{
+			if ( name == "report" )
+			{
+				cmd->m_reportPath = value;
+			}
+			else
+			{
+				knownOption = parseBacktestOption( name, value, &cmd->m_params )
+					|| parseMonteCarloOption( name, value, &cmd->m_monteCarlo );
+			}
+		}
+		catch ( std::logic_error& )
+		{
+			parseError( "incorrect value" );
+		}
+
+		if ( !knownOption )
+		{
+			parseError( "unknown option" );
+		}
+		token = getNextToken();
+	}
+
+	cmd->m_strategy = token;
+	std::getline( m_cmdLine, cmd->m_strategyCmdLine );
+	m_result = cmd.release();
+}
+
+void KExecutorCommandParser::parseOptimizeCommand()
+{
+	std::unique_ptr< SOptimizeCommand > cmd( new SOptimizeCommand() );
+	cmd->m_path = getNextToken();
+
+	// the same options as of backtest and the ones of the optimizer
+	std::string token = getNextToken();
+	for ( std::size_t separator = token.find( '=' ); separator != std::string::npos; separator = token.find( '=' ) )
+	{
+		const std::string& name = token.substr( 0, separator );
+		const std::string& value = token.substr( separator + 1 );
+		bool knownOption = true;
+		try
+		{
+			if ( name == "top" )
+			{
+				cmd->m_topCount = std::stoul( value );
+			}
+			else if ( name == "report" )
+			{
+				cmd->m_reportPath = value;
+			}
+			else
+			{
+				knownOption = parseOptimizerOption( name, value, &cmd->m_params );
+			}
+		}
+		catch ( std::logic_error& )
+		{
+			parseError( "incorrect value" );
+		}
+
+		if ( !knownOption )
+		{
+			parseError( "unknown option" );
+		}
+		token = getNextToken();
+	}
+
+	cmd->m_strategy = token;
+	std::getline( m_cmdLine, cmd->m_cmdLineTemplate );
+	m_result = cmd.release();
+}
+
+void KExecutorCommandParser::parseWalkForwardCommand()
+{
+	std::unique_ptr< SWalkForwardCommand > cmd( new SWalkForwardCommand() );
+	cmd->m_path = getNextToken();
+
+	SWalkForwardParams& params = cmd->m_params;
+	std::string token = getNextToken();
+	for ( std::size_t separator = token.find( '=' ); separator != std::string::npos; separator = token.find( '=' ) )
+	{
+		const std::string& name = token.substr( 0, separator );
+		const std::string& value = token.substr( separator + 1 );
+		bool knownOption = true;
+		try
+		{
+			if ( name == "insample" )
+			{
+				params.m_inSample = parseDuration( value );
+			}
+			else if ( name == "outsample" )
+			{
+				params.m_outOfSample = parseDuration( value );
+			}
+			else if ( name == "anchored" )
+			{
+				params.m_anchored = ( std::stoi( value ) != 0 );
+			}
+			else if ( name == "report" )
+			{
+				cmd->m_reportPath = value;
+			}
+			else
+			{
+				knownOption = parseOptimizerOption( name, value, &params.m_optimizer )
+					|| parseMonteCarloOption( name, value, &params.m_monteCarlo );
+			}
+		}
+		catch ( std::logic_error& )
+		{
+			parseError( "incorrect value" );
+		}
+
+		if ( !knownOption )
+		{
+			parseError( "unknown option" );
+		}
+		token = getNextToken();
+	}
+
+	cmd->m_strategy = token;
+	std::getline( m_cmdLine, cmd->m_cmdLineTemplate );
+	m_result = cmd.release();
+}
+
+bool KExecutorCommandParser::parseBacktestOption(
+	const std::string& name,
+	const std::string& value,
+	SBacktestParams* params )
+{
+	if ( name == "spread" )
+	{
+		params->m_execution.m_spread = std::stod( value );
+	}
+	else if ( name == "slippage" )
+	{
+		params->m_execution.m_slippage = std::stod( value );
+	}
+	else if ( name == "latency" )
+	{
+		params->m_execution.m_latency = std::stoll( value );
+	}
+	else if ( name == "commission" )
+	{
+		params->m_execution.m_commission = std::stod( value );
+	}
+	else if ( name == "contract" )
+	{
+		params->m_execution.m_contractSize = std::stod( value );
+	}
+	else if ( name == "balance" )
+	{
+		params->m_initialBalance = std::stod( value );
+	}
+	else
+	{
+		return false;
+	}
+	return true;
+}
+
+bool KExecutorCommandParser::parseOptimizerOption(
+	const std::string& name,
+	const std::string& value,
+	SOptimizerParams* params )
+{
+	if ( name == "sample" )
+	{
+		if ( !optimizer::parse( value, &params->m_sampling ) )
+		{
+			throw std::invalid_argument( value );
+		}
+	}
+	else if ( name == "count" )
+	{
+		params->m_sampleCount = std::stoul( value );
+	}
+	else if ( name == "seed" )
+	{
+		params->m_seed = std::stoull( value );
+	}
+	else if ( name == "metric" )
+	{
+		if ( !optimizer::parse( value, &params->m_metric ) )
+		{
+			throw std::invalid_argument( value );
+		}
+	}
+	else if ( name == "threads" )
+	{
+		params->m_threadCount = std::stoul( value );
+	}
+	else
+	{
+		return parseBacktestOption( name, value, &params->m_backtest );
+	}
+	return true;
+}
+
+bool KExecutorCommandParser::parseMonteCarloOption(
+	const std::string& name,
+	const std::string& value,
+	SMonteCarloParams* params )
+{
+	if ( name == "montecarlo" )
+	{
+		params->m_runCount = std::stoul( value );
+	}
+	else if ( name == "method" )
+	{
+		if ( !montecarlo::parse( value, &params->m_method ) )
+		{
+			throw std::invalid_argument( value );
+		}
+	}
+	else
+	{
+		return false;
+	}
+	return true;
+}
+
+datetime_t KExecutorCommandParser::parseDuration( const std::string& value )
+{
+	std::size_t size = 0;
+	const double number = std::stod( value, &size );
+	const std::string& unit = value.substr( size );
+	datetime_t unitSeconds = 1;
+	if ( unit == "m" )
+	{
+		unitSeconds = 60;
+	}
+	else if ( unit == "h" )
+	{
+		unitSeconds = 60 * 60;
+	}
+	else if ( unit == "d" )
+	{
+		unitSeconds = 24 * 60 * 60;
+	}
+	else if ( !unit.empty() )
+	{
+		throw std::invalid_argument( value );
+	}
+
+	const datetime_t result = static_cast< datetime_t >( number * unitSeconds );
+	return result;
+}
+
+const std::map< std::string, KExecutorCommandParser::TCommandParseRoutine > KExecutorCommandParser::s_cmd2parser =
+{
+	{CmdNameListAccounts, &KExecutorCommandParser::parseListAccountsCommand},
+	{CmdNameSelect, &KExecutorCommandParser::parseSelectCommand},
+	{CmdNameHelp, &KExecutorCommandParser::parseHelpCommand},
+	{CmdNameRecord, &KExecutorCommandParser::parseRecordCommand},
+	{CmdNameReplay, &KExecutorCommandParser::parseReplayCommand},
+	{CmdNameAllocs, &KExecutorCommandParser::parseAllocsCommand},
+	{CmdNameStrategies, &KExecutorCommandParser::parseStrategiesCommand},
+	{CmdNamePositions, &KExecutorCommandParser::parsePositionsCommand},
+	{CmdNameEquity, &KExecutorCommandParser::parseEquityCommand},
+	{CmdNameRisk, &KExecutorCommandParser::parseRiskCommand},
+	{CmdNameThrottle, &KExecutorCommandParser::parseThrottleCommand},
+	{CmdNameTrail, &KExecutorCommandParser::parseTrailCommand},
+	{CmdNameConditional, &KExecutorCommandParser::parseConditionalCommand},
+	{CmdNameAlert, &KExecutorCommandParser::parseAlertCommand},
+	{CmdNameAlgo, &KExecutorCommandParser::parseAlgoCommand},
+	{CmdNameCopy, &KExecutorCommandParser::parseCopyCommand},
+	{CmdNamePaper, &KExecutorCommandParser::parsePaperCommand},
+	{CmdNameArchive, &KExecutorCommandParser::parseArchiveCommand},
+	{CmdNameImport, &KExecutorCommandParser::parseImportCommand},
+	{CmdNameBacktest, &KExecutorCommandParser::parseBacktestCommand},
+	{CmdNameOptimize, &KExecutorCommandParser::parseOptimizeCommand},
+	{CmdNameWalkForward, &KExecutorCommandParser::parseWalkForwardCommand},
+};
+
+const std::map<std::string, std::string> KExecutorCommandParser::s_alias2cmd =
+{
+	{"la", CmdNameListAccounts},
+	{"sel", CmdNameSelect},
+	{"h", CmdNameHelp},
+	{"rec", CmdNameRecord},
+	{"rep", CmdNameReplay},
+	{"al", CmdNameAllocs},
+	{"sts", CmdNameStrategies},
+	{"pos", CmdNamePositions},
+	{"eq", CmdNameEquity},
+	{"rk", CmdNameRisk},
+	{"thr", CmdNameThrottle},
+	{"tr", CmdNameTrail},
+	{"cnd", CmdNameConditional},
+	{"alr", CmdNameAlert},
+	{"alg", CmdNameAlgo},
+	{"cp", CmdNameCopy},
+	{"pp", CmdNamePaper},
+	{"arc", CmdNameArchive},
+	{"imp", CmdNameImport},
+	{"bt", CmdNameBacktest},
+	{"opt", CmdNameOptimize},
+	{"wf", CmdNameWalkForward},
+};
+
+// ---------------------------------------------------------------------------
+// ---------------------------------------------------------------------------
+
+struct SGenericTraderCommand;
+struct SGenericStrategyCommand;
+struct SGenericExecutorCommand;
+
+struct IGenericCommandVisitor
+{
+	virtual void visitTraderCommand( SGenericTraderCommand* cmd ) = 0;
+	virtual void visitStrategyCommand( SGenericStrategyCommand* cmd ) = 0;
+	virtual void visitExecutorCommand( SGenericExecutorCommand* cmd ) = 0;
+};
+
+// ---------------------------------------------------------------------------
+
+struct SGenericCommand
+{
+	SGenericCommand( const account_key_t& key )
+		: m_key( key )
+	{
+	}
+
+	virtual ~SGenericCommand()
+	{
+	}
+
+	virtual void accept( IGenericCommandVisitor* visitor ) = 0;
+
+	const account_key_t m_key;
+};
+
+struct SGenericTraderCommand : public SGenericCommand
+{
+	SGenericTraderCommand(
 		const account_key_t& key,
 		HCommand cmd )
 		: SGenericCommand( key )
@@ -489,6 +1695,7 @@ class KExecutor : public IExecutor, ICommandParserCallback, IGenericCommandVisit
 			std::ostream* cout,
 			std::ostream* cerr,
 			IAccountManager* accountManager,
+			ICommunicator* communicator,
 			ITradeManager* tradeManager );
 		virtual ~KExecutor();
 
@@ -515,21 +1722,43 @@ class KExecutor : public IExecutor, ICommandParserCallback, IGenericCommandVisit
 		virtual void visitListAccountsCommand( const SListAccountsCommand& cmd );
 		virtual void visitSelectCommand( const SSelectCommand& cmd );
 		virtual void visitHelpCommand( const SHelpCommand& cmd );
+		virtual void visitRecordCommand( const SRecordCommand& cmd );
+		virtual void visitReplayCommand( const SReplayCommand& cmd );
+		virtual void visitAllocsCommand( const SAllocsCommand& cmd );
+		virtual void visitStrategiesCommand( const SStrategiesCommand& cmd );
+		virtual void visitPositionsCommand( const SPositionsCommand& cmd );
+		virtual void visitEquityCommand( const SEquityCommand& cmd );
+		virtual void visitRiskCommand( const SRiskCommand& cmd );
+		virtual void visitThrottleCommand( const SThrottleCommand& cmd );
+		virtual void visitTrailCommand( const STrailCommand& cmd );
+		virtual void visitConditionalCommand( const SConditionalCommand& cmd );
+		virtual void visitAlertCommand( const SAlertCommand& cmd );
+		virtual void visitAlgoCommand( const SAlgoCommand& cmd );
+		virtual void visitCopyCommand( const SCopyCommand& cmd );
+		virtual void visitPaperCommand( const SPaperCommand& cmd );
+		virtual void visitArchiveCommand( const SArchiveCommand& cmd );
+		virtual void visitImportCommand( const SImportCommand& cmd );
+		virtual void visitBacktestCommand( const SBacktestCommand& cmd );
+		virtual void visitOptimizeCommand( const SOptimizeCommand& cmd );
+		virtual void visitWalkForwardCommand( const SWalkForwardCommand& cmd );
 
 	private:
 		HTrader getTrader( const account_key_t& key );
+		void executeTraderCommand( HTrader trader, HCommand command );
 		HTradingStrategy createStrategy( const std::string& strategyName );
 		void ensureStrategy(
 			HTrader trader,
 			const std::string& symbol,
 			const std::string& strategy );
 		void printAccount( const account_key_t& key );
+		std::string prepareAccountDirName( const account_key_t& key ) const;
 
 	private:
 		std::ostream& m_cout;
 		std::ostream& m_cerr;
 
 		IAccountManager& m_accountManager;
+		ICommunicator& m_communicator;
 		ITradeManager& m_tradeManager;
 
 		strategy2factory_t m_strategyFactories;
@@ -544,10 +1773,12 @@ KExecutor::KExecutor(
 	std::ostream* cout,
 	std::ostream* cerr,
 	IAccountManager* accountManager,
+	ICommunicator* communicator,
 	ITradeManager* tradeManager )
 	: m_cout( *cout )
 	, m_cerr( *cerr )
 	, m_accountManager( *accountManager )
+	, m_communicator( *communicator )
 	, m_tradeManager( *tradeManager )
 {
 }
@@ -570,7 +1801,7 @@ bool KExecutor::executeCommand(const account_key_t& key, HCommand command, std::
 	try
 	{
 		HTrader trader = getTrader( key );
-		trader->executeCommand( command );
+		executeTraderCommand( trader, command );
 		result = true;
 	}
 	catch ( std::exception& e )
@@ -630,7 +1861,7 @@ void KExecutor::visitTraderCommand( SGenericTraderCommand* traderCmd )
 	const account_key_t& key = traderCmd->m_key;
 	HTrader trader = getTrader( key );
 	HCommand command = traderCmd->m_command;
-	trader->executeCommand( command );
+	executeTraderCommand( trader, command );
 }
 
 void KExecutor::visitStrategyCommand( SGenericStrategyCommand* strategyCmd )
@@ -695,6 +1926,662 @@ void KExecutor::visitHelpCommand( const SHelpCommand& cmd )
 	m_cout << consts::CmdExit << std::endl;
 }
 
+void KExecutor::visitRecordCommand( const SRecordCommand& cmd )
+{
+	const std::string& path = cmd.m_path;
+	if ( path.empty() )
+	{
+		HSessionRecorder recorder = m_communicator.stopRecording();
+		if ( recorder )
+		{
+			recorder->printStats( m_cout );
+		}
+		else
+		{
+			m_cout << "session is not recorded" << std::endl;
+		}
+	}
+	else
+	{
+		HSessionRecorder recorder( createSessionRecorder( path ) );
+		m_communicator.startRecording( recorder );
+		m_cout << "recording session to " << path << std::endl;
+	}
+}
+
+void KExecutor::visitReplayCommand( const SReplayCommand& cmd )
+{
+	const std::string& path = cmd.m_path;
+	if ( path.empty() )
+	{
+		m_communicator.stopReplay();
+	}
+	else
+	{
+		m_communicator.startReplay( path, cmd.m_speed, &m_cout );
+	}
+}
+
+void KExecutor::visitAllocsCommand( const SAllocsCommand& cmd )
+{
+	if ( cpp::isAllocTrackingEnabled() )
+	{
+		if ( !cpp::checkAllocSites( m_cout ) )
+		{
+			throw std::runtime_error( "allocation budget exceeded" );
+		}
+	}
+	else
+	{
+		m_cout << "allocation tracking is disabled, build with CPP_TRACK_ALLOCATIONS" << std::endl;
+	}
+}
+
+void KExecutor::visitStrategiesCommand( const SStrategiesCommand& /*cmd*/ )
+{
+	account_keys_t accountKeys;
+	if ( !m_accountManager.getKeys( &accountKeys ) )
+	{
+		m_cout << "no account connected" << std::endl;
+		return;
+	}
+
+	SStrategyPoolStats stats;
+	for ( auto key : accountKeys )
+	{
+		HTrader trader = getTrader( key );
+		trader->getStrategyStats( &stats );
+		m_cout << "account " << key << std::endl;
+		stats.print( m_cout );
+	}
+}
+
+void KExecutor::visitPositionsCommand( const SPositionsCommand& /*cmd*/ )
+{
+	account_keys_t accountKeys;
+	if ( !m_accountManager.getKeys( &accountKeys ) )
+	{
+		m_cout << "no account connected" << std::endl;
+		return;
+	}
+
+	for ( auto key : accountKeys )
+	{
+		HTrader trader = getTrader( key );
+		const IPositionEngine& positionEngine = trader->getPositions();
+		std::vector<SPosition> positions;
+		positionEngine.getPositions( &positions );
+		m_cout << "account " << key << std::endl;
+		m_cout << "symbol open net average buy buyPrice sell sellPrice realized unrealized" << std::endl;
+		for ( const SPosition& position : positions )
+		{
+			m_cout << position.toString() << std::endl;
+		}
+		m_cout << "total symbols open gross realized unrealized" << std::endl;
+		m_cout << "total " << positionEngine.getAccountPosition().toString() << std::endl;
+	}
+}
+
+void KExecutor::visitEquityCommand( const SEquityCommand& cmd )
+{
+	account_keys_t accountKeys;
+	if ( !m_accountManager.getKeys( &accountKeys ) )
+	{
+		m_cout << "no account connected" << std::endl;
+		return;
+	}
+
+	for ( auto key : accountKeys )
+	{
+		HTrader trader = getTrader( key );
+		const IEquityTracker& equityTracker = trader->getEquity();
+		m_cout << "account " << key << std::endl;
+		equityTracker.getStats().print( m_cout );
+
+		std::vector<SEquitySnapshot> history;
+		if ( equityTracker.getHistory( cmd.m_historyCount, &history ) != 0 )
+		{
+			m_cout << "time equity realized unrealized drawdown open" << std::endl;
+			for ( const SEquitySnapshot& snapshot : history )
+			{
+				m_cout << snapshot.m_time << ' ' << snapshot.m_equity << ' ' << snapshot.m_realizedProfit
+					<< ' ' << snapshot.m_unrealizedProfit << ' ' << snapshot.m_drawdown
+					<< ' ' << snapshot.m_openCount << std::endl;
+			}
+		}
+	}
+}
+
+void KExecutor::visitRiskCommand( const SRiskCommand& cmd )
+{
+	account_keys_t accountKeys;
+	if ( !m_accountManager.getKeys( &accountKeys ) )
+	{
+		m_cout << "no account connected" << std::endl;
+		return;
+	}
+
+	for ( auto key : accountKeys )
+	{
+		HTrader trader = getTrader( key );
+		IRiskGuard& riskGuard = trader->getRiskGuard();
+		if ( !cmd.m_options.empty() )
+		{
+			SRiskLimits limits = riskGuard.getLimits();
+			for ( const std::string& option : cmd.m_options )
+			{
+				const std::size_t separator = option.find( '=' );
+				setRiskLimit( option.substr( 0, separator ), option.substr( separator + 1 ), &limits );
+			}
+			riskGuard.setLimits( limits );
+		}
+
+		const SRiskStats stats = riskGuard.getStats();
+		m_cout << "account " << key << std::endl;
+		riskGuard.getLimits().print( m_cout );
+		m_cout << stats.m_checkCount << " orders checked, " << stats.m_refusedCount << " refused, "
+			<< stats.m_reservedCount << " in flight" << std::endl;
+	}
+}
+
+void KExecutor::visitThrottleCommand( const SThrottleCommand& cmd )
+{
+	account_keys_t accountKeys;
+	if ( !m_accountManager.getKeys( &accountKeys ) )
+	{
+		m_cout << "no account connected" << std::endl;
+		return;
+	}
+
+	for ( auto key : accountKeys )
+	{
+		HTrader trader = getTrader( key );
+		HConnection connection = trader->getConnection();
+		m_cout << "account " << key << std::endl;
+		if ( !connection )
+		{
+			m_cout << "not connected" << std::endl;
+			continue;
+		}
+
+		ICommandThrottle& throttle = connection->getThrottle();
+		if ( !cmd.m_options.empty() )
+		{
+			SThrottleLimits limits = throttle.getLimits();
+			for ( const std::string& option : cmd.m_options )
+			{
+				const std::size_t separator = option.find( '=' );
+				setThrottleLimit( option.substr( 0, separator ), option.substr( separator + 1 ), &limits );
+			}
+			throttle.setLimits( limits );
+		}
+
+		throttle.getLimits().print( m_cout );
+		throttle.getStats().print( m_cout );
+	}
+}
+
+void KExecutor::visitTrailCommand( const STrailCommand& cmd )
+{
+	account_keys_t accountKeys;
+	if ( !m_accountManager.getKeys( &accountKeys ) )
+	{
+		m_cout << "no account connected" << std::endl;
+		return;
+	}
+
+	if ( cmd.m_ticket.isNull() )
+	{
+		for ( auto key : accountKeys )
+		{
+			ITrailingStops& trailingStops = getTrader( key )->getTrailingStops();
+			std::vector< STrailingRule > rules;
+			trailingStops.getRules( &rules );
+			const STrailingStats stats = trailingStops.getStats();
+			m_cout << "account " << key << std::endl;
+			for ( const STrailingRule& rule : rules )
+			{
+				m_cout << rule.m_ticket << ' ' << rule.m_symbol << ' ' << ( rule.m_buy ? "buy" : "sell" )
+					<< " distance " << rule.m_distance << " step " << rule.m_step
+					<< " stop loss " << rule.m_stopLoss << std::endl;
+			}
+			m_cout << stats.m_ruleCount << " rules, " << stats.m_tickCount << " ticks, "
+				<< stats.m_triggerCount << " stops moved" << std::endl;
+		}
+		return;
+	}
+
+	// the tickets are unique within an account, the rule goes to the one
+	// which knows the order
+	for ( auto key : accountKeys )
+	{
+		HTrader trader = getTrader( key );
+		ITrailingStops& trailingStops = trader->getTrailingStops();
+		if ( cmd.m_stop )
+		{
+			if ( trailingStops.removeRule( cmd.m_ticket ) )
+			{
+				return;
+			}
+			continue;
+		}
+
+		SOrder order;
+		if ( trader->getOrders().get( cmd.m_ticket, &order ) )
+		{
+			std::string error;
+			if ( !trailingStops.addRule( order, cmd.m_distance, cmd.m_step, &error ) )
+			{
+				throw std::invalid_argument( error );
+			}
+			return;
+		}
+	}
+
+	const std::string error = ( cmd.m_stop ? "no trailing stop of order " : "unknown order " ) + std::to_string( cmd.m_ticket );
+	throw std::invalid_argument( error );
+}
+
+void KExecutor::visitConditionalCommand( const SConditionalCommand& cmd )
+{
+	account_keys_t accountKeys;
+	if ( !m_accountManager.getKeys( &accountKeys ) )
+	{
+		m_cout << "no account connected" << std::endl;
+		return;
+	}
+
+	switch ( cmd.m_action )
+	{
+		case SConditionalCommand::List:
+			for ( auto key : accountKeys )
+			{
+				IConditionalOrders& conditionalOrders = getTrader( key )->getConditionalOrders();
+				std::vector< SConditionalOrder > orders;
+				conditionalOrders.getOrders( &orders );
+				const SConditionalStats stats = conditionalOrders.getStats();
+				m_cout << "account " << key << std::endl;
+				for ( const SConditionalOrder& order : orders )
+				{
+					m_cout << order.toString() << std::endl;
+				}
+				const double avgLatency = ( stats.m_firedCount != 0 ) ? ( stats.m_totalLatency / stats.m_firedCount ) : 0.0;
+				m_cout << stats.m_orderCount << " orders, " << stats.m_tickCount << " ticks, "
+					<< stats.m_firedCount << " fired, " << stats.m_failedCloseCount << " closes failed, latency avg " << avgLatency * 1e6
+					<< "us max " << stats.m_maxLatency * 1e6
+					<< "us last " << stats.m_lastLatency * 1e6 << "us" << std::endl;
+			}
+			return;
+
+		case SConditionalCommand::VirtualStops:
+			// like the trailing stops they go to the account which knows the
+			// order
+			for ( auto key : accountKeys )
+			{
+				HTrader trader = getTrader( key );
+				SOrder order;
+				if ( trader->getOrders().get( cmd.m_ticket, &order ) )
+				{
+					std::string error;
+					const uint32_t id = trader->getConditionalOrders().addVirtualStops(
+						order, cmd.m_stopLoss, cmd.m_takeProfit, &error );
+					if ( id == 0 )
+					{
+						throw std::invalid_argument( error );
+					}
+					m_cout << id << std::endl;
+					return;
+				}
+			}
+			throw std::invalid_argument( "unknown order " + std::to_string( cmd.m_ticket ) );
+
+		default:
+			break;
+	}
+
+	// the new orders and the ids are of the selected account
+	if ( !m_accountManager.exists( m_selectedAccount ) )
+	{
+		throw std::invalid_argument( "default account not selected, please run 'select' command" );
+	}
+
+	IConditionalOrders& conditionalOrders = getTrader( m_selectedAccount )->getConditionalOrders();
+	if ( cmd.m_action == SConditionalCommand::Cancel )
+	{
+		if ( !conditionalOrders.cancel( cmd.m_id ) )
+		{
+			throw std::invalid_argument( "unknown conditional order " + std::to_string( cmd.m_id ) );
+		}
+		return;
+	}
+
+	std::string error;
+	const uint32_t id = ( cmd.m_action == SConditionalCommand::Oco )
+		? conditionalOrders.addOco( cmd.m_entries[0], cmd.m_entries[1], &error )
+		: conditionalOrders.addBracket( cmd.m_entries[0], &error );
+	if ( id == 0 )
+	{
+		throw std::invalid_argument( error );
+	}
+	m_cout << id << std::endl;
+}
+
+void KExecutor::visitAlertCommand( const SAlertCommand& cmd )
+{
+	account_keys_t accountKeys;
+	if ( !m_accountManager.getKeys( &accountKeys ) )
+	{
+		m_cout << "no account connected" << std::endl;
+		return;
+	}
+
+	if ( cmd.m_action == SAlertCommand::List )
+	{
+		for ( auto key : accountKeys )
+		{
+			IAlertEngine& alertEngine = getTrader( key )->getAlerts();
+			std::vector< SAlert > alerts;
+			alertEngine.getAlerts( &alerts );
+			const SAlertStats stats = alertEngine.getStats();
+			m_cout << "account " << key << std::endl;
+			for ( const SAlert& alert : alerts )
+			{
+				m_cout << alert.toString() << std::endl;
+			}
+			m_cout << stats.m_alertCount << " alerts, " << stats.m_tickCount << " ticks, "
+				<< stats.m_firedCount << " fired in " << stats.m_batchCount << " batches" << std::endl;
+		}
+		return;
+	}
+
+	// the alerts are set for the selected account
+	if ( !m_accountManager.exists( m_selectedAccount ) )
+	{
+		throw std::invalid_argument( "default account not selected, please run 'select' command" );
+	}
+
+	IAlertEngine& alertEngine = getTrader( m_selectedAccount )->getAlerts();
+	std::string error;
+	switch ( cmd.m_action )
+	{
+		case SAlertCommand::Add:
+			m_cout << alertEngine.add( cmd.m_symbol, cmd.m_above, cmd.m_price ) << std::endl;
+			break;
+
+		case SAlertCommand::Cancel:
+			if ( !alertEngine.remove( cmd.m_id ) )
+			{
+				throw std::invalid_argument( "unknown alert " + std::to_string( cmd.m_id ) );
+			}
+			break;
+
+		case SAlertCommand::Save:
+			if ( !alertEngine.save( cmd.m_path, &error ) )
+			{
+				throw std::invalid_argument( error );
+			}
+			break;
+
+		default:
+			if ( !alertEngine.load( cmd.m_path, &error ) )
+			{
+				throw std::invalid_argument( error );
+			}
+			m_cout << alertEngine.getStats().m_alertCount << " alerts" << std::endl;
+			break;
+	}
+}
+
+void KExecutor::visitAlgoCommand( const SAlgoCommand& cmd )
+{
+	account_keys_t accountKeys;
+	if ( !m_accountManager.getKeys( &accountKeys ) )
+	{
+		m_cout << "no account connected" << std::endl;
+		return;
+	}
+
+	if ( cmd.m_action == SAlgoCommand::List )
+	{
+		for ( auto key : accountKeys )
+		{
+			std::vector< SAlgoReport > reports;
+			getTrader( key )->getExecutionAlgos().getReports( &reports );
+			m_cout << "account " << key << std::endl;
+			for ( const SAlgoReport& report : reports )
+			{
+				report.print( m_cout );
+			}
+		}
+		return;
+	}
+
+	// the parent orders are of the selected account
+	if ( !m_accountManager.exists( m_selectedAccount ) )
+	{
+		throw std::invalid_argument( "default account not selected, please run 'select' command" );
+	}
+
+	IExecutionAlgos& executionAlgos = getTrader( m_selectedAccount )->getExecutionAlgos();
+	if ( cmd.m_action == SAlgoCommand::Cancel )
+	{
+		if ( !executionAlgos.cancel( cmd.m_id ) )
+		{
+			throw std::invalid_argument( "no running algo " + std::to_string( cmd.m_id ) );
+		}
+		return;
+	}
+
+	std::string error;
+	const uint32_t id = executionAlgos.start( cmd.m_params, &error );
+	if ( id == 0 )
+	{
+		throw std::invalid_argument( error );
+	}
+	m_cout << id << std::endl;
+}
+
+void KExecutor::visitCopyCommand( const SCopyCommand& cmd )
+{
+	ICopyTrader& copyTrader = m_tradeManager.getCopyTrader();
+	std::string error;
+	switch ( cmd.m_action )
+	{
+		case SCopyCommand::List:
+		{
+			const account_key_t master = copyTrader.getMaster();
+			if ( master.isValid() )
+			{
+				m_cout << "master " << master << std::endl;
+			}
+			else
+			{
+				m_cout << "no master" << std::endl;
+			}
+
+			std::vector< SCopyFollower > followers;
+			copyTrader.getFollowers( &followers );
+			for ( const SCopyFollower& follower : followers )
+			{
+				follower.print( m_cout );
+			}
+			copyTrader.getStats().print( m_cout );
+			break;
+		}
+
+		case SCopyCommand::Master:
+			if ( cmd.m_key.isValid() && !m_accountManager.exists( cmd.m_key ) )
+			{
+				throw std::invalid_argument( "unknown account" );
+			}
+			copyTrader.setMaster( cmd.m_key );
+			break;
+
+		case SCopyCommand::Follow:
+			if ( !m_accountManager.exists( cmd.m_follower.m_key ) )
+			{
+				throw std::invalid_argument( "unknown account" );
+			}
+			if ( !copyTrader.setFollower( cmd.m_follower, &error ) )
+			{
+				throw std::invalid_argument( error );
+			}
+			break;
+
+		default:
+			if ( !copyTrader.removeFollower( cmd.m_key ) )
+			{
+				throw std::invalid_argument( "account is not a follower" );
+			}
+			break;
+	}
+}
+
+void KExecutor::visitPaperCommand( const SPaperCommand& /*cmd*/ )
+{
+	account_keys_t accountKeys;
+	if ( !m_accountManager.getKeys( &accountKeys ) )
+	{
+		m_cout << "no account connected" << std::endl;
+		return;
+	}
+
+	for ( auto key : accountKeys )
+	{
+		m_cout << "account " << key << std::endl;
+		SPaperStats stats;
+		if ( m_tradeManager.getPaperStats( key, &stats ) )
+		{
+			stats.print( m_cout );
+		}
+		else
+		{
+			m_cout << "live" << std::endl;
+		}
+	}
+}
+
+void KExecutor::visitArchiveCommand( const SArchiveCommand& cmd )
+{
+	account_keys_t accountKeys;
+	if ( !m_accountManager.getKeys( &accountKeys ) )
+	{
+		m_cout << "no account connected" << std::endl;
+		return;
+	}
+
+	const std::string& directory = cmd.m_directory;
+	for ( auto key : accountKeys )
+	{
+		HTrader trader = getTrader( key );
+		if ( HTickArchive archive = trader->getTickArchive() )
+		{
+			trader->setTickArchive( HTickArchive() );
+			archive->close();
+			archive->printStats( m_cout );
+		}
+
+		if ( !directory.empty() )
+		{
+			const std::string& accountDirectory = directory + "/" + prepareAccountDirName( key );
+			HTickArchive archive( createTickArchive( accountDirectory ) );
+			trader->setTickArchive( archive );
+			m_cout << "archiving ticks of account " << key << " to " << accountDirectory << std::endl;
+		}
+	}
+}
+
+void KExecutor::visitImportCommand( const SImportCommand& cmd )
+{
+	const SHistoryImportResult& result = importHistory( cmd.m_path, cmd.m_directory, cmd.m_symbol );
+
+	std::string what = "ticks";
+	timeframe::ETimeframe tf = timeframe::M1;
+	if ( result.m_kind == history::Bars )
+	{
+		what = timeframe::fromSeconds( result.m_period, &tf )
+			? timeframe::name( tf ) + " bars"
+			: "P" + std::to_string( result.m_period ) + " bars";
+	}
+
+	const double megabytes = result.m_inputSize / ( 1024.0 * 1024.0 );
+	const double seconds = std::max( result.m_seconds, 0.001 );
+	m_cout << "imported " << result.m_symbol << ' ' << what << ": "
+		<< result.m_rowCount << " rows, " << result.m_rejectedCount << " rejected, "
+		<< std::fixed << std::setprecision( 1 ) << megabytes << " MB in "
+		<< std::setprecision( 2 ) << seconds << "s ("
+		<< std::setprecision( 1 ) << ( megabytes / seconds ) << " MB/s) -> "
+		<< result.m_outputPath << std::defaultfloat << std::endl;
+}
+
+void KExecutor::visitBacktestCommand( const SBacktestCommand& cmd )
+{
+	if ( m_strategyFactories.count( cmd.m_strategy ) == 0 )
+	{
+		throw std::invalid_argument( "unknown strategy " + cmd.m_strategy );
+	}
+
+	std::unique_ptr< ITickFeed > feed( openTickFeed( cmd.m_path ) );
+	HTradingStrategy strategy = createStrategy( cmd.m_strategy );
+	const SBacktestReport& report = runBacktest( *feed, strategy.get(), cmd.m_strategyCmdLine, cmd.m_params );
+	report.printSummary( m_cout );
+	if ( cmd.m_monteCarlo.m_runCount != 0 )
+	{
+		std::vector< volume_t > tradeProfits;
+		for ( const SOrder& trade : report.m_trades )
+		{
+			tradeProfits.push_back( SBacktestReport::netProfit( trade ) );
+		}
+
+		cpp::KWorkStealingPool pool;
+		runMonteCarlo( tradeProfits, report.m_initialBalance, cmd.m_monteCarlo, &pool ).print( m_cout );
+	}
+
+	if ( !cmd.m_reportPath.empty() )
+	{
+		report.save( cmd.m_reportPath );
+		m_cout << "report saved to " << cmd.m_reportPath << std::endl;
+	}
+}
+
+void KExecutor::visitOptimizeCommand( const SOptimizeCommand& cmd )
+{
+	auto it = m_strategyFactories.find( cmd.m_strategy );
+	if ( it == m_strategyFactories.end() )
+	{
+		throw std::invalid_argument( "unknown strategy " + cmd.m_strategy );
+	}
+
+	std::unique_ptr< ITickFeed > feed( openTickFeed( cmd.m_path ) );
+	const SOptimizerReport& report = runOptimization(
+		*feed, it->second, cmd.m_strategy, cmd.m_cmdLineTemplate, cmd.m_params );
+	report.printTop( m_cout, cmd.m_topCount );
+	if ( !cmd.m_reportPath.empty() )
+	{
+		report.save( cmd.m_reportPath );
+		m_cout << "results saved to " << cmd.m_reportPath << std::endl;
+	}
+}
+
+void KExecutor::visitWalkForwardCommand( const SWalkForwardCommand& cmd )
+{
+	auto it = m_strategyFactories.find( cmd.m_strategy );
+	if ( it == m_strategyFactories.end() )
+	{
+		throw std::invalid_argument( "unknown strategy " + cmd.m_strategy );
+	}
+
+	std::unique_ptr< ITickFeed > feed( openTickFeed( cmd.m_path ) );
+	const SWalkForwardReport& report = runWalkForward(
+		*feed, it->second, cmd.m_strategy, cmd.m_cmdLineTemplate, cmd.m_params );
+	report.print( m_cout );
+	if ( !cmd.m_reportPath.empty() )
+	{
+		report.save( cmd.m_reportPath );
+		m_cout << "windows saved to " << cmd.m_reportPath << std::endl;
+	}
+}
+
 // ---------------------------------------------------------------------------
 
 HTrader KExecutor::getTrader( const account_key_t& key )
@@ -705,6 +2592,32 @@ HTrader KExecutor::getTrader( const account_key_t& key )
 	return trader;
 }
 
+void KExecutor::executeTraderCommand( HTrader trader, HCommand command )
+{
+	// the orders which are closed or unknown are refused without a round
+	// trip to MetaTrader
+	switch ( command->operation() )
+	{
+		case KCommand::Close:
+		case KCommand::Modify:
+		case KCommand::SetStopLoss:
+		case KCommand::SetTakeProfit:
+		{
+			std::string error;
+			if ( !trader->getOrders().validateTickets( command->tickets(), &error ) )
+			{
+				throw std::invalid_argument( error );
+			}
+			break;
+		}
+
+		default:
+			break;
+	}
+
+	trader->executeCommand( command );
+}
+
 HTradingStrategy KExecutor::createStrategy( const std::string& strategyName )
 {
 	auto it = m_strategyFactories.find( strategyName );
@@ -719,7 +2632,7 @@ void KExecutor::ensureStrategy(
 	const std::string& symbol,
 	const std::string& strategyName )
 {
-	const std::string& currentStrategyName = trader->getStrategy( symbol );
+	const std::string currentStrategyName = trader->getStrategy( symbol );
 	if ( currentStrategyName != strategyName )
 	{
 		if ( !currentStrategyName.empty() )
@@ -738,6 +2651,14 @@ void KExecutor::printAccount( const account_key_t& key )
 	m_cout << key << ' ' << accountInfo.m_broker << ' ' << accountInfo.m_accountLogin << std::endl;
 }
 
+std::string KExecutor::prepareAccountDirName( const account_key_t& key ) const
+{
+	const SAccountInfo& accountInfo = m_accountManager.get( key );
+	std::string result = accountInfo.m_broker + "-" + std::to_string( accountInfo.m_accountLogin );
+	std::replace_if( result.begin(), result.end(), []( const char c ) { return !std::isalnum( static_cast<unsigned char>( c ) ) && ( c != '-' ); }, '_' );
+	return result;
+}
+
 } // anonymous namespace
 
 // ---------------------------------------------------------------------------
@@ -746,9 +2667,10 @@ IExecutor* createExecutor(
 	std::ostream* cout,
 	std::ostream* cerr,
 	IAccountManager* accountManager,
+	ICommunicator* communicator,
 	ITradeManager* tradeManager )
 {
-	IExecutor* executor = new KExecutor( cout, cerr, accountManager, tradeManager );
+	IExecutor* executor = new KExecutor( cout, cerr, accountManager, communicator, tradeManager );
 	return executor;
 }
 
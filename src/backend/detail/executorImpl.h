@@ -7,12 +7,14 @@ namespace fx
 
 struct IExecutor;
 struct IAccountManager;
+struct ICommunicator;
 struct ITradeManager;
 
 IExecutor* createExecutor( 
 	std::ostream* cout,
 	std::ostream* cerr,
 	IAccountManager* accountManager, 
+	ICommunicator* communicator,
 	ITradeManager* tradeManager );
 
 } // namespace fx
@@ -0,0 +1,43 @@
+// author: Darek Slusarczyk alias marines marinesovitch 2012-2013, 2022
+#ifndef INC_BACKEND_HISTORYFORMAT_H
+#define INC_BACKEND_HISTORYFORMAT_H
+
+#include "history.h"
+#include "common/consts.h"
+#include <cstdint>
+
+namespace fx
+{
+
+namespace history
+{
+
+// the file starts with the header padded to HeaderSize, then there are the
+// columns: time (int64_t) and values (double) of ETickColumn or EBarColumn,
+// each column starts at m_columnOffsets, aligned to ColumnAlignment
+const char Signature[] = { 'F', 'X', 'H', 'I', 'S', 'T', '0', '1' };
+
+const char FileExtension[] = ".fxhist";
+
+struct SHeader
+{
+	char m_signature[sizeof(Signature)];
+	char m_symbol[consts::MaxSymbolNameLen];
+	uint32_t m_kind;
+	uint32_t m_columnCount;
+	int64_t m_period;
+	uint64_t m_count;
+	// the time column and then the value columns
+	uint64_t m_columnOffsets[1 + MaxColumnCount];
+};
+
+const std::size_t HeaderSize = 256;
+const std::size_t ColumnAlignment = 64;
+
+static_assert(sizeof(SHeader) <= HeaderSize, "history header doesn't fit");
+
+} // namespace history
+
+} // namespace fx
+
+#endif
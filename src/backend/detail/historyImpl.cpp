@@ -0,0 +1,122 @@
+// author: Darek Slusarczyk alias marines marinesovitch 2012-2013, 2022
+#include "ph.h"
+#include "historyImpl.h"
+#include "history.h"
+#include "historyFormat.h"
+#include "common/mappedFile.h"
+
+namespace fx
+{
+
+namespace
+{
+
+class KHistory : public IHistory
+{
+	public:
+		KHistory(const std::string& path);
+		virtual ~KHistory();
+
+	public:
+		// IHistory
+		virtual const std::string& getSymbol() const;
+		virtual history::EKind getKind() const;
+		virtual datetime_t getPeriod() const;
+
+		virtual std::size_t size() const;
+		virtual const datetime_t* getTimes() const;
+		virtual const double* getColumn(const int column) const;
+
+		virtual std::size_t lowerBound(const datetime_t time) const;
+
+	private:
+		KMappedFile m_file;
+		const history::SHeader* m_header;
+		const char* m_data;
+		std::string m_symbol;
+
+};
+
+// ---------------------------------------------------------------------------
+
+KHistory::KHistory(const std::string& path)
+{
+	m_data = m_file.open(path) ? m_file.mapAll() : nullptr;
+	if ((m_data == nullptr) || (m_file.fileSize() < history::HeaderSize))
+	{
+		throw std::runtime_error("cannot open history " + path);
+	}
+
+	m_header = reinterpret_cast<const history::SHeader*>(m_data);
+	bool valid = std::equal(std::begin(history::Signature), std::end(history::Signature), m_header->m_signature)
+		&& ((m_header->m_kind == history::Ticks) || (m_header->m_kind == history::Bars))
+		&& (m_header->m_columnCount <= history::MaxColumnCount);
+	for (uint32_t i = 0; valid && (i <= m_header->m_columnCount); ++i)
+	{
+		const uint64_t columnEnd = m_header->m_columnOffsets[i] + m_header->m_count * sizeof(double);
+		valid = (columnEnd <= m_file.fileSize());
+	}
+
+	if (!valid)
+	{
+		throw std::runtime_error("incorrect format of history " + path);
+	}
+
+	m_symbol.assign(m_header->m_symbol, strnlen(m_header->m_symbol, sizeof(m_header->m_symbol)));
+}
+
+KHistory::~KHistory()
+{
+}
+
+// ---------------------------------------------------------------------------
+
+const std::string& KHistory::getSymbol() const
+{
+	return m_symbol;
+}
+
+history::EKind KHistory::getKind() const
+{
+	return static_cast<history::EKind>(m_header->m_kind);
+}
+
+datetime_t KHistory::getPeriod() const
+{
+	return m_header->m_period;
+}
+
+std::size_t KHistory::size() const
+{
+	return static_cast<std::size_t>(m_header->m_count);
+}
+
+const datetime_t* KHistory::getTimes() const
+{
+	return reinterpret_cast<const datetime_t*>(m_data + m_header->m_columnOffsets[0]);
+}
+
+const double* KHistory::getColumn(const int column) const
+{
+	assert((0 <= column) && (static_cast<uint32_t>(column) < m_header->m_columnCount));
+	return reinterpret_cast<const double*>(m_data + m_header->m_columnOffsets[1 + column]);
+}
+
+std::size_t KHistory::lowerBound(const datetime_t time) const
+{
+	const datetime_t* times = getTimes();
+	const std::size_t result = std::lower_bound(times, times + size(), time) - times;
+	return result;
+}
+
+} // anonymous namespace
+
+// ---------------------------------------------------------------------------
+
+IHistory* openHistory(const std::string& path)
+{
+	IHistory* history = new KHistory(path);
+	return history;
+}
+
+} // namespace fx
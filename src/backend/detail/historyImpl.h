@@ -0,0 +1,15 @@
+// author: Darek Slusarczyk alias marines marinesovitch 2012-2013, 2022
+#ifndef INC_BACKEND_HISTORYIMPL_H
+#define INC_BACKEND_HISTORYIMPL_H
+
+namespace fx
+{
+
+struct IHistory;
+
+// maps the whole file, throws std::runtime_error if it cannot be used
+IHistory* openHistory(const std::string& path);
+
+} // namespace fx
+
+#endif
@@ -0,0 +1,868 @@
+// author: Darek Slusarczyk alias marines marinesovitch 2012-2013, 2022
+#include "ph.h"
+#include "historyImporter.h"
+#include "historyFormat.h"
+#include "bar.h"
+#include "common/mappedFile.h"
+#include <charconv>
+#include <chrono>
+#include <cstring>
+#include <filesystem>
+
+namespace fx
+{
+
+namespace
+{
+
+// small enough to be mapped in a 32-bit process next to everything else
+const std::size_t WindowSize = 64 * 1024 * 1024;
+const std::size_t ColumnBufferSize = 1024 * 1024;
+
+const datetime_t SecondsPerDay = 24 * 60 * 60;
+
+// the days since 1970-01-01 of the civil date, based on the algorithm of
+// Howard Hinnant
+int64_t daysFromCivil(int64_t year, const int64_t month, const int64_t day)
+{
+	year -= (month <= 2) ? 1 : 0;
+	const int64_t era = (0 <= year ? year : year - 399) / 400;
+	const int64_t yearOfEra = year - era * 400;
+	const int64_t dayOfYear = (153 * (month + (2 < month ? -3 : 9)) + 2) / 5 + day - 1;
+	const int64_t dayOfEra = yearOfEra * 365 + yearOfEra / 4 - yearOfEra / 100 + dayOfYear;
+	return era * 146097 + dayOfEra - 719468;
+}
+
+unsigned int workerCount()
+{
+	const unsigned int result = std::max(1u, std::thread::hardware_concurrency());
+	return result;
+}
+
+// runs routine(i) for i in [0, count) in parallel, one thread per index
+template<typename TRoutine>
+void parallelFor(const std::size_t count, TRoutine routine)
+{
+	std::vector<std::thread> threads;
+	for (std::size_t i = 1; i < count; ++i)
+	{
+		threads.emplace_back(routine, i);
+	}
+	if (0 < count)
+	{
+		routine(0);
+	}
+	for (std::thread& thread : threads)
+	{
+		thread.join();
+	}
+}
+
+// ---------------------------------------------------------------------------
+
+// the rows parsed from a single chunk of input
+struct SRows
+{
+	void clear();
+	void add(const datetime_t time, const double* values, const int valueCount);
+
+	std::vector<datetime_t> m_times;
+	std::vector<double> m_values[history::MaxColumnCount];
+	uint64_t m_rejectedCount = 0;
+	// the shortest step between subsequent rows, it gives the period of bars
+	datetime_t m_minStep = std::numeric_limits<datetime_t>::max();
+};
+
+void SRows::clear()
+{
+	m_times.clear();
+	for (std::vector<double>& values : m_values)
+	{
+		values.clear();
+	}
+	m_rejectedCount = 0;
+	m_minStep = std::numeric_limits<datetime_t>::max();
+}
+
+void SRows::add(const datetime_t time, const double* values, const int valueCount)
+{
+	if (!m_times.empty() && (m_times.back() < time))
+	{
+		m_minStep = std::min(m_minStep, time - m_times.back());
+	}
+	m_times.push_back(time);
+	for (int i = 0; i < valueCount; ++i)
+	{
+		m_values[i].push_back(values[i]);
+	}
+}
+
+// ---------------------------------------------------------------------------
+
+// the columns are collected in temporary files next to the output, so the
+// memory usage doesn't depend on the size of input, at the end they are
+// concatenated into the output file
+class KColumnWriter
+{
+	public:
+		KColumnWriter(const std::string& outputPath, const int valueCount);
+		~KColumnWriter();
+
+	public:
+		void append(const SRows& rows);
+		uint64_t count() const;
+		void finish(const std::string& symbol, const history::EKind kind, const datetime_t period);
+
+	private:
+		struct SColumnFile
+		{
+			std::string m_path;
+			std::vector<char> m_buffer;
+			std::ofstream m_stream;
+		};
+
+		void openColumn(SColumnFile* column, const std::string& path);
+		void writeColumn(SColumnFile* column, const char* data, const std::size_t size);
+		void removeColumns();
+
+	private:
+		const std::string m_outputPath;
+		const int m_valueCount;
+		std::vector<std::unique_ptr<SColumnFile>> m_columns;
+		uint64_t m_count = 0;
+
+};
+
+// ---------------------------------------------------------------------------
+
+KColumnWriter::KColumnWriter(const std::string& outputPath, const int valueCount)
+	: m_outputPath(outputPath)
+	, m_valueCount(valueCount)
+{
+	for (int i = 0; i <= valueCount; ++i)
+	{
+		std::unique_ptr<SColumnFile> column(new SColumnFile());
+		openColumn(column.get(), outputPath + ".col" + std::to_string(i));
+		m_columns.push_back(std::move(column));
+	}
+}
+
+KColumnWriter::~KColumnWriter()
+{
+	removeColumns();
+}
+
+void KColumnWriter::append(const SRows& rows)
+{
+	writeColumn(m_columns[0].get(), reinterpret_cast<const char*>(rows.m_times.data()), rows.m_times.size() * sizeof(datetime_t));
+	for (int i = 0; i < m_valueCount; ++i)
+	{
+		const std::vector<double>& values = rows.m_values[i];
+		writeColumn(m_columns[1 + i].get(), reinterpret_cast<const char*>(values.data()), values.size() * sizeof(double));
+	}
+	m_count += rows.m_times.size();
+}
+
+uint64_t KColumnWriter::count() const
+{
+	return m_count;
+}
+
+void KColumnWriter::finish(const std::string& symbol, const history::EKind kind, const datetime_t period)
+{
+	history::SHeader header;
+	memset(&header, 0, sizeof(header));
+	std::copy(std::begin(history::Signature), std::end(history::Signature), header.m_signature);
+	symbol.copy(header.m_symbol, sizeof(header.m_symbol) - 1);
+	header.m_kind = kind;
+	header.m_columnCount = m_valueCount;
+	header.m_period = period;
+	header.m_count = m_count;
+
+	uint64_t offset = history::HeaderSize;
+	for (int i = 0; i <= m_valueCount; ++i)
+	{
+		header.m_columnOffsets[i] = offset;
+		const uint64_t columnSize = m_count * sizeof(double);
+		offset += (columnSize + history::ColumnAlignment - 1) / history::ColumnAlignment * history::ColumnAlignment;
+	}
+
+	std::vector<char> buffer(ColumnBufferSize);
+	std::ofstream output;
+	output.rdbuf()->pubsetbuf(buffer.data(), buffer.size());
+	output.open(m_outputPath, std::ios::binary | std::ios::trunc);
+	if (!output)
+	{
+		throw std::runtime_error("cannot create file " + m_outputPath);
+	}
+
+	std::vector<char> padding(history::HeaderSize, 0);
+	output.write(reinterpret_cast<const char*>(&header), sizeof(header));
+	output.write(padding.data(), history::HeaderSize - sizeof(header));
+
+	for (int i = 0; i <= m_valueCount; ++i)
+	{
+		SColumnFile& column = *m_columns[i];
+		column.m_stream.close();
+
+		const uint64_t position = static_cast<uint64_t>(output.tellp());
+		assert(position <= header.m_columnOffsets[i]);
+		output.write(padding.data(), static_cast<std::streamsize>(header.m_columnOffsets[i] - position));
+
+		std::ifstream input(column.m_path, std::ios::binary);
+		if (0 < m_count)
+		{
+			output << input.rdbuf();
+		}
+	}
+
+	if (!output.flush())
+	{
+		throw std::runtime_error("cannot write file " + m_outputPath);
+	}
+}
+
+void KColumnWriter::openColumn(SColumnFile* column, const std::string& path)
+{
+	column->m_path = path;
+	column->m_buffer.resize(ColumnBufferSize);
+	column->m_stream.rdbuf()->pubsetbuf(column->m_buffer.data(), column->m_buffer.size());
+	column->m_stream.open(path, std::ios::binary | std::ios::trunc);
+	if (!column->m_stream)
+	{
+		throw std::runtime_error("cannot create file " + path);
+	}
+}
+
+void KColumnWriter::writeColumn(SColumnFile* column, const char* data, const std::size_t size)
+{
+	if (!column->m_stream.write(data, size))
+	{
+		throw std::runtime_error("cannot write file " + column->m_path);
+	}
+}
+
+void KColumnWriter::removeColumns()
+{
+	for (std::unique_ptr<SColumnFile>& column : m_columns)
+	{
+		column->m_stream.close();
+		std::error_code error;
+		std::filesystem::remove(column->m_path, error);
+	}
+	m_columns.clear();
+}
+
+// ---------------------------------------------------------------------------
+// ---------------------------------------------------------------------------
+
+// the base of importers of particular formats
+class KImporter
+{
+	public:
+		KImporter(const std::string& inputPath);
+		virtual ~KImporter();
+
+	public:
+		void run(const std::string& outputDirectory, const std::string& symbol, SHistoryImportResult* result);
+
+	protected:
+		// recognizes the format, sets m_kind, m_valueCount, m_symbol and m_period
+		// if they are known from the input, returns the offset of the data
+		virtual uint64_t readHeader() = 0;
+		// returns the size of the window which ends at the boundary of a row
+		virtual std::size_t adjustWindow(const char* window, const std::size_t size, const bool lastWindow) = 0;
+		virtual void splitWindow(const char* window, const std::size_t size, std::vector<std::pair<std::size_t, std::size_t>>* chunks) = 0;
+		virtual void parseChunk(const char* first, const char* last, SRows* rows) const = 0;
+
+	private:
+		std::string prepareOutputPath(const std::string& outputDirectory) const;
+
+	protected:
+		KMappedFile m_input;
+		history::EKind m_kind = history::Bars;
+		int m_valueCount = 0;
+		std::string m_symbol;
+		datetime_t m_period = 0;
+
+};
+
+// ---------------------------------------------------------------------------
+
+KImporter::KImporter(const std::string& inputPath)
+{
+	if (!m_input.open(inputPath))
+	{
+		throw std::runtime_error("cannot open file " + inputPath);
+	}
+}
+
+KImporter::~KImporter()
+{
+}
+
+void KImporter::run(const std::string& outputDirectory, const std::string& symbol, SHistoryImportResult* result)
+{
+	const auto start = std::chrono::steady_clock::now();
+	if (!symbol.empty())
+	{
+		m_symbol = symbol;
+	}
+
+	uint64_t offset = readHeader();
+	if (m_symbol.empty())
+	{
+		m_symbol = std::filesystem::path(m_input.path()).stem().string();
+	}
+
+	std::error_code error;
+	std::filesystem::create_directories(outputDirectory, error);
+	// the name of output is known after parsing (the period of csv bars),
+	// so the columns are collected under a temporary name
+	const std::string& tempPath = outputDirectory + "/" + m_symbol + ".import";
+	KColumnWriter writer(tempPath, m_valueCount);
+
+	const uint64_t inputSize = m_input.fileSize();
+	std::vector<std::pair<std::size_t, std::size_t>> chunks;
+	std::vector<SRows> chunkRows(workerCount());
+	uint64_t rejectedCount = 0;
+	datetime_t minStep = std::numeric_limits<datetime_t>::max();
+	while (offset < inputSize)
+	{
+		const std::size_t viewSize = static_cast<std::size_t>(std::min<uint64_t>(WindowSize, inputSize - offset));
+		const char* window = m_input.mapView(offset, viewSize);
+		if (window == nullptr)
+		{
+			throw std::runtime_error("cannot map file " + m_input.path());
+		}
+
+		const bool lastWindow = (offset + viewSize == inputSize);
+		const std::size_t windowSize = adjustWindow(window, viewSize, lastWindow);
+		if (windowSize == 0)
+		{
+			throw std::runtime_error("row longer than window in " + m_input.path());
+		}
+
+		chunks.clear();
+		splitWindow(window, windowSize, &chunks);
+		assert(chunks.size() <= chunkRows.size());
+		parallelFor(chunks.size(), [&](const std::size_t i)
+		{
+			chunkRows[i].clear();
+			parseChunk(window + chunks[i].first, window + chunks[i].second, &chunkRows[i]);
+		});
+
+		for (std::size_t i = 0; i < chunks.size(); ++i)
+		{
+			writer.append(chunkRows[i]);
+			rejectedCount += chunkRows[i].m_rejectedCount;
+			minStep = std::min(minStep, chunkRows[i].m_minStep);
+		}
+
+		offset += windowSize;
+	}
+
+	if ((m_kind == history::Bars) && (m_period == 0) && (minStep != std::numeric_limits<datetime_t>::max()))
+	{
+		m_period = minStep;
+	}
+
+	const std::string& outputPath = prepareOutputPath(outputDirectory);
+	writer.finish(m_symbol, m_kind, m_period);
+	std::filesystem::rename(tempPath, outputPath, error);
+	if (error)
+	{
+		throw std::runtime_error("cannot create file " + outputPath);
+	}
+
+	result->m_outputPath = outputPath;
+	result->m_symbol = m_symbol;
+	result->m_kind = m_kind;
+	result->m_period = m_period;
+	result->m_rowCount = writer.count();
+	result->m_rejectedCount = rejectedCount;
+	result->m_inputSize = inputSize;
+	result->m_seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+std::string KImporter::prepareOutputPath(const std::string& outputDirectory) const
+{
+	std::string suffix;
+	timeframe::ETimeframe tf = timeframe::M1;
+	if (m_kind == history::Ticks)
+	{
+		suffix = "ticks";
+	}
+	else if (timeframe::fromSeconds(m_period, &tf))
+	{
+		suffix = timeframe::name(tf);
+	}
+	else
+	{
+		suffix = "P" + std::to_string(m_period);
+	}
+
+	const std::string& result = outputDirectory + "/" + m_symbol + "_" + suffix + history::FileExtension;
+	return result;
+}
+
+// ---------------------------------------------------------------------------
+// ---------------------------------------------------------------------------
+
+class KCsvImporter : public KImporter
+{
+	public:
+		KCsvImporter(const std::string& inputPath);
+
+	protected:
+		virtual uint64_t readHeader();
+		virtual std::size_t adjustWindow(const char* window, const std::size_t size, const bool lastWindow);
+		virtual void splitWindow(const char* window, const std::size_t size, std::vector<std::pair<std::size_t, std::size_t>>* chunks);
+		virtual void parseChunk(const char* first, const char* last, SRows* rows) const;
+
+	private:
+		static bool parseInt(const char** pos, const char* last, int* value);
+		static bool skipSeparator(const char** pos, const char* last, const char* separators);
+		static bool parseDateTime(const char** pos, const char* last, datetime_t* time);
+		static int countValues(const char* pos, const char* last);
+		bool parseLine(const char* first, const char* last, datetime_t* time, double* values) const;
+
+	private:
+		// the number of values in the line, it may be less than m_valueCount
+		int m_lineValueCount = 0;
+
+};
+
+// ---------------------------------------------------------------------------
+
+KCsvImporter::KCsvImporter(const std::string& inputPath)
+	: KImporter(inputPath)
+{
+}
+
+uint64_t KCsvImporter::readHeader()
+{
+	// the format is recognized by the first line which starts with date
+	const std::size_t viewSize = static_cast<std::size_t>(std::min<uint64_t>(WindowSize, m_input.fileSize()));
+	const char* view = m_input.mapView(0, viewSize);
+	const char* pos = view;
+	const char* last = view + viewSize;
+	while ((pos != nullptr) && (pos < last))
+	{
+		const char* lineEnd = static_cast<const char*>(memchr(pos, '\n', last - pos));
+		if (lineEnd == nullptr)
+		{
+			lineEnd = last;
+		}
+
+		const char* linePos = pos;
+		datetime_t time = 0;
+		if (parseDateTime(&linePos, lineEnd, &time))
+		{
+			m_lineValueCount = countValues(linePos, lineEnd);
+			break;
+		}
+		pos = lineEnd + 1;
+	}
+
+	switch (m_lineValueCount)
+	{
+		case 2:
+		case 3:
+			m_kind = history::Ticks;
+			m_valueCount = history::TickColumnCount;
+			break;
+
+		case 4:
+		case 5:
+			m_kind = history::Bars;
+			m_valueCount = history::BarColumnCount;
+			break;
+
+		default:
+			throw std::runtime_error("unknown format of " + m_input.path());
+	}
+
+	// the period in name of MetaTrader export (e.g. EURUSD60) is not reliable,
+	// it is detected from the data, so only the symbol is taken
+	std::string name = std::filesystem::path(m_input.path()).stem().string();
+	while (!name.empty() && std::isdigit(static_cast<unsigned char>(name.back())))
+	{
+		name.pop_back();
+	}
+	if (m_symbol.empty())
+	{
+		m_symbol = name;
+	}
+	return 0;
+}
+
+std::size_t KCsvImporter::adjustWindow(const char* window, const std::size_t size, const bool lastWindow)
+{
+	if (lastWindow)
+	{
+		return size;
+	}
+
+	std::size_t result = size;
+	while ((0 < result) && (window[result - 1] != '\n'))
+	{
+		--result;
+	}
+	return result;
+}
+
+void KCsvImporter::splitWindow(const char* window, const std::size_t size, std::vector<std::pair<std::size_t, std::size_t>>* chunks)
+{
+	const std::size_t count = workerCount();
+	const std::size_t chunkSize = size / count + 1;
+	std::size_t first = 0;
+	while (first < size)
+	{
+		std::size_t last = std::min(first + chunkSize, size);
+		const char* lineEnd = (last < size) ? static_cast<const char*>(memchr(window + last, '\n', size - last)) : nullptr;
+		last = (lineEnd != nullptr) ? (lineEnd - window + 1) : size;
+		chunks->emplace_back(first, last);
+		first = last;
+	}
+}
+
+void KCsvImporter::parseChunk(const char* first, const char* last, SRows* rows) const
+{
+	const char* pos = first;
+	datetime_t time = 0;
+	double values[history::MaxColumnCount] = { 0 };
+	while (pos < last)
+	{
+		const char* lineEnd = static_cast<const char*>(memchr(pos, '\n', last - pos));
+		if (lineEnd == nullptr)
+		{
+			lineEnd = last;
+		}
+
+		const char* contentEnd = lineEnd;
+		while ((pos < contentEnd) && ((contentEnd[-1] == '\r') || (contentEnd[-1] == ' ')))
+		{
+			--contentEnd;
+		}
+
+		if (pos < contentEnd)
+		{
+			if (parseLine(pos, contentEnd, &time, values))
+			{
+				rows->add(time, values, m_valueCount);
+			}
+			else
+			{
+				++rows->m_rejectedCount;
+			}
+		}
+		pos = lineEnd + 1;
+	}
+}
+
+// ---------------------------------------------------------------------------
+
+bool KCsvImporter::parseInt(const char** pos, const char* last, int* value)
+{
+	const std::from_chars_result result = std::from_chars(*pos, last, *value);
+	*pos = result.ptr;
+	return result.ec == std::errc();
+}
+
+// skips a single character from separators or any non-digit if separators
+// are nullptr
+bool KCsvImporter::skipSeparator(const char** pos, const char* last, const char* separators)
+{
+	if ((*pos == last) || std::isdigit(static_cast<unsigned char>(**pos))
+		|| ((separators != nullptr) && (strchr(separators, **pos) == nullptr)))
+	{
+		return false;
+	}
+	++*pos;
+	return true;
+}
+
+bool KCsvImporter::parseDateTime(const char** pos, const char* last, datetime_t* time)
+{
+	// yyyy.mm.dd, the separator may be any non-digit
+	int year = 0;
+	int month = 0;
+	int day = 0;
+	if (!parseInt(pos, last, &year) || !skipSeparator(pos, last, nullptr)
+		|| !parseInt(pos, last, &month) || !skipSeparator(pos, last, nullptr)
+		|| !parseInt(pos, last, &day))
+	{
+		return false;
+	}
+
+	// date and time are separated by comma, space or T
+	if (!skipSeparator(pos, last, ", T"))
+	{
+		return false;
+	}
+
+	// hh:mm[:ss[.fff]]
+	int hour = 0;
+	int minute = 0;
+	int second = 0;
+	if (!parseInt(pos, last, &hour) || !skipSeparator(pos, last, ":")
+		|| !parseInt(pos, last, &minute))
+	{
+		return false;
+	}
+
+	if (skipSeparator(pos, last, ":"))
+	{
+		if (!parseInt(pos, last, &second))
+		{
+			return false;
+		}
+
+		if (skipSeparator(pos, last, "."))
+		{
+			while ((*pos != last) && std::isdigit(static_cast<unsigned char>(**pos)))
+			{
+				++*pos;
+			}
+		}
+	}
+
+	if ((month < 1) || (12 < month) || (day < 1) || (31 < day)
+		|| (23 < hour) || (59 < minute) || (60 < second))
+	{
+		return false;
+	}
+
+	*time = daysFromCivil(year, month, day) * SecondsPerDay + hour * 3600 + minute * 60 + second;
+	return true;
+}
+
+int KCsvImporter::countValues(const char* pos, const char* last)
+{
+	const int result = static_cast<int>(std::count(pos, last, ','));
+	return result;
+}
+
+bool KCsvImporter::parseLine(const char* first, const char* last, datetime_t* time, double* values) const
+{
+	const char* pos = first;
+	if (!parseDateTime(&pos, last, time))
+	{
+		return false;
+	}
+
+	for (int i = 0; i < m_lineValueCount; ++i)
+	{
+		if ((pos == last) || (*pos != ','))
+		{
+			return false;
+		}
+		++pos;
+		const std::from_chars_result result = std::from_chars(pos, last, values[i]);
+		if (result.ec != std::errc())
+		{
+			return false;
+		}
+		pos = result.ptr;
+	}
+
+	// the optional columns (tick last price, bar volume)
+	for (int i = m_lineValueCount; i < m_valueCount; ++i)
+	{
+		values[i] = 0.0;
+	}
+
+	const bool result = (pos == last);
+	return result;
+}
+
+// ---------------------------------------------------------------------------
+// ---------------------------------------------------------------------------
+
+namespace hst
+{
+
+#pragma pack(push, 1)
+
+struct SHeader
+{
+	int32_t m_version;
+	char m_copyright[64];
+	char m_symbol[12];
+	int32_t m_period;
+	int32_t m_digits;
+	int32_t m_timeSign;
+	int32_t m_lastSync;
+	int32_t m_unused[13];
+};
+
+struct SRecord400
+{
+	int32_t m_time;
+	double m_open;
+	double m_low;
+	double m_high;
+	double m_close;
+	double m_volume;
+};
+
+struct SRecord401
+{
+	int64_t m_time;
+	double m_open;
+	double m_high;
+	double m_low;
+	double m_close;
+	int64_t m_volume;
+	int32_t m_spread;
+	int64_t m_realVolume;
+};
+
+#pragma pack(pop)
+
+} // namespace hst
+
+// ---------------------------------------------------------------------------
+
+class KHstImporter : public KImporter
+{
+	public:
+		KHstImporter(const std::string& inputPath);
+
+	protected:
+		virtual uint64_t readHeader();
+		virtual std::size_t adjustWindow(const char* window, const std::size_t size, const bool lastWindow);
+		virtual void splitWindow(const char* window, const std::size_t size, std::vector<std::pair<std::size_t, std::size_t>>* chunks);
+		virtual void parseChunk(const char* first, const char* last, SRows* rows) const;
+
+	private:
+		int32_t m_version = 0;
+		std::size_t m_recordSize = 0;
+
+};
+
+// ---------------------------------------------------------------------------
+
+KHstImporter::KHstImporter(const std::string& inputPath)
+	: KImporter(inputPath)
+{
+}
+
+uint64_t KHstImporter::readHeader()
+{
+	const char* view = m_input.mapView(0, sizeof(hst::SHeader));
+	if ((view == nullptr) || (m_input.fileSize() < sizeof(hst::SHeader)))
+	{
+		throw std::runtime_error("incorrect format of " + m_input.path());
+	}
+
+	hst::SHeader header;
+	memcpy(&header, view, sizeof(header));
+	m_version = header.m_version;
+	switch (m_version)
+	{
+		case 400:
+			m_recordSize = sizeof(hst::SRecord400);
+			break;
+
+		case 401:
+			m_recordSize = sizeof(hst::SRecord401);
+			break;
+
+		default:
+			throw std::runtime_error("unsupported version of " + m_input.path());
+	}
+
+	m_kind = history::Bars;
+	m_valueCount = history::BarColumnCount;
+	m_period = static_cast<datetime_t>(header.m_period) * 60;
+	if (m_symbol.empty())
+	{
+		m_symbol.assign(header.m_symbol, strnlen(header.m_symbol, sizeof(header.m_symbol)));
+	}
+	return sizeof(hst::SHeader);
+}
+
+std::size_t KHstImporter::adjustWindow(const char* /*window*/, const std::size_t size, const bool lastWindow)
+{
+	// a truncated record at the end of file is skipped
+	const std::size_t result = size - size % m_recordSize;
+	return (lastWindow && (result == 0)) ? size : result;
+}
+
+void KHstImporter::splitWindow(const char* /*window*/, const std::size_t size, std::vector<std::pair<std::size_t, std::size_t>>* chunks)
+{
+	const std::size_t recordCount = size / m_recordSize;
+	const std::size_t count = workerCount();
+	const std::size_t chunkRecords = recordCount / count + 1;
+	for (std::size_t first = 0; first < recordCount; first += chunkRecords)
+	{
+		const std::size_t last = std::min(first + chunkRecords, recordCount);
+		chunks->emplace_back(first * m_recordSize, last * m_recordSize);
+	}
+}
+
+void KHstImporter::parseChunk(const char* first, const char* last, SRows* rows) const
+{
+	const std::size_t recordCount = (last - first) / m_recordSize;
+	rows->m_times.reserve(recordCount);
+	double values[history::BarColumnCount];
+	for (const char* pos = first; pos + m_recordSize <= last; pos += m_recordSize)
+	{
+		datetime_t time = 0;
+		if (m_version == 400)
+		{
+			hst::SRecord400 record;
+			memcpy(&record, pos, sizeof(record));
+			time = record.m_time;
+			values[history::Open] = record.m_open;
+			values[history::High] = record.m_high;
+			values[history::Low] = record.m_low;
+			values[history::Close] = record.m_close;
+			values[history::Volume] = record.m_volume;
+		}
+		else
+		{
+			hst::SRecord401 record;
+			memcpy(&record, pos, sizeof(record));
+			time = record.m_time;
+			values[history::Open] = record.m_open;
+			values[history::High] = record.m_high;
+			values[history::Low] = record.m_low;
+			values[history::Close] = record.m_close;
+			values[history::Volume] = static_cast<double>(record.m_volume);
+		}
+		rows->add(time, values, history::BarColumnCount);
+	}
+	rows->m_rejectedCount += ((last - first) % m_recordSize) ? 1 : 0;
+}
+
+} // anonymous namespace
+
+// ---------------------------------------------------------------------------
+
+SHistoryImportResult importHistory(
+	const std::string& inputPath,
+	const std::string& outputDirectory,
+	const std::string& symbol)
+{
+	std::string extension = std::filesystem::path(inputPath).extension().string();
+	std::transform(extension.begin(), extension.end(), extension.begin(), [](const char c) { return static_cast<char>(std::tolower(static_cast<unsigned char>(c))); });
+
+	std::unique_ptr<KImporter> importer;
+	if (extension == ".hst")
+	{
+		importer.reset(new KHstImporter(inputPath));
+	}
+	else
+	{
+		importer.reset(new KCsvImporter(inputPath));
+	}
+
+	SHistoryImportResult result;
+	importer->run(outputDirectory, symbol, &result);
+	return result;
+}
+
+} // namespace fx
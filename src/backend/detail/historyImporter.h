@@ -0,0 +1,38 @@
+// author: Darek Slusarczyk alias marines marinesovitch 2012-2013, 2022
+#ifndef INC_BACKEND_HISTORYIMPORTER_H
+#define INC_BACKEND_HISTORYIMPORTER_H
+
+#include "history.h"
+
+namespace fx
+{
+
+struct SHistoryImportResult
+{
+	std::string m_outputPath;
+	std::string m_symbol;
+	history::EKind m_kind = history::Bars;
+	datetime_t m_period = 0;
+	uint64_t m_rowCount = 0;
+	uint64_t m_rejectedCount = 0;
+	uint64_t m_inputSize = 0;
+	double m_seconds = 0.0;
+};
+
+// imports MetaTrader history into <outputDirectory>/<symbol>_<timeframe>.fxhist
+// (or _ticks for ticks), the supported inputs are:
+// - .hst bar files (version 400 and 401)
+// - csv with bars: date,time,open,high,low,close[,volume]
+// - csv with ticks: date time,bid,ask[,last]
+// the date is yyyy.mm.dd, the time hh:mm[:ss[.fff]]; if symbol is empty it is
+// taken from .hst header or from the name of csv (e.g. EURUSD60.csv); the
+// input is mapped by windows and each window is parsed in parallel, so the
+// size of the input is not limited by memory; throws std::runtime_error
+SHistoryImportResult importHistory(
+	const std::string& inputPath,
+	const std::string& outputDirectory,
+	const std::string& symbol);
+
+} // namespace fx
+
+#endif
@@ -0,0 +1,424 @@
+// author: Darek Slusarczyk alias marines marinesovitch 2012-2013, 2022
+#include "ph.h"
+#include "indicatorBatch.h"
+#include <cmath>
+#include <intrin.h>
+#include <immintrin.h>
+
+namespace fx
+{
+
+namespace indicator
+{
+
+namespace
+{
+
+const double NotReady = std::numeric_limits<double>::quiet_NaN();
+
+// the window sums are computed exactly at the start of each block and then
+// updated by the differences, so the rounding errors don't add up over the
+// whole column
+const std::size_t SyncBlock = 1024;
+
+// ---------------------------------------------------------------------------
+// the kernels, all the indicators are made of them
+
+// output[i] = input[i - period + 1] + ... + input[i] for i >= period - 1
+typedef void (*window_sums_t)(const double* input, const std::size_t size, const std::size_t period, double* output);
+
+// output[i] = a * output[i - 1] + b * input[i], output[-1] = initial
+typedef void (*recurrence_t)(
+	const double* input,
+	const std::size_t size,
+	const double a,
+	const double b,
+	const double initial,
+	double* output);
+
+double exactWindowSum(const double* input, const std::size_t last, const std::size_t period)
+{
+	double sum = 0.0;
+	for (std::size_t i = last + 1 - period; i <= last; ++i)
+	{
+		sum += input[i];
+	}
+	return sum;
+}
+
+void windowSumsScalar(const double* input, const std::size_t size, const std::size_t period, double* output)
+{
+	for (std::size_t block = period - 1; block < size; block += SyncBlock)
+	{
+		const std::size_t end = std::min(block + SyncBlock, size);
+		double sum = exactWindowSum(input, block, period);
+		output[block] = sum;
+		for (std::size_t i = block + 1; i < end; ++i)
+		{
+			sum += input[i] - input[i - period];
+			output[i] = sum;
+		}
+	}
+}
+
+void recurrenceScalar(
+	const double* input,
+	const std::size_t size,
+	const double a,
+	const double b,
+	const double initial,
+	double* output)
+{
+	double previous = initial;
+	for (std::size_t i = 0; i < size; ++i)
+	{
+		previous = a * previous + b * input[i];
+		output[i] = previous;
+	}
+}
+
+// ---------------------------------------------------------------------------
+// AVX2: both kernels are prefix scans, each vector of four values is scanned
+// in two steps of shifts across lanes and then gets the carry of the
+// previous vector
+
+// [0, v0, v1, v2]
+inline __m256d shiftByOne(const __m256d v)
+{
+	return _mm256_blend_pd(_mm256_permute4x64_pd(v, _MM_SHUFFLE(2, 1, 0, 0)), _mm256_setzero_pd(), 0x1);
+}
+
+// [0, 0, v0, v1]
+inline __m256d shiftByTwo(const __m256d v)
+{
+	return _mm256_blend_pd(_mm256_permute4x64_pd(v, _MM_SHUFFLE(1, 0, 0, 0)), _mm256_setzero_pd(), 0x3);
+}
+
+inline __m256d broadcastLast(const __m256d v)
+{
+	return _mm256_permute4x64_pd(v, _MM_SHUFFLE(3, 3, 3, 3));
+}
+
+void windowSumsAvx2(const double* input, const std::size_t size, const std::size_t period, double* output)
+{
+	for (std::size_t block = period - 1; block < size; block += SyncBlock)
+	{
+		const std::size_t end = std::min(block + SyncBlock, size);
+		double sum = exactWindowSum(input, block, period);
+		output[block] = sum;
+
+		std::size_t i = block + 1;
+		__m256d carry = _mm256_set1_pd(sum);
+		for (; i + 4 <= end; i += 4)
+		{
+			__m256d difference = _mm256_sub_pd(_mm256_loadu_pd(input + i), _mm256_loadu_pd(input + i - period));
+			difference = _mm256_add_pd(difference, shiftByOne(difference));
+			difference = _mm256_add_pd(difference, shiftByTwo(difference));
+			const __m256d sums = _mm256_add_pd(difference, carry);
+			_mm256_storeu_pd(output + i, sums);
+			carry = broadcastLast(sums);
+		}
+
+		sum = output[i - 1];
+		for (; i < end; ++i)
+		{
+			sum += input[i] - input[i - period];
+			output[i] = sum;
+		}
+	}
+}
+
+void recurrenceAvx2(
+	const double* input,
+	const std::size_t size,
+	const double a,
+	const double b,
+	const double initial,
+	double* output)
+{
+	const double a2 = a * a;
+	const __m256d factor = _mm256_set1_pd(a);
+	const __m256d factor2 = _mm256_set1_pd(a2);
+	const __m256d weight = _mm256_set1_pd(b);
+	// the share of the carry in each lane
+	const __m256d carryFactors = _mm256_setr_pd(a, a2, a2 * a, a2 * a2);
+
+	std::size_t i = 0;
+	__m256d carry = _mm256_set1_pd(initial);
+	for (; i + 4 <= size; i += 4)
+	{
+		__m256d values = _mm256_mul_pd(weight, _mm256_loadu_pd(input + i));
+		values = _mm256_add_pd(values, _mm256_mul_pd(factor, shiftByOne(values)));
+		values = _mm256_add_pd(values, _mm256_mul_pd(factor2, shiftByTwo(values)));
+		values = _mm256_add_pd(values, _mm256_mul_pd(carryFactors, carry));
+		_mm256_storeu_pd(output + i, values);
+		carry = broadcastLast(values);
+	}
+
+	const double previous = (i != 0) ? output[i - 1] : initial;
+	recurrenceScalar(input + i, size - i, a, b, previous, output + i);
+}
+
+// ---------------------------------------------------------------------------
+
+bool hasAvx2()
+{
+	int info[4] = { 0, 0, 0, 0 };
+	__cpuid(info, 0);
+	if (info[0] < 7)
+	{
+		return false;
+	}
+
+	__cpuid(info, 1);
+	const bool osxsave = (info[2] & (1 << 27)) != 0;
+	const bool avx = (info[2] & (1 << 28)) != 0;
+	// the system has to save the ymm registers too
+	if (!osxsave || !avx || ((_xgetbv(0) & 0x6) != 0x6))
+	{
+		return false;
+	}
+
+	__cpuidex(info, 7, 0);
+	const bool result = (info[1] & (1 << 5)) != 0;
+	return result;
+}
+
+struct SKernels
+{
+	bool m_avx2;
+	window_sums_t m_windowSums;
+	recurrence_t m_recurrence;
+};
+
+const SKernels& kernels()
+{
+	static const SKernels s_kernels = hasAvx2()
+		? SKernels{ true, &windowSumsAvx2, &recurrenceAvx2 }
+		: SKernels{ false, &windowSumsScalar, &recurrenceScalar };
+	return s_kernels;
+}
+
+void checkPeriod(const std::size_t period)
+{
+	if (period == 0)
+	{
+		throw std::invalid_argument("incorrect period");
+	}
+}
+
+void fillNotReady(double* output, const std::size_t count)
+{
+	std::fill(output, output + count, NotReady);
+}
+
+// the smoothing of Wilder on input[0, size): output[period - 1] is the mean
+// of the first period inputs
+void wilderAverage(const double* input, const std::size_t size, const std::size_t period, double* output)
+{
+	fillNotReady(output, std::min(period - 1, size));
+	if (size < period)
+	{
+		return;
+	}
+
+	output[period - 1] = exactWindowSum(input, period - 1, period) / period;
+	const double a = static_cast<double>(period - 1) / period;
+	kernels().m_recurrence(input + period, size - period, a, 1.0 / period, output[period - 1], output + period);
+}
+
+} // anonymous namespace
+
+// ---------------------------------------------------------------------------
+
+void sma(const double* input, const std::size_t size, const std::size_t period, double* output)
+{
+	checkPeriod(period);
+	fillNotReady(output, std::min(period - 1, size));
+	if (size < period)
+	{
+		return;
+	}
+
+	kernels().m_windowSums(input, size, period, output);
+	const double scale = 1.0 / period;
+	for (std::size_t i = period - 1; i < size; ++i)
+	{
+		output[i] *= scale;
+	}
+}
+
+void ema(const double* input, const std::size_t size, const std::size_t period, double* output)
+{
+	checkPeriod(period);
+	fillNotReady(output, std::min(period - 1, size));
+	if (size < period)
+	{
+		return;
+	}
+
+	output[period - 1] = exactWindowSum(input, period - 1, period) / period;
+	const double alpha = 2.0 / (period + 1);
+	kernels().m_recurrence(input + period, size - period, 1.0 - alpha, alpha, output[period - 1], output + period);
+}
+
+void rsi(const double* input, const std::size_t size, const std::size_t period, double* output)
+{
+	checkPeriod(period);
+	if (size <= period)
+	{
+		fillNotReady(output, size);
+		return;
+	}
+
+	// the changes start at the second input
+	const std::size_t changeCount = size - 1;
+	std::vector<double> gains(changeCount);
+	std::vector<double> losses(changeCount);
+	for (std::size_t i = 0; i < changeCount; ++i)
+	{
+		const double change = input[i + 1] - input[i];
+		gains[i] = std::max(change, 0.0);
+		losses[i] = std::max(-change, 0.0);
+	}
+
+	std::vector<double> averageGains(changeCount);
+	std::vector<double> averageLosses(changeCount);
+	wilderAverage(gains.data(), changeCount, period, averageGains.data());
+	wilderAverage(losses.data(), changeCount, period, averageLosses.data());
+
+	fillNotReady(output, period);
+	for (std::size_t i = period; i < size; ++i)
+	{
+		const double loss = averageLosses[i - 1];
+		output[i] = (loss == 0.0) ? 100.0 : 100.0 - 100.0 / (1.0 + averageGains[i - 1] / loss);
+	}
+}
+
+void atr(
+	const double* high,
+	const double* low,
+	const double* close,
+	const std::size_t size,
+	const std::size_t period,
+	double* output)
+{
+	checkPeriod(period);
+	if (size == 0)
+	{
+		return;
+	}
+
+	std::vector<double> ranges(size);
+	ranges[0] = high[0] - low[0];
+	for (std::size_t i = 1; i < size; ++i)
+	{
+		const double previousClose = close[i - 1];
+		ranges[i] = std::max(high[i] - low[i], std::max(std::abs(high[i] - previousClose), std::abs(low[i] - previousClose)));
+	}
+	wilderAverage(ranges.data(), size, period, output);
+}
+
+void bollinger(
+	const double* input,
+	const std::size_t size,
+	const std::size_t period,
+	const double deviations,
+	double* middle,
+	double* upper,
+	double* lower)
+{
+	checkPeriod(period);
+	const std::size_t notReadyCount = std::min(period - 1, size);
+	fillNotReady(middle, notReadyCount);
+	fillNotReady(upper, notReadyCount);
+	fillNotReady(lower, notReadyCount);
+	if (size < period)
+	{
+		return;
+	}
+
+	// each block is shifted by its first value, so the variance doesn't
+	// drown in the rounding of squares of whole prices
+	const window_sums_t windowSums = kernels().m_windowSums;
+	std::vector<double> shifted(SyncBlock + period - 1);
+	std::vector<double> squares(SyncBlock + period - 1);
+	std::vector<double> sums(SyncBlock + period - 1);
+	std::vector<double> squareSums(SyncBlock + period - 1);
+	for (std::size_t block = period - 1; block < size; block += SyncBlock)
+	{
+		const std::size_t end = std::min(block + SyncBlock, size);
+		const std::size_t first = block + 1 - period;
+		const std::size_t count = end - first;
+		const double reference = input[block];
+		for (std::size_t i = 0; i < count; ++i)
+		{
+			shifted[i] = input[first + i] - reference;
+			squares[i] = shifted[i] * shifted[i];
+		}
+		windowSums(shifted.data(), count, period, sums.data());
+		windowSums(squares.data(), count, period, squareSums.data());
+
+		for (std::size_t i = period - 1; i < count; ++i)
+		{
+			const double mean = sums[i] / period;
+			const double variance = squareSums[i] / period - mean * mean;
+			const double deviation = (0.0 < variance) ? std::sqrt(variance) : 0.0;
+			const std::size_t index = first + i;
+			middle[index] = reference + mean;
+			upper[index] = middle[index] + deviations * deviation;
+			lower[index] = middle[index] - deviations * deviation;
+		}
+	}
+}
+
+void vwap(
+	const datetime_t* times,
+	const double* price,
+	const double* volume,
+	const std::size_t size,
+	const datetime_t sessionLength,
+	double* output)
+{
+	if (sessionLength <= 0)
+	{
+		throw std::invalid_argument("incorrect session");
+	}
+
+	std::vector<double> priceVolumes(size);
+	for (std::size_t i = 0; i < size; ++i)
+	{
+		priceVolumes[i] = price[i] * volume[i];
+	}
+
+	// the running sums of each session
+	std::vector<double> volumeSums(size);
+	const recurrence_t recurrence = kernels().m_recurrence;
+	for (std::size_t first = 0; first < size;)
+	{
+		const datetime_t session = times[first] / sessionLength;
+		std::size_t end = first + 1;
+		while ((end < size) && (times[end] / sessionLength == session))
+		{
+			++end;
+		}
+
+		recurrence(priceVolumes.data() + first, end - first, 1.0, 1.0, 0.0, output + first);
+		recurrence(volume + first, end - first, 1.0, 1.0, 0.0, volumeSums.data() + first);
+		first = end;
+	}
+
+	for (std::size_t i = 0; i < size; ++i)
+	{
+		output[i] = (0.0 < volumeSums[i]) ? output[i] / volumeSums[i] : NotReady;
+	}
+}
+
+bool isAvx2Used()
+{
+	return kernels().m_avx2;
+}
+
+} // namespace indicator
+
+} // namespace fx
@@ -21,8 +21,8 @@ KInstance::KInstance(
 	, m_cerr(cerr)
 	, m_accountManager(createAccountManager())
 	, m_communicator(createCommunicator( m_accountManager ))
-	, m_trademanager(createTradeManager( m_communicator ))
-	, m_executor(createExecutor( cout, cerr, m_accountManager, m_trademanager ))
+	, m_trademanager(createTradeManager( m_communicator, cerr ))
+	, m_executor(createExecutor( cout, cerr, m_accountManager, m_communicator, m_trademanager ))
 {
 }
 
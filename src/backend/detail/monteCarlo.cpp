@@ -0,0 +1,74 @@
+// author: Darek Slusarczyk alias marines marinesovitch 2012-2013, 2022
+#include "ph.h"
+#include "monteCarlo.h"
+
+namespace fx
+{
+
+namespace montecarlo
+{
+
+namespace
+{
+
+const std::string s_methodNames[] =
+{
+	"bootstrap",
+	"shuffle"
+};
+
+} // anonymous namespace
+
+// ---------------------------------------------------------------------------
+
+bool parse(const std::string& name, EMethod* method)
+{
+	for (int i = Bootstrap; i <= Shuffle; ++i)
+	{
+		if (s_methodNames[i] == name)
+		{
+			*method = static_cast<EMethod>(i);
+			return true;
+		}
+	}
+	return false;
+}
+
+const std::string& name(const EMethod method)
+{
+	assert((Bootstrap <= method) && (method <= Shuffle));
+	return s_methodNames[method];
+}
+
+} // namespace montecarlo
+
+// ---------------------------------------------------------------------------
+
+namespace
+{
+
+void printDistribution(std::ostream& os, const char* title, const SMonteCarloDistribution& distribution)
+{
+	os << title << ": mean " << distribution.m_mean
+		<< ", 5% " << distribution.m_p5
+		<< ", 25% " << distribution.m_p25
+		<< ", median " << distribution.m_median
+		<< ", 75% " << distribution.m_p75
+		<< ", 95% " << distribution.m_p95 << '\n';
+}
+
+} // anonymous namespace
+
+void SMonteCarloReport::print(std::ostream& os) const
+{
+	os << "monte carlo " << montecarlo::name(m_method) << ", " << m_runCount << " runs of "
+		<< m_tradeCount << " trades in " << std::fixed << std::setprecision(2) << m_seconds << "s\n";
+	printDistribution(os, "net profit", m_netProfit);
+	printDistribution(os, "max drawdown", m_maxDrawdown);
+	os << std::setprecision(1);
+	printDistribution(os, "max drawdown %", m_maxDrawdownPercent);
+	os << "probability of loss " << (100.0 * m_lossProbability) << '%'
+		<< std::defaultfloat << std::endl;
+}
+
+} // namespace fx
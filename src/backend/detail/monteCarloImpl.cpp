@@ -0,0 +1,278 @@
+// author: Darek Slusarczyk alias marines marinesovitch 2012-2013, 2022
+#include "ph.h"
+#include "monteCarloImpl.h"
+#include "cpp/workStealingPool.h"
+#include <chrono>
+#include <numeric>
+#include <random>
+#include <emmintrin.h>
+
+namespace fx
+{
+
+namespace
+{
+
+// the runs are simulated side by side in the lanes of two SSE2 registers,
+// SSE2 is the baseline of all the supported targets
+const std::size_t Lanes = 4;
+// the runs of a single task of the pool, a multiple of lanes
+const std::size_t RunsPerTask = 16 * Lanes;
+
+struct SLaneResults
+{
+	double m_netProfit[Lanes];
+	double m_maxDrawdown[Lanes];
+	double m_maxDrawdownPercent[Lanes];
+};
+
+// profits are interleaved: profits[trade * Lanes + lane], so each step of
+// all the lanes is a single load
+void simulateLanes(
+	const double* profits,
+	const std::size_t tradeCount,
+	const double initialBalance,
+	SLaneResults* results)
+{
+	__m128d equity[2] = { _mm_set1_pd(initialBalance), _mm_set1_pd(initialBalance) };
+	__m128d peak[2] = { equity[0], equity[1] };
+	__m128d drawdown[2] = { _mm_setzero_pd(), _mm_setzero_pd() };
+	__m128d drawdownRatio[2] = { _mm_setzero_pd(), _mm_setzero_pd() };
+
+	for (std::size_t trade = 0; trade < tradeCount; ++trade)
+	{
+		const double* step = profits + trade * Lanes;
+		for (int half = 0; half < 2; ++half)
+		{
+			equity[half] = _mm_add_pd(equity[half], _mm_loadu_pd(step + 2 * half));
+			peak[half] = _mm_max_pd(peak[half], equity[half]);
+			const __m128d fall = _mm_sub_pd(peak[half], equity[half]);
+			drawdown[half] = _mm_max_pd(drawdown[half], fall);
+			// max_pd returns the second operand for NaN, i.e. the ratio of a
+			// zero peak is ignored
+			drawdownRatio[half] = _mm_max_pd(_mm_div_pd(fall, peak[half]), drawdownRatio[half]);
+		}
+	}
+
+	const __m128d balance = _mm_set1_pd(initialBalance);
+	const __m128d hundred = _mm_set1_pd(100.0);
+	for (int half = 0; half < 2; ++half)
+	{
+		_mm_storeu_pd(results->m_netProfit + 2 * half, _mm_sub_pd(equity[half], balance));
+		_mm_storeu_pd(results->m_maxDrawdown + 2 * half, drawdown[half]);
+		_mm_storeu_pd(results->m_maxDrawdownPercent + 2 * half, _mm_mul_pd(drawdownRatio[half], hundred));
+	}
+}
+
+// an index in [0, count) out of 32 random bits without division
+inline std::size_t randomIndex(const uint32_t random, const std::size_t count)
+{
+	const std::size_t result = static_cast<std::size_t>((static_cast<uint64_t>(random) * count) >> 32);
+	return result;
+}
+
+SMonteCarloDistribution describe(std::vector<double>* values)
+{
+	SMonteCarloDistribution result;
+	if (values->empty())
+	{
+		return result;
+	}
+
+	std::sort(values->begin(), values->end());
+	auto percentile = [values](const double share)
+	{
+		const std::size_t index = static_cast<std::size_t>(share * (values->size() - 1) + 0.5);
+		return (*values)[index];
+	};
+
+	double sum = 0.0;
+	for (const double value : *values)
+	{
+		sum += value;
+	}
+	result.m_mean = sum / values->size();
+	result.m_p5 = percentile(0.05);
+	result.m_p25 = percentile(0.25);
+	result.m_median = percentile(0.5);
+	result.m_p75 = percentile(0.75);
+	result.m_p95 = percentile(0.95);
+	return result;
+}
+
+// ---------------------------------------------------------------------------
+
+class KMonteCarlo
+{
+	public:
+		KMonteCarlo(
+			const std::vector<volume_t>& tradeProfits,
+			const volume_t initialBalance,
+			const SMonteCarloParams& params,
+			const unsigned int workerCount);
+
+	public:
+		void runTask(const std::size_t task, const unsigned int worker);
+		void fillReport(SMonteCarloReport* report);
+
+	private:
+		void fillBootstrap(std::mt19937* generator, double* profits) const;
+		void fillShuffle(std::mt19937* generator, std::vector<std::size_t>* order, double* profits) const;
+
+	private:
+		const std::vector<volume_t>& m_tradeProfits;
+		const volume_t m_initialBalance;
+		const SMonteCarloParams m_params;
+
+		// the buffers of each worker
+		struct SScratch
+		{
+			std::vector<double> m_profits;
+			std::vector<std::size_t> m_order;
+		};
+		std::vector<SScratch> m_scratches;
+
+		std::vector<double> m_netProfits;
+		std::vector<double> m_maxDrawdowns;
+		std::vector<double> m_maxDrawdownPercents;
+
+};
+
+// ---------------------------------------------------------------------------
+
+KMonteCarlo::KMonteCarlo(
+	const std::vector<volume_t>& tradeProfits,
+	const volume_t initialBalance,
+	const SMonteCarloParams& params,
+	const unsigned int workerCount)
+	: m_tradeProfits(tradeProfits)
+	, m_initialBalance(initialBalance)
+	, m_params(params)
+	, m_scratches(workerCount)
+	, m_netProfits(params.m_runCount)
+	, m_maxDrawdowns(params.m_runCount)
+	, m_maxDrawdownPercents(params.m_runCount)
+{
+	for (SScratch& scratch : m_scratches)
+	{
+		scratch.m_profits.resize(tradeProfits.size() * Lanes);
+		scratch.m_order.resize(tradeProfits.size());
+	}
+}
+
+void KMonteCarlo::runTask(const std::size_t task, const unsigned int worker)
+{
+	SScratch& scratch = m_scratches[worker];
+	// each task has its own generator, so the results don't depend on the
+	// scheduling
+	std::seed_seq seed = {
+		static_cast<uint32_t>(m_params.m_seed),
+		static_cast<uint32_t>(m_params.m_seed >> 32),
+		static_cast<uint32_t>(task) };
+	std::mt19937 generator(seed);
+	// the shuffles of a task start from the identity, not from the order left
+	// by the previous task of the worker
+	std::iota(scratch.m_order.begin(), scratch.m_order.end(), std::size_t(0));
+
+	const std::size_t tradeCount = m_tradeProfits.size();
+	const std::size_t firstRun = task * RunsPerTask;
+	const std::size_t endRun = std::min(firstRun + RunsPerTask, m_params.m_runCount);
+	for (std::size_t run = firstRun; run < endRun; run += Lanes)
+	{
+		if (m_params.m_method == montecarlo::Shuffle)
+		{
+			fillShuffle(&generator, &scratch.m_order, scratch.m_profits.data());
+		}
+		else
+		{
+			fillBootstrap(&generator, scratch.m_profits.data());
+		}
+
+		SLaneResults results;
+		simulateLanes(scratch.m_profits.data(), tradeCount, m_initialBalance, &results);
+
+		const std::size_t laneCount = std::min(Lanes, endRun - run);
+		for (std::size_t lane = 0; lane < laneCount; ++lane)
+		{
+			m_netProfits[run + lane] = results.m_netProfit[lane];
+			m_maxDrawdowns[run + lane] = results.m_maxDrawdown[lane];
+			m_maxDrawdownPercents[run + lane] = results.m_maxDrawdownPercent[lane];
+		}
+	}
+}
+
+void KMonteCarlo::fillReport(SMonteCarloReport* report)
+{
+	const std::size_t lossCount = std::count_if(m_netProfits.begin(), m_netProfits.end(),
+		[](const double profit) { return profit < 0.0; });
+	report->m_lossProbability = m_netProfits.empty() ? 0.0 : static_cast<double>(lossCount) / m_netProfits.size();
+	report->m_netProfit = describe(&m_netProfits);
+	report->m_maxDrawdown = describe(&m_maxDrawdowns);
+	report->m_maxDrawdownPercent = describe(&m_maxDrawdownPercents);
+}
+
+// ---------------------------------------------------------------------------
+
+void KMonteCarlo::fillBootstrap(std::mt19937* generator, double* profits) const
+{
+	const std::size_t tradeCount = m_tradeProfits.size();
+	const std::size_t valueCount = tradeCount * Lanes;
+	for (std::size_t i = 0; i < valueCount; ++i)
+	{
+		profits[i] = m_tradeProfits[randomIndex((*generator)(), tradeCount)];
+	}
+}
+
+void KMonteCarlo::fillShuffle(std::mt19937* generator, std::vector<std::size_t>* order, double* profits) const
+{
+	// the order left by the previous shuffle of the task is as good a start
+	// as any
+	const std::size_t tradeCount = m_tradeProfits.size();
+	for (std::size_t lane = 0; lane < Lanes; ++lane)
+	{
+		for (std::size_t i = tradeCount; 1 < i; --i)
+		{
+			std::swap((*order)[i - 1], (*order)[randomIndex((*generator)(), i)]);
+		}
+
+		for (std::size_t i = 0; i < tradeCount; ++i)
+		{
+			profits[i * Lanes + lane] = m_tradeProfits[(*order)[i]];
+		}
+	}
+}
+
+} // anonymous namespace
+
+// ---------------------------------------------------------------------------
+
+SMonteCarloReport runMonteCarlo(
+	const std::vector<volume_t>& tradeProfits,
+	const volume_t initialBalance,
+	const SMonteCarloParams& params,
+	cpp::KWorkStealingPool* pool)
+{
+	const auto start = std::chrono::steady_clock::now();
+	SMonteCarloReport report;
+	report.m_method = params.m_method;
+	report.m_tradeCount = tradeProfits.size();
+	report.m_initialBalance = initialBalance;
+	if (tradeProfits.empty() || (params.m_runCount == 0))
+	{
+		return report;
+	}
+
+	report.m_runCount = params.m_runCount;
+	KMonteCarlo monteCarlo(tradeProfits, initialBalance, params, pool->size());
+	const std::size_t taskCount = (params.m_runCount + RunsPerTask - 1) / RunsPerTask;
+	pool->run(taskCount, [&monteCarlo](const std::size_t task, const unsigned int worker)
+	{
+		monteCarlo.runTask(task, worker);
+	});
+
+	monteCarlo.fillReport(&report);
+	report.m_seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+	return report;
+}
+
+} // namespace fx
@@ -0,0 +1,26 @@
+// author: Darek Slusarczyk alias marines marinesovitch 2012-2013, 2022
+#ifndef INC_BACKEND_MONTECARLOIMPL_H
+#define INC_BACKEND_MONTECARLOIMPL_H
+
+#include "monteCarlo.h"
+
+namespace cpp
+{
+class KWorkStealingPool;
+}
+
+namespace fx
+{
+
+// simulates params.m_runCount sequences made of the net profits of trades
+// (in the order of closing) on the pool; the drawdowns are computed from
+// initialBalance
+SMonteCarloReport runMonteCarlo(
+	const std::vector<volume_t>& tradeProfits,
+	const volume_t initialBalance,
+	const SMonteCarloParams& params,
+	cpp::KWorkStealingPool* pool);
+
+} // namespace fx
+
+#endif
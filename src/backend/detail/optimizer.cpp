@@ -0,0 +1,137 @@
+// author: Darek Slusarczyk alias marines marinesovitch 2012-2013, 2022
+#include "ph.h"
+#include "optimizer.h"
+
+namespace fx
+{
+
+namespace optimizer
+{
+
+namespace
+{
+
+const std::string s_metricNames[] =
+{
+	"profit",
+	"pf",
+	"drawdown",
+	"recovery",
+	"winrate"
+};
+
+const std::string s_samplingNames[] =
+{
+	"grid",
+	"random",
+	"lhs"
+};
+
+} // anonymous namespace
+
+// ---------------------------------------------------------------------------
+
+bool parse(const std::string& name, EMetric* metric)
+{
+	for (int i = Profit; i <= WinRate; ++i)
+	{
+		if (s_metricNames[i] == name)
+		{
+			*metric = static_cast<EMetric>(i);
+			return true;
+		}
+	}
+	return false;
+}
+
+const std::string& name(const EMetric metric)
+{
+	assert((Profit <= metric) && (metric <= WinRate));
+	return s_metricNames[metric];
+}
+
+bool parse(const std::string& name, ESampling* sampling)
+{
+	for (int i = Grid; i <= LatinHypercube; ++i)
+	{
+		if (s_samplingNames[i] == name)
+		{
+			*sampling = static_cast<ESampling>(i);
+			return true;
+		}
+	}
+	return false;
+}
+
+} // namespace optimizer
+
+// ---------------------------------------------------------------------------
+
+SOptimizerParams::SOptimizerParams()
+{
+	// thousands of runs need only the summaries
+	m_backtest.m_details = false;
+}
+
+// ---------------------------------------------------------------------------
+
+void SOptimizerReport::printTop(std::ostream& os, const std::size_t count) const
+{
+	const double seconds = std::max(m_seconds, 0.001);
+	os << m_strategy << ' ' << m_symbol << ", " << m_results.size() << " runs of "
+		<< m_tickCount << " ticks in " << std::fixed << std::setprecision(2) << seconds << "s ("
+		<< std::setprecision(1) << (m_results.size() / seconds) << " runs/s, "
+		<< std::setprecision(0) << (m_results.size() * static_cast<double>(m_tickCount) / seconds) << " ticks/s) on "
+		<< m_threadCount << " threads, ranked by " << optimizer::name(m_metric) << '\n';
+
+	const std::size_t shown = std::min(count, m_results.size());
+	for (std::size_t i = 0; i < shown; ++i)
+	{
+		const SOptimizerResult& result = m_results[i];
+		os << std::setw(4) << (i + 1) << ". ";
+		if (!result.m_error.empty())
+		{
+			os << "error: " << result.m_error << " | " << result.m_strategyCmdLine << '\n';
+			continue;
+		}
+
+		const SBacktestReport& report = result.m_report;
+		os << "score " << std::setprecision(2) << result.m_score
+			<< ", net " << (report.m_finalBalance - report.m_initialBalance)
+			<< ", trades " << (report.m_winCount + report.m_lossCount)
+			<< ", drawdown " << report.m_maxDrawdown
+			<< " (" << std::setprecision(1) << report.m_maxDrawdownPercent << "%) | "
+			<< result.m_strategyCmdLine << '\n';
+	}
+	os << std::defaultfloat << std::flush;
+}
+
+void SOptimizerReport::save(const std::string& path) const
+{
+	std::ofstream os(path, std::ios::trunc);
+	if (!os)
+	{
+		throw std::runtime_error("cannot create file " + path);
+	}
+
+	os << std::setprecision(10);
+	os << "rank,score,net profit,gross profit,gross loss,wins,losses,rejected,max drawdown,max drawdown %,parameters,error\n";
+	for (std::size_t i = 0; i < m_results.size(); ++i)
+	{
+		const SOptimizerResult& result = m_results[i];
+		const SBacktestReport& report = result.m_report;
+		os << (i + 1) << ',' << result.m_score
+			<< ',' << (report.m_finalBalance - report.m_initialBalance)
+			<< ',' << report.m_grossProfit << ',' << report.m_grossLoss
+			<< ',' << report.m_winCount << ',' << report.m_lossCount << ',' << report.m_rejectedCount
+			<< ',' << report.m_maxDrawdown << ',' << report.m_maxDrawdownPercent
+			<< ",\"" << result.m_strategyCmdLine << "\",\"" << result.m_error << "\"\n";
+	}
+
+	if (!os)
+	{
+		throw std::runtime_error("cannot write file " + path);
+	}
+}
+
+} // namespace fx
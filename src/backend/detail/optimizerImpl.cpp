@@ -0,0 +1,387 @@
+// author: Darek Slusarczyk alias marines marinesovitch 2012-2013, 2022
+#include "ph.h"
+#include "optimizerImpl.h"
+#include "backtesterImpl.h"
+#include "tickFeed.h"
+#include "tradingStrategy.h"
+#include "tradingStrategyFactory.h"
+#include "cpp/workStealingPool.h"
+#include <chrono>
+#include <random>
+
+namespace fx
+{
+
+namespace
+{
+
+// more runs would be rather a mistake in the ranges than a sensible sweep
+const std::size_t MaxRunCount = 1000000;
+
+struct SRange
+{
+	double m_from = 0;
+	double m_step = 0;
+	std::size_t m_count = 0;
+	// of the values in the command line, so they look like the ones in the
+	// template
+	int m_decimals = 0;
+};
+
+int countDecimals(const std::string& number)
+{
+	const std::size_t point = number.find('.');
+	const int result = (point != std::string::npos) ? static_cast<int>(number.size() - point - 1) : 0;
+	return result;
+}
+
+// <from>:<to>:<step>, returns false for other tokens
+bool parseRange(const std::string& token, SRange* range)
+{
+	std::string parts[3];
+	std::istringstream is(token);
+	for (std::string& part : parts)
+	{
+		if (!std::getline(is, part, ':') || part.empty())
+		{
+			return false;
+		}
+	}
+
+	std::string rest;
+	if (std::getline(is, rest))
+	{
+		return false;
+	}
+
+	double values[3] = { 0.0, 0.0, 0.0 };
+	for (int i = 0; i < 3; ++i)
+	{
+		try
+		{
+			std::size_t size = 0;
+			values[i] = std::stod(parts[i], &size);
+			if (size != parts[i].size())
+			{
+				return false;
+			}
+		}
+		catch (std::logic_error&)
+		{
+			return false;
+		}
+	}
+
+	const double from = values[0];
+	const double to = values[1];
+	const double step = values[2];
+	if ((step <= 0.0) || (to < from))
+	{
+		throw std::invalid_argument("incorrect range " + token);
+	}
+
+	range->m_from = from;
+	range->m_step = step;
+	// the epsilon keeps the end of the range despite rounding of the step
+	range->m_count = static_cast<std::size_t>((to - from) / step + 1e-9) + 1;
+	range->m_decimals = std::max({ countDecimals(parts[0]), countDecimals(parts[1]), countDecimals(parts[2]) });
+	return true;
+}
+
+// ---------------------------------------------------------------------------
+
+// makes the commands of strategy out of a template with ranges
+class KParameterSampler
+{
+	public:
+		KParameterSampler(const std::string& cmdLineTemplate);
+
+	public:
+		cpp::strings_t run(const SOptimizerParams& params);
+
+	private:
+		// each parameter set is given by the indices of values in the ranges
+		typedef std::vector<std::size_t> indices_t;
+
+		void sampleGrid();
+		void sampleRandom(const SOptimizerParams& params);
+		void sampleLatinHypercube(const SOptimizerParams& params);
+		std::string formatCmdLine(const indices_t& indices) const;
+
+	private:
+		// the literal tokens of the template, the ones at the positions of
+		// ranges are empty
+		std::vector<std::string> m_tokens;
+		// the token index of each range
+		std::vector<std::size_t> m_rangePositions;
+		std::vector<SRange> m_ranges;
+
+		std::vector<indices_t> m_samples;
+
+};
+
+// ---------------------------------------------------------------------------
+
+KParameterSampler::KParameterSampler(const std::string& cmdLineTemplate)
+{
+	std::istringstream is(cmdLineTemplate);
+	std::string token;
+	while (is >> token)
+	{
+		SRange range;
+		if (parseRange(token, &range))
+		{
+			m_rangePositions.push_back(m_tokens.size());
+			m_ranges.push_back(range);
+			token.clear();
+		}
+		m_tokens.push_back(token);
+	}
+}
+
+cpp::strings_t KParameterSampler::run(const SOptimizerParams& params)
+{
+	switch (params.m_sampling)
+	{
+		case optimizer::Grid:
+			sampleGrid();
+			break;
+
+		case optimizer::Random:
+			sampleRandom(params);
+			break;
+
+		case optimizer::LatinHypercube:
+			sampleLatinHypercube(params);
+			break;
+
+		default:
+			assert(!"unknown sampling");
+	}
+
+	cpp::strings_t result;
+	result.reserve(m_samples.size());
+	for (const indices_t& sample : m_samples)
+	{
+		result.push_back(formatCmdLine(sample));
+	}
+	return result;
+}
+
+void KParameterSampler::sampleGrid()
+{
+	std::size_t count = 1;
+	for (const SRange& range : m_ranges)
+	{
+		if (MaxRunCount / count < range.m_count)
+		{
+			throw std::invalid_argument("too many combinations of parameters, use random sampling");
+		}
+		count *= range.m_count;
+	}
+
+	m_samples.resize(count, indices_t(m_ranges.size()));
+	for (std::size_t i = 0; i < count; ++i)
+	{
+		// the first range changes the slowest
+		std::size_t rest = i;
+		for (std::size_t r = m_ranges.size(); r-- != 0;)
+		{
+			m_samples[i][r] = rest % m_ranges[r].m_count;
+			rest /= m_ranges[r].m_count;
+		}
+	}
+}
+
+void KParameterSampler::sampleRandom(const SOptimizerParams& params)
+{
+	const std::size_t count = std::min(params.m_sampleCount, MaxRunCount);
+	std::mt19937_64 generator(params.m_seed);
+	m_samples.resize(count, indices_t(m_ranges.size()));
+	for (indices_t& sample : m_samples)
+	{
+		for (std::size_t r = 0; r < m_ranges.size(); ++r)
+		{
+			std::uniform_int_distribution<std::size_t> distribution(0, m_ranges[r].m_count - 1);
+			sample[r] = distribution(generator);
+		}
+	}
+}
+
+void KParameterSampler::sampleLatinHypercube(const SOptimizerParams& params)
+{
+	const std::size_t count = std::min(params.m_sampleCount, MaxRunCount);
+	std::mt19937_64 generator(params.m_seed);
+	std::uniform_real_distribution<double> distribution(0.0, 1.0);
+	m_samples.resize(count, indices_t(m_ranges.size()));
+
+	std::vector<std::size_t> strata(count);
+	for (std::size_t r = 0; r < m_ranges.size(); ++r)
+	{
+		for (std::size_t i = 0; i < count; ++i)
+		{
+			strata[i] = i;
+		}
+		std::shuffle(strata.begin(), strata.end(), generator);
+
+		const std::size_t valueCount = m_ranges[r].m_count;
+		for (std::size_t i = 0; i < count; ++i)
+		{
+			// a random point of the stratum snapped to the step of the range
+			const double position = (strata[i] + distribution(generator)) / count;
+			m_samples[i][r] = std::min(static_cast<std::size_t>(position * valueCount), valueCount - 1);
+		}
+	}
+}
+
+std::string KParameterSampler::formatCmdLine(const indices_t& indices) const
+{
+	std::ostringstream os;
+	os << std::fixed;
+	std::size_t r = 0;
+	for (std::size_t i = 0; i < m_tokens.size(); ++i)
+	{
+		if (i != 0)
+		{
+			os << ' ';
+		}
+		if ((r < m_rangePositions.size()) && (m_rangePositions[r] == i))
+		{
+			const SRange& range = m_ranges[r];
+			os << std::setprecision(range.m_decimals) << (range.m_from + indices[r] * range.m_step);
+			++r;
+		}
+		else
+		{
+			os << m_tokens[i];
+		}
+	}
+	return os.str();
+}
+
+} // anonymous namespace
+
+// ---------------------------------------------------------------------------
+
+cpp::strings_t sampleStrategyCmdLines(const std::string& cmdLineTemplate, const SOptimizerParams& params)
+{
+	KParameterSampler sampler(cmdLineTemplate);
+	const cpp::strings_t& result = sampler.run(params);
+	return result;
+}
+
+double scoreBacktest(const SBacktestReport& report, const optimizer::EMetric metric)
+{
+	const double infinity = std::numeric_limits<double>::infinity();
+	const volume_t netProfit = report.m_finalBalance - report.m_initialBalance;
+	const std::size_t tradeCount = report.m_winCount + report.m_lossCount;
+	double result = 0.0;
+	switch (metric)
+	{
+		case optimizer::Profit:
+			result = netProfit;
+			break;
+
+		case optimizer::ProfitFactor:
+			if (report.m_grossLoss < 0.0)
+			{
+				result = report.m_grossProfit / -report.m_grossLoss;
+			}
+			else
+			{
+				result = (0.0 < report.m_grossProfit) ? infinity : 0.0;
+			}
+			break;
+
+		case optimizer::Drawdown:
+			result = -report.m_maxDrawdown;
+			break;
+
+		case optimizer::Recovery:
+			if (0.0 < report.m_maxDrawdown)
+			{
+				result = netProfit / report.m_maxDrawdown;
+			}
+			else
+			{
+				result = (0.0 < netProfit) ? infinity : 0.0;
+			}
+			break;
+
+		case optimizer::WinRate:
+			result = tradeCount ? 100.0 * report.m_winCount / tradeCount : 0.0;
+			break;
+
+		default:
+			assert(!"unknown metric");
+	}
+	return result;
+}
+
+void evaluateParameters(
+	const ITickFeed& feed,
+	ITradingStrategyFactory* factory,
+	const std::string& strategyName,
+	const SBacktestParams& params,
+	const optimizer::EMetric metric,
+	SOptimizerResult* result)
+{
+	try
+	{
+		HTradingStrategy strategy = factory->create(strategyName);
+		result->m_report = runBacktest(feed, strategy.get(), result->m_strategyCmdLine, params);
+		result->m_score = scoreBacktest(result->m_report, metric);
+	}
+	catch (std::exception& e)
+	{
+		result->m_error = e.what();
+	}
+}
+
+void rankResults(std::vector<SOptimizerResult>* results)
+{
+	// equal scores keep the order of samples
+	std::stable_sort(results->begin(), results->end(),
+		[](const SOptimizerResult& lhs, const SOptimizerResult& rhs)
+		{
+			if (lhs.m_error.empty() != rhs.m_error.empty())
+			{
+				return lhs.m_error.empty();
+			}
+			return rhs.m_score < lhs.m_score;
+		});
+}
+
+SOptimizerReport runOptimization(
+	const ITickFeed& feed,
+	ITradingStrategyFactory* factory,
+	const std::string& strategyName,
+	const std::string& cmdLineTemplate,
+	const SOptimizerParams& params)
+{
+	const auto start = std::chrono::steady_clock::now();
+	const cpp::strings_t& cmdLines = sampleStrategyCmdLines(cmdLineTemplate, params);
+
+	SOptimizerReport report;
+	report.m_symbol = feed.getSymbol();
+	report.m_strategy = strategyName;
+	report.m_tickCount = feed.size();
+	report.m_metric = params.m_metric;
+	report.m_results.resize(cmdLines.size());
+
+	// every run writes only its own result, so they need no locking
+	cpp::KWorkStealingPool pool(params.m_threadCount);
+	report.m_threadCount = pool.size();
+	pool.run(cmdLines.size(), [&](const std::size_t index, const unsigned int /*worker*/)
+	{
+		SOptimizerResult& result = report.m_results[index];
+		result.m_strategyCmdLine = cmdLines[index];
+		evaluateParameters(feed, factory, strategyName, params.m_backtest, params.m_metric, &result);
+	});
+
+	rankResults(&report.m_results);
+	report.m_seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+	return report;
+}
+
+} // namespace fx
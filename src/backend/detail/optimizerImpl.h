@@ -0,0 +1,51 @@
+// author: Darek Slusarczyk alias marines marinesovitch 2012-2013, 2022
+#ifndef INC_BACKEND_OPTIMIZERIMPL_H
+#define INC_BACKEND_OPTIMIZERIMPL_H
+
+#include "optimizer.h"
+#include "cpp/types.h"
+
+namespace fx
+{
+
+struct ITickFeed;
+struct ITradingStrategyFactory;
+
+// the commands of strategy with the parameter sets chosen from the ranges of
+// cmdLineTemplate (see runOptimization), throws std::invalid_argument for
+// incorrect ranges
+cpp::strings_t sampleStrategyCmdLines(const std::string& cmdLineTemplate, const SOptimizerParams& params);
+
+// the higher the better
+double scoreBacktest(const SBacktestReport& report, const optimizer::EMetric metric);
+
+// backtests a new strategy with result->m_strategyCmdLine, the exceptions
+// of the strategy go to result->m_error; it may run in many threads at once
+void evaluateParameters(
+	const ITickFeed& feed,
+	ITradingStrategyFactory* factory,
+	const std::string& strategyName,
+	const SBacktestParams& params,
+	const optimizer::EMetric metric,
+	SOptimizerResult* result);
+
+// the best first, the refused parameters last
+void rankResults(std::vector<SOptimizerResult>* results);
+
+// backtests the strategy with parameter sets chosen from cmdLineTemplate in
+// parallel: the template is a command of the strategy in which the tokens
+// <from>:<to>:<step> are ranges of parameters, e.g.
+//     start b 1.3000:1.3200:0.0050 1.2900 0.1:0.5:0.1 0.0010:0.0040:0.0010
+// each run gets its own strategy, the factory is called from many threads at
+// once, and all of them replay the same feed; throws std::invalid_argument
+// for incorrect ranges
+SOptimizerReport runOptimization(
+	const ITickFeed& feed,
+	ITradingStrategyFactory* factory,
+	const std::string& strategyName,
+	const std::string& cmdLineTemplate,
+	const SOptimizerParams& params);
+
+} // namespace fx
+
+#endif
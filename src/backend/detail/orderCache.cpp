@@ -0,0 +1,37 @@
+// author: Darek Slusarczyk alias marines marinesovitch 2012-2013, 2022
+#include "ph.h"
+#include "orderCache.h"
+
+namespace fx
+{
+
+SOrderFilter::SOrderFilter()
+{
+}
+
+SOrderFilter::SOrderFilter(
+	const std::string& symbol,
+	const SOrder::EStatus status,
+	const SOrder::EType type)
+	: m_symbol(symbol)
+	, m_status(status)
+	, m_type(type)
+{
+}
+
+bool SOrderFilter::matches(const SOrder& order) const
+{
+	const bool result
+		= (m_symbol.empty() || (m_symbol == order.m_symbolName))
+		&& ((m_status == SOrder::Unknown) || (m_status == order.m_status))
+		&& ((m_type == SOrder::None) || (m_type == order.m_type));
+	return result;
+}
+
+// ---------------------------------------------------------------------------
+
+IOrderCache::~IOrderCache()
+{
+}
+
+} // namespace fx
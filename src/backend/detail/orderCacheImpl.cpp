@@ -0,0 +1,396 @@
+// author: Darek Slusarczyk alias marines marinesovitch 2012-2013, 2022
+#include "ph.h"
+#include "orderCacheImpl.h"
+#include "orderCache.h"
+#include <array>
+#include <deque>
+#include <shared_mutex>
+#include <string_view>
+#include <unordered_map>
+
+namespace fx
+{
+
+namespace
+{
+
+typedef uint32_t slot_t;
+typedef std::vector<slot_t> slots_t;
+
+// the place of an order in the secondary indexes, so it may be moved to
+// another list in O(1)
+struct SIndexPositions
+{
+	slot_t m_symbol = 0;
+	slot_t m_status = 0;
+	slot_t m_type = 0;
+};
+
+// ---------------------------------------------------------------------------
+
+// the orders are kept in a dense array; the ticket index maps tickets to
+// slots, the secondary indexes are lists of slots per symbol, status and
+// type; a change of the symbol, status or type moves the slot between lists
+// by swapping it with the last one; a dropped closed order is replaced by
+// the last one in the array, which is moved to its slot in all the indexes
+class KOrderCache : public IOrderCache
+{
+	public:
+		KOrderCache(const std::size_t closedCapacity);
+
+	public:
+		// IOrderCache
+		virtual void update(const SOrder& order);
+		virtual void clear();
+
+		virtual void setComplete();
+		virtual bool isComplete() const;
+
+		virtual std::size_t size() const;
+		virtual bool get(const ticket_t ticket, SOrder* order) const;
+		virtual std::size_t find(const SOrderFilter& filter, std::vector<SOrder>* orders) const;
+		virtual std::size_t count(const SOrderFilter& filter) const;
+
+		virtual bool validateTickets(const tickets_t& tickets, std::string* error) const;
+
+	private:
+		enum EIndex
+		{
+			SymbolIndex,
+			StatusIndex,
+			TypeIndex
+		};
+
+		// must be called with locked m_mutex
+		void insert(const SOrder& order);
+		void replace(const slot_t slot, const SOrder& order);
+		void addToList(slots_t* list, const slot_t slot, slot_t* position);
+		void removeFromList(slots_t* list, const slot_t position, const EIndex index);
+		slot_t* getPosition(const slot_t slot, const EIndex index);
+		void onClosed(const ticket_t ticket);
+		void erase(const slot_t slot);
+
+		slots_t& ensureSymbolList(const std::string_view& symbol);
+		const slots_t* getCandidates(const SOrderFilter& filter) const;
+
+		template<typename TVisitor>
+		void visit(const SOrderFilter& filter, TVisitor visitor) const;
+
+	private:
+		mutable std::shared_mutex m_mutex;
+
+		std::vector<SOrder> m_orders;
+		std::vector<SIndexPositions> m_positions;
+		std::unordered_map<int32_t, slot_t> m_ticket2slot;
+
+		std::map<std::string, slots_t, std::less<>> m_symbol2slots;
+		std::array<slots_t, SOrder::Unknown + 1> m_status2slots;
+		std::array<slots_t, SOrder::None + 1> m_type2slots;
+
+		const std::size_t m_closedCapacity;
+		// the tickets of the closed orders in the order they were closed
+		std::deque<int32_t> m_closedTickets;
+
+		std::atomic<bool> m_complete = false;
+
+};
+
+// ---------------------------------------------------------------------------
+
+KOrderCache::KOrderCache(const std::size_t closedCapacity)
+	: m_closedCapacity(closedCapacity)
+{
+}
+
+// ---------------------------------------------------------------------------
+// IOrderCache
+
+void KOrderCache::update(const SOrder& order)
+{
+	std::unique_lock<std::shared_mutex> lock(m_mutex);
+	auto it = m_ticket2slot.find(order.m_ticket);
+	if (it == m_ticket2slot.end())
+	{
+		insert(order);
+	}
+	else
+	{
+		replace(it->second, order);
+	}
+}
+
+void KOrderCache::clear()
+{
+	std::unique_lock<std::shared_mutex> lock(m_mutex);
+	m_orders.clear();
+	m_positions.clear();
+	m_ticket2slot.clear();
+	m_symbol2slots.clear();
+	m_closedTickets.clear();
+	for (slots_t& slots : m_status2slots)
+	{
+		slots.clear();
+	}
+	for (slots_t& slots : m_type2slots)
+	{
+		slots.clear();
+	}
+	m_complete = false;
+}
+
+void KOrderCache::setComplete()
+{
+	m_complete = true;
+}
+
+bool KOrderCache::isComplete() const
+{
+	return m_complete;
+}
+
+std::size_t KOrderCache::size() const
+{
+	std::shared_lock<std::shared_mutex> lock(m_mutex);
+	return m_orders.size();
+}
+
+bool KOrderCache::get(const ticket_t ticket, SOrder* order) const
+{
+	std::shared_lock<std::shared_mutex> lock(m_mutex);
+	auto it = m_ticket2slot.find(ticket);
+	if (it == m_ticket2slot.end())
+	{
+		return false;
+	}
+
+	*order = m_orders[it->second];
+	return true;
+}
+
+std::size_t KOrderCache::find(const SOrderFilter& filter, std::vector<SOrder>* orders) const
+{
+	const std::size_t first = orders->size();
+	visit(filter, [orders](const SOrder& order) { orders->push_back(order); });
+	std::sort(orders->begin() + first, orders->end(),
+		[](const SOrder& lhs, const SOrder& rhs) { return lhs.m_ticket < rhs.m_ticket; });
+	const std::size_t result = orders->size() - first;
+	return result;
+}
+
+std::size_t KOrderCache::count(const SOrderFilter& filter) const
+{
+	std::size_t result = 0;
+	visit(filter, [&result](const SOrder& /*order*/) { ++result; });
+	return result;
+}
+
+bool KOrderCache::validateTickets(const tickets_t& tickets, std::string* error) const
+{
+	std::shared_lock<std::shared_mutex> lock(m_mutex);
+	for (const ticket_t ticket : tickets)
+	{
+		auto it = m_ticket2slot.find(ticket);
+		if (it == m_ticket2slot.end())
+		{
+			if (m_complete)
+			{
+				*error = "unknown order " + std::to_string(ticket);
+				return false;
+			}
+		}
+		else if (m_orders[it->second].m_status == SOrder::Closed)
+		{
+			*error = "order " + std::to_string(ticket) + " is already closed";
+			return false;
+		}
+	}
+	return true;
+}
+
+// ---------------------------------------------------------------------------
+
+void KOrderCache::insert(const SOrder& order)
+{
+	const slot_t slot = static_cast<slot_t>(m_orders.size());
+	m_orders.push_back(order);
+	m_positions.push_back(SIndexPositions());
+	m_ticket2slot.emplace(order.m_ticket, slot);
+
+	SIndexPositions& positions = m_positions.back();
+	addToList(&ensureSymbolList(order.m_symbolName), slot, &positions.m_symbol);
+	addToList(&m_status2slots[order.m_status], slot, &positions.m_status);
+	addToList(&m_type2slots[order.m_type], slot, &positions.m_type);
+	if (order.m_status == SOrder::Closed)
+	{
+		onClosed(order.m_ticket);
+	}
+}
+
+void KOrderCache::replace(const slot_t slot, const SOrder& order)
+{
+	SOrder& current = m_orders[slot];
+	if (std::strcmp(current.m_symbolName, order.m_symbolName) != 0)
+	{
+		removeFromList(&ensureSymbolList(current.m_symbolName), m_positions[slot].m_symbol, SymbolIndex);
+		addToList(&ensureSymbolList(order.m_symbolName), slot, &m_positions[slot].m_symbol);
+	}
+	const bool closed = (current.m_status != SOrder::Closed) && (order.m_status == SOrder::Closed);
+	if (current.m_status != order.m_status)
+	{
+		removeFromList(&m_status2slots[current.m_status], m_positions[slot].m_status, StatusIndex);
+		addToList(&m_status2slots[order.m_status], slot, &m_positions[slot].m_status);
+	}
+	if (current.m_type != order.m_type)
+	{
+		removeFromList(&m_type2slots[current.m_type], m_positions[slot].m_type, TypeIndex);
+		addToList(&m_type2slots[order.m_type], slot, &m_positions[slot].m_type);
+	}
+	current = order;
+	if (closed)
+	{
+		onClosed(order.m_ticket);
+	}
+}
+
+void KOrderCache::addToList(slots_t* list, const slot_t slot, slot_t* position)
+{
+	*position = static_cast<slot_t>(list->size());
+	list->push_back(slot);
+}
+
+void KOrderCache::removeFromList(slots_t* list, const slot_t position, const EIndex index)
+{
+	const slot_t moved = list->back();
+	(*list)[position] = moved;
+	*getPosition(moved, index) = position;
+	list->pop_back();
+}
+
+slot_t* KOrderCache::getPosition(const slot_t slot, const EIndex index)
+{
+	SIndexPositions& positions = m_positions[slot];
+	switch (index)
+	{
+		case SymbolIndex:
+			return &positions.m_symbol;
+
+		case StatusIndex:
+			return &positions.m_status;
+
+		default:
+			return &positions.m_type;
+	}
+}
+
+void KOrderCache::onClosed(const ticket_t ticket)
+{
+	m_closedTickets.push_back(ticket);
+	while (m_closedCapacity < m_closedTickets.size())
+	{
+		// a closed order stays closed, so the ticket still has its slot
+		erase(m_ticket2slot.find(m_closedTickets.front())->second);
+		m_closedTickets.pop_front();
+	}
+}
+
+void KOrderCache::erase(const slot_t slot)
+{
+	SIndexPositions& positions = m_positions[slot];
+	SOrder& order = m_orders[slot];
+	removeFromList(&ensureSymbolList(order.m_symbolName), positions.m_symbol, SymbolIndex);
+	removeFromList(&m_status2slots[order.m_status], positions.m_status, StatusIndex);
+	removeFromList(&m_type2slots[order.m_type], positions.m_type, TypeIndex);
+	m_ticket2slot.erase(order.m_ticket);
+
+	const slot_t last = static_cast<slot_t>(m_orders.size() - 1);
+	if (slot != last)
+	{
+		order = m_orders[last];
+		positions = m_positions[last];
+		ensureSymbolList(order.m_symbolName)[positions.m_symbol] = slot;
+		m_status2slots[order.m_status][positions.m_status] = slot;
+		m_type2slots[order.m_type][positions.m_type] = slot;
+		m_ticket2slot[order.m_ticket] = slot;
+	}
+	m_orders.pop_back();
+	m_positions.pop_back();
+}
+
+slots_t& KOrderCache::ensureSymbolList(const std::string_view& symbol)
+{
+	auto it = m_symbol2slots.find(symbol);
+	if (it == m_symbol2slots.end())
+	{
+		it = m_symbol2slots.emplace(std::string(symbol), slots_t()).first;
+	}
+	return it->second;
+}
+
+const slots_t* KOrderCache::getCandidates(const SOrderFilter& filter) const
+{
+	// the shortest of the lists of the given criteria, nullptr means all
+	// the orders
+	static const slots_t NoSlots;
+	const slots_t* result = nullptr;
+	if (!filter.m_symbol.empty())
+	{
+		auto it = m_symbol2slots.find(filter.m_symbol);
+		result = (it != m_symbol2slots.end()) ? &it->second : &NoSlots;
+	}
+
+	if (filter.m_status != SOrder::Unknown)
+	{
+		const slots_t* slots = &m_status2slots[filter.m_status];
+		if ((result == nullptr) || (slots->size() < result->size()))
+		{
+			result = slots;
+		}
+	}
+
+	if (filter.m_type != SOrder::None)
+	{
+		const slots_t* slots = &m_type2slots[filter.m_type];
+		if ((result == nullptr) || (slots->size() < result->size()))
+		{
+			result = slots;
+		}
+	}
+	return result;
+}
+
+template<typename TVisitor>
+void KOrderCache::visit(const SOrderFilter& filter, TVisitor visitor) const
+{
+	std::shared_lock<std::shared_mutex> lock(m_mutex);
+	const slots_t* candidates = getCandidates(filter);
+	if (candidates == nullptr)
+	{
+		for (const SOrder& order : m_orders)
+		{
+			visitor(order);
+		}
+	}
+	else
+	{
+		for (const slot_t slot : *candidates)
+		{
+			const SOrder& order = m_orders[slot];
+			if (filter.matches(order))
+			{
+				visitor(order);
+			}
+		}
+	}
+}
+
+} // anonymous namespace
+
+// ---------------------------------------------------------------------------
+
+IOrderCache* createOrderCache(const std::size_t closedCapacity)
+{
+	IOrderCache* cache = new KOrderCache(closedCapacity);
+	return cache;
+}
+
+} // namespace fx
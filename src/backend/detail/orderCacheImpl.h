@@ -0,0 +1,17 @@
+// author: Darek Slusarczyk alias marines marinesovitch 2012-2013, 2022
+#ifndef INC_BACKEND_ORDERCACHEIMPL_H
+#define INC_BACKEND_ORDERCACHEIMPL_H
+
+namespace fx
+{
+
+struct IOrderCache;
+
+// the closed orders kept beyond it are dropped, the oldest closed first
+const std::size_t DefaultClosedOrderCapacity = 4096;
+
+IOrderCache* createOrderCache(const std::size_t closedCapacity = DefaultClosedOrderCapacity);
+
+} // namespace fx
+
+#endif
@@ -0,0 +1,24 @@
+// author: Darek Slusarczyk alias marines marinesovitch 2012-2013, 2022
+#include "ph.h"
+#include "paperConnection.h"
+
+namespace fx
+{
+
+void SPaperStats::print(std::ostream& os) const
+{
+	const double avgTickSeconds = (m_tickCount != 0) ? (m_totalTickSeconds / m_tickCount) : 0.0;
+	os << "balance " << m_balance << ", equity " << m_equity << ", " << m_orderCount << " orders" << std::endl
+		<< m_tickCount << " ticks, " << m_commandCount << " commands"
+		<< ", tick avg " << avgTickSeconds * 1e6
+		<< "us max " << m_maxTickSeconds * 1e6
+		<< "us last " << m_lastTickSeconds * 1e6 << "us" << std::endl;
+}
+
+// ---------------------------------------------------------------------------
+
+IPaperConnection::~IPaperConnection()
+{
+}
+
+} // namespace fx
@@ -0,0 +1,267 @@
+// author: Darek Slusarczyk alias marines marinesovitch 2012-2013, 2022
+#include "ph.h"
+#include "paperConnectionImpl.h"
+#include "paperConnection.h"
+#include "commandThrottle.h"
+#include "commandThrottleImpl.h"
+#include "executionSimulator.h"
+#include "executionSimulatorImpl.h"
+#include "common/command.h"
+#include "common/order.h"
+#include "common/types.h"
+#include <chrono>
+
+namespace fx
+{
+
+namespace
+{
+
+typedef std::chrono::steady_clock clock_t;
+
+// the reports of the simulator are collected while it handles a tick and
+// passed to the trader after it, out of the lock of the simulator, so the
+// trader may send commands meanwhile
+class KReportCollector : public IExecutionSink
+{
+	public:
+		// IExecutionSink
+		virtual void onOrder(const SOrder& order);
+		virtual void onCmdResult(HCommand command, const std::string& output);
+
+	public:
+		void flush(ITraderSink* sink);
+
+	private:
+		std::vector<SOrder> m_orders;
+		std::vector<std::pair<HCommand, std::string>> m_results;
+
+};
+
+// ---------------------------------------------------------------------------
+
+void KReportCollector::onOrder(const SOrder& order)
+{
+	m_orders.push_back(order);
+}
+
+void KReportCollector::onCmdResult(HCommand command, const std::string& output)
+{
+	m_results.emplace_back(command, output);
+}
+
+void KReportCollector::flush(ITraderSink* sink)
+{
+	// the vectors keep their capacity, the ticks which change no order
+	// don't touch the heap
+	for (const SOrder& order : m_orders)
+	{
+		sink->onOrder(order);
+	}
+	m_orders.clear();
+
+	for (const auto& result : m_results)
+	{
+		sink->onCmdResult(result.first, result.second);
+	}
+	m_results.clear();
+}
+
+// ---------------------------------------------------------------------------
+
+// the simulator is not synchronized, it is driven by the tick loop of the
+// live connection and fed by the command thread, which takes the commands
+// from the throttle like the cmd loop of the live connection; so the
+// commands are executed by the next tick after they left the throttle
+class KPaperConnection : public IPaperConnection
+{
+	public:
+		KPaperConnection(const SExecutionParams& params, ITraderSink* sink);
+		virtual ~KPaperConnection();
+
+	public:
+		// IConnection
+		virtual bool isConnected() const;
+		virtual void sendCommand(HCommand command);
+		virtual ICommandThrottle& getThrottle();
+
+	public:
+		// ITraderSink
+		virtual void onRegisterSymbol(const std::string& symbol);
+		virtual void onUnregisterSymbol(const std::string& symbol);
+
+		virtual void onTick(const STick& tick);
+		virtual void onSymbol(const SSymbolInfo& symbolInfo);
+		virtual void onOrder(const SOrder& order);
+		virtual void onCmdResult(HCommand command, const std::string& output);
+		virtual void onDisconnected();
+
+	public:
+		// IPaperConnection
+		virtual void setLiveConnection(HConnection connection);
+		virtual SPaperStats getStats() const;
+
+	private:
+		void cmdLoop();
+
+	private:
+		ITraderSink& m_sink;
+		// accessed atomically, because it is set while the tick loop runs
+		HConnection m_liveConnection;
+
+		// the ticks of the live connection and the ones of a replayed
+		// session come one after another
+		std::mutex m_tickMutex;
+		KReportCollector m_reports;
+
+		mutable std::mutex m_mutex;
+		std::unique_ptr<IExecutionSimulator> m_simulator;
+		SPaperStats m_stats;
+
+		std::unique_ptr<ICommandThrottle> m_cmdQueue;
+		// queued by the destructor after the other commands, stops the
+		// command thread
+		const HCommand m_stopCommand;
+		std::thread m_cmdThread;
+
+};
+
+// ---------------------------------------------------------------------------
+
+KPaperConnection::KPaperConnection(const SExecutionParams& params, ITraderSink* sink)
+	: m_sink(*sink)
+	, m_simulator(createExecutionSimulator(params, &m_reports))
+	, m_cmdQueue(createCommandThrottle(SThrottleLimits()))
+	, m_stopCommand(std::make_shared<KCmdGet>(tickets_t()))
+{
+	m_cmdThread = std::thread(&KPaperConnection::cmdLoop, this);
+}
+
+KPaperConnection::~KPaperConnection()
+{
+	// the commands queued before are still passed to the simulator
+	m_cmdQueue->push(m_stopCommand);
+	m_cmdThread.join();
+}
+
+// ---------------------------------------------------------------------------
+// IConnection
+
+bool KPaperConnection::isConnected() const
+{
+	HConnection liveConnection = std::atomic_load(&m_liveConnection);
+	const bool result = liveConnection && liveConnection->isConnected();
+	return result;
+}
+
+void KPaperConnection::sendCommand(HCommand command)
+{
+	m_cmdQueue->push(command);
+}
+
+ICommandThrottle& KPaperConnection::getThrottle()
+{
+	return *m_cmdQueue;
+}
+
+// ---------------------------------------------------------------------------
+// ITraderSink
+
+void KPaperConnection::onRegisterSymbol(const std::string& symbol)
+{
+	m_sink.onRegisterSymbol(symbol);
+}
+
+void KPaperConnection::onUnregisterSymbol(const std::string& symbol)
+{
+	m_sink.onUnregisterSymbol(symbol);
+}
+
+void KPaperConnection::onTick(const STick& tick)
+{
+	std::lock_guard<std::mutex> tickLock(m_tickMutex);
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		const auto start = clock_t::now();
+		m_simulator->onTick(tick);
+		const double seconds = std::chrono::duration<double>(clock_t::now() - start).count();
+
+		++m_stats.m_tickCount;
+		m_stats.m_lastTickSeconds = seconds;
+		m_stats.m_maxTickSeconds = (std::max)(m_stats.m_maxTickSeconds, seconds);
+		m_stats.m_totalTickSeconds += seconds;
+	}
+
+	// the orders filled or closed by the tick are known to the trader before
+	// the tick itself, like they would come from the order loop
+	m_reports.flush(&m_sink);
+	m_sink.onTick(tick);
+}
+
+void KPaperConnection::onSymbol(const SSymbolInfo& symbolInfo)
+{
+	m_sink.onSymbol(symbolInfo);
+}
+
+void KPaperConnection::onOrder(const SOrder& /*order*/)
+{
+	// the live orders of the account aren't a part of the paper account
+}
+
+void KPaperConnection::onCmdResult(HCommand command, const std::string& output)
+{
+	m_sink.onCmdResult(command, output);
+}
+
+void KPaperConnection::onDisconnected()
+{
+	// the commands of the paper account are executed by the simulator
+}
+
+// ---------------------------------------------------------------------------
+// IPaperConnection
+
+void KPaperConnection::setLiveConnection(HConnection connection)
+{
+	std::atomic_store(&m_liveConnection, connection);
+}
+
+SPaperStats KPaperConnection::getStats() const
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+	SPaperStats result = m_stats;
+	result.m_balance = m_simulator->getBalance();
+	result.m_equity = m_simulator->getEquity();
+	result.m_orderCount = m_simulator->getOrderCount();
+	return result;
+}
+
+// ---------------------------------------------------------------------------
+
+void KPaperConnection::cmdLoop()
+{
+	for (;;)
+	{
+		HCommand command = m_cmdQueue->pop();
+		if (command == m_stopCommand)
+		{
+			break;
+		}
+
+		std::lock_guard<std::mutex> lock(m_mutex);
+		m_simulator->sendCommand(command);
+		++m_stats.m_commandCount;
+	}
+}
+
+} // anonymous namespace
+
+// ---------------------------------------------------------------------------
+
+IPaperConnection* createPaperConnection(const SExecutionParams& params, ITraderSink* sink)
+{
+	IPaperConnection* connection = new KPaperConnection(params, sink);
+	return connection;
+}
+
+} // namespace fx
@@ -0,0 +1,16 @@
+// author: Darek Slusarczyk alias marines marinesovitch 2012-2013, 2022
+#ifndef INC_BACKEND_PAPERCONNECTIONIMPL_H
+#define INC_BACKEND_PAPERCONNECTIONIMPL_H
+
+namespace fx
+{
+
+struct IPaperConnection;
+struct ITraderSink;
+struct SExecutionParams;
+
+IPaperConnection* createPaperConnection(const SExecutionParams& params, ITraderSink* sink);
+
+} // namespace fx
+
+#endif
@@ -0,0 +1,385 @@
+// author: Darek Slusarczyk alias marines marinesovitch 2012-2013, 2022
+#include "ph.h"
+#include "positionEngineImpl.h"
+#include "positionEngine.h"
+#include "common/order.h"
+#include <string_view>
+#include <unordered_map>
+
+namespace fx
+{
+
+namespace
+{
+
+// what a single order adds to its symbol, it is kept so the previous state
+// of the order may be subtracted when the order changes
+struct SContribution
+{
+	std::size_t m_symbol = 0;
+	bool m_open = false;
+	bool m_pending = false;
+	volume_t m_buyLots = 0;
+	volume_t m_buyPriceLots = 0;
+	volume_t m_sellLots = 0;
+	volume_t m_sellPriceLots = 0;
+	// lots * the close price at which MetaTrader reported the profit
+	volume_t m_buyMarkLots = 0;
+	volume_t m_sellMarkLots = 0;
+	volume_t m_floatingProfit = 0;
+	volume_t m_realizedProfit = 0;
+};
+
+// ---------------------------------------------------------------------------
+
+struct SSymbolState
+{
+	SPosition m_position;
+	// the sums of lots * open price, the averages are derived from them
+	volume_t m_buyPriceLots = 0;
+	volume_t m_sellPriceLots = 0;
+	// the profit reported by MetaTrader with the open orders, the ticks only
+	// add the moves of the prices since the reports, so the profit stays in
+	// the account currency
+	volume_t m_floatingProfit = 0;
+	volume_t m_buyMarkLots = 0;
+	volume_t m_sellMarkLots = 0;
+	// the profit of one lot per a unit of the price, 0 until it is known
+	double m_profitPerPriceLot = 0;
+	price_t m_bid = 0;
+	price_t m_ask = 0;
+	bool m_hasPrices = false;
+};
+
+// ---------------------------------------------------------------------------
+
+class KPositionEngine : public IPositionEngine
+{
+	public:
+		KPositionEngine(const double contractSize);
+
+	public:
+		// IPositionEngine
+		virtual void onOrder(const SOrder& order);
+		virtual void onTick(const STick& tick);
+		virtual void clear();
+
+		virtual bool getPosition(const std::string& symbol, SPosition* position) const;
+		virtual void getPositions(std::vector<SPosition>* positions) const;
+		virtual SAccountPosition getAccountPosition() const;
+
+	private:
+		// must be called with locked m_mutex
+		SContribution makeContribution(const std::size_t symbol, const SOrder& order) const;
+		void learnProfitPerPriceLot(SSymbolState* state, const SOrder& order) const;
+		void apply(const SContribution& contribution, const int sign);
+		void refresh(SSymbolState* state);
+		std::size_t ensureSymbol(const std::string_view& symbol);
+
+	private:
+		const double m_contractSize;
+
+		mutable std::mutex m_mutex;
+
+		std::vector<SSymbolState> m_symbols;
+		std::map<std::string, std::size_t, std::less<>> m_symbol2index;
+		std::unordered_map<int32_t, SContribution> m_ticket2contribution;
+
+		SAccountPosition m_account;
+
+};
+
+// ---------------------------------------------------------------------------
+
+KPositionEngine::KPositionEngine(const double contractSize)
+	: m_contractSize(contractSize)
+{
+}
+
+// ---------------------------------------------------------------------------
+// IPositionEngine
+
+void KPositionEngine::onOrder(const SOrder& order)
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+	const std::size_t symbol = ensureSymbol(order.m_symbolName);
+	learnProfitPerPriceLot(&m_symbols[symbol], order);
+	const SContribution contribution = makeContribution(symbol, order);
+	auto it = m_ticket2contribution.find(order.m_ticket);
+	if (it == m_ticket2contribution.end())
+	{
+		m_ticket2contribution.emplace(order.m_ticket, contribution);
+	}
+	else
+	{
+		apply(it->second, -1);
+		it->second = contribution;
+	}
+	apply(contribution, 1);
+	++m_account.m_version;
+}
+
+void KPositionEngine::onTick(const STick& tick)
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+	auto it = m_symbol2index.find(std::string_view(tick.m_symbolName));
+	if (it == m_symbol2index.end())
+	{
+		// no order of the symbol yet, so its prices are not needed
+		return;
+	}
+
+	SSymbolState& state = m_symbols[it->second];
+	state.m_bid = tick.m_bid.m_value;
+	state.m_ask = tick.m_ask.m_value;
+	state.m_hasPrices = true;
+	refresh(&state);
+	++m_account.m_version;
+}
+
+void KPositionEngine::clear()
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+	m_symbols.clear();
+	m_symbol2index.clear();
+	m_ticket2contribution.clear();
+	const uint64_t version = m_account.m_version;
+	m_account = SAccountPosition();
+	m_account.m_version = version + 1;
+}
+
+bool KPositionEngine::getPosition(const std::string& symbol, SPosition* position) const
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+	auto it = m_symbol2index.find(symbol);
+	if (it == m_symbol2index.end())
+	{
+		return false;
+	}
+
+	*position = m_symbols[it->second].m_position;
+	return true;
+}
+
+void KPositionEngine::getPositions(std::vector<SPosition>* positions) const
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+	positions->reserve(positions->size() + m_symbols.size());
+	for (const auto& symbol2index : m_symbol2index)
+	{
+		positions->push_back(m_symbols[symbol2index.second].m_position);
+	}
+}
+
+SAccountPosition KPositionEngine::getAccountPosition() const
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+	return m_account;
+}
+
+// ---------------------------------------------------------------------------
+
+SContribution KPositionEngine::makeContribution(const std::size_t symbol, const SOrder& order) const
+{
+	SContribution result;
+	result.m_symbol = symbol;
+	const volume_t lots = order.m_lots.m_value;
+	const price_t price = order.m_openPrice.m_value;
+	// without the close price the profit is taken as reported at the open
+	const price_t markPrice = order.m_closePrice.isNull() ? price : order.m_closePrice.m_value;
+	switch (order.m_status)
+	{
+		case SOrder::Open:
+			if (order.m_type == SOrder::Buy)
+			{
+				result.m_open = true;
+				result.m_buyLots = lots;
+				result.m_buyPriceLots = lots * price;
+				result.m_buyMarkLots = lots * markPrice;
+			}
+			else if (order.m_type == SOrder::Sell)
+			{
+				result.m_open = true;
+				result.m_sellLots = lots;
+				result.m_sellPriceLots = lots * price;
+				result.m_sellMarkLots = lots * markPrice;
+			}
+			result.m_floatingProfit
+				= order.m_profit.m_value + order.m_commission.m_value + order.m_swap.m_value;
+			break;
+
+		case SOrder::Pending:
+			result.m_pending = true;
+			break;
+
+		case SOrder::Closed:
+			// a cancelled pending order has no profit, so it adds nothing
+			result.m_realizedProfit
+				= order.m_profit.m_value + order.m_commission.m_value + order.m_swap.m_value;
+			break;
+
+		default:
+			break;
+	}
+	return result;
+}
+
+void KPositionEngine::learnProfitPerPriceLot(SSymbolState* state, const SOrder& order) const
+{
+	if ((m_contractSize != 0) || order.m_closePrice.isNull() || (order.m_lots.m_value <= 0))
+	{
+		return;
+	}
+
+	price_t move = 0;
+	if (order.m_type == SOrder::Buy)
+	{
+		move = order.m_closePrice.m_value - order.m_openPrice.m_value;
+	}
+	else if (order.m_type == SOrder::Sell)
+	{
+		move = order.m_openPrice.m_value - order.m_closePrice.m_value;
+	}
+
+	// the tiny moves would give a rough ratio, the latest report wins, so
+	// the ratio follows the rate of the account currency
+	if (std::abs(move) < 1e-9)
+	{
+		return;
+	}
+
+	const double profitPerPriceLot = order.m_profit.m_value / (move * order.m_lots.m_value);
+	if (0 < profitPerPriceLot)
+	{
+		state->m_profitPerPriceLot = profitPerPriceLot;
+	}
+}
+
+void KPositionEngine::apply(const SContribution& contribution, const int sign)
+{
+	SSymbolState& state = m_symbols[contribution.m_symbol];
+	SPosition& position = state.m_position;
+	const bool wasOpen = !position.isFlat();
+
+	m_account.m_grossLots -= position.m_buyLots + position.m_sellLots;
+	m_account.m_realizedProfit += sign * contribution.m_realizedProfit;
+	if (contribution.m_open)
+	{
+		if (sign > 0)
+		{
+			++m_account.m_openCount;
+			++position.m_openCount;
+		}
+		else
+		{
+			--m_account.m_openCount;
+			--position.m_openCount;
+		}
+	}
+	if (contribution.m_pending)
+	{
+		if (sign > 0)
+		{
+			++m_account.m_pendingCount;
+			++position.m_pendingCount;
+		}
+		else
+		{
+			--m_account.m_pendingCount;
+			--position.m_pendingCount;
+		}
+	}
+	position.m_realizedProfit += sign * contribution.m_realizedProfit;
+	position.m_buyLots += sign * contribution.m_buyLots;
+	position.m_sellLots += sign * contribution.m_sellLots;
+	state.m_buyPriceLots += sign * contribution.m_buyPriceLots;
+	state.m_sellPriceLots += sign * contribution.m_sellPriceLots;
+	state.m_buyMarkLots += sign * contribution.m_buyMarkLots;
+	state.m_sellMarkLots += sign * contribution.m_sellMarkLots;
+	state.m_floatingProfit += sign * contribution.m_floatingProfit;
+
+	if (position.isFlat())
+	{
+		// the sums are reset, so the rounding errors do not accumulate
+		position.m_buyLots = 0;
+		position.m_sellLots = 0;
+		state.m_buyPriceLots = 0;
+		state.m_sellPriceLots = 0;
+		state.m_buyMarkLots = 0;
+		state.m_sellMarkLots = 0;
+		state.m_floatingProfit = 0;
+	}
+	m_account.m_grossLots += position.m_buyLots + position.m_sellLots;
+
+	const bool isOpen = !position.isFlat();
+	if (wasOpen != isOpen)
+	{
+		if (isOpen)
+		{
+			++m_account.m_symbolCount;
+		}
+		else
+		{
+			--m_account.m_symbolCount;
+		}
+	}
+
+	refresh(&state);
+}
+
+void KPositionEngine::refresh(SSymbolState* state)
+{
+	SPosition& position = state->m_position;
+	position.m_buyPrice = (position.m_buyLots != 0) ? state->m_buyPriceLots / position.m_buyLots : 0;
+	position.m_sellPrice = (position.m_sellLots != 0) ? state->m_sellPriceLots / position.m_sellLots : 0;
+	position.m_netLots = position.m_buyLots - position.m_sellLots;
+	position.m_averagePrice = (position.m_netLots != 0)
+		? (state->m_buyPriceLots - state->m_sellPriceLots) / position.m_netLots
+		: 0;
+
+	m_account.m_unrealizedProfit -= position.m_unrealizedProfit;
+	if (position.isFlat())
+	{
+		position.m_unrealizedProfit = 0;
+	}
+	else if (state->m_hasPrices && (state->m_profitPerPriceLot != 0))
+	{
+		position.m_unrealizedProfit = state->m_floatingProfit + state->m_profitPerPriceLot * (
+			position.m_buyLots * state->m_bid - state->m_buyMarkLots
+			+ state->m_sellMarkLots - position.m_sellLots * state->m_ask);
+	}
+	else
+	{
+		position.m_unrealizedProfit = state->m_floatingProfit;
+	}
+	m_account.m_unrealizedProfit += position.m_unrealizedProfit;
+}
+
+std::size_t KPositionEngine::ensureSymbol(const std::string_view& symbol)
+{
+	auto it = m_symbol2index.find(symbol);
+	if (it == m_symbol2index.end())
+	{
+		const std::size_t index = m_symbols.size();
+		m_symbols.push_back(SSymbolState());
+		m_symbols.back().m_profitPerPriceLot = m_contractSize;
+		SPosition& position = m_symbols.back().m_position;
+		const std::size_t length = std::min(symbol.size(), std::size_t(consts::MaxSymbolNameLen - 1));
+		std::memcpy(position.m_symbolName, symbol.data(), length);
+		position.m_symbolName[length] = 0;
+		it = m_symbol2index.emplace(std::string(symbol), index).first;
+	}
+	return it->second;
+}
+
+} // anonymous namespace
+
+// ---------------------------------------------------------------------------
+
+IPositionEngine* createPositionEngine(const double contractSize)
+{
+	IPositionEngine* engine = new KPositionEngine(contractSize);
+	return engine;
+}
+
+} // namespace fx
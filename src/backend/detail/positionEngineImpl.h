@@ -0,0 +1,17 @@
+// author: Darek Slusarczyk alias marines marinesovitch 2012-2013, 2022
+#ifndef INC_BACKEND_POSITIONENGINEIMPL_H
+#define INC_BACKEND_POSITIONENGINEIMPL_H
+
+namespace fx
+{
+
+struct IPositionEngine;
+
+// the profit of one lot per a unit of the price, if it is known like in the
+// backtests; by default it is derived for each symbol from the profits of
+// its orders reported by MetaTrader, so it is in the account currency
+IPositionEngine* createPositionEngine(const double contractSize = 0);
+
+} // namespace fx
+
+#endif
@@ -0,0 +1,23 @@
+// author: Darek Slusarczyk alias marines marinesovitch 2012-2013, 2022
+#include "ph.h"
+#include "riskGuard.h"
+
+namespace fx
+{
+
+void SRiskLimits::print(std::ostream& os) const
+{
+	os << "lots=" << m_maxOrderLots
+		<< " symbol=" << m_maxSymbolLots
+		<< " account=" << m_maxAccountLots
+		<< " orders=" << m_maxOrderCount
+		<< " band=" << m_priceBand << std::endl;
+}
+
+// ---------------------------------------------------------------------------
+
+IRiskGuard::~IRiskGuard()
+{
+}
+
+} // namespace fx
@@ -0,0 +1,460 @@
+// author: Darek Slusarczyk alias marines marinesovitch 2012-2013, 2022
+#include "ph.h"
+#include "riskGuardImpl.h"
+#include "riskGuard.h"
+#include "common/command.h"
+#include "common/order.h"
+#include "common/position.h"
+#include <algorithm>
+#include <array>
+#include <string_view>
+
+namespace fx
+{
+
+namespace
+{
+
+// the symbols are added on their first tick or order and never removed, the
+// slot of a symbol is published by m_ready, so the readers need no lock
+struct SRiskSymbol
+{
+	char m_name[consts::MaxSymbolNameLen];
+	std::atomic<bool> m_ready = false;
+
+	// the bid and ask of the last tick, 0 until the first one
+	std::atomic<price_t> m_bid = 0;
+	std::atomic<price_t> m_ask = 0;
+	std::atomic<volume_t> m_netLots = 0;
+	// the net lots of the orders in flight, changed under the reserve mutex
+	std::atomic<volume_t> m_reservedNetLots = 0;
+};
+
+// a new order which passed the check, but wasn't reported nor refused yet
+struct SRiskReservation
+{
+	const KCommand* m_command;
+	SRiskSymbol* m_symbol;
+	std::string m_symbolName;
+	SOrder::EType m_type;
+	volume_t m_lots;
+	volume_t m_netLots;
+};
+
+const std::size_t MaxRiskSymbols = 256;
+
+// used only for the reasons of refusal, they are not on the hot path
+std::string lots2str(const volume_t lots)
+{
+	std::ostringstream os;
+	os << lots;
+	return os.str();
+}
+
+// ---------------------------------------------------------------------------
+
+class KRiskGuard : public IRiskGuard
+{
+	public:
+		KRiskGuard(const SRiskLimits& limits);
+
+	public:
+		// IRiskGuard
+		virtual void setLimits(const SRiskLimits& limits);
+		virtual SRiskLimits getLimits() const;
+
+		virtual void onTick(const STick& tick);
+		virtual void onPosition(const SPosition& position, const SAccountPosition& account);
+		virtual void onNewOrder(const SOrder& order);
+		virtual void onCmdResult(const KCommand& command, const bool success);
+		virtual void onCmdLost(const KCommand& command);
+		virtual void onDisconnected();
+
+		virtual bool check(const KCommand& command, std::string* error);
+		virtual SRiskStats getStats() const;
+
+	private:
+		bool checkNewOrder(const SNewOrder& order, SRiskReservation* reservation, std::string* error);
+		void release(std::vector<SRiskReservation>::iterator it);
+		bool checkPriceBand(
+			const char* name,
+			const price_t price,
+			const price_t middle,
+			const double band,
+			std::string* error) const;
+
+		const SRiskSymbol* findSymbol(const std::string_view& name) const;
+		SRiskSymbol* ensureSymbol(const std::string_view& name);
+
+	private:
+		std::atomic<volume_t> m_maxOrderLots;
+		std::atomic<volume_t> m_maxSymbolLots;
+		std::atomic<volume_t> m_maxAccountLots;
+		std::atomic<std::size_t> m_maxOrderCount;
+		std::atomic<double> m_priceBand;
+
+		// open addressing, the slots are claimed under the mutex, which is
+		// taken only for a new symbol
+		std::array<SRiskSymbol, MaxRiskSymbols> m_symbols;
+		std::mutex m_insertMutex;
+
+		std::atomic<volume_t> m_grossLots = 0;
+		std::atomic<std::size_t> m_orderCount = 0;
+
+		// the new orders are checked and reserved one at a time, else two of
+		// them could pass the same limit together
+		mutable std::mutex m_reserveMutex;
+		std::vector<SRiskReservation> m_reservations;
+		volume_t m_reservedLots = 0;
+
+		std::atomic<uint64_t> m_checkCount = 0;
+		std::atomic<uint64_t> m_refusedCount = 0;
+
+};
+
+// ---------------------------------------------------------------------------
+
+KRiskGuard::KRiskGuard(const SRiskLimits& limits)
+{
+	setLimits(limits);
+}
+
+// ---------------------------------------------------------------------------
+// IRiskGuard
+
+void KRiskGuard::setLimits(const SRiskLimits& limits)
+{
+	m_maxOrderLots = limits.m_maxOrderLots;
+	m_maxSymbolLots = limits.m_maxSymbolLots;
+	m_maxAccountLots = limits.m_maxAccountLots;
+	m_maxOrderCount = limits.m_maxOrderCount;
+	m_priceBand = limits.m_priceBand;
+}
+
+SRiskLimits KRiskGuard::getLimits() const
+{
+	SRiskLimits limits;
+	limits.m_maxOrderLots = m_maxOrderLots;
+	limits.m_maxSymbolLots = m_maxSymbolLots;
+	limits.m_maxAccountLots = m_maxAccountLots;
+	limits.m_maxOrderCount = m_maxOrderCount;
+	limits.m_priceBand = m_priceBand;
+	return limits;
+}
+
+void KRiskGuard::onTick(const STick& tick)
+{
+	if (SRiskSymbol* symbol = ensureSymbol(tick.m_symbolName))
+	{
+		symbol->m_bid.store(tick.m_bid.m_value, std::memory_order_relaxed);
+		symbol->m_ask.store(tick.m_ask.m_value, std::memory_order_relaxed);
+	}
+}
+
+void KRiskGuard::onPosition(const SPosition& position, const SAccountPosition& account)
+{
+	if (SRiskSymbol* symbol = ensureSymbol(position.m_symbolName))
+	{
+		symbol->m_netLots.store(position.m_netLots, std::memory_order_relaxed);
+	}
+	m_grossLots.store(account.m_grossLots, std::memory_order_relaxed);
+	m_orderCount.store(account.m_openCount + account.m_pendingCount, std::memory_order_relaxed);
+}
+
+void KRiskGuard::onNewOrder(const SOrder& order)
+{
+	std::lock_guard<std::mutex> lock(m_reserveMutex);
+	// the report doesn't tell the command, the oldest reservation of the same
+	// order is released, MetaTrader executes them in the order they were sent
+	auto it = std::find_if(m_reservations.begin(), m_reservations.end(),
+		[&order](const SRiskReservation& reservation)
+		{
+			return (reservation.m_type == order.m_type)
+				&& (std::abs(reservation.m_lots - order.m_lots.m_value) < 1e-6)
+				&& (reservation.m_symbolName == order.m_symbolName);
+		});
+	if (it != m_reservations.end())
+	{
+		release(it);
+	}
+}
+
+void KRiskGuard::onCmdResult(const KCommand& command, const bool success)
+{
+	if (success || (command.operation() != KCommand::Open))
+	{
+		// the executed order is released by its report
+		return;
+	}
+
+	onCmdLost(command);
+}
+
+void KRiskGuard::onCmdLost(const KCommand& command)
+{
+	std::lock_guard<std::mutex> lock(m_reserveMutex);
+	auto it = std::find_if(m_reservations.begin(), m_reservations.end(),
+		[&command](const SRiskReservation& reservation) { return reservation.m_command == &command; });
+	if (it != m_reservations.end())
+	{
+		release(it);
+	}
+}
+
+void KRiskGuard::onDisconnected()
+{
+	std::lock_guard<std::mutex> lock(m_reserveMutex);
+	while (!m_reservations.empty())
+	{
+		release(m_reservations.end() - 1);
+	}
+}
+
+bool KRiskGuard::check(const KCommand& command, std::string* error)
+{
+	if (command.operation() != KCommand::Open)
+	{
+		return true;
+	}
+
+	m_checkCount.fetch_add(1, std::memory_order_relaxed);
+	const SNewOrder& order = static_cast<const KCmdOpen&>(command).newOrder();
+	std::lock_guard<std::mutex> lock(m_reserveMutex);
+	SRiskReservation reservation;
+	const bool result = checkNewOrder(order, &reservation, error);
+	if (result)
+	{
+		reservation.m_command = &command;
+		if (reservation.m_symbol != nullptr)
+		{
+			std::atomic<volume_t>& reservedNetLots = reservation.m_symbol->m_reservedNetLots;
+			reservedNetLots.store(reservedNetLots.load(std::memory_order_relaxed) + reservation.m_netLots, std::memory_order_relaxed);
+		}
+		m_reservedLots += reservation.m_lots;
+		m_reservations.push_back(reservation);
+	}
+	else
+	{
+		m_refusedCount.fetch_add(1, std::memory_order_relaxed);
+	}
+	return result;
+}
+
+SRiskStats KRiskGuard::getStats() const
+{
+	SRiskStats stats;
+	stats.m_checkCount = m_checkCount.load(std::memory_order_relaxed);
+	stats.m_refusedCount = m_refusedCount.load(std::memory_order_relaxed);
+	std::lock_guard<std::mutex> lock(m_reserveMutex);
+	stats.m_reservedCount = m_reservations.size();
+	return stats;
+}
+
+// ---------------------------------------------------------------------------
+
+bool KRiskGuard::checkNewOrder(const SNewOrder& order, SRiskReservation* reservation, std::string* error)
+{
+	const volume_t lots = order.m_lots.m_value;
+	if (lots <= 0)
+	{
+		*error = "incorrect lots " + lots2str(lots);
+		return false;
+	}
+
+	const volume_t maxOrderLots = m_maxOrderLots.load(std::memory_order_relaxed);
+	if ((maxOrderLots != 0) && (maxOrderLots < lots))
+	{
+		*error = "lots " + lots2str(lots) + " exceed the limit of an order " + lots2str(maxOrderLots);
+		return false;
+	}
+
+	const std::size_t maxOrderCount = m_maxOrderCount.load(std::memory_order_relaxed);
+	const std::size_t orderCount = m_orderCount.load(std::memory_order_relaxed) + m_reservations.size();
+	if ((maxOrderCount != 0) && (maxOrderCount <= orderCount))
+	{
+		*error = "the account has already " + std::to_string(orderCount) + " orders, the limit is " + std::to_string(maxOrderCount);
+		return false;
+	}
+
+	const volume_t maxAccountLots = m_maxAccountLots.load(std::memory_order_relaxed);
+	const volume_t grossLots = m_grossLots.load(std::memory_order_relaxed) + m_reservedLots + lots;
+	if ((maxAccountLots != 0) && (maxAccountLots < grossLots))
+	{
+		*error = "lots of the account " + lots2str(grossLots) + " would exceed the limit " + lots2str(maxAccountLots);
+		return false;
+	}
+
+	bool isBuy = false;
+	switch (order.m_type)
+	{
+		case SOrder::Buy:
+		case SOrder::BuyLimit:
+		case SOrder::BuyStop:
+			isBuy = true;
+			break;
+
+		case SOrder::Sell:
+		case SOrder::SellLimit:
+		case SOrder::SellStop:
+			isBuy = false;
+			break;
+
+		default:
+			*error = "incorrect order type";
+			return false;
+	}
+
+	// the symbol is added now if it has no tick nor order yet, so its orders
+	// in flight are counted
+	SRiskSymbol* symbol = ensureSymbol(order.m_symbolName);
+	const volume_t maxSymbolLots = m_maxSymbolLots.load(std::memory_order_relaxed);
+	const volume_t netLots = (symbol != nullptr)
+		? (symbol->m_netLots.load(std::memory_order_relaxed) + symbol->m_reservedNetLots.load(std::memory_order_relaxed))
+		: 0;
+	const volume_t orderNetLots = isBuy ? lots : -lots;
+	const volume_t newNetLots = netLots + orderNetLots;
+	if ((maxSymbolLots != 0) && (maxSymbolLots < std::abs(newNetLots)) && (std::abs(netLots) < std::abs(newNetLots)))
+	{
+		*error = "net lots of " + order.m_symbolName + ' ' + lots2str(newNetLots)
+			+ " would exceed the limit " + lots2str(maxSymbolLots);
+		return false;
+	}
+
+	// the stop loss and take profit on the wrong side of the price are
+	// typos, MetaTrader would reject them or close the order at once
+	const price_t openPrice = order.m_openPrice.m_value;
+	const price_t stopLoss = order.m_stopLoss.m_value;
+	const price_t takeProfit = order.m_takeProfit.m_value;
+	if (!order.m_openPrice.isNull())
+	{
+		if (!order.m_stopLoss.isNull() && (isBuy ? (openPrice <= stopLoss) : (stopLoss <= openPrice)))
+		{
+			*error = "stop loss " + order.m_stopLoss.toString() + " is on the wrong side of the open price";
+			return false;
+		}
+		if (!order.m_takeProfit.isNull() && (isBuy ? (takeProfit <= openPrice) : (openPrice <= takeProfit)))
+		{
+			*error = "take profit " + order.m_takeProfit.toString() + " is on the wrong side of the open price";
+			return false;
+		}
+	}
+
+	reservation->m_symbol = symbol;
+	reservation->m_symbolName = order.m_symbolName;
+	reservation->m_type = order.m_type;
+	reservation->m_lots = lots;
+	reservation->m_netLots = orderNetLots;
+
+	const double band = m_priceBand.load(std::memory_order_relaxed);
+	if (band == 0)
+	{
+		return true;
+	}
+
+	const price_t bid = (symbol != nullptr) ? symbol->m_bid.load(std::memory_order_relaxed) : 0;
+	const price_t ask = (symbol != nullptr) ? symbol->m_ask.load(std::memory_order_relaxed) : 0;
+	if ((bid <= 0) || (ask <= 0))
+	{
+		*error = "no quote of " + order.m_symbolName + " yet";
+		return false;
+	}
+
+	const price_t middle = (bid + ask) / 2;
+	const bool result
+		= checkPriceBand("open price", openPrice, middle, band, error)
+		&& checkPriceBand("stop loss", stopLoss, middle, band, error)
+		&& checkPriceBand("take profit", takeProfit, middle, band, error);
+	return result;
+}
+
+bool KRiskGuard::checkPriceBand(
+	const char* name,
+	const price_t price,
+	const price_t middle,
+	const double band,
+	std::string* error) const
+{
+	// the null prices are not set
+	if ((price == 0) || (std::abs(price - middle) <= band * middle))
+	{
+		return true;
+	}
+
+	*error = std::string(name) + ' ' + SPrice(price).toString() + " is too far from the quote " + SPrice(middle).toString();
+	return false;
+}
+
+void KRiskGuard::release(std::vector<SRiskReservation>::iterator it)
+{
+	if (it->m_symbol != nullptr)
+	{
+		std::atomic<volume_t>& reservedNetLots = it->m_symbol->m_reservedNetLots;
+		reservedNetLots.store(reservedNetLots.load(std::memory_order_relaxed) - it->m_netLots, std::memory_order_relaxed);
+	}
+	m_reservedLots -= it->m_lots;
+	m_reservations.erase(it);
+}
+
+const SRiskSymbol* KRiskGuard::findSymbol(const std::string_view& name) const
+{
+	const std::size_t start = std::hash<std::string_view>()(name) % MaxRiskSymbols;
+	for (std::size_t i = 0; i < MaxRiskSymbols; ++i)
+	{
+		const SRiskSymbol& symbol = m_symbols[(start + i) % MaxRiskSymbols];
+		if (!symbol.m_ready.load(std::memory_order_acquire))
+		{
+			return nullptr;
+		}
+
+		if (name == symbol.m_name)
+		{
+			return &symbol;
+		}
+	}
+	return nullptr;
+}
+
+SRiskSymbol* KRiskGuard::ensureSymbol(const std::string_view& name)
+{
+	if (const SRiskSymbol* symbol = findSymbol(name))
+	{
+		return const_cast<SRiskSymbol*>(symbol);
+	}
+
+	std::lock_guard<std::mutex> lock(m_insertMutex);
+	const std::size_t start = std::hash<std::string_view>()(name) % MaxRiskSymbols;
+	for (std::size_t i = 0; i < MaxRiskSymbols; ++i)
+	{
+		SRiskSymbol& symbol = m_symbols[(start + i) % MaxRiskSymbols];
+		if (!symbol.m_ready.load(std::memory_order_acquire))
+		{
+			const std::size_t length = std::min(name.size(), consts::MaxSymbolNameLen - 1);
+			std::memcpy(symbol.m_name, name.data(), length);
+			symbol.m_name[length] = 0;
+			symbol.m_ready.store(true, std::memory_order_release);
+			return &symbol;
+		}
+
+		if (name == symbol.m_name)
+		{
+			// the other loop has just added it
+			return &symbol;
+		}
+	}
+
+	// the table is full, the symbol has no quote, so its orders are refused
+	// while the price band is on
+	return nullptr;
+}
+
+} // anonymous namespace
+
+// ---------------------------------------------------------------------------
+
+IRiskGuard* createRiskGuard(const SRiskLimits& limits)
+{
+	IRiskGuard* guard = new KRiskGuard(limits);
+	return guard;
+}
+
+} // namespace fx
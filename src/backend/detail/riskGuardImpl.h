@@ -0,0 +1,15 @@
+// author: Darek Slusarczyk alias marines marinesovitch 2012-2013, 2022
+#ifndef INC_BACKEND_RISKGUARDIMPL_H
+#define INC_BACKEND_RISKGUARDIMPL_H
+
+namespace fx
+{
+
+struct IRiskGuard;
+struct SRiskLimits;
+
+IRiskGuard* createRiskGuard(const SRiskLimits& limits);
+
+} // namespace fx
+
+#endif
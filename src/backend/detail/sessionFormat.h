@@ -0,0 +1,53 @@
+// author: Darek Slusarczyk alias marines marinesovitch 2012-2013, 2022
+#ifndef INC_BACKEND_SESSIONFORMAT_H
+#define INC_BACKEND_SESSIONFORMAT_H
+
+#include <cstdint>
+
+namespace fx
+{
+
+namespace session
+{
+
+// the file starts with signature, then there is a sequence of frames, each
+// frame consists of header and payload:
+// - Account: int64_t login followed by broker name
+// - Note: uint8_t note::EKind followed by symbol name
+// - Tick, Symbol, Order: raw STick, SSymbolInfo, SOrder (the same as sent
+//   over the pipes)
+// - Cmd, CmdResult: text of command / its output
+const char Signature[] = { 'F', 'X', 'S', 'E', 'S', 'S', '0', '1' };
+
+enum EFrameKind : uint8_t
+{
+	Account = 1,
+	Note,
+	Tick,
+	Symbol,
+	Order,
+	Cmd,
+	CmdResult,
+	FrameKindCount
+};
+
+#pragma pack(push, 1)
+
+struct SFrameHeader
+{
+	// nanoseconds since start of recording
+	int64_t m_time;
+	int32_t m_accountKey;
+	uint32_t m_size;
+	uint8_t m_kind;
+};
+
+#pragma pack(pop)
+
+const uint32_t MaxFrameSize = 64 * 1024;
+
+} // namespace session
+
+} // namespace fx
+
+#endif
@@ -0,0 +1,197 @@
+// author: Darek Slusarczyk alias marines marinesovitch 2012-2013, 2022
+#include "ph.h"
+#include "sessionRecorderImpl.h"
+#include "sessionRecorder.h"
+#include "sessionFormat.h"
+#include "common/order.h"
+#include "common/symbolInfo.h"
+#include <chrono>
+
+namespace fx
+{
+
+namespace
+{
+
+const std::size_t FileBufferSize = 1024 * 1024;
+
+class KSessionRecorder : public ISessionRecorder
+{
+	public:
+		KSessionRecorder(const std::string& path);
+		virtual ~KSessionRecorder();
+
+	public:
+		// ISessionRecorder
+		virtual void recordAccount(const account_key_t& key, const SAccountInfo& accountInfo);
+		virtual void recordNote(const account_key_t& key, const note::EKind noteKind, const std::string& symbol);
+
+		virtual void recordTick(const account_key_t& key, const STick& tick);
+		virtual void recordSymbol(const account_key_t& key, const SSymbolInfo& symbolInfo);
+		virtual void recordOrder(const account_key_t& key, const SOrder& order);
+		virtual void recordCommand(const account_key_t& key, const std::string& command);
+		virtual void recordCmdResult(const account_key_t& key, const std::string& output);
+
+		virtual void printStats(std::ostream& os) const;
+
+	private:
+		template<typename T>
+		void recordItem(const session::EFrameKind kind, const account_key_t& key, const T& item)
+		{
+			writeFrame(kind, key, reinterpret_cast<const char*>(&item), sizeof(item));
+		}
+
+		void writeFrame(
+			const session::EFrameKind kind,
+			const account_key_t& key,
+			const char* payload,
+			const std::size_t payloadSize,
+			const char* payloadTail = nullptr,
+			const std::size_t payloadTailSize = 0);
+
+	private:
+		const std::string m_path;
+		const std::chrono::steady_clock::time_point m_start;
+
+		std::vector<char> m_fileBuffer;
+		std::ofstream m_file;
+
+		uint64_t m_frameCounts[session::FrameKindCount] = { 0 };
+		uint64_t m_bytes = 0;
+
+		mutable std::mutex m_mutex;
+
+};
+
+// ---------------------------------------------------------------------------
+
+KSessionRecorder::KSessionRecorder(const std::string& path)
+	: m_path(path)
+	, m_start(std::chrono::steady_clock::now())
+	, m_fileBuffer(FileBufferSize)
+{
+	m_file.rdbuf()->pubsetbuf(m_fileBuffer.data(), m_fileBuffer.size());
+	m_file.open(path, std::ios::binary | std::ios::trunc);
+	if (!m_file)
+	{
+		throw std::runtime_error("cannot create file " + path);
+	}
+	m_file.write(session::Signature, sizeof(session::Signature));
+	m_bytes += sizeof(session::Signature);
+}
+
+KSessionRecorder::~KSessionRecorder()
+{
+	m_file.flush();
+}
+
+// ---------------------------------------------------------------------------
+
+void KSessionRecorder::recordAccount(const account_key_t& key, const SAccountInfo& accountInfo)
+{
+	const int64_t accountLogin = accountInfo.m_accountLogin;
+	const std::string& broker = accountInfo.m_broker;
+	writeFrame(
+		session::Account,
+		key,
+		reinterpret_cast<const char*>(&accountLogin),
+		sizeof(accountLogin),
+		broker.c_str(),
+		broker.length());
+}
+
+void KSessionRecorder::recordNote(const account_key_t& key, const note::EKind noteKind, const std::string& symbol)
+{
+	const uint8_t rawNoteKind = static_cast<uint8_t>(noteKind);
+	writeFrame(
+		session::Note,
+		key,
+		reinterpret_cast<const char*>(&rawNoteKind),
+		sizeof(rawNoteKind),
+		symbol.c_str(),
+		symbol.length());
+}
+
+void KSessionRecorder::recordTick(const account_key_t& key, const STick& tick)
+{
+	recordItem(session::Tick, key, tick);
+}
+
+void KSessionRecorder::recordSymbol(const account_key_t& key, const SSymbolInfo& symbolInfo)
+{
+	recordItem(session::Symbol, key, symbolInfo);
+}
+
+void KSessionRecorder::recordOrder(const account_key_t& key, const SOrder& order)
+{
+	recordItem(session::Order, key, order);
+}
+
+void KSessionRecorder::recordCommand(const account_key_t& key, const std::string& command)
+{
+	writeFrame(session::Cmd, key, command.c_str(), command.length());
+}
+
+void KSessionRecorder::recordCmdResult(const account_key_t& key, const std::string& output)
+{
+	writeFrame(session::CmdResult, key, output.c_str(), output.length());
+}
+
+void KSessionRecorder::printStats(std::ostream& os) const
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+	os << m_path << ": "
+		<< m_frameCounts[session::Tick] << " ticks, "
+		<< m_frameCounts[session::Symbol] << " symbols, "
+		<< m_frameCounts[session::Order] << " orders, "
+		<< m_frameCounts[session::Cmd] << " commands, "
+		<< m_frameCounts[session::CmdResult] << " command results, "
+		<< m_frameCounts[session::Note] << " notes, "
+		<< m_bytes << " bytes" << std::endl;
+}
+
+// ---------------------------------------------------------------------------
+
+void KSessionRecorder::writeFrame(
+	const session::EFrameKind kind,
+	const account_key_t& key,
+	const char* payload,
+	const std::size_t payloadSize,
+	const char* payloadTail,
+	const std::size_t payloadTailSize)
+{
+	const std::size_t frameSize = payloadSize + payloadTailSize;
+	assert(frameSize <= session::MaxFrameSize);
+
+	session::SFrameHeader header;
+	header.m_kind = kind;
+	header.m_accountKey = key;
+	header.m_size = static_cast<uint32_t>(std::min<std::size_t>(frameSize, session::MaxFrameSize));
+
+	std::lock_guard<std::mutex> lock(m_mutex);
+	// take the time under the lock, so the frames are stored in chronological order
+	const auto sinceStart = std::chrono::steady_clock::now() - m_start;
+	header.m_time = std::chrono::duration_cast<std::chrono::nanoseconds>(sinceStart).count();
+
+	m_file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+	m_file.write(payload, payloadSize);
+	if (payloadTail != nullptr)
+	{
+		m_file.write(payloadTail, header.m_size - payloadSize);
+	}
+
+	++m_frameCounts[kind];
+	m_bytes += sizeof(header) + header.m_size;
+}
+
+} // anonymous namespace
+
+// ---------------------------------------------------------------------------
+
+ISessionRecorder* createSessionRecorder(const std::string& path)
+{
+	ISessionRecorder* recorder = new KSessionRecorder(path);
+	return recorder;
+}
+
+} // namespace fx
@@ -0,0 +1,15 @@
+// author: Darek Slusarczyk alias marines marinesovitch 2012-2013, 2022
+#ifndef INC_BACKEND_SESSIONRECORDERIMPL_H
+#define INC_BACKEND_SESSIONRECORDERIMPL_H
+
+namespace fx
+{
+
+struct ISessionRecorder;
+
+// throws std::runtime_error if the file cannot be created
+ISessionRecorder* createSessionRecorder(const std::string& path);
+
+} // namespace fx
+
+#endif
@@ -0,0 +1,12 @@
+// author: Darek Slusarczyk alias marines marinesovitch 2012-2013, 2022
+#include "ph.h"
+#include "sessionReplayer.h"
+
+namespace fx
+{
+
+ISessionReplayer::~ISessionReplayer()
+{
+}
+
+} // namespace fx
@@ -0,0 +1,362 @@
+// author: Darek Slusarczyk alias marines marinesovitch 2012-2013, 2022
+#include "ph.h"
+#include "sessionReplayerImpl.h"
+#include "sessionReplayer.h"
+#include "sessionFormat.h"
+#include "traderSink.h"
+#include "common/order.h"
+#include "common/symbolInfo.h"
+#include <chrono>
+
+namespace fx
+{
+
+namespace
+{
+
+const std::size_t FileBufferSize = 1024 * 1024;
+
+class KSessionReplayer : public ISessionReplayer
+{
+	public:
+		KSessionReplayer(
+			const std::string& path,
+			const double speed,
+			ISessionReplayTarget* target,
+			std::ostream* cout);
+		virtual ~KSessionReplayer();
+
+	public:
+		// ISessionReplayer
+		virtual void run();
+		virtual void stop();
+		virtual bool isRunning() const;
+
+	private:
+		typedef std::chrono::steady_clock clock_t;
+
+		void replayLoop();
+		bool readFrame();
+		void waitForFrame(const clock_t::time_point& start);
+		void replayFrame();
+
+		void replayAccount();
+		void replayNote(const account_key_t& key);
+
+		template<typename T>
+		bool getItem(T* item) const
+		{
+			const bool result = (m_payload.size() == sizeof(T));
+			if (result)
+			{
+				memcpy(item, m_payload.data(), sizeof(T));
+			}
+			return result;
+		}
+
+		ITraderSink* getSink(account_key_t* key) const;
+		void printStats(const clock_t::duration& elapsed) const;
+
+	private:
+		const std::string m_path;
+		const double m_speed;
+		ISessionReplayTarget& m_target;
+		std::ostream& m_cout;
+
+		std::vector<char> m_fileBuffer;
+		std::ifstream m_file;
+
+		session::SFrameHeader m_header;
+		std::vector<char> m_payload;
+
+		// recorded key -> key in the current backend
+		std::map<int32_t, account_key_t> m_accountKeys;
+
+		uint64_t m_frameCounts[session::FrameKindCount] = { 0 };
+		uint64_t m_skippedFrames = 0;
+		clock_t::duration m_maxLag = clock_t::duration::zero();
+
+		std::thread m_thread;
+		std::atomic<bool> m_running = false;
+		std::atomic<bool> m_stopRequested = false;
+
+};
+
+// ---------------------------------------------------------------------------
+
+KSessionReplayer::KSessionReplayer(
+	const std::string& path,
+	const double speed,
+	ISessionReplayTarget* target,
+	std::ostream* cout)
+	: m_path(path)
+	, m_speed(speed)
+	, m_target(*target)
+	, m_cout(*cout)
+	, m_fileBuffer(FileBufferSize)
+{
+	m_file.rdbuf()->pubsetbuf(m_fileBuffer.data(), m_fileBuffer.size());
+	m_file.open(path, std::ios::binary);
+	if (!m_file)
+	{
+		throw std::runtime_error("cannot open file " + path);
+	}
+
+	char signature[sizeof(session::Signature)];
+	if (!m_file.read(signature, sizeof(signature))
+		|| !std::equal(signature, signature + sizeof(signature), session::Signature))
+	{
+		throw std::runtime_error("incorrect format of session " + path);
+	}
+}
+
+KSessionReplayer::~KSessionReplayer()
+{
+	stop();
+}
+
+// ---------------------------------------------------------------------------
+
+void KSessionReplayer::run()
+{
+	assert(!m_thread.joinable());
+	m_running = true;
+	m_thread = std::thread(&KSessionReplayer::replayLoop, this);
+}
+
+void KSessionReplayer::stop()
+{
+	m_stopRequested = true;
+	if (m_thread.joinable())
+	{
+		m_thread.join();
+	}
+}
+
+bool KSessionReplayer::isRunning() const
+{
+	return m_running;
+}
+
+// ---------------------------------------------------------------------------
+
+void KSessionReplayer::replayLoop()
+{
+	const clock_t::time_point start = clock_t::now();
+	while (!m_stopRequested && readFrame())
+	{
+		waitForFrame(start);
+		replayFrame();
+	}
+	printStats(clock_t::now() - start);
+	m_running = false;
+}
+
+bool KSessionReplayer::readFrame()
+{
+	bool result = false;
+	if (m_file.read(reinterpret_cast<char*>(&m_header), sizeof(m_header))
+		&& (m_header.m_size <= session::MaxFrameSize))
+	{
+		m_payload.resize(m_header.m_size);
+		result = m_payload.empty() || m_file.read(m_payload.data(), m_payload.size());
+	}
+	return result;
+}
+
+void KSessionReplayer::waitForFrame(const clock_t::time_point& start)
+{
+	if (m_speed <= 0.0)
+	{
+		return;
+	}
+
+	const std::chrono::duration<double, std::nano> frameTime(m_header.m_time / m_speed);
+	const clock_t::time_point deadline = start + std::chrono::duration_cast<clock_t::duration>(frameTime);
+	const clock_t::time_point now = clock_t::now();
+	if (now < deadline)
+	{
+		std::this_thread::sleep_until(deadline);
+	}
+	else
+	{
+		m_maxLag = std::max(m_maxLag, now - deadline);
+	}
+}
+
+void KSessionReplayer::replayFrame()
+{
+	const session::EFrameKind kind = static_cast<session::EFrameKind>(m_header.m_kind);
+	if ((kind < session::Account) || (session::FrameKindCount <= kind))
+	{
+		++m_skippedFrames;
+		return;
+	}
+
+	if (kind == session::Account)
+	{
+		replayAccount();
+		++m_frameCounts[kind];
+		return;
+	}
+
+	account_key_t key;
+	ITraderSink* sink = getSink(&key);
+	if (sink == nullptr)
+	{
+		++m_skippedFrames;
+		return;
+	}
+
+	bool replayed = true;
+	switch (kind)
+	{
+		case session::Note:
+			replayNote(key);
+			break;
+
+		case session::Tick:
+		{
+			STick tick;
+			replayed = getItem(&tick);
+			if (replayed)
+			{
+				sink->onTick(tick);
+			}
+			break;
+		}
+
+		case session::Symbol:
+		{
+			SSymbolInfo symbolInfo;
+			replayed = getItem(&symbolInfo);
+			if (replayed)
+			{
+				sink->onSymbol(symbolInfo);
+			}
+			break;
+		}
+
+		case session::Order:
+		{
+			SOrder order;
+			replayed = getItem(&order);
+			if (replayed)
+			{
+				sink->onOrder(order);
+			}
+			break;
+		}
+
+		case session::Cmd:
+			// commands were sent by backend, they are only counted
+			break;
+
+		case session::CmdResult:
+		{
+			const std::string output(m_payload.begin(), m_payload.end());
+			sink->onCmdResult(HCommand(), output);
+			break;
+		}
+
+		default:
+			assert(!"unexpected frame kind!");
+	}
+
+	if (replayed)
+	{
+		++m_frameCounts[kind];
+	}
+	else
+	{
+		++m_skippedFrames;
+	}
+}
+
+// ---------------------------------------------------------------------------
+
+void KSessionReplayer::replayAccount()
+{
+	int64_t rawAccountLogin = 0;
+	if (m_payload.size() < sizeof(rawAccountLogin))
+	{
+		++m_skippedFrames;
+		return;
+	}
+
+	memcpy(&rawAccountLogin, m_payload.data(), sizeof(rawAccountLogin));
+	const std::string broker(m_payload.begin() + sizeof(rawAccountLogin), m_payload.end());
+	const SAccountInfo accountInfo(broker, account_login_t(rawAccountLogin));
+	const account_key_t key = m_target.replayAccount(accountInfo);
+	if (key.isNull())
+	{
+		m_cout << "account " << broker << ' ' << rawAccountLogin
+			<< " is connected, its frames are skipped" << std::endl;
+		return;
+	}
+	m_accountKeys[m_header.m_accountKey] = key;
+}
+
+void KSessionReplayer::replayNote(const account_key_t& key)
+{
+	if (m_payload.empty())
+	{
+		return;
+	}
+
+	const note::EKind noteKind = static_cast<note::EKind>(m_payload[0]);
+	const std::string symbol(m_payload.begin() + 1, m_payload.end());
+	m_target.replayNote(key, noteKind, symbol);
+}
+
+ITraderSink* KSessionReplayer::getSink(account_key_t* key) const
+{
+	ITraderSink* result = nullptr;
+	auto it = m_accountKeys.find(m_header.m_accountKey);
+	if (it != m_accountKeys.end())
+	{
+		*key = it->second;
+		result = m_target.replaySink(*key);
+	}
+	return result;
+}
+
+void KSessionReplayer::printStats(const clock_t::duration& elapsed) const
+{
+	const double seconds = std::chrono::duration<double>(elapsed).count();
+	uint64_t frameCount = 0;
+	for (const uint64_t count : m_frameCounts)
+	{
+		frameCount += count;
+	}
+	const double rate = (0.0 < seconds) ? (frameCount / seconds) : 0.0;
+	const double maxLag = std::chrono::duration<double, std::milli>(m_maxLag).count();
+
+	m_cout << "replay of " << m_path << (m_stopRequested ? " stopped" : " finished") << ": "
+		<< m_frameCounts[session::Tick] << " ticks, "
+		<< m_frameCounts[session::Symbol] << " symbols, "
+		<< m_frameCounts[session::Order] << " orders, "
+		<< m_frameCounts[session::Cmd] << " commands, "
+		<< m_frameCounts[session::CmdResult] << " command results, "
+		<< m_frameCounts[session::Note] << " notes, "
+		<< m_skippedFrames << " skipped, "
+		<< std::fixed << std::setprecision(3) << seconds << "s, "
+		<< std::setprecision(1) << rate << " frames/s, max lag " << maxLag << "ms"
+		<< std::defaultfloat << std::endl;
+}
+
+} // anonymous namespace
+
+// ---------------------------------------------------------------------------
+
+ISessionReplayer* createSessionReplayer(
+	const std::string& path,
+	const double speed,
+	ISessionReplayTarget* target,
+	std::ostream* cout)
+{
+	ISessionReplayer* replayer = new KSessionReplayer(path, speed, target, cout);
+	return replayer;
+}
+
+} // namespace fx
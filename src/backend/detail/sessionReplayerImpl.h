@@ -0,0 +1,21 @@
+// author: Darek Slusarczyk alias marines marinesovitch 2012-2013, 2022
+#ifndef INC_BACKEND_SESSIONREPLAYERIMPL_H
+#define INC_BACKEND_SESSIONREPLAYERIMPL_H
+
+namespace fx
+{
+
+struct ISessionReplayer;
+struct ISessionReplayTarget;
+
+// speed 1 means the original pace of the session, 0 means as fast as possible,
+// throws std::runtime_error if the file cannot be opened or is not a session
+ISessionReplayer* createSessionReplayer(
+	const std::string& path,
+	const double speed,
+	ISessionReplayTarget* target,
+	std::ostream* cout);
+
+} // namespace fx
+
+#endif
@@ -0,0 +1,41 @@
+// author: Darek Slusarczyk alias marines marinesovitch 2012-2013, 2022
+#include "ph.h"
+#include "strategyPool.h"
+
+namespace fx
+{
+
+void SStrategyPoolStats::print(std::ostream& os) const
+{
+	for (std::size_t i = 0; i < m_workers.size(); ++i)
+	{
+		const SStrategyWorkerStats& worker = m_workers[i];
+		os << "worker " << i << ": " << worker.m_eventCount << " events, queue " << worker.m_queueDepth
+			<< " (max " << worker.m_maxQueueDepth << " of " << worker.m_queueCapacity << ")"
+			<< ", stalls " << worker.m_stallCount << '\n';
+	}
+
+	if (m_strategies.empty())
+	{
+		os << "no strategies\n";
+	}
+
+	for (const SStrategyStats& strategy : m_strategies)
+	{
+		const double average = (strategy.m_eventCount != 0) ? (strategy.m_seconds / strategy.m_eventCount) : 0.0;
+		os << strategy.m_strategy << ' ' << strategy.m_symbol << " on worker " << strategy.m_worker
+			<< ": " << strategy.m_eventCount << " events in " << std::fixed << std::setprecision(3)
+			<< (strategy.m_seconds * 1e3) << "ms, average " << std::setprecision(2) << (average * 1e6)
+			<< "us, max " << (strategy.m_maxSeconds * 1e6) << "us" << std::defaultfloat
+			<< ", errors " << strategy.m_errorCount << '\n';
+	}
+	os << std::flush;
+}
+
+// ---------------------------------------------------------------------------
+
+IStrategyPool::~IStrategyPool()
+{
+}
+
+} // namespace fx
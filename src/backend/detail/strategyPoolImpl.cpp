@@ -0,0 +1,589 @@
+// author: Darek Slusarczyk alias marines marinesovitch 2012-2013, 2022
+#include "ph.h"
+#include "strategyPoolImpl.h"
+#include "strategyPool.h"
+#include "barEngine.h"
+#include "barEngineImpl.h"
+#include "strategyHost.h"
+#include "tickStore.h"
+#include "tradingStrategy.h"
+#include "common/order.h"
+#include "common/types.h"
+#include "cpp/mpscQueue.h"
+#include <chrono>
+#include <string_view>
+
+namespace fx
+{
+
+namespace
+{
+
+// the events dispatched by a worker at once, the executor waits at most for
+// such a batch to get to the strategies
+const std::size_t MaxBatchSize = 64;
+
+// the attempts to get an event before the worker goes to sleep, while it
+// spins the producers don't have to wake it
+const std::size_t SpinCount = 64;
+
+// ---------------------------------------------------------------------------
+
+struct SStrategyEvent
+{
+	enum EKind
+	{
+		Tick,
+		Bar,
+		Order
+	};
+
+	EKind m_kind = Tick;
+	uint64_t m_tickCount = 0;
+	// the symbol of a bar is the one of m_tick
+	STick m_tick;
+	timeframe::ETimeframe m_timeframe = timeframe::M1;
+	SBar m_bar;
+	SOrder m_order;
+};
+
+struct SSymbolStrategy
+{
+	HTradingStrategy m_strategy;
+	// the ticks of the symbol up to this count were passed to the warm-up
+	uint64_t m_warmUpEndCount = 0;
+	uint64_t m_eventCount = 0;
+	uint64_t m_errorCount = 0;
+	double m_seconds = 0.0;
+	double m_maxSeconds = 0.0;
+};
+
+typedef std::map<std::string, SSymbolStrategy, std::less<>> symbol2strategy_t;
+
+// ---------------------------------------------------------------------------
+
+// the host of a strategy while it warms up, the commands of the history are
+// not sent anywhere, the orders and positions are the live ones
+class KWarmUpHost : public IStrategyHost
+{
+	public:
+		KWarmUpHost( const IStrategyHost& liveHost )
+			: m_liveHost( liveHost )
+		{
+		}
+
+		virtual void executeCommand( HCommand /*command*/ )
+		{
+		}
+
+		virtual const IOrderCache& getOrders() const
+		{
+			return m_liveHost.getOrders();
+		}
+
+		virtual const IPositionEngine& getPositions() const
+		{
+			return m_liveHost.getPositions();
+		}
+
+	private:
+		const IStrategyHost& m_liveHost;
+
+};
+
+// ---------------------------------------------------------------------------
+
+// passes the bars built from the history to the strategy which warms up
+class KWarmUpBarSink : public IBarSink
+{
+	public:
+		KWarmUpBarSink( ITradingStrategy* strategy )
+			: m_strategy( strategy )
+		{
+		}
+
+		virtual void onBarClosed(const std::string& /*symbol*/, const timeframe::ETimeframe timeframe, const SBar& bar)
+		{
+			if (m_strategy->getBarTimeframes() & timeframe::flag(timeframe))
+			{
+				m_strategy->onBar(timeframe, bar);
+			}
+		}
+
+	private:
+		ITradingStrategy* m_strategy;
+
+};
+
+void warmUpStrategy(
+	const std::string& symbol,
+	const STickSeries& history,
+	const IStrategyHost& liveHost,
+	ITradingStrategy* strategy )
+{
+	KWarmUpHost host( liveHost );
+	strategy->setHost( &host );
+	if (!strategy->warmUp( history ))
+	{
+		KWarmUpBarSink barSink( strategy );
+		std::unique_ptr<IBarEngine> barEngine( createBarEngine( &barSink ) );
+		for (std::size_t i = 0; i < history.size(); ++i)
+		{
+			const STick tick(
+				symbol.c_str(),
+				SDateTime( history.m_times[i] ),
+				SPrice( history.m_bids[i] ),
+				SPrice( history.m_asks[i] ),
+				SPrice( history.m_lasts[i] ) );
+			barEngine->onTick( tick );
+			strategy->onTick( tick );
+		}
+	}
+}
+
+// ---------------------------------------------------------------------------
+// ---------------------------------------------------------------------------
+
+// a thread with the strategies of a shard of symbols, the events come through
+// a lock-free queue; a producer takes a lock only to wake the worker if it
+// sleeps on the empty queue
+class KStrategyWorker
+{
+	public:
+		KStrategyWorker(std::ostream* cerr);
+		~KStrategyWorker();
+
+	public:
+		void push(const SStrategyEvent& event);
+
+		// the strategies may be used only with the locked mutex
+		std::mutex& strategiesMutex();
+		symbol2strategy_t& strategies();
+
+		void getStats(SStrategyWorkerStats* stats) const;
+
+	private:
+		void loop();
+		bool waitForEvent(SStrategyEvent* event);
+		void wake();
+		void dispatch(const SStrategyEvent& event);
+
+	private:
+		std::ostream& m_cerr;
+		cpp::KMpscQueue<SStrategyEvent> m_queue;
+
+		// held by the worker while it dispatches a batch of events
+		std::mutex m_strategiesMutex;
+		symbol2strategy_t m_strategies;
+
+		std::mutex m_wakeMutex;
+		std::condition_variable m_onEvent;
+		std::atomic<bool> m_sleeping = false;
+		std::atomic<bool> m_stop = false;
+
+		// read by the stats; the counts of events and the depth are written
+		// only by the worker, the stalls by the channel loops which push
+		std::atomic<uint64_t> m_eventCount = 0;
+		std::atomic<std::size_t> m_maxQueueDepth = 0;
+		std::atomic<uint64_t> m_stallCount = 0;
+
+		std::thread m_thread;
+
+};
+
+// ---------------------------------------------------------------------------
+
+KStrategyWorker::KStrategyWorker(std::ostream* cerr)
+	: m_cerr(*cerr)
+	, m_queue(StrategyQueueCapacity)
+	, m_thread(&KStrategyWorker::loop, this)
+{
+}
+
+KStrategyWorker::~KStrategyWorker()
+{
+	{
+		std::lock_guard<std::mutex> lock(m_wakeMutex);
+		m_stop = true;
+		m_onEvent.notify_one();
+	}
+	m_thread.join();
+}
+
+void KStrategyWorker::push(const SStrategyEvent& event)
+{
+	if (!m_queue.tryPush(event))
+	{
+		// the worker is behind, the channel loop has to wait for it, like
+		// it waited for the strategies before they had their own threads
+		++m_stallCount;
+		do
+		{
+			wake();
+			std::this_thread::yield();
+		}
+		while (!m_queue.tryPush(event));
+	}
+	wake();
+}
+
+std::mutex& KStrategyWorker::strategiesMutex()
+{
+	return m_strategiesMutex;
+}
+
+symbol2strategy_t& KStrategyWorker::strategies()
+{
+	return m_strategies;
+}
+
+void KStrategyWorker::getStats(SStrategyWorkerStats* stats) const
+{
+	stats->m_eventCount = m_eventCount.load(std::memory_order_relaxed);
+	stats->m_queueDepth = m_queue.size();
+	stats->m_maxQueueDepth = m_maxQueueDepth.load(std::memory_order_relaxed);
+	stats->m_queueCapacity = m_queue.capacity();
+	stats->m_stallCount = m_stallCount.load(std::memory_order_relaxed);
+}
+
+// ---------------------------------------------------------------------------
+
+void KStrategyWorker::loop()
+{
+	SStrategyEvent event;
+	while (waitForEvent(&event))
+	{
+		const std::size_t depth = m_queue.size() + 1;
+		if (m_maxQueueDepth.load(std::memory_order_relaxed) < depth)
+		{
+			m_maxQueueDepth.store(depth, std::memory_order_relaxed);
+		}
+
+		std::lock_guard<std::mutex> lock(m_strategiesMutex);
+		std::size_t batchSize = 0;
+		do
+		{
+			dispatch(event);
+		}
+		while ((++batchSize < MaxBatchSize) && m_queue.tryPop(&event));
+		m_eventCount.store(m_eventCount.load(std::memory_order_relaxed) + batchSize, std::memory_order_relaxed);
+	}
+}
+
+bool KStrategyWorker::waitForEvent(SStrategyEvent* event)
+{
+	for (;;)
+	{
+		for (std::size_t i = 0; i < SpinCount; ++i)
+		{
+			if (m_queue.tryPop(event))
+			{
+				return true;
+			}
+			std::this_thread::yield();
+		}
+
+		// the fence pairs with the one in wake, so either the worker sees
+		// the new event or the producer sees the worker sleeping
+		std::unique_lock<std::mutex> lock(m_wakeMutex);
+		m_sleeping.store(true, std::memory_order_relaxed);
+		std::atomic_thread_fence(std::memory_order_seq_cst);
+		m_onEvent.wait(lock, [this]{ return m_stop || !m_queue.empty(); });
+		m_sleeping.store(false, std::memory_order_relaxed);
+		if (m_stop)
+		{
+			return false;
+		}
+	}
+}
+
+void KStrategyWorker::wake()
+{
+	std::atomic_thread_fence(std::memory_order_seq_cst);
+	if (m_sleeping.load(std::memory_order_relaxed))
+	{
+		std::lock_guard<std::mutex> lock(m_wakeMutex);
+		m_onEvent.notify_one();
+	}
+}
+
+void KStrategyWorker::dispatch(const SStrategyEvent& event)
+{
+	const std::string_view symbol((event.m_kind == SStrategyEvent::Order) ? event.m_order.m_symbolName : event.m_tick.m_symbolName);
+	auto it = m_strategies.find(symbol);
+	if (it == m_strategies.end())
+	{
+		return;
+	}
+
+	SSymbolStrategy& symbolStrategy = it->second;
+	ITradingStrategy* strategy = symbolStrategy.m_strategy.get();
+	if ((event.m_kind != SStrategyEvent::Order) && (event.m_tickCount <= symbolStrategy.m_warmUpEndCount))
+	{
+		// the tick was already in the history of the warm-up
+		return;
+	}
+
+	const auto start = std::chrono::steady_clock::now();
+	try
+	{
+		switch (event.m_kind)
+		{
+			case SStrategyEvent::Tick:
+				strategy->onTick(event.m_tick);
+				break;
+
+			case SStrategyEvent::Bar:
+				if (strategy->getBarTimeframes() & timeframe::flag(event.m_timeframe))
+				{
+					strategy->onBar(event.m_timeframe, event.m_bar);
+				}
+				break;
+
+			case SStrategyEvent::Order:
+				strategy->onOrder(event.m_order);
+				break;
+		}
+	}
+	catch (std::exception& e)
+	{
+		// e.g. a command refused by the risk limits, the worker goes on
+		++symbolStrategy.m_errorCount;
+		m_cerr << strategy->getName() << ' ' << it->first << ": " << e.what() << std::endl;
+	}
+	const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+	++symbolStrategy.m_eventCount;
+	symbolStrategy.m_seconds += seconds;
+	symbolStrategy.m_maxSeconds = std::max(symbolStrategy.m_maxSeconds, seconds);
+}
+
+// ---------------------------------------------------------------------------
+// ---------------------------------------------------------------------------
+
+class KStrategyPool : public IStrategyPool
+{
+	public:
+		KStrategyPool(
+			IStrategyHost* host,
+			const ITickStore* tickStore,
+			std::ostream* cerr,
+			const unsigned int workerCount);
+
+	public:
+		// IStrategyPool
+		virtual void pushTick(const STick& tick, const uint64_t tickCount);
+		virtual void pushBar(
+			const std::string& symbol,
+			const timeframe::ETimeframe timeframe,
+			const SBar& bar,
+			const uint64_t tickCount);
+		virtual void pushOrder(const SOrder& order);
+
+		virtual std::string getStrategy(const std::string& symbol) const;
+		virtual void setStrategy(const std::string& symbol, HTradingStrategy strategy);
+		virtual void removeStrategy(const std::string& symbol);
+		virtual void executeStrategyCommand(const std::string& symbol, std::istringstream& cmdLine);
+
+		virtual void getStats(SStrategyPoolStats* stats) const;
+
+	private:
+		bool hasStrategies() const;
+		unsigned int getWorkerIndex(const std::string_view& symbol) const;
+		KStrategyWorker& getWorker(const std::string_view& symbol) const;
+
+	private:
+		IStrategyHost& m_host;
+		const ITickStore& m_tickStore;
+		std::vector<std::unique_ptr<KStrategyWorker>> m_workers;
+
+		// while there are no strategies, the events aren't pushed at all
+		std::atomic<std::size_t> m_strategyCount = 0;
+
+};
+
+// ---------------------------------------------------------------------------
+
+KStrategyPool::KStrategyPool(
+	IStrategyHost* host,
+	const ITickStore* tickStore,
+	std::ostream* cerr,
+	const unsigned int workerCount)
+	: m_host(*host)
+	, m_tickStore(*tickStore)
+{
+	for (unsigned int i = 0; i < std::max(workerCount, 1u); ++i)
+	{
+		m_workers.emplace_back(new KStrategyWorker(cerr));
+	}
+}
+
+// ---------------------------------------------------------------------------
+// IStrategyPool
+
+void KStrategyPool::pushTick(const STick& tick, const uint64_t tickCount)
+{
+	if (hasStrategies())
+	{
+		SStrategyEvent event;
+		event.m_kind = SStrategyEvent::Tick;
+		event.m_tickCount = tickCount;
+		event.m_tick = tick;
+		getWorker(tick.m_symbolName).push(event);
+	}
+}
+
+void KStrategyPool::pushBar(
+	const std::string& symbol,
+	const timeframe::ETimeframe timeframe,
+	const SBar& bar,
+	const uint64_t tickCount)
+{
+	if (hasStrategies())
+	{
+		SStrategyEvent event;
+		event.m_kind = SStrategyEvent::Bar;
+		event.m_tickCount = tickCount;
+		std::strncpy(event.m_tick.m_symbolName, symbol.c_str(), consts::MaxSymbolNameLen - 1);
+		event.m_tick.m_symbolName[consts::MaxSymbolNameLen - 1] = 0;
+		event.m_timeframe = timeframe;
+		event.m_bar = bar;
+		getWorker(symbol).push(event);
+	}
+}
+
+void KStrategyPool::pushOrder(const SOrder& order)
+{
+	if (hasStrategies())
+	{
+		SStrategyEvent event;
+		event.m_kind = SStrategyEvent::Order;
+		event.m_order = order;
+		getWorker(order.m_symbolName).push(event);
+	}
+}
+
+std::string KStrategyPool::getStrategy(const std::string& symbol) const
+{
+	KStrategyWorker& worker = getWorker(symbol);
+	std::lock_guard<std::mutex> lock(worker.strategiesMutex());
+	const symbol2strategy_t& strategies = worker.strategies();
+	auto it = strategies.find(symbol);
+	if (it != strategies.end())
+	{
+		const std::string result = it->second.m_strategy->getName();
+		return result;
+	}
+	return std::string();
+}
+
+void KStrategyPool::setStrategy(const std::string& symbol, HTradingStrategy strategy)
+{
+	// counted before the history is taken, so the tick loop can't skip a
+	// tick which is not in the history, the fence pairs with the one in
+	// hasStrategies
+	++m_strategyCount;
+	std::atomic_thread_fence(std::memory_order_seq_cst);
+
+	// the worker waits for the end of the warm-up, so the ticks pushed
+	// meanwhile come live right after the history, and the queued ones
+	// which are in the history already are skipped by their count
+	KStrategyWorker& worker = getWorker(symbol);
+	std::lock_guard<std::mutex> lock(worker.strategiesMutex());
+	assert(worker.strategies().count(symbol) == 0);
+	STickSeries history;
+	m_tickStore.getLastTicks(symbol, m_tickStore.capacity(), &history);
+	warmUpStrategy(symbol, history, m_host, strategy.get());
+	strategy->setHost(&m_host);
+
+	SSymbolStrategy symbolStrategy;
+	symbolStrategy.m_strategy = strategy;
+	symbolStrategy.m_warmUpEndCount = history.m_endCount;
+	worker.strategies().insert(std::make_pair(symbol, symbolStrategy));
+}
+
+void KStrategyPool::removeStrategy(const std::string& symbol)
+{
+	KStrategyWorker& worker = getWorker(symbol);
+	std::lock_guard<std::mutex> lock(worker.strategiesMutex());
+	if (worker.strategies().erase(symbol) != 0)
+	{
+		--m_strategyCount;
+	}
+}
+
+void KStrategyPool::executeStrategyCommand(const std::string& symbol, std::istringstream& cmdLine)
+{
+	KStrategyWorker& worker = getWorker(symbol);
+	std::lock_guard<std::mutex> lock(worker.strategiesMutex());
+	symbol2strategy_t& strategies = worker.strategies();
+	auto it = strategies.find(symbol);
+	assert(it != strategies.end());
+	it->second.m_strategy->executeCommand(cmdLine);
+}
+
+void KStrategyPool::getStats(SStrategyPoolStats* stats) const
+{
+	stats->m_workers.resize(m_workers.size());
+	stats->m_strategies.clear();
+	for (unsigned int i = 0; i < m_workers.size(); ++i)
+	{
+		KStrategyWorker& worker = *m_workers[i];
+		worker.getStats(&stats->m_workers[i]);
+
+		std::lock_guard<std::mutex> lock(worker.strategiesMutex());
+		for (const auto& it : worker.strategies())
+		{
+			const SSymbolStrategy& symbolStrategy = it.second;
+			SStrategyStats strategyStats;
+			strategyStats.m_symbol = it.first;
+			strategyStats.m_strategy = symbolStrategy.m_strategy->getName();
+			strategyStats.m_worker = i;
+			strategyStats.m_eventCount = symbolStrategy.m_eventCount;
+			strategyStats.m_seconds = symbolStrategy.m_seconds;
+			strategyStats.m_maxSeconds = symbolStrategy.m_maxSeconds;
+			strategyStats.m_errorCount = symbolStrategy.m_errorCount;
+			stats->m_strategies.push_back(strategyStats);
+		}
+	}
+}
+
+// ---------------------------------------------------------------------------
+
+bool KStrategyPool::hasStrategies() const
+{
+	// the tick is appended to the tick store before, so either it is
+	// pushed or it is in the history of the warm-up
+	std::atomic_thread_fence(std::memory_order_seq_cst);
+	const bool result = (m_strategyCount.load(std::memory_order_relaxed) != 0);
+	return result;
+}
+
+unsigned int KStrategyPool::getWorkerIndex(const std::string_view& symbol) const
+{
+	const std::size_t hash = std::hash<std::string_view>()(symbol);
+	const unsigned int result = static_cast<unsigned int>(hash % m_workers.size());
+	return result;
+}
+
+KStrategyWorker& KStrategyPool::getWorker(const std::string_view& symbol) const
+{
+	KStrategyWorker& result = *m_workers[getWorkerIndex(symbol)];
+	return result;
+}
+
+} // anonymous namespace
+
+// ---------------------------------------------------------------------------
+
+IStrategyPool* createStrategyPool(
+	IStrategyHost* host,
+	const ITickStore* tickStore,
+	std::ostream* cerr,
+	const unsigned int workerCount)
+{
+	IStrategyPool* pool = new KStrategyPool(host, tickStore, cerr, workerCount);
+	return pool;
+}
+
+} // namespace fx
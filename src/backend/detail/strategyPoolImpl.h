@@ -0,0 +1,27 @@
+// author: Darek Slusarczyk alias marines marinesovitch 2012-2013, 2022
+#ifndef INC_BACKEND_STRATEGYPOOLIMPL_H
+#define INC_BACKEND_STRATEGYPOOLIMPL_H
+
+namespace fx
+{
+
+struct IStrategyPool;
+struct IStrategyHost;
+struct ITickStore;
+
+// the host gets the commands of the strategies, the tick store gives the
+// ticks for their warm-up, the errors of the strategies go to cerr
+IStrategyPool* createStrategyPool(
+	IStrategyHost* host,
+	const ITickStore* tickStore,
+	std::ostream* cerr,
+	const unsigned int workerCount);
+
+const unsigned int DefaultStrategyWorkerCount = 4;
+
+// the events of a worker waiting for it, rounded up to power of 2
+const std::size_t StrategyQueueCapacity = 4 * 1024;
+
+} // namespace fx
+
+#endif
@@ -0,0 +1,16 @@
+// author: Darek Slusarczyk alias marines marinesovitch 2012-2013, 2022
+#include "ph.h"
+#include "tickArchive.h"
+
+namespace fx
+{
+
+ITickArchive::~ITickArchive()
+{
+}
+
+ITickSegment::~ITickSegment()
+{
+}
+
+} // namespace fx
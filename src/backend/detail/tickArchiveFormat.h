@@ -0,0 +1,54 @@
+// author: Darek Slusarczyk alias marines marinesovitch 2012-2013, 2022
+#ifndef INC_BACKEND_TICKARCHIVEFORMAT_H
+#define INC_BACKEND_TICKARCHIVEFORMAT_H
+
+#include "common/consts.h"
+#include <cstdint>
+
+namespace fx
+{
+
+namespace tickarchive
+{
+
+// the segment file starts with the header aligned to HeaderSize, then
+// there is an array of STickRecord; a created segment has room for
+// SegmentCapacity records, when it is closed, the file is truncated to the
+// records it contains, every IndexStride-th record has an entry in the index
+const char Signature[] = { 'F', 'X', 'T', 'I', 'C', 'K', '0', '1' };
+
+const char SegmentExtension[] = ".fxtick";
+
+const uint32_t IndexStride = 1024;
+const uint32_t MaxIndexEntries = 256;
+const uint32_t SegmentCapacity = IndexStride * MaxIndexEntries;
+
+struct SIndexEntry
+{
+	int64_t m_time;
+	uint32_t m_record;
+	uint32_t m_reserved;
+};
+
+struct SSegmentHeader
+{
+	char m_signature[sizeof(Signature)];
+	char m_symbol[consts::MaxSymbolNameLen];
+	int64_t m_day;
+	uint32_t m_capacity;
+	uint32_t m_recordCount;
+	uint32_t m_indexCount;
+	// set when the segment is complete and truncated
+	uint32_t m_closed;
+	SIndexEntry m_index[MaxIndexEntries];
+};
+
+const std::size_t HeaderSize = 8 * 1024;
+
+static_assert(sizeof(SSegmentHeader) <= HeaderSize, "segment header doesn't fit");
+
+} // namespace tickarchive
+
+} // namespace fx
+
+#endif
@@ -0,0 +1,535 @@
+// author: Darek Slusarczyk alias marines marinesovitch 2012-2013, 2022
+#include "ph.h"
+#include "tickArchiveImpl.h"
+#include "tickArchive.h"
+#include "tickArchiveFormat.h"
+#include "common/fileUtils.h"
+#include "common/mappedFile.h"
+#include "common/types.h"
+#include <chrono>
+#include <filesystem>
+#include <string_view>
+
+namespace fx
+{
+
+namespace
+{
+
+const std::size_t QueueCapacity = 64 * 1024;
+const std::chrono::milliseconds IdleSleep(2);
+const std::chrono::seconds FlushInterval(1);
+
+const datetime_t SecondsPerDay = 24 * 60 * 60;
+
+datetime_t dayStart(const datetime_t time)
+{
+	datetime_t remainder = time % SecondsPerDay;
+	if (remainder < 0)
+	{
+		remainder += SecondsPerDay;
+	}
+	return time - remainder;
+}
+
+// yyyymmdd of the day, the conversion of days to the civil date is based on
+// the algorithm of Howard Hinnant
+std::string formatDay(const datetime_t day)
+{
+	const int64_t z = day / SecondsPerDay + 719468;
+	const int64_t era = (0 <= z ? z : z - 146096) / 146097;
+	const int64_t dayOfEra = z - era * 146097;
+	const int64_t yearOfEra = (dayOfEra - dayOfEra / 1460 + dayOfEra / 36524 - dayOfEra / 146096) / 365;
+	const int64_t dayOfYear = dayOfEra - (365 * yearOfEra + yearOfEra / 4 - yearOfEra / 100);
+	const int64_t mp = (5 * dayOfYear + 2) / 153;
+	const int64_t d = dayOfYear - (153 * mp + 2) / 5 + 1;
+	const int64_t m = mp < 10 ? mp + 3 : mp - 9;
+	const int64_t y = yearOfEra + era * 400 + (m <= 2 ? 1 : 0);
+
+	std::ostringstream os;
+	os << std::setfill('0') << std::setw(4) << y << std::setw(2) << m << std::setw(2) << d;
+	return os.str();
+}
+
+// ---------------------------------------------------------------------------
+
+class KSegmentWriter
+{
+	public:
+		KSegmentWriter(const std::string& path, const std::string& symbol, const datetime_t day);
+		~KSegmentWriter();
+
+	public:
+		datetime_t day() const;
+		bool isFull() const;
+
+		void append(const STick& tick);
+		void flush();
+		void close();
+
+	private:
+		KMappedFile m_file;
+		tickarchive::SSegmentHeader* m_header;
+		STickRecord* m_records;
+		bool m_dirty = false;
+
+};
+
+// ---------------------------------------------------------------------------
+
+KSegmentWriter::KSegmentWriter(const std::string& path, const std::string& symbol, const datetime_t day)
+{
+	const uint64_t fileSize = tickarchive::HeaderSize + tickarchive::SegmentCapacity * sizeof(STickRecord);
+	if (!m_file.create(path, fileSize))
+	{
+		throw std::runtime_error("cannot create segment " + path);
+	}
+
+	char* data = m_file.data();
+	m_header = reinterpret_cast<tickarchive::SSegmentHeader*>(data);
+	m_records = reinterpret_cast<STickRecord*>(data + tickarchive::HeaderSize);
+
+	// the fresh mapping is zeroed
+	std::copy(std::begin(tickarchive::Signature), std::end(tickarchive::Signature), m_header->m_signature);
+	symbol.copy(m_header->m_symbol, sizeof(m_header->m_symbol) - 1);
+	m_header->m_day = day;
+	m_header->m_capacity = tickarchive::SegmentCapacity;
+}
+
+KSegmentWriter::~KSegmentWriter()
+{
+	close();
+}
+
+datetime_t KSegmentWriter::day() const
+{
+	return m_header->m_day;
+}
+
+bool KSegmentWriter::isFull() const
+{
+	const bool result = (m_header->m_capacity <= m_header->m_recordCount);
+	return result;
+}
+
+void KSegmentWriter::append(const STick& tick)
+{
+	assert(!isFull());
+	const uint32_t recordIndex = m_header->m_recordCount;
+	STickRecord& record = m_records[recordIndex];
+	record.m_time = tick.m_time.m_value;
+	record.m_bid = tick.m_bid.m_value;
+	record.m_ask = tick.m_ask.m_value;
+	record.m_last = tick.m_last.m_value;
+
+	if ((recordIndex % tickarchive::IndexStride) == 0)
+	{
+		tickarchive::SIndexEntry& entry = m_header->m_index[m_header->m_indexCount];
+		entry.m_time = record.m_time;
+		entry.m_record = recordIndex;
+		++m_header->m_indexCount;
+	}
+
+	m_header->m_recordCount = recordIndex + 1;
+	m_dirty = true;
+}
+
+void KSegmentWriter::flush()
+{
+	if (m_dirty)
+	{
+		m_file.flush();
+		m_dirty = false;
+	}
+}
+
+void KSegmentWriter::close()
+{
+	if (m_file.isOpen())
+	{
+		m_header->m_closed = 1;
+		const uint64_t finalSize = tickarchive::HeaderSize + m_header->m_recordCount * sizeof(STickRecord);
+		m_file.flush();
+		m_file.close(finalSize);
+	}
+}
+
+// ---------------------------------------------------------------------------
+// ---------------------------------------------------------------------------
+
+class KTickArchive : public ITickArchive
+{
+	public:
+		KTickArchive(const std::string& directory);
+		virtual ~KTickArchive();
+
+	public:
+		// ITickArchive
+		virtual void append(const STick& tick);
+		virtual void close();
+		virtual void printStats(std::ostream& os) const;
+
+	private:
+		typedef std::chrono::steady_clock clock_t;
+
+		void archiveLoop();
+		std::size_t writeQueuedTicks();
+		void writeTick(const STick& tick);
+		KSegmentWriter& ensureSegment(const std::string_view& symbol, const datetime_t day);
+		void rollSegments(const datetime_t day);
+		std::string prepareSegmentPath(const std::string& symbol, const datetime_t day);
+
+		void flushSegments();
+		void closeSegments();
+
+	private:
+		typedef std::map<std::string, std::unique_ptr<KSegmentWriter>, std::less<>> symbol2segment_t;
+
+		const std::string m_directory;
+
+		// single consumer ring, the producers are serialized by m_appendMutex
+		std::vector<STick> m_queue;
+		std::atomic<uint64_t> m_queueHead = 0;
+		std::atomic<uint64_t> m_queueTail = 0;
+		std::mutex m_appendMutex;
+
+		// used only by the archive thread
+		symbol2segment_t m_segments;
+		// the latest day of the ticks written so far
+		datetime_t m_currentDay = std::numeric_limits<datetime_t>::min();
+
+		std::atomic<uint64_t> m_archivedTicks = 0;
+		std::atomic<uint64_t> m_droppedTicks = 0;
+		std::atomic<uint64_t> m_lateTicks = 0;
+		std::atomic<uint64_t> m_failedTicks = 0;
+		std::atomic<uint64_t> m_segmentCount = 0;
+		std::string m_lastError;
+		mutable std::mutex m_errorMutex;
+
+		std::thread m_thread;
+		std::atomic<bool> m_stopRequested = false;
+
+};
+
+// ---------------------------------------------------------------------------
+
+KTickArchive::KTickArchive(const std::string& directory)
+	: m_directory(directory)
+	, m_queue(QueueCapacity)
+{
+	std::error_code error;
+	std::filesystem::create_directories(directory, error);
+	if (error)
+	{
+		throw std::runtime_error("cannot create directory " + directory);
+	}
+	m_thread = std::thread(&KTickArchive::archiveLoop, this);
+}
+
+KTickArchive::~KTickArchive()
+{
+	close();
+}
+
+void KTickArchive::append(const STick& tick)
+{
+	std::lock_guard<std::mutex> lock(m_appendMutex);
+	const uint64_t head = m_queueHead.load(std::memory_order_relaxed);
+	const uint64_t tail = m_queueTail.load(std::memory_order_acquire);
+	if (QueueCapacity <= head - tail)
+	{
+		++m_droppedTicks;
+		return;
+	}
+	m_queue[head % QueueCapacity] = tick;
+	m_queueHead.store(head + 1, std::memory_order_release);
+}
+
+void KTickArchive::close()
+{
+	m_stopRequested = true;
+	if (m_thread.joinable())
+	{
+		m_thread.join();
+	}
+}
+
+void KTickArchive::printStats(std::ostream& os) const
+{
+	os << m_directory << ": "
+		<< m_archivedTicks << " ticks, "
+		<< m_segmentCount << " segments, "
+		<< m_droppedTicks << " dropped, "
+		<< m_lateTicks << " late, "
+		<< m_failedTicks << " failed";
+	std::lock_guard<std::mutex> lock(m_errorMutex);
+	if (!m_lastError.empty())
+	{
+		os << " (" << m_lastError << ")";
+	}
+	os << std::endl;
+}
+
+// ---------------------------------------------------------------------------
+
+void KTickArchive::archiveLoop()
+{
+	clock_t::time_point lastFlush = clock_t::now();
+	while (!m_stopRequested)
+	{
+		if (writeQueuedTicks() == 0)
+		{
+			std::this_thread::sleep_for(IdleSleep);
+		}
+
+		const clock_t::time_point now = clock_t::now();
+		if (FlushInterval <= now - lastFlush)
+		{
+			flushSegments();
+			lastFlush = now;
+		}
+	}
+
+	writeQueuedTicks();
+	closeSegments();
+}
+
+std::size_t KTickArchive::writeQueuedTicks()
+{
+	const uint64_t tail = m_queueTail.load(std::memory_order_relaxed);
+	const uint64_t head = m_queueHead.load(std::memory_order_acquire);
+	for (uint64_t i = tail; i < head; ++i)
+	{
+		writeTick(m_queue[i % QueueCapacity]);
+	}
+	m_queueTail.store(head, std::memory_order_release);
+	const std::size_t result = static_cast<std::size_t>(head - tail);
+	return result;
+}
+
+void KTickArchive::writeTick(const STick& tick)
+{
+	try
+	{
+		const datetime_t day = dayStart(tick.m_time.m_value);
+		if (day < m_currentDay)
+		{
+			// the segments of the previous days are closed, and the ticks of
+			// a segment have to be in order
+			++m_lateTicks;
+			return;
+		}
+
+		if (m_currentDay < day)
+		{
+			rollSegments(day);
+			m_currentDay = day;
+		}
+
+		KSegmentWriter& segment = ensureSegment(tick.m_symbolName, day);
+		segment.append(tick);
+		++m_archivedTicks;
+	}
+	catch (std::exception& e)
+	{
+		++m_failedTicks;
+		std::lock_guard<std::mutex> lock(m_errorMutex);
+		m_lastError = e.what();
+	}
+}
+
+KSegmentWriter& KTickArchive::ensureSegment(const std::string_view& symbol, const datetime_t day)
+{
+	auto it = m_segments.find(symbol);
+	if (it == m_segments.end())
+	{
+		it = m_segments.emplace(std::string(symbol), std::unique_ptr<KSegmentWriter>()).first;
+	}
+
+	std::unique_ptr<KSegmentWriter>& segment = it->second;
+	if (!segment || (segment->day() != day) || segment->isFull())
+	{
+		segment.reset();
+		const std::string& path = prepareSegmentPath(it->first, day);
+		segment.reset(new KSegmentWriter(path, it->first, day));
+		++m_segmentCount;
+	}
+	return *segment;
+}
+
+void KTickArchive::rollSegments(const datetime_t day)
+{
+	// the segments of the symbols quiet since the previous day are closed too,
+	// so all of them may be read once the day is over
+	for (auto& [symbol, segment] : m_segments)
+	{
+		if (segment && (segment->day() < day))
+		{
+			segment.reset();
+		}
+	}
+}
+
+std::string KTickArchive::prepareSegmentPath(const std::string& symbol, const datetime_t day)
+{
+	const std::string& symbolDirectory = m_directory + "/" + symbol;
+	std::error_code error;
+	std::filesystem::create_directories(symbolDirectory, error);
+	if (error)
+	{
+		throw std::runtime_error("cannot create directory " + symbolDirectory);
+	}
+
+	const std::string& dayPrefix = symbolDirectory + "/" + formatDay(day) + "-";
+	std::string result;
+	int part = 0;
+	do
+	{
+		result = dayPrefix + std::to_string(part) + tickarchive::SegmentExtension;
+		++part;
+	}
+	while (utils::pathExists(result));
+	return result;
+}
+
+void KTickArchive::flushSegments()
+{
+	for (auto& [symbol, segment] : m_segments)
+	{
+		if (segment)
+		{
+			segment->flush();
+		}
+	}
+}
+
+void KTickArchive::closeSegments()
+{
+	m_segments.clear();
+}
+
+// ---------------------------------------------------------------------------
+// ---------------------------------------------------------------------------
+
+class KTickSegment : public ITickSegment
+{
+	public:
+		KTickSegment(const std::string& path);
+		virtual ~KTickSegment();
+
+	public:
+		// ITickSegment
+		virtual const std::string& getSymbol() const;
+		virtual datetime_t getDay() const;
+
+		virtual std::size_t size() const;
+		virtual const STickRecord* begin() const;
+		virtual const STickRecord* end() const;
+
+		virtual const STickRecord* lowerBound(const datetime_t time) const;
+
+	private:
+		KMappedFile m_file;
+		const tickarchive::SSegmentHeader* m_header;
+		const STickRecord* m_records;
+		std::string m_symbol;
+
+};
+
+// ---------------------------------------------------------------------------
+
+KTickSegment::KTickSegment(const std::string& path)
+{
+	const char* data = m_file.open(path) ? m_file.mapAll() : nullptr;
+	if ((data == nullptr) || (m_file.fileSize() < tickarchive::HeaderSize))
+	{
+		throw std::runtime_error("cannot open segment " + path);
+	}
+
+	m_header = reinterpret_cast<const tickarchive::SSegmentHeader*>(data);
+	m_records = reinterpret_cast<const STickRecord*>(data + tickarchive::HeaderSize);
+
+	const uint64_t recordsSize = m_file.fileSize() - tickarchive::HeaderSize;
+	if (!std::equal(std::begin(tickarchive::Signature), std::end(tickarchive::Signature), m_header->m_signature)
+		|| (recordsSize < m_header->m_recordCount * sizeof(STickRecord))
+		|| (tickarchive::MaxIndexEntries < m_header->m_indexCount))
+	{
+		throw std::runtime_error("incorrect format of segment " + path);
+	}
+
+	if (!m_header->m_closed)
+	{
+		throw std::runtime_error("segment is still written " + path);
+	}
+
+	m_symbol.assign(m_header->m_symbol, strnlen(m_header->m_symbol, sizeof(m_header->m_symbol)));
+}
+
+KTickSegment::~KTickSegment()
+{
+}
+
+const std::string& KTickSegment::getSymbol() const
+{
+	return m_symbol;
+}
+
+datetime_t KTickSegment::getDay() const
+{
+	return m_header->m_day;
+}
+
+std::size_t KTickSegment::size() const
+{
+	return m_header->m_recordCount;
+}
+
+const STickRecord* KTickSegment::begin() const
+{
+	return m_records;
+}
+
+const STickRecord* KTickSegment::end() const
+{
+	return m_records + m_header->m_recordCount;
+}
+
+const STickRecord* KTickSegment::lowerBound(const datetime_t time) const
+{
+	// the first index entry not earlier than time, the wanted record is
+	// between it and the previous entry
+	const tickarchive::SIndexEntry* indexBegin = m_header->m_index;
+	const tickarchive::SIndexEntry* indexEnd = indexBegin + m_header->m_indexCount;
+	const tickarchive::SIndexEntry* entry = std::lower_bound(
+		indexBegin,
+		indexEnd,
+		time,
+		[](const tickarchive::SIndexEntry& entry, const datetime_t time) { return entry.m_time < time; });
+
+	const STickRecord* first = (entry != indexBegin) ? (m_records + (entry - 1)->m_record) : begin();
+	const STickRecord* last = (entry != indexEnd) ? (m_records + entry->m_record + 1) : end();
+	const STickRecord* result = std::lower_bound(
+		first,
+		last,
+		time,
+		[](const STickRecord& record, const datetime_t time) { return record.m_time < time; });
+	return result;
+}
+
+} // anonymous namespace
+
+// ---------------------------------------------------------------------------
+
+ITickArchive* createTickArchive(const std::string& directory)
+{
+	ITickArchive* tickArchive = new KTickArchive(directory);
+	return tickArchive;
+}
+
+ITickSegment* openTickSegment(const std::string& path)
+{
+	ITickSegment* tickSegment = new KTickSegment(path);
+	return tickSegment;
+}
+
+} // namespace fx
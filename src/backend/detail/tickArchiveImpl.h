@@ -0,0 +1,17 @@
+// author: Darek Slusarczyk alias marines marinesovitch 2012-2013, 2022
+#ifndef INC_BACKEND_TICKARCHIVEIMPL_H
+#define INC_BACKEND_TICKARCHIVEIMPL_H
+
+namespace fx
+{
+
+struct ITickArchive;
+struct ITickSegment;
+
+// both throw std::runtime_error if the directory / segment cannot be used
+ITickArchive* createTickArchive(const std::string& directory);
+ITickSegment* openTickSegment(const std::string& path);
+
+} // namespace fx
+
+#endif
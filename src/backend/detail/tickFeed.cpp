@@ -0,0 +1,12 @@
+// author: Darek Slusarczyk alias marines marinesovitch 2012-2013, 2022
+#include "ph.h"
+#include "tickFeed.h"
+
+namespace fx
+{
+
+ITickFeed::~ITickFeed()
+{
+}
+
+} // namespace fx
@@ -0,0 +1,250 @@
+// author: Darek Slusarczyk alias marines marinesovitch 2012-2013, 2022
+#include "ph.h"
+#include "tickFeedImpl.h"
+#include "tickFeed.h"
+#include "history.h"
+#include "historyFormat.h"
+#include "historyImpl.h"
+#include "tickArchive.h"
+#include "tickArchiveFormat.h"
+#include "tickArchiveImpl.h"
+#include <filesystem>
+
+namespace fx
+{
+
+namespace
+{
+
+// the segments of a symbol are named <yyyymmdd>-<part>, the parts have to
+// be compared as numbers
+bool segmentLess(const std::filesystem::path& lhs, const std::filesystem::path& rhs)
+{
+	auto splitName = [](const std::filesystem::path& path)
+	{
+		const std::string& name = path.stem().string();
+		const std::size_t separator = name.find('-');
+		const std::string& day = name.substr(0, separator);
+		const int part = (separator != std::string::npos) ? std::atoi(name.c_str() + separator + 1) : 0;
+		return std::make_pair(day, part);
+	};
+
+	const bool result = splitName(lhs) < splitName(rhs);
+	return result;
+}
+
+// ---------------------------------------------------------------------------
+
+// all the files stay mapped as long as the feed exists, so the replays in
+// many threads share the same pages
+class KTickFeed : public ITickFeed
+{
+	public:
+		KTickFeed(const std::string& path);
+		virtual ~KTickFeed();
+
+	public:
+		// ITickFeed
+		virtual const std::string& getSymbol() const;
+		virtual uint64_t size() const;
+		virtual datetime_t getFirstTime() const;
+		virtual datetime_t getLastTime() const;
+
+		virtual void replay(ITickFeedSink* sink) const;
+		virtual void replay(ITickFeedSink* sink, const datetime_t from, const datetime_t to) const;
+
+	private:
+		void openDirectory(const std::string& directory);
+		void openSegment(const std::string& path);
+		void openHistory(const std::string& path);
+		void setSymbol(const std::string& symbol);
+
+		void replayHistory(ITickFeedSink* sink, const datetime_t from, const datetime_t to) const;
+
+	private:
+		std::vector<std::unique_ptr<ITickSegment>> m_segments;
+		std::unique_ptr<IHistory> m_history;
+		std::string m_symbol;
+		uint64_t m_size = 0;
+
+};
+
+// ---------------------------------------------------------------------------
+
+KTickFeed::KTickFeed(const std::string& path)
+{
+	const std::string& extension = std::filesystem::path(path).extension().string();
+	if (std::filesystem::is_directory(path))
+	{
+		openDirectory(path);
+	}
+	else if (extension == tickarchive::SegmentExtension)
+	{
+		openSegment(path);
+	}
+	else if (extension == history::FileExtension)
+	{
+		openHistory(path);
+	}
+	else
+	{
+		throw std::runtime_error("unknown kind of ticks: " + path);
+	}
+
+	if (m_size == 0)
+	{
+		throw std::runtime_error("no ticks in " + path);
+	}
+}
+
+KTickFeed::~KTickFeed()
+{
+}
+
+// ---------------------------------------------------------------------------
+// ITickFeed
+
+const std::string& KTickFeed::getSymbol() const
+{
+	return m_symbol;
+}
+
+uint64_t KTickFeed::size() const
+{
+	return m_size;
+}
+
+datetime_t KTickFeed::getFirstTime() const
+{
+	const datetime_t result = m_history ? m_history->getTimes()[0] : m_segments.front()->begin()->m_time;
+	return result;
+}
+
+datetime_t KTickFeed::getLastTime() const
+{
+	if (m_history)
+	{
+		// the last tick made of a bar is its close
+		const datetime_t closeOffset = (m_history->getKind() == history::Ticks) ? 0 : 3 * (m_history->getPeriod() / 4);
+		return m_history->getTimes()[m_history->size() - 1] + closeOffset;
+	}
+
+	const STickRecord* last = m_segments.back()->end() - 1;
+	return last->m_time;
+}
+
+void KTickFeed::replay(ITickFeedSink* sink) const
+{
+	replay(sink, std::numeric_limits<datetime_t>::min(), std::numeric_limits<datetime_t>::max());
+}
+
+void KTickFeed::replay(ITickFeedSink* sink, const datetime_t from, const datetime_t to) const
+{
+	if (m_history)
+	{
+		replayHistory(sink, from, to);
+		return;
+	}
+
+	for (const std::unique_ptr<ITickSegment>& segment : m_segments)
+	{
+		const STickRecord* end = segment->lowerBound(to);
+		for (const STickRecord* record = segment->lowerBound(from); record < end; ++record)
+		{
+			sink->onTick(record->m_time, record->m_bid, record->m_ask, record->m_last);
+		}
+	}
+}
+
+// ---------------------------------------------------------------------------
+
+void KTickFeed::openDirectory(const std::string& directory)
+{
+	std::vector<std::filesystem::path> segments;
+	for (const auto& entry : std::filesystem::directory_iterator(directory))
+	{
+		if (entry.is_regular_file() && (entry.path().extension() == tickarchive::SegmentExtension))
+		{
+			segments.push_back(entry.path());
+		}
+	}
+
+	std::sort(segments.begin(), segments.end(), segmentLess);
+	for (const std::filesystem::path& segment : segments)
+	{
+		openSegment(segment.string());
+	}
+}
+
+void KTickFeed::openSegment(const std::string& path)
+{
+	std::unique_ptr<ITickSegment> segment(openTickSegment(path));
+	setSymbol(segment->getSymbol());
+	m_size += segment->size();
+	m_segments.push_back(std::move(segment));
+}
+
+void KTickFeed::openHistory(const std::string& path)
+{
+	m_history.reset(fx::openHistory(path));
+	setSymbol(m_history->getSymbol());
+	const uint64_t ticksPerRow = (m_history->getKind() == history::Ticks) ? 1 : 4;
+	m_size = m_history->size() * ticksPerRow;
+}
+
+void KTickFeed::setSymbol(const std::string& symbol)
+{
+	if (m_symbol.empty())
+	{
+		m_symbol = symbol;
+	}
+	else if (m_symbol != symbol)
+	{
+		throw std::runtime_error("ticks of different symbols: " + m_symbol + " and " + symbol);
+	}
+}
+
+void KTickFeed::replayHistory(ITickFeedSink* sink, const datetime_t from, const datetime_t to) const
+{
+	const std::size_t first = m_history->lowerBound(from);
+	const std::size_t end = m_history->lowerBound(to);
+	const datetime_t* times = m_history->getTimes();
+	if (m_history->getKind() == history::Ticks)
+	{
+		const double* bids = m_history->getColumn(history::Bid);
+		const double* asks = m_history->getColumn(history::Ask);
+		const double* lasts = m_history->getColumn(history::Last);
+		for (std::size_t i = first; i < end; ++i)
+		{
+			sink->onTick(times[i], bids[i], asks[i], lasts[i]);
+		}
+		return;
+	}
+
+	// the ticks are spread over the bar, so they stay within its period
+	const datetime_t step = std::max<datetime_t>(m_history->getPeriod() / 4, 0);
+	const double* opens = m_history->getColumn(history::Open);
+	const double* highs = m_history->getColumn(history::High);
+	const double* lows = m_history->getColumn(history::Low);
+	const double* closes = m_history->getColumn(history::Close);
+	for (std::size_t i = first; i < end; ++i)
+	{
+		const bool bullish = (opens[i] <= closes[i]);
+		sink->onTick(times[i], opens[i], 0.0, 0.0);
+		sink->onTick(times[i] + step, bullish ? lows[i] : highs[i], 0.0, 0.0);
+		sink->onTick(times[i] + 2 * step, bullish ? highs[i] : lows[i], 0.0, 0.0);
+		sink->onTick(times[i] + 3 * step, closes[i], 0.0, 0.0);
+	}
+}
+
+} // anonymous namespace
+
+// ---------------------------------------------------------------------------
+
+ITickFeed* openTickFeed(const std::string& path)
+{
+	ITickFeed* feed = new KTickFeed(path);
+	return feed;
+}
+
+} // namespace fx
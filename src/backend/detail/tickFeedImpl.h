@@ -0,0 +1,18 @@
+// author: Darek Slusarczyk alias marines marinesovitch 2012-2013, 2022
+#ifndef INC_BACKEND_TICKFEEDIMPL_H
+#define INC_BACKEND_TICKFEEDIMPL_H
+
+namespace fx
+{
+
+struct ITickFeed;
+
+// path may be a tick archive segment (.fxtick), a directory with segments of
+// a symbol, or an imported history (.fxhist); the bars of history are
+// replayed as four ticks: open, low, high and close (high before low for
+// bearish bars); throws std::runtime_error
+ITickFeed* openTickFeed(const std::string& path);
+
+} // namespace fx
+
+#endif
@@ -0,0 +1,33 @@
+// author: Darek Slusarczyk alias marines marinesovitch 2012-2013, 2022
+#include "ph.h"
+#include "tickStore.h"
+
+namespace fx
+{
+
+std::size_t STickSeries::size() const
+{
+	return m_times.size();
+}
+
+bool STickSeries::empty() const
+{
+	return m_times.empty();
+}
+
+void STickSeries::clear()
+{
+	m_times.clear();
+	m_bids.clear();
+	m_asks.clear();
+	m_lasts.clear();
+	m_endCount = 0;
+}
+
+// ---------------------------------------------------------------------------
+
+ITickStore::~ITickStore()
+{
+}
+
+} // namespace fx
@@ -0,0 +1,325 @@
+// author: Darek Slusarczyk alias marines marinesovitch 2012-2013, 2022
+#include "ph.h"
+#include "tickStoreImpl.h"
+#include "tickStore.h"
+#include "common/types.h"
+#include <shared_mutex>
+#include <string_view>
+
+namespace fx
+{
+
+namespace
+{
+
+std::size_t roundUpToPowerOf2(const std::size_t value)
+{
+	std::size_t result = 1;
+	while (result < value)
+	{
+		result <<= 1;
+	}
+	return result;
+}
+
+// ---------------------------------------------------------------------------
+
+// the ring of ticks of a single symbol, each column is a separate array of
+// relaxed atomics (plain loads and stores on x86), there is a single writer,
+// the readers validate the copied range like in a seqlock:
+// - the writer bumps m_reserved before it overwrites the slot and m_committed
+//   after the slot is complete
+// - the reader copies the committed ticks and then drops those which could be
+//   overwritten in the meantime according to m_reserved
+class KTickRing
+{
+	public:
+		KTickRing(const std::size_t capacity);
+
+	public:
+		uint64_t append(const STick& tick);
+
+		uint64_t count() const;
+		void getLast(const std::size_t count, STickSeries* series) const;
+		void getSince(const datetime_t since, STickSeries* series) const;
+
+	private:
+		template<typename T>
+		using column_t = std::unique_ptr<std::atomic<T>[]>;
+
+		std::size_t slot(const uint64_t index) const;
+		uint64_t oldestIndex(const uint64_t count) const;
+		uint64_t lowerBound(uint64_t first, uint64_t last, const datetime_t since) const;
+		void copy(const uint64_t first, const uint64_t last, STickSeries* series) const;
+
+	private:
+		const std::size_t m_capacity;
+		const uint64_t m_mask;
+
+		column_t<datetime_t> m_times;
+		column_t<price_t> m_bids;
+		column_t<price_t> m_asks;
+		column_t<price_t> m_lasts;
+
+		std::atomic<uint64_t> m_reserved = 0;
+		std::atomic<uint64_t> m_committed = 0;
+
+};
+
+// ---------------------------------------------------------------------------
+
+KTickRing::KTickRing(const std::size_t capacity)
+	: m_capacity(roundUpToPowerOf2(capacity))
+	, m_mask(m_capacity - 1)
+	, m_times(new std::atomic<datetime_t>[m_capacity])
+	, m_bids(new std::atomic<price_t>[m_capacity])
+	, m_asks(new std::atomic<price_t>[m_capacity])
+	, m_lasts(new std::atomic<price_t>[m_capacity])
+{
+}
+
+uint64_t KTickRing::append(const STick& tick)
+{
+	const uint64_t index = m_committed.load(std::memory_order_relaxed);
+	m_reserved.store(index + 1, std::memory_order_relaxed);
+	std::atomic_thread_fence(std::memory_order_release);
+
+	const std::size_t i = slot(index);
+	m_times[i].store(tick.m_time.m_value, std::memory_order_relaxed);
+	m_bids[i].store(tick.m_bid.m_value, std::memory_order_relaxed);
+	m_asks[i].store(tick.m_ask.m_value, std::memory_order_relaxed);
+	m_lasts[i].store(tick.m_last.m_value, std::memory_order_relaxed);
+
+	m_committed.store(index + 1, std::memory_order_release);
+	return index + 1;
+}
+
+uint64_t KTickRing::count() const
+{
+	return m_committed.load(std::memory_order_acquire);
+}
+
+void KTickRing::getLast(const std::size_t count, STickSeries* series) const
+{
+	const uint64_t last = m_committed.load(std::memory_order_acquire);
+	const uint64_t first = std::max(oldestIndex(last), last - std::min<uint64_t>(last, count));
+	copy(first, last, series);
+}
+
+void KTickRing::getSince(const datetime_t since, STickSeries* series) const
+{
+	const uint64_t last = m_committed.load(std::memory_order_acquire);
+	const uint64_t first = lowerBound(oldestIndex(last), last, since);
+	copy(first, last, series);
+
+	// the search could be misled by slots overwritten during the search, the
+	// overwritten ticks are dropped by copy, so trim what remained before since
+	const auto& times = series->m_times;
+	const std::ptrdiff_t outdated = std::lower_bound(times.begin(), times.end(), since) - times.begin();
+	if (0 < outdated)
+	{
+		series->m_times.erase(series->m_times.begin(), series->m_times.begin() + outdated);
+		series->m_bids.erase(series->m_bids.begin(), series->m_bids.begin() + outdated);
+		series->m_asks.erase(series->m_asks.begin(), series->m_asks.begin() + outdated);
+		series->m_lasts.erase(series->m_lasts.begin(), series->m_lasts.begin() + outdated);
+	}
+}
+
+// ---------------------------------------------------------------------------
+
+std::size_t KTickRing::slot(const uint64_t index) const
+{
+	return static_cast<std::size_t>(index & m_mask);
+}
+
+uint64_t KTickRing::oldestIndex(const uint64_t count) const
+{
+	return (m_capacity < count) ? (count - m_capacity) : 0;
+}
+
+uint64_t KTickRing::lowerBound(uint64_t first, uint64_t last, const datetime_t since) const
+{
+	// the ticks of a symbol come in chronological order
+	while (first < last)
+	{
+		const uint64_t middle = first + (last - first) / 2;
+		if (m_times[slot(middle)].load(std::memory_order_relaxed) < since)
+		{
+			first = middle + 1;
+		}
+		else
+		{
+			last = middle;
+		}
+	}
+	return first;
+}
+
+void KTickRing::copy(const uint64_t first, const uint64_t last, STickSeries* series) const
+{
+	const std::size_t size = static_cast<std::size_t>(last - first);
+	series->m_endCount = last;
+	series->m_times.resize(size);
+	series->m_bids.resize(size);
+	series->m_asks.resize(size);
+	series->m_lasts.resize(size);
+
+	for (std::size_t i = 0; i < size; ++i)
+	{
+		const std::size_t s = slot(first + i);
+		series->m_times[i] = m_times[s].load(std::memory_order_relaxed);
+		series->m_bids[i] = m_bids[s].load(std::memory_order_relaxed);
+		series->m_asks[i] = m_asks[s].load(std::memory_order_relaxed);
+		series->m_lasts[i] = m_lasts[s].load(std::memory_order_relaxed);
+	}
+
+	std::atomic_thread_fence(std::memory_order_acquire);
+	const uint64_t reserved = m_reserved.load(std::memory_order_relaxed);
+	const uint64_t valid = oldestIndex(reserved);
+	if (first < valid)
+	{
+		const std::size_t overwritten = static_cast<std::size_t>(std::min(valid, last) - first);
+		series->m_times.erase(series->m_times.begin(), series->m_times.begin() + overwritten);
+		series->m_bids.erase(series->m_bids.begin(), series->m_bids.begin() + overwritten);
+		series->m_asks.erase(series->m_asks.begin(), series->m_asks.begin() + overwritten);
+		series->m_lasts.erase(series->m_lasts.begin(), series->m_lasts.begin() + overwritten);
+	}
+}
+
+// ---------------------------------------------------------------------------
+// ---------------------------------------------------------------------------
+
+class KTickStore : public ITickStore
+{
+	public:
+		KTickStore(const std::size_t capacity);
+		virtual ~KTickStore();
+
+	public:
+		// ITickStore
+		virtual uint64_t append(const STick& tick);
+
+		virtual std::size_t capacity() const;
+		virtual uint64_t tickCount(const std::string& symbol) const;
+
+		virtual bool getLastTicks(const std::string& symbol, const std::size_t count, STickSeries* series) const;
+		virtual bool getTicksSince(const std::string& symbol, const datetime_t since, STickSeries* series) const;
+
+	private:
+		const KTickRing* getRing(const std::string_view& symbol) const;
+		KTickRing* ensureRing(const std::string_view& symbol);
+
+	private:
+		typedef std::map<std::string, std::unique_ptr<KTickRing>, std::less<>> symbol2ring_t;
+
+		const std::size_t m_capacity;
+
+		// the rings are never removed, so a found ring may be used without
+		// the lock, the exclusive lock is taken only when a new symbol comes
+		mutable std::shared_mutex m_ringsMutex;
+		symbol2ring_t m_rings;
+
+		// the tick loop is the only writer, but a replayed session may feed
+		// the same account concurrently
+		std::mutex m_appendMutex;
+
+};
+
+// ---------------------------------------------------------------------------
+
+KTickStore::KTickStore(const std::size_t capacity)
+	: m_capacity(roundUpToPowerOf2(capacity))
+{
+}
+
+KTickStore::~KTickStore()
+{
+}
+
+uint64_t KTickStore::append(const STick& tick)
+{
+	const std::string_view symbol(tick.m_symbolName);
+	KTickRing* ring = ensureRing(symbol);
+	std::lock_guard<std::mutex> lock(m_appendMutex);
+	const uint64_t result = ring->append(tick);
+	return result;
+}
+
+std::size_t KTickStore::capacity() const
+{
+	return m_capacity;
+}
+
+uint64_t KTickStore::tickCount(const std::string& symbol) const
+{
+	const KTickRing* ring = getRing(symbol);
+	const uint64_t result = (ring != nullptr) ? ring->count() : 0;
+	return result;
+}
+
+bool KTickStore::getLastTicks(const std::string& symbol, const std::size_t count, STickSeries* series) const
+{
+	series->clear();
+	const KTickRing* ring = getRing(symbol);
+	if (ring != nullptr)
+	{
+		ring->getLast(count, series);
+	}
+	const bool result = !series->empty();
+	return result;
+}
+
+bool KTickStore::getTicksSince(const std::string& symbol, const datetime_t since, STickSeries* series) const
+{
+	series->clear();
+	const KTickRing* ring = getRing(symbol);
+	if (ring != nullptr)
+	{
+		ring->getSince(since, series);
+	}
+	const bool result = !series->empty();
+	return result;
+}
+
+// ---------------------------------------------------------------------------
+
+const KTickRing* KTickStore::getRing(const std::string_view& symbol) const
+{
+	std::shared_lock<std::shared_mutex> lock(m_ringsMutex);
+	auto it = m_rings.find(symbol);
+	const KTickRing* result = (it != m_rings.end()) ? it->second.get() : nullptr;
+	return result;
+}
+
+KTickRing* KTickStore::ensureRing(const std::string_view& symbol)
+{
+	{
+		std::shared_lock<std::shared_mutex> lock(m_ringsMutex);
+		auto it = m_rings.find(symbol);
+		if (it != m_rings.end())
+		{
+			return it->second.get();
+		}
+	}
+
+	std::unique_lock<std::shared_mutex> lock(m_ringsMutex);
+	auto it = m_rings.find(symbol);
+	if (it == m_rings.end())
+	{
+		std::unique_ptr<KTickRing> ring(new KTickRing(m_capacity));
+		it = m_rings.emplace(std::string(symbol), std::move(ring)).first;
+	}
+	return it->second.get();
+}
+
+} // anonymous namespace
+
+// ---------------------------------------------------------------------------
+
+ITickStore* createTickStore(const std::size_t capacity)
+{
+	ITickStore* tickStore = new KTickStore(capacity);
+	return tickStore;
+}
+
+} // namespace fx
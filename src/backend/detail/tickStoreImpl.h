@@ -0,0 +1,17 @@
+// author: Darek Slusarczyk alias marines marinesovitch 2012-2013, 2022
+#ifndef INC_BACKEND_TICKSTOREIMPL_H
+#define INC_BACKEND_TICKSTOREIMPL_H
+
+namespace fx
+{
+
+struct ITickStore;
+
+// capacity is the number of ticks kept per symbol, rounded up to power of 2
+ITickStore* createTickStore(const std::size_t capacity);
+
+const std::size_t DefaultTickStoreCapacity = 64 * 1024;
+
+} // namespace fx
+
+#endif
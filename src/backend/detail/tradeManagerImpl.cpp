@@ -3,6 +3,11 @@
 #include "tradeManagerImpl.h"
 #include "tradeManager.h"
 #include "tradeObserver.h"
+#include "copyTrader.h"
+#include "copyTraderImpl.h"
+#include "executionSimulator.h"
+#include "paperConnection.h"
+#include "paperConnectionImpl.h"
 #include "trader.h"
 #include "traderImpl.h"
 #include "communicator.h"
@@ -13,6 +18,7 @@
 #include "common/types.h"
 #include "common/utils.h"
 #include "cpp/types.h"
+#include <shared_mutex>
 
 namespace fx
 {
@@ -22,6 +28,7 @@ namespace
 
 
 typedef std::map< account_key_t, HTrader > traders_t;
+typedef std::map< account_key_t, HPaperConnection > paper_connections_t;
 
 // ---------------------------------------------------------------------------
 
@@ -78,13 +85,17 @@ typedef std::map< account_key_t, HTrader > traders_t;
 class KTradeManager : public ITradeManager, public ICommunicatorObserver
 {
 	public: 
-		KTradeManager( ICommunicator* communicator );
+		KTradeManager( ICommunicator* communicator, std::ostream* cerr );
 		virtual ~KTradeManager();
 
 	public: 
 		// ITradeManager
 		virtual void run();
 		virtual HTrader getTrader(const account_key_t& key) const;
+		virtual ICopyTrader& getCopyTrader();
+
+		virtual void setPaperTrading(const SExecutionParams& params);
+		virtual bool getPaperStats(const account_key_t& key, SPaperStats* stats) const;
 
 	public: 
 		// ICommunicatorObserver
@@ -93,23 +104,42 @@ class KTradeManager : public ITradeManager, public ICommunicatorObserver
 
 	private:
 		ICommunicator& m_communicator;
+		// the traders and the copy trader report the refused commands there
+		std::ostream& m_cerr;
 		ITradeObserver* m_observer = nullptr;
 
+		// the order loops, the strategy pools and the copy trader look the
+		// traders up while the communicator adds the detected accounts
+		mutable std::shared_mutex m_tradersMutex;
 		traders_t m_traders;
+		// observes the orders of all traders
+		std::unique_ptr<ICopyTrader> m_copyTrader;
+
+		// set if the accounts trade on the simulated broker
+		std::unique_ptr<SExecutionParams> m_paperParams;
+		// guarded by m_tradersMutex as well
+		paper_connections_t m_paperConnections;
 
 };
 
 // ---------------------------------------------------------------------------
 
-KTradeManager::KTradeManager( ICommunicator* communicator ) 
+KTradeManager::KTradeManager( ICommunicator* communicator, std::ostream* cerr ) 
 	: m_communicator( *communicator )
+	, m_cerr( *cerr )
 	//, m_observer(&KTradeObserverStub::s_instance)
+	, m_copyTrader( createCopyTrader( this, &m_cerr ) )
 {
 	m_communicator.setObserver( this );
 }
 
 KTradeManager::~KTradeManager()
 {
+	// the traders may outlive the manager in their connections
+	for ( auto& key2trader : m_traders )
+	{
+		key2trader.second->setOrderObserver( nullptr );
+	}
 }
 
 //void KTradeManager::setObserver(ITradeObserver* observer)
@@ -125,6 +155,7 @@ void KTradeManager::run()
 
 HTrader KTradeManager::getTrader(const account_key_t& key) const
 {
+	std::shared_lock<std::shared_mutex> lock( m_tradersMutex );
 	HTrader result;
 	auto it = m_traders.find( key );
 	if ( it != m_traders.end() )
@@ -134,15 +165,57 @@ HTrader KTradeManager::getTrader(const account_key_t& key) const
 	return result;
 }
 
+ICopyTrader& KTradeManager::getCopyTrader()
+{
+	return *m_copyTrader;
+}
+
+void KTradeManager::setPaperTrading(const SExecutionParams& params)
+{
+	assert( m_traders.empty() );
+	m_paperParams.reset( new SExecutionParams( params ) );
+}
+
+bool KTradeManager::getPaperStats(const account_key_t& key, SPaperStats* stats) const
+{
+	std::shared_lock<std::shared_mutex> lock( m_tradersMutex );
+	auto it = m_paperConnections.find( key );
+	if ( it == m_paperConnections.end() )
+	{
+		return false;
+	}
+
+	*stats = it->second->getStats();
+	return true;
+}
+
 // ---------------------------------------------------------------------------
 
 void KTradeManager::onNewAccountDetected(const account_key_t& key)
 {
-	assert( m_traders.count( key ) == 0 );
-	HTrader trader( fx::createTrader( key ) );
-	m_traders.insert( std::make_pair( key, trader ) );
-	HConnection connection = m_communicator.connect( key, trader.get() );
-	trader->setConnection( connection );
+	HTrader trader( fx::createTrader( key, &m_cerr ) );
+	{
+		std::unique_lock<std::shared_mutex> lock( m_tradersMutex );
+		assert( m_traders.count( key ) == 0 );
+		m_traders.insert( std::make_pair( key, trader ) );
+	}
+	trader->setOrderObserver( m_copyTrader.get() );
+	if ( !m_paperParams )
+	{
+		HConnection connection = m_communicator.connect( key, trader.get() );
+		trader->setConnection( connection );
+		return;
+	}
+
+	// the paper connection stands between the live connection and the trader
+	HPaperConnection paperConnection( createPaperConnection( *m_paperParams, trader.get() ) );
+	{
+		std::unique_lock<std::shared_mutex> lock( m_tradersMutex );
+		m_paperConnections.insert( std::make_pair( key, paperConnection ) );
+	}
+	HConnection liveConnection = m_communicator.connect( key, paperConnection.get() );
+	paperConnection->setLiveConnection( liveConnection );
+	trader->setConnection( paperConnection );
 }
 
 void KTradeManager::onSymbolNote(const account_key_t& key, const note::EKind noteKind, const std::string& symbol)
@@ -169,9 +242,9 @@ void KTradeManager::onSymbolNote(const account_key_t& key, const note::EKind not
 
 // ---------------------------------------------------------------------------
 
-ITradeManager* createTradeManager(ICommunicator* communicator)
+ITradeManager* createTradeManager(ICommunicator* communicator, std::ostream* cerr)
 {
-	ITradeManager* tradeManager = new KTradeManager( communicator );
+	ITradeManager* tradeManager = new KTradeManager( communicator, cerr );
 	return tradeManager;
 }
 
@@ -8,7 +8,7 @@ namespace fx
 struct ITradeManager;
 struct ICommunicator;
 
-ITradeManager* createTradeManager(ICommunicator* communicator);
+ITradeManager* createTradeManager(ICommunicator* communicator, std::ostream* cerr);
 
 } // namespace fx
 
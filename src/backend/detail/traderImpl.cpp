@@ -2,13 +2,38 @@
 #include "ph.h"
 #include "traderImpl.h"
 #include "trader.h"
+#include "barEngine.h"
+#include "barEngineImpl.h"
+#include "equityTracker.h"
+#include "equityTrackerImpl.h"
+#include "orderCache.h"
+#include "orderCacheImpl.h"
+#include "riskGuard.h"
+#include "riskGuardImpl.h"
+#include "positionEngine.h"
+#include "positionEngineImpl.h"
+#include "strategyHost.h"
+#include "strategyPool.h"
+#include "strategyPoolImpl.h"
+#include "tickStore.h"
+#include "tickStoreImpl.h"
 #include "tradingStrategy.h"
+#include "trailingStops.h"
+#include "trailingStopsImpl.h"
+#include "conditionalOrders.h"
+#include "conditionalOrdersImpl.h"
+#include "alertEngine.h"
+#include "alertEngineImpl.h"
+#include "executionAlgos.h"
+#include "executionAlgosImpl.h"
 #include "connection.h"
 #include "common/command.h"
+#include "common/consts.h"
 #include "common/symbolInfo.h"
 #include "common/order.h"
 #include "common/types.h"
 #include "cpp/types.h"
+#include <string_view>
 
 namespace fx
 {
@@ -16,28 +41,41 @@ namespace fx
 namespace
 {
 
-typedef std::map<ticket_t, HOrder> orders_t;
-typedef std::map<std::string, HTradingStrategy> symbol2strategy_t;
-
-// ---------------------------------------------------------------------------
-
-class KTrader : public ITrader, ICommandVisitor
+class KTrader : public ITrader, IStrategyHost, ICommandVisitor, IBarSink, IAlertSink
 {
 	public:
-		KTrader( const account_key_t& key );
+		KTrader( const account_key_t& key, std::ostream* cerr );
 		virtual ~KTrader();
 
 	public:
 		// ITrader
 		virtual void setConnection( HConnection connection );
+		virtual HConnection getConnection() const;
+		// it is also IStrategyHost::executeCommand, the commands of strategies
+		// go to MetaTrader the same way as the ones of user
 		virtual void executeCommand( HCommand command );
+		virtual void setOrderObserver( IOrderObserver* observer );
+		// it is also IStrategyHost::getOrders
+		virtual const IOrderCache& getOrders() const;
+		// it is also IStrategyHost::getPositions
+		virtual const IPositionEngine& getPositions() const;
+		virtual const IEquityTracker& getEquity() const;
+		virtual IRiskGuard& getRiskGuard();
+		virtual ITrailingStops& getTrailingStops();
+		virtual IConditionalOrders& getConditionalOrders();
+		virtual IAlertEngine& getAlerts();
+		virtual IExecutionAlgos& getExecutionAlgos();
 
 		virtual void showTicks( const bool show );
+		virtual const ITickStore& getTickStore() const;
+		virtual void setTickArchive( HTickArchive archive );
+		virtual HTickArchive getTickArchive() const;
 
-		virtual const std::string& getStrategy( const std::string& symbol ) const;
+		virtual std::string getStrategy( const std::string& symbol ) const;
 		virtual void setStrategy( const std::string& symbol, HTradingStrategy strategy );
 		virtual void removeStrategy( const std::string& symbol );
 		virtual void executeStrategyCommand( const std::string& symbol, std::istringstream& cmdLine );
+		virtual void getStrategyStats( SStrategyPoolStats* stats ) const;
 
 	public:
 		// ITraderSink
@@ -47,7 +85,8 @@ class KTrader : public ITrader, ICommandVisitor
 		virtual void onTick(const STick& tick);
 		virtual void onSymbol(const SSymbolInfo& symbolInfo);
 		virtual void onOrder(const SOrder& order);
-		virtual void onCmdResult(const std::string& output);
+		virtual void onCmdResult(HCommand command, const std::string& output);
+		virtual void onDisconnected();
 
 	public:
 		// ICommandVisitor
@@ -56,20 +95,72 @@ class KTrader : public ITrader, ICommandVisitor
 		virtual void visitHideTicks( KCmdHideTicks* cmd );
 		virtual void visitDefault( KCommand* cmd );
 
+	public:
+		// IBarSink
+		virtual void onBarClosed(const std::string& symbol, const timeframe::ETimeframe timeframe, const SBar& bar);
+
+	public:
+		// IAlertSink
+		virtual void onAlerts(const alert_events_t& events);
+
+	private:
+		// answers get from the cache if it knows the orders
+		bool printCachedOrders( const tickets_t& tickets ) const;
+
 	private:
 		const account_key_t m_accountKey;
+		// the components which send commands on their own report the
+		// refused ones there
+		std::ostream& m_cerr;
 		HConnection m_connection;
 		cpp::stringset_t m_symbols;
-		orders_t m_orders;
+		// filled by the order loop, the strategies query it from their workers
+		std::unique_ptr<IOrderCache> m_orderCache;
+		// fed by both the order and the tick loop, before the strategies get
+		// the event, so they see the position which includes it
+		std::unique_ptr<IPositionEngine> m_positionEngine;
+		// gets the account totals of the position engine after every change
+		std::unique_ptr<IEquityTracker> m_equityTracker;
+		// fed by the channel loops, read lock-free by executeCommand
+		std::unique_ptr<IRiskGuard> m_riskGuard;
+		// sends its commands the same way as the strategies
+		std::unique_ptr<ITrailingStops> m_trailingStops;
+		std::unique_ptr<IConditionalOrders> m_conditionalOrders;
+		std::unique_ptr<IAlertEngine> m_alertEngine;
+		// sends its children from its own timer thread
+		std::unique_ptr<IExecutionAlgos> m_executionAlgos;
 		bool m_showTicks = false;
-		symbol2strategy_t m_symbol2strategy;
+		std::unique_ptr<ITickStore> m_tickStore;
+		std::unique_ptr<IBarEngine> m_barEngine;
+		// the count of ticks of the symbol of the current tick including it,
+		// like the bar engine it is used only in the tick loop
+		uint64_t m_tickCount = 0;
+		// the strategies are set by executor and run on the workers of the
+		// pool, the channel loops only push the events to them
+		std::unique_ptr<IStrategyPool> m_strategyPool;
+		// accessed atomically, because it is set while the tick loop is running
+		HTickArchive m_tickArchive;
+		// set by the trade manager, read by the order loop
+		std::atomic<IOrderObserver*> m_orderObserver = nullptr;
 
 };
 
 // ---------------------------------------------------------------------------
 
-KTrader::KTrader( const account_key_t& key )
+KTrader::KTrader( const account_key_t& key, std::ostream* cerr )
 	: m_accountKey( key )
+	, m_cerr( *cerr )
+	, m_orderCache( createOrderCache() )
+	, m_positionEngine( createPositionEngine() )
+	, m_equityTracker( createEquityTracker() )
+	, m_riskGuard( createRiskGuard( SRiskLimits() ) )
+	, m_trailingStops( createTrailingStops( this ) )
+	, m_conditionalOrders( createConditionalOrders( this, &m_cerr ) )
+	, m_alertEngine( createAlertEngine( this ) )
+	, m_executionAlgos( createExecutionAlgos( this, &m_cerr ) )
+	, m_tickStore( createTickStore( DefaultTickStoreCapacity ) )
+	, m_barEngine( createBarEngine( this ) )
+	, m_strategyPool( createStrategyPool( this, m_tickStore.get(), &m_cerr, DefaultStrategyWorkerCount ) )
 {
 }
 
@@ -83,6 +174,15 @@ KTrader::~KTrader()
 void KTrader::setConnection( HConnection connection )
 {
 	m_connection = connection;
+	// the orders of the account are loaded into the cache by the replies of
+	// get, then they are kept up to date by the order channel; until get is
+	// answered the queries are passed to the terminal
+	m_connection->sendCommand( std::make_shared<KCmdGet>( tickets_t() ) );
+}
+
+HConnection KTrader::getConnection() const
+{
+	return m_connection;
 }
 
 void KTrader::executeCommand( HCommand command )
@@ -90,11 +190,72 @@ void KTrader::executeCommand( HCommand command )
 	if (command->isLocal())
 	{
 		command->accept(this);
+		return;
 	}
-	else
+
+	std::string error;
+	if (!m_riskGuard->check( *command, &error ))
 	{
-		m_connection->sendCommand( command );
+		throw std::invalid_argument( "refused by risk limits: " + error );
 	}
+
+	if ((command->operation() != KCommand::Get) || !printCachedOrders( command->tickets() ))
+	{
+		try
+		{
+			m_connection->sendCommand( command );
+		}
+		catch ( const std::exception& )
+		{
+			m_riskGuard->onCmdLost( *command );
+			throw;
+		}
+	}
+}
+
+void KTrader::setOrderObserver( IOrderObserver* observer )
+{
+	m_orderObserver = observer;
+}
+
+const IOrderCache& KTrader::getOrders() const
+{
+	return *m_orderCache;
+}
+
+const IPositionEngine& KTrader::getPositions() const
+{
+	return *m_positionEngine;
+}
+
+const IEquityTracker& KTrader::getEquity() const
+{
+	return *m_equityTracker;
+}
+
+IRiskGuard& KTrader::getRiskGuard()
+{
+	return *m_riskGuard;
+}
+
+ITrailingStops& KTrader::getTrailingStops()
+{
+	return *m_trailingStops;
+}
+
+IConditionalOrders& KTrader::getConditionalOrders()
+{
+	return *m_conditionalOrders;
+}
+
+IAlertEngine& KTrader::getAlerts()
+{
+	return *m_alertEngine;
+}
+
+IExecutionAlgos& KTrader::getExecutionAlgos()
+{
+	return *m_executionAlgos;
 }
 
 void KTrader::showTicks( const bool show )
@@ -102,39 +263,44 @@ void KTrader::showTicks( const bool show )
 	m_showTicks = show;
 }
 
-const std::string& KTrader::getStrategy( const std::string& symbol ) const
+const ITickStore& KTrader::getTickStore() const
 {
-	auto it = m_symbol2strategy.find(symbol);
-	if (it != m_symbol2strategy.end())
-	{
-		HTradingStrategy strategy = it->second;
-		const std::string& result = strategy->getName();
-		return result;
-	}
-	else
-	{
-		static const std::string EmptyStrategy;
-		return EmptyStrategy;
-	}
+	return *m_tickStore;
+}
+
+void KTrader::setTickArchive( HTickArchive archive )
+{
+	std::atomic_store( &m_tickArchive, archive );
+}
+
+HTickArchive KTrader::getTickArchive() const
+{
+	return std::atomic_load( &m_tickArchive );
+}
+
+std::string KTrader::getStrategy( const std::string& symbol ) const
+{
+	return m_strategyPool->getStrategy( symbol );
 }
 
 void KTrader::setStrategy( const std::string& symbol, HTradingStrategy strategy )
 {
-	assert( getStrategy( symbol ).empty() );
-	m_symbol2strategy.insert( std::make_pair( symbol, strategy ) );
+	m_strategyPool->setStrategy( symbol, strategy );
 }
 
 void KTrader::removeStrategy( const std::string& symbol )
 {
-	m_symbol2strategy.erase( symbol );
+	m_strategyPool->removeStrategy( symbol );
 }
 
 void KTrader::executeStrategyCommand( const std::string& symbol, std::istringstream& cmdLine )
 {
-	auto it = m_symbol2strategy.find(symbol);
-	assert(it != m_symbol2strategy.end());
-	HTradingStrategy strategy = it->second;
-	strategy->executeCommand(cmdLine);
+	m_strategyPool->executeStrategyCommand( symbol, cmdLine );
+}
+
+void KTrader::getStrategyStats( SStrategyPoolStats* stats ) const
+{
+	m_strategyPool->getStats( stats );
 }
 
 
@@ -155,6 +321,21 @@ void KTrader::onUnregisterSymbol(const std::string& symbol)
 
 void KTrader::onTick(const STick& tick)
 {
+	m_tickCount = m_tickStore->append(tick);
+	if (HTickArchive archive = getTickArchive())
+	{
+		archive->append(tick);
+	}
+	m_positionEngine->onTick(tick);
+	m_riskGuard->onTick(tick);
+	m_equityTracker->onTick(tick.m_time.m_value, m_positionEngine->getAccountPosition());
+	m_trailingStops->onTick(tick);
+	m_conditionalOrders->onTick(tick);
+	m_alertEngine->onTick(tick);
+	m_executionAlgos->onTick(tick);
+	m_barEngine->onTick(tick);
+	m_strategyPool->pushTick(tick, m_tickCount);
+
 	if (m_showTicks)
 	{
 		std::cout << "onTick " << tick.m_symbolName << ' ' 
@@ -170,13 +351,65 @@ void KTrader::onSymbol(const SSymbolInfo& symbolInfo)
 
 void KTrader::onOrder(const SOrder& order)
 {
+	// the orders before it were handled by this loop already, while the
+	// reply of the get may come on the cmd loop earlier
+	if (order.isDumpEnd())
+	{
+		m_orderCache->setComplete();
+		return;
+	}
+
+	// the copies of the orders go out before anything else is done
+	if (IOrderObserver* observer = m_orderObserver)
+	{
+		observer->onOrder(m_accountKey, order);
+	}
+
 	const std::string& orderStr = SOrder::serialize(order);
 	std::cout << "KTrader::onOrder " << orderStr << std::endl;
+
+	SOrder cachedOrder;
+	const bool isNewOrder = !m_orderCache->get(order.m_ticket, &cachedOrder);
+	m_orderCache->update(order);
+	m_positionEngine->onOrder(order);
+	const SAccountPosition account = m_positionEngine->getAccountPosition();
+	m_equityTracker->onOrder(account);
+	SPosition position;
+	m_positionEngine->getPosition(order.m_symbolName, &position);
+	m_riskGuard->onPosition(position, account);
+	if (isNewOrder)
+	{
+		m_riskGuard->onNewOrder(order);
+	}
+	m_trailingStops->onOrder(order);
+	m_conditionalOrders->onOrder(order);
+	m_executionAlgos->onOrder(order);
+
+	m_strategyPool->pushOrder(order);
 }
 
-void KTrader::onCmdResult(const std::string& output)
+void KTrader::onCmdResult(HCommand command, const std::string& output)
 {
 	std::cout << "KTrader::onCmdResult " << output << std::endl;
+	if (!command)
+	{
+		return;
+	}
+
+	const bool success = (output == consts::CmdResultSuccess);
+	m_riskGuard->onCmdResult(*command, success);
+	m_conditionalOrders->onCmdResult(*command, success);
+	m_executionAlgos->onCmdResult(*command, success);
+	if (IOrderObserver* observer = m_orderObserver)
+	{
+		observer->onCmdResult(m_accountKey, *command, success);
+	}
+}
+
+void KTrader::onDisconnected()
+{
+	std::cout << "KTrader::onDisconnected" << std::endl;
+	m_riskGuard->onDisconnected();
 }
 
 
@@ -205,13 +438,72 @@ void KTrader::visitDefault( KCommand* /*cmd*/ )
 	assert(!"unknown command!");
 }
 
+// ---------------------------------------------------------------------------
+// IBarSink
+
+void KTrader::onBarClosed(const std::string& symbol, const timeframe::ETimeframe timeframe, const SBar& bar)
+{
+	m_strategyPool->pushBar(symbol, timeframe, bar, m_tickCount);
+}
+
+// ---------------------------------------------------------------------------
+// IAlertSink
+
+void KTrader::onAlerts(const alert_events_t& events)
+{
+	// the batch is written at once, so the alerts of a tick aren't mixed
+	// with the output of the other loops
+	std::ostringstream os;
+	for (const SAlertEvent& event : events)
+	{
+		os << "alert " << m_accountKey << ": " << event.m_alert.toString()
+			<< " bid " << event.m_bid << ' ' << event.m_time << '\n';
+	}
+	std::cout << os.str() << std::flush;
+}
+
+// ---------------------------------------------------------------------------
+
+bool KTrader::printCachedOrders( const tickets_t& tickets ) const
+{
+	std::vector<SOrder> orders;
+	if (tickets.empty())
+	{
+		if (!m_orderCache->isComplete())
+		{
+			return false;
+		}
+		// like MetaTrader, all the orders are the open and pending ones
+		m_orderCache->find( SOrderFilter( std::string(), SOrder::Open ), &orders );
+		m_orderCache->find( SOrderFilter( std::string(), SOrder::Pending ), &orders );
+	}
+	else
+	{
+		SOrder order;
+		for (const ticket_t ticket : tickets)
+		{
+			if (!m_orderCache->get( ticket, &order ))
+			{
+				return false;
+			}
+			orders.push_back( order );
+		}
+	}
+
+	for (const SOrder& order : orders)
+	{
+		std::cout << SOrder::serialize(order) << std::endl;
+	}
+	return true;
+}
+
 } // anonymous namespace
 
 // ---------------------------------------------------------------------------
 
-ITrader* createTrader( const account_key_t& key )
+ITrader* createTrader( const account_key_t& key, std::ostream* cerr )
 {
-	ITrader* trader = new KTrader( key );
+	ITrader* trader = new KTrader( key, cerr );
 	return trader;
 }
 
@@ -9,7 +9,7 @@ namespace fx
 
 struct ITrader;
 
-ITrader* createTrader( const account_key_t& key );
+ITrader* createTrader( const account_key_t& key, std::ostream* cerr );
 
 } // namespace fx
 
@@ -0,0 +1,273 @@
+// author: Darek Slusarczyk alias marines marinesovitch 2012-2013, 2022
+#include "ph.h"
+#include "trailingStopsImpl.h"
+#include "trailingStops.h"
+#include "strategyHost.h"
+#include "common/command.h"
+#include "common/order.h"
+#include <string_view>
+
+namespace fx
+{
+
+namespace
+{
+
+// the key is the level at which a rule triggers: the bid for buys and the
+// negated ask for sells, so both are triggered by the levels above the key
+typedef std::multimap<price_t, int32_t> triggers_t;
+
+struct SSymbolRules
+{
+	triggers_t m_buys;
+	triggers_t m_sells;
+};
+
+struct SRule
+{
+	STrailingRule m_rule;
+	SSymbolRules* m_symbolRules = nullptr;
+	triggers_t::iterator m_trigger;
+};
+
+// ---------------------------------------------------------------------------
+
+class KTrailingStops : public ITrailingStops
+{
+	public:
+		KTrailingStops(IStrategyHost* host);
+
+	public:
+		// ITrailingStops
+		virtual bool addRule(
+			const SOrder& order,
+			const price_t distance,
+			const price_t step,
+			std::string* error);
+		virtual bool removeRule(const ticket_t ticket);
+		virtual void getRules(std::vector<STrailingRule>* rules) const;
+
+		virtual void onTick(const STick& tick);
+		virtual void onOrder(const SOrder& order);
+
+		virtual STrailingStats getStats() const;
+
+	private:
+		// must be called with locked m_mutex
+		void trigger(triggers_t* triggers, const price_t level, const STick& tick, std::vector<HCommand>* commands);
+		void insertTrigger(SRule* rule);
+		void eraseTrigger(SRule* rule);
+		void eraseRule(std::map<int32_t, SRule>::iterator it);
+
+	private:
+		IStrategyHost& m_host;
+
+		mutable std::mutex m_mutex;
+		std::map<int32_t, SRule> m_ticket2rule;
+		std::map<std::string, SSymbolRules, std::less<>> m_symbol2rules;
+
+		STrailingStats m_stats;
+
+};
+
+// ---------------------------------------------------------------------------
+
+KTrailingStops::KTrailingStops(IStrategyHost* host)
+	: m_host(*host)
+{
+}
+
+// ---------------------------------------------------------------------------
+// ITrailingStops
+
+bool KTrailingStops::addRule(
+	const SOrder& order,
+	const price_t distance,
+	const price_t step,
+	std::string* error)
+{
+	if ((order.m_status != SOrder::Open) || ((order.m_type != SOrder::Buy) && (order.m_type != SOrder::Sell)))
+	{
+		*error = "order " + std::to_string(order.m_ticket) + " is not an open buy or sell";
+		return false;
+	}
+
+	if ((distance <= 0) || (step < 0))
+	{
+		*error = "incorrect distance or step";
+		return false;
+	}
+
+	std::lock_guard<std::mutex> lock(m_mutex);
+	auto it = m_ticket2rule.find(order.m_ticket);
+	if (it != m_ticket2rule.end())
+	{
+		eraseRule(it);
+	}
+
+	auto symbolIt = m_symbol2rules.find(std::string_view(order.m_symbolName));
+	if (symbolIt == m_symbol2rules.end())
+	{
+		symbolIt = m_symbol2rules.emplace(std::string(order.m_symbolName), SSymbolRules()).first;
+	}
+
+	SRule& rule = m_ticket2rule[order.m_ticket];
+	rule.m_rule.m_ticket = order.m_ticket;
+	rule.m_rule.m_symbol = order.m_symbolName;
+	rule.m_rule.m_buy = (order.m_type == SOrder::Buy);
+	rule.m_rule.m_distance = distance;
+	rule.m_rule.m_step = (step != 0) ? step : (distance / 10);
+	rule.m_rule.m_stopLoss = order.m_stopLoss.m_value;
+	rule.m_symbolRules = &symbolIt->second;
+	insertTrigger(&rule);
+	m_stats.m_ruleCount = m_ticket2rule.size();
+	return true;
+}
+
+bool KTrailingStops::removeRule(const ticket_t ticket)
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+	auto it = m_ticket2rule.find(ticket);
+	if (it == m_ticket2rule.end())
+	{
+		return false;
+	}
+
+	eraseRule(it);
+	return true;
+}
+
+void KTrailingStops::getRules(std::vector<STrailingRule>* rules) const
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+	for (const auto& ticket2rule : m_ticket2rule)
+	{
+		rules->push_back(ticket2rule.second.m_rule);
+	}
+}
+
+void KTrailingStops::onTick(const STick& tick)
+{
+	// the commands are sent without the lock, the vector allocates only if
+	// a stop moves
+	std::vector<HCommand> commands;
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		auto it = m_symbol2rules.find(std::string_view(tick.m_symbolName));
+		if (it == m_symbol2rules.end())
+		{
+			return;
+		}
+
+		++m_stats.m_tickCount;
+		SSymbolRules& symbolRules = it->second;
+		trigger(&symbolRules.m_buys, tick.m_bid.m_value, tick, &commands);
+		trigger(&symbolRules.m_sells, -tick.m_ask.m_value, tick, &commands);
+	}
+
+	for (HCommand command : commands)
+	{
+		m_host.executeCommand(command);
+	}
+}
+
+void KTrailingStops::onOrder(const SOrder& order)
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+	auto it = m_ticket2rule.find(order.m_ticket);
+	if (it == m_ticket2rule.end())
+	{
+		return;
+	}
+
+	if (order.m_status != SOrder::Open)
+	{
+		eraseRule(it);
+		return;
+	}
+
+	// the stop loss set by the user or confirmed by MetaTrader, a stale
+	// confirmation of an older command doesn't move the stop back
+	SRule& rule = it->second;
+	const price_t stopLoss = order.m_stopLoss.m_value;
+	const price_t current = rule.m_rule.m_stopLoss;
+	const bool moved = (stopLoss != 0) && ((current == 0) || (rule.m_rule.m_buy ? (current < stopLoss) : (stopLoss < current)));
+	if (moved)
+	{
+		eraseTrigger(&rule);
+		rule.m_rule.m_stopLoss = stopLoss;
+		insertTrigger(&rule);
+	}
+}
+
+STrailingStats KTrailingStops::getStats() const
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+	return m_stats;
+}
+
+// ---------------------------------------------------------------------------
+
+void KTrailingStops::trigger(triggers_t* triggers, const price_t level, const STick& tick, std::vector<HCommand>* commands)
+{
+	// the new trigger of a moved rule is a step above the level, so the loop
+	// visits each rule at most once
+	while (!triggers->empty() && (triggers->begin()->first <= level))
+	{
+		SRule& rule = m_ticket2rule.find(triggers->begin()->second)->second;
+		triggers->erase(triggers->begin());
+
+		STrailingRule& trailingRule = rule.m_rule;
+		trailingRule.m_stopLoss = trailingRule.m_buy
+			? (tick.m_bid.m_value - trailingRule.m_distance)
+			: (tick.m_ask.m_value + trailingRule.m_distance);
+		insertTrigger(&rule);
+
+		tickets_t tickets(1, trailingRule.m_ticket);
+		commands->push_back(std::make_shared<KCmdSetStopLoss>(SPrice(trailingRule.m_stopLoss), tickets));
+		++m_stats.m_triggerCount;
+	}
+}
+
+void KTrailingStops::insertTrigger(SRule* rule)
+{
+	const STrailingRule& trailingRule = rule->m_rule;
+	const price_t stopLoss = trailingRule.m_stopLoss;
+	// without a stop loss the rule triggers on the next tick
+	price_t key = std::numeric_limits<price_t>::lowest();
+	if (stopLoss != 0)
+	{
+		// the price at which the stop would move by the step
+		key = trailingRule.m_buy
+			? (stopLoss + trailingRule.m_step + trailingRule.m_distance)
+			: -(stopLoss - trailingRule.m_step - trailingRule.m_distance);
+	}
+
+	triggers_t& triggers = trailingRule.m_buy ? rule->m_symbolRules->m_buys : rule->m_symbolRules->m_sells;
+	rule->m_trigger = triggers.emplace(key, trailingRule.m_ticket);
+}
+
+void KTrailingStops::eraseTrigger(SRule* rule)
+{
+	triggers_t& triggers = rule->m_rule.m_buy ? rule->m_symbolRules->m_buys : rule->m_symbolRules->m_sells;
+	triggers.erase(rule->m_trigger);
+}
+
+void KTrailingStops::eraseRule(std::map<int32_t, SRule>::iterator it)
+{
+	eraseTrigger(&it->second);
+	m_ticket2rule.erase(it);
+	m_stats.m_ruleCount = m_ticket2rule.size();
+}
+
+} // anonymous namespace
+
+// ---------------------------------------------------------------------------
+
+ITrailingStops* createTrailingStops(IStrategyHost* host)
+{
+	ITrailingStops* trailingStops = new KTrailingStops(host);
+	return trailingStops;
+}
+
+} // namespace fx
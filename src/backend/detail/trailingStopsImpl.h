@@ -0,0 +1,16 @@
+// author: Darek Slusarczyk alias marines marinesovitch 2012-2013, 2022
+#ifndef INC_BACKEND_TRAILINGSTOPSIMPL_H
+#define INC_BACKEND_TRAILINGSTOPSIMPL_H
+
+namespace fx
+{
+
+struct ITrailingStops;
+struct IStrategyHost;
+
+// the commands are sent through the host, like the ones of strategies
+ITrailingStops* createTrailingStops(IStrategyHost* host);
+
+} // namespace fx
+
+#endif
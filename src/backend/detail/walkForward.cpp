@@ -0,0 +1,113 @@
+// author: Darek Slusarczyk alias marines marinesovitch 2012-2013, 2022
+#include "ph.h"
+#include "walkForward.h"
+
+namespace fx
+{
+
+namespace
+{
+
+std::string formatTime(const datetime_t time)
+{
+	const std::time_t rawTime = static_cast<std::time_t>(time);
+	const std::tm* tm = std::gmtime(&rawTime);
+	std::ostringstream os;
+	if (tm != nullptr)
+	{
+		os << std::put_time(tm, "%Y.%m.%d %H:%M");
+	}
+	else
+	{
+		os << time;
+	}
+	return os.str();
+}
+
+volume_t netProfit(const SOptimizerResult& result)
+{
+	const volume_t profit = result.m_report.m_finalBalance - result.m_report.m_initialBalance;
+	return profit;
+}
+
+} // anonymous namespace
+
+// ---------------------------------------------------------------------------
+
+void SWalkForwardReport::print(std::ostream& os) const
+{
+	const double seconds = std::max(m_seconds, 0.001);
+	os << m_strategy << ' ' << m_symbol << ", " << m_windows.size() << " windows, "
+		<< m_runCount << " runs in " << std::fixed << std::setprecision(2) << seconds << "s ("
+		<< std::setprecision(1) << (m_runCount / seconds) << " runs/s) on "
+		<< m_threadCount << " threads, optimized for " << optimizer::name(m_metric) << '\n';
+
+	for (const SWalkForwardWindow& window : m_windows)
+	{
+		os << formatTime(window.m_inSampleFrom) << " - " << formatTime(window.m_outOfSampleFrom)
+			<< " - " << formatTime(window.m_outOfSampleTo) << ": ";
+		if (!window.m_inSample.m_error.empty())
+		{
+			os << "no parameters: " << window.m_inSample.m_error << '\n';
+			continue;
+		}
+
+		os << std::setprecision(2) << "in sample " << netProfit(window.m_inSample);
+		if (window.m_outOfSample.m_error.empty())
+		{
+			const SBacktestReport& report = window.m_outOfSample.m_report;
+			os << ", out of sample " << netProfit(window.m_outOfSample)
+				<< ", trades " << (report.m_winCount + report.m_lossCount)
+				<< ", drawdown " << report.m_maxDrawdown;
+		}
+		else
+		{
+			os << ", out of sample error: " << window.m_outOfSample.m_error;
+		}
+		os << " | " << window.m_inSample.m_strategyCmdLine << '\n';
+	}
+
+	os << "in sample profit " << m_inSampleProfit
+		<< ", out of sample profit " << m_outOfSampleProfit
+		<< " in " << m_outOfSampleTradeCount << " trades"
+		<< ", efficiency " << m_efficiency
+		<< std::defaultfloat << '\n';
+
+	if (m_monteCarlo.m_runCount != 0)
+	{
+		m_monteCarlo.print(os);
+	}
+	os << std::flush;
+}
+
+void SWalkForwardReport::save(const std::string& path) const
+{
+	std::ofstream os(path, std::ios::trunc);
+	if (!os)
+	{
+		throw std::runtime_error("cannot create file " + path);
+	}
+
+	os << std::setprecision(10);
+	os << "in sample from,out of sample from,out of sample to,parameters,in sample score,in sample profit,"
+		"out of sample score,out of sample profit,trades,max drawdown,error\n";
+	for (const SWalkForwardWindow& window : m_windows)
+	{
+		const SBacktestReport& report = window.m_outOfSample.m_report;
+		const std::string& error = window.m_inSample.m_error.empty() ? window.m_outOfSample.m_error : window.m_inSample.m_error;
+		os << formatTime(window.m_inSampleFrom) << ',' << formatTime(window.m_outOfSampleFrom)
+			<< ',' << formatTime(window.m_outOfSampleTo)
+			<< ",\"" << window.m_inSample.m_strategyCmdLine << '"'
+			<< ',' << window.m_inSample.m_score << ',' << netProfit(window.m_inSample)
+			<< ',' << window.m_outOfSample.m_score << ',' << netProfit(window.m_outOfSample)
+			<< ',' << (report.m_winCount + report.m_lossCount) << ',' << report.m_maxDrawdown
+			<< ",\"" << error << "\"\n";
+	}
+
+	if (!os)
+	{
+		throw std::runtime_error("cannot write file " + path);
+	}
+}
+
+} // namespace fx
@@ -0,0 +1,218 @@
+// author: Darek Slusarczyk alias marines marinesovitch 2012-2013, 2022
+#include "ph.h"
+#include "walkForwardImpl.h"
+#include "monteCarloImpl.h"
+#include "optimizerImpl.h"
+#include "tickFeed.h"
+#include "cpp/workStealingPool.h"
+#include <chrono>
+
+namespace fx
+{
+
+namespace
+{
+
+const datetime_t Day = 24 * 60 * 60;
+
+class KWalkForward
+{
+	public:
+		KWalkForward(
+			const ITickFeed& feed,
+			ITradingStrategyFactory* factory,
+			const std::string& strategyName,
+			const SWalkForwardParams& params);
+
+	public:
+		SWalkForwardReport run(const std::string& cmdLineTemplate);
+
+	private:
+		void makeWindows();
+		void optimizeInSample(const cpp::strings_t& cmdLines);
+		void runOutOfSample();
+		void summarize();
+
+	private:
+		const ITickFeed& m_feed;
+		ITradingStrategyFactory* m_factory;
+		const std::string m_strategyName;
+		const SWalkForwardParams m_params;
+
+		cpp::KWorkStealingPool m_pool;
+		SWalkForwardReport m_report;
+
+};
+
+// ---------------------------------------------------------------------------
+
+KWalkForward::KWalkForward(
+	const ITickFeed& feed,
+	ITradingStrategyFactory* factory,
+	const std::string& strategyName,
+	const SWalkForwardParams& params)
+	: m_feed(feed)
+	, m_factory(factory)
+	, m_strategyName(strategyName)
+	, m_params(params)
+	, m_pool(params.m_optimizer.m_threadCount)
+{
+}
+
+SWalkForwardReport KWalkForward::run(const std::string& cmdLineTemplate)
+{
+	const auto start = std::chrono::steady_clock::now();
+	m_report.m_symbol = m_feed.getSymbol();
+	m_report.m_strategy = m_strategyName;
+	m_report.m_metric = m_params.m_optimizer.m_metric;
+	m_report.m_threadCount = m_pool.size();
+
+	makeWindows();
+	optimizeInSample(sampleStrategyCmdLines(cmdLineTemplate, m_params.m_optimizer));
+	runOutOfSample();
+	summarize();
+
+	m_report.m_seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+	return m_report;
+}
+
+// ---------------------------------------------------------------------------
+
+void KWalkForward::makeWindows()
+{
+	if ((m_params.m_inSample <= 0) || (m_params.m_outOfSample <= 0))
+	{
+		throw std::invalid_argument("incorrect length of windows");
+	}
+
+	const datetime_t firstDay = m_feed.getFirstTime() / Day * Day;
+	const datetime_t lastTime = m_feed.getLastTime();
+	for (datetime_t shift = 0; ; shift += m_params.m_outOfSample)
+	{
+		SWalkForwardWindow window;
+		window.m_inSampleFrom = m_params.m_anchored ? firstDay : firstDay + shift;
+		window.m_outOfSampleFrom = firstDay + m_params.m_inSample + shift;
+		window.m_outOfSampleTo = window.m_outOfSampleFrom + m_params.m_outOfSample;
+		if (lastTime < window.m_outOfSampleFrom)
+		{
+			break;
+		}
+		m_report.m_windows.push_back(window);
+	}
+
+	if (m_report.m_windows.empty())
+	{
+		throw std::invalid_argument("the ticks are shorter than the in-sample window");
+	}
+}
+
+void KWalkForward::optimizeInSample(const cpp::strings_t& cmdLines)
+{
+	// the runs of all the windows are scheduled at once, so the pool isn't
+	// drained at the end of each window
+	const std::size_t setCount = cmdLines.size();
+	if (setCount == 0)
+	{
+		throw std::invalid_argument("no parameter sets");
+	}
+
+	std::vector<SOptimizerResult> results(m_report.m_windows.size() * setCount);
+	m_pool.run(results.size(), [&](const std::size_t index, const unsigned int /*worker*/)
+	{
+		const SWalkForwardWindow& window = m_report.m_windows[index / setCount];
+		SBacktestParams params = m_params.m_optimizer.m_backtest;
+		params.m_from = window.m_inSampleFrom;
+		params.m_to = window.m_outOfSampleFrom;
+
+		SOptimizerResult& result = results[index];
+		result.m_strategyCmdLine = cmdLines[index % setCount];
+		evaluateParameters(m_feed, m_factory, m_strategyName, params, m_params.m_optimizer.m_metric, &result);
+	});
+	m_report.m_runCount += results.size();
+
+	for (std::size_t w = 0; w < m_report.m_windows.size(); ++w)
+	{
+		std::vector<SOptimizerResult> windowResults(
+			std::make_move_iterator(results.begin() + w * setCount),
+			std::make_move_iterator(results.begin() + (w + 1) * setCount));
+		rankResults(&windowResults);
+		m_report.m_windows[w].m_inSample = std::move(windowResults.front());
+	}
+}
+
+void KWalkForward::runOutOfSample()
+{
+	std::atomic<std::size_t> runCount(0);
+	m_pool.run(m_report.m_windows.size(), [&](const std::size_t index, const unsigned int /*worker*/)
+	{
+		SWalkForwardWindow& window = m_report.m_windows[index];
+		if (!window.m_inSample.m_error.empty())
+		{
+			return;
+		}
+
+		SBacktestParams params = m_params.m_optimizer.m_backtest;
+		params.m_details = true;
+		params.m_from = window.m_outOfSampleFrom;
+		params.m_to = window.m_outOfSampleTo;
+		window.m_outOfSample.m_strategyCmdLine = window.m_inSample.m_strategyCmdLine;
+		evaluateParameters(m_feed, m_factory, m_strategyName, params, m_params.m_optimizer.m_metric, &window.m_outOfSample);
+		++runCount;
+	});
+	m_report.m_runCount += runCount;
+}
+
+void KWalkForward::summarize()
+{
+	std::vector<volume_t> tradeProfits;
+	datetime_t inSampleTime = 0;
+	datetime_t outOfSampleTime = 0;
+	for (const SWalkForwardWindow& window : m_report.m_windows)
+	{
+		if (!window.m_inSample.m_error.empty() || !window.m_outOfSample.m_error.empty())
+		{
+			continue;
+		}
+
+		const SBacktestReport& inSample = window.m_inSample.m_report;
+		m_report.m_inSampleProfit += inSample.m_finalBalance - inSample.m_initialBalance;
+		inSampleTime += window.m_outOfSampleFrom - window.m_inSampleFrom;
+
+		const SBacktestReport& outOfSample = window.m_outOfSample.m_report;
+		m_report.m_outOfSampleProfit += outOfSample.m_finalBalance - outOfSample.m_initialBalance;
+		outOfSampleTime += window.m_outOfSampleTo - window.m_outOfSampleFrom;
+		for (const SOrder& trade : outOfSample.m_trades)
+		{
+			tradeProfits.push_back(SBacktestReport::netProfit(trade));
+		}
+	}
+	m_report.m_outOfSampleTradeCount = tradeProfits.size();
+
+	if ((0 < inSampleTime) && (0 < outOfSampleTime) && (0.0 < m_report.m_inSampleProfit))
+	{
+		const double inSampleRate = m_report.m_inSampleProfit / inSampleTime;
+		const double outOfSampleRate = m_report.m_outOfSampleProfit / outOfSampleTime;
+		m_report.m_efficiency = outOfSampleRate / inSampleRate;
+	}
+
+	m_report.m_monteCarlo = runMonteCarlo(
+		tradeProfits, m_params.m_optimizer.m_backtest.m_initialBalance, m_params.m_monteCarlo, &m_pool);
+}
+
+} // anonymous namespace
+
+// ---------------------------------------------------------------------------
+
+SWalkForwardReport runWalkForward(
+	const ITickFeed& feed,
+	ITradingStrategyFactory* factory,
+	const std::string& strategyName,
+	const std::string& cmdLineTemplate,
+	const SWalkForwardParams& params)
+{
+	KWalkForward walkForward(feed, factory, strategyName, params);
+	const SWalkForwardReport& report = walkForward.run(cmdLineTemplate);
+	return report;
+}
+
+} // namespace fx
@@ -0,0 +1,27 @@
+// author: Darek Slusarczyk alias marines marinesovitch 2012-2013, 2022
+#ifndef INC_BACKEND_WALKFORWARDIMPL_H
+#define INC_BACKEND_WALKFORWARDIMPL_H
+
+#include "walkForward.h"
+
+namespace fx
+{
+
+struct ITickFeed;
+struct ITradingStrategyFactory;
+
+// optimizes the parameters (see runOptimization) in each in-sample window
+// and runs the best ones in the following out-of-sample window; the
+// optimizations of all the windows run in parallel, then the out-of-sample
+// backtests, and then the monte carlo simulation of their trades; throws
+// std::invalid_argument if the feed is shorter than a pair of windows
+SWalkForwardReport runWalkForward(
+	const ITickFeed& feed,
+	ITradingStrategyFactory* factory,
+	const std::string& strategyName,
+	const std::string& cmdLineTemplate,
+	const SWalkForwardParams& params);
+
+} // namespace fx
+
+#endif
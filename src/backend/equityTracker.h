@@ -0,0 +1,71 @@
+// author: Darek Slusarczyk alias marines marinesovitch 2012-2013, 2022
+#ifndef INC_BACKEND_EQUITYTRACKER_H
+#define INC_BACKEND_EQUITYTRACKER_H
+
+#include "common/baseTypes.h"
+
+namespace fx
+{
+
+struct SAccountPosition;
+
+// the profit of an account since the backend connected to it; MetaTrader
+// doesn't send the balance, so the equity is the realized and unrealized
+// profit of the orders of the session, in the account currency like the
+// totals of the position engine it is built on
+struct SEquitySnapshot
+{
+	datetime_t m_time = 0;
+	volume_t m_realizedProfit = 0;
+	volume_t m_unrealizedProfit = 0;
+	volume_t m_equity = 0;
+	// the highest equity so far and how far below it the equity is
+	volume_t m_peakEquity = 0;
+	volume_t m_drawdown = 0;
+	std::size_t m_openCount = 0;
+};
+
+// ---------------------------------------------------------------------------
+
+struct SEquityStats
+{
+	public:
+		void print(std::ostream& os) const;
+
+	public:
+		SEquitySnapshot m_current;
+		volume_t m_maxDrawdown = 0;
+		datetime_t m_maxDrawdownTime = 0;
+		uint64_t m_updateCount = 0;
+		uint64_t m_snapshotCount = 0;
+
+};
+
+// ---------------------------------------------------------------------------
+
+// follows the equity of an account on every tick and order update, each
+// update is O(1), it gets the totals of the position engine which has
+// already revalued only the symbol of the tick; the drawdown is checked on
+// every update, but the snapshots are kept in the history at most once per
+// interval of tick time, the oldest ones are overwritten
+struct IEquityTracker
+{
+	public:
+		virtual ~IEquityTracker();
+
+	public:
+		// the tick loop passes the time of the tick, the order loop uses the
+		// time of the last tick; an account older than the last one seen
+		// (by its version) is ignored, so the loops may race
+		virtual void onTick(const datetime_t time, const SAccountPosition& account) = 0;
+		virtual void onOrder(const SAccountPosition& account) = 0;
+
+		virtual SEquityStats getStats() const = 0;
+		// the newest count snapshots from the oldest one, returns their count
+		virtual std::size_t getHistory(const std::size_t count, std::vector<SEquitySnapshot>* history) const = 0;
+
+};
+
+} // namespace fx
+
+#endif
@@ -0,0 +1,107 @@
+// author: Darek Slusarczyk alias marines marinesovitch 2012-2013, 2022
+#ifndef INC_BACKEND_EXECUTIONALGOS_H
+#define INC_BACKEND_EXECUTIONALGOS_H
+
+#include "common/order.h"
+
+namespace fx
+{
+
+class KCommand;
+struct STick;
+
+// a parent order executed as market child orders over the given duration;
+// the children are sent at the ends of equal slices of it: TWAP sends the
+// same lots in each slice, VWAP sizes them by the ticks of the symbol seen
+// in the slice against the tick rate observed so far, so more goes out when
+// the market is active; the ticks stand for the volume, MetaTrader gives no
+// volume of the forex quotes
+struct SAlgoParams
+{
+	public:
+		enum EKind
+		{
+			Twap,
+			Vwap
+		};
+
+	public:
+		EKind m_kind = Twap;
+		// a buy or sell, its stop loss and take profit go to every child
+		SNewOrder m_order;
+		// in seconds
+		datetime_t m_duration = 0;
+		std::size_t m_sliceCount = 0;
+
+};
+
+// ---------------------------------------------------------------------------
+
+// the progress of a parent order, it is also its fill report: the children
+// reported by MetaTrader are aggregated into the filled lots and the average
+// price
+struct SAlgoReport
+{
+	public:
+		enum EState
+		{
+			Running,
+			Done,
+			Cancelled
+		};
+
+	public:
+		void print(std::ostream& os) const;
+
+	public:
+		uint32_t m_id = 0;
+		SAlgoParams m_params;
+		EState m_state = Running;
+
+		std::size_t m_sliceIndex = 0;
+		std::size_t m_childCount = 0;
+		std::size_t m_filledCount = 0;
+		// refused by the risk limits or rejected by MetaTrader
+		std::size_t m_failedCount = 0;
+		volume_t m_sentLots = 0;
+		volume_t m_filledLots = 0;
+		price_t m_averagePrice = 0;
+		tickets_t m_tickets;
+		// since the start, until now or the end
+		double m_seconds = 0.0;
+
+};
+
+// ---------------------------------------------------------------------------
+
+// the execution algorithms of an account, the slices are scheduled on a
+// timer wheel driven by a thread of the engine, the children are sent
+// through the host like the commands of the strategies; the orders opened by
+// the children are recognized as the first new orders of the same symbol,
+// type and lots, so an equal manual order opened at the same time may be
+// taken for a child
+struct IExecutionAlgos
+{
+	public:
+		virtual ~IExecutionAlgos();
+
+	public:
+		// returns the id of the parent order, or 0 with the reason
+		virtual uint32_t start(const SAlgoParams& params, std::string* error) = 0;
+		// the slices not sent yet are dropped, the children sent are still
+		// aggregated
+		virtual bool cancel(const uint32_t id) = 0;
+		// sorted by id, including the finished ones
+		virtual void getReports(std::vector<SAlgoReport>* reports) const = 0;
+
+		virtual void onTick(const STick& tick) = 0;
+		virtual void onOrder(const SOrder& order) = 0;
+		// the result of a command executed by MetaTrader, a rejected child
+		// is not waited for anymore
+		virtual void onCmdResult(const KCommand& command, const bool success) = 0;
+
+};
+
+} // namespace fx
+
+#endif
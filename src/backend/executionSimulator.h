@@ -0,0 +1,69 @@
+// author: Darek Slusarczyk alias marines marinesovitch 2012-2013, 2022
+#ifndef INC_BACKEND_EXECUTIONSIMULATOR_H
+#define INC_BACKEND_EXECUTIONSIMULATOR_H
+
+#include "common/smartTypes.h"
+#include "common/baseTypes.h"
+
+namespace fx
+{
+
+struct STick;
+struct SOrder;
+
+struct SExecutionParams
+{
+	// the minimal spread, the ask of ticks with a narrower spread (or without
+	// ask, like the ones made of bars) is moved to bid + spread
+	price_t m_spread = 0;
+	// the adverse shift of price of market orders, stop orders and stop losses
+	price_t m_slippage = 0;
+	// the delay of commands in seconds, a command is executed by the first
+	// tick not earlier than the time of the tick it was sent at plus latency,
+	// so even with no latency it is executed by the next tick
+	datetime_t m_latency = 0;
+	// the profit of an order is (close - open) * lots * contract size
+	volume_t m_contractSize = 100000;
+	// charged per lot when an order is closed
+	volume_t m_commission = 0;
+};
+
+// ---------------------------------------------------------------------------
+
+struct IExecutionSink
+{
+	// every change of an order: opened, filled, modified and closed; a get
+	// of all the orders ends with SOrder::makeDumpEnd like in MetaTrader
+	virtual void onOrder(const SOrder& order) = 0;
+	// the result of every executed command, like the one of MetaTrader:
+	// consts::CmdResultSuccess or the reasons of the rejection
+	virtual void onCmdResult(HCommand command, const std::string& output) = 0;
+};
+
+// ---------------------------------------------------------------------------
+
+// the execution model of a MetaTrader account driven by ticks, it accepts the
+// same commands as the connection and reports the orders the same way, it
+// is not synchronized
+struct IExecutionSimulator
+{
+	public:
+		virtual ~IExecutionSimulator();
+
+	public:
+		virtual void sendCommand(HCommand command) = 0;
+
+		// executes the due commands, then fills the pending orders and
+		// closes the ones which hit the stop loss or take profit
+		virtual void onTick(const STick& tick) = 0;
+
+		virtual volume_t getBalance() const = 0;
+		// the balance with the floating profit of open orders
+		virtual volume_t getEquity() const = 0;
+		virtual std::size_t getOrderCount() const = 0;
+
+};
+
+} // namespace fx
+
+#endif
@@ -0,0 +1,71 @@
+// author: Darek Slusarczyk alias marines marinesovitch 2012-2013, 2022
+#ifndef INC_BACKEND_HISTORY_H
+#define INC_BACKEND_HISTORY_H
+
+#include "common/baseTypes.h"
+
+namespace fx
+{
+
+namespace history
+{
+
+enum EKind
+{
+	Ticks = 1,
+	Bars
+};
+
+// the columns besides time, all of them are doubles
+enum ETickColumn
+{
+	Bid,
+	Ask,
+	Last,
+	TickColumnCount
+};
+
+enum EBarColumn
+{
+	Open,
+	High,
+	Low,
+	Close,
+	Volume,
+	BarColumnCount
+};
+
+const int MaxColumnCount = BarColumnCount;
+
+} // namespace history
+
+// ---------------------------------------------------------------------------
+
+// the imported history of a symbol mapped for reading, each column is an
+// array of values, the rows are sorted the same way as in the source file
+struct IHistory
+{
+	public:
+		virtual ~IHistory();
+
+	public:
+		virtual const std::string& getSymbol() const = 0;
+		virtual history::EKind getKind() const = 0;
+		// the period of bars in seconds, 0 for ticks
+		virtual datetime_t getPeriod() const = 0;
+
+		virtual std::size_t size() const = 0;
+		virtual const datetime_t* getTimes() const = 0;
+		// history::ETickColumn or history::EBarColumn
+		virtual const double* getColumn(const int column) const = 0;
+
+		// the first row not earlier than the given time
+		virtual std::size_t lowerBound(const datetime_t time) const = 0;
+
+};
+
+typedef std::shared_ptr<IHistory> HHistory;
+
+} // namespace fx
+
+#endif
@@ -0,0 +1,53 @@
+// author: Darek Slusarczyk alias marines marinesovitch 2012-2013, 2022
+#ifndef INC_BACKEND_INDICATORBATCH_H
+#define INC_BACKEND_INDICATORBATCH_H
+
+#include "common/baseTypes.h"
+
+namespace fx
+{
+
+// the indicators of indicators.h over whole columns, e.g. of IHistory, for
+// backtests and warm-up; they follow the definitions of the streaming ones
+// but sum in a different order, so the values may differ in the last bits;
+// the outputs have the size of the inputs and are NaN until the indicator is
+// ready; the scans run on AVX2 if the processor has it, else on a scalar
+// fallback
+namespace indicator
+{
+
+void sma(const double* input, const std::size_t size, const std::size_t period, double* output);
+void ema(const double* input, const std::size_t size, const std::size_t period, double* output);
+void rsi(const double* input, const std::size_t size, const std::size_t period, double* output);
+void atr(
+	const double* high,
+	const double* low,
+	const double* close,
+	const std::size_t size,
+	const std::size_t period,
+	double* output);
+void bollinger(
+	const double* input,
+	const std::size_t size,
+	const std::size_t period,
+	const double deviations,
+	double* middle,
+	double* upper,
+	double* lower);
+// the sessions start at multiples of sessionLength
+void vwap(
+	const datetime_t* times,
+	const double* price,
+	const double* volume,
+	const std::size_t size,
+	const datetime_t sessionLength,
+	double* output);
+
+// whether the AVX2 kernels were chosen
+bool isAvx2Used();
+
+} // namespace indicator
+
+} // namespace fx
+
+#endif
@@ -0,0 +1,594 @@
+// author: Darek Slusarczyk alias marines marinesovitch 2012-2013, 2022
+#ifndef INC_BACKEND_INDICATORS_H
+#define INC_BACKEND_INDICATORS_H
+
+#include "bar.h"
+#include <array>
+#include <cmath>
+
+namespace fx
+{
+
+// streaming indicators for strategies: each update takes O(1) and the state
+// has a fixed size, so they may be fed from onTick (e.g. with the bid) as
+// well as from onBar; all of them have
+//     bool update(...) - returns isReady()
+//     TValue value() const - valid once ready
+//     bool isReady() const
+//     void reset()
+// so they may be chained with KChain; the indicators over a window keep at
+// most MaxPeriod values in place, so they never allocate; the batch variants
+// for whole columns are in indicatorBatch.h
+
+template<typename TValue, std::size_t MaxPeriod = 256>
+class KSma
+{
+	public:
+		typedef TValue value_t;
+
+		explicit KSma(const std::size_t period)
+			: m_period(period)
+		{
+			if ((period == 0) || (MaxPeriod < period))
+			{
+				throw std::invalid_argument("incorrect period of sma");
+			}
+			reset();
+		}
+
+		bool update(const TValue input)
+		{
+			if (m_count == m_period)
+			{
+				m_sum -= m_window[m_position];
+			}
+			else
+			{
+				++m_count;
+			}
+			m_window[m_position] = input;
+			m_sum += input;
+
+			if (++m_position == m_period)
+			{
+				m_position = 0;
+				// the exact sum once per period, so the rounding errors of the
+				// running sum don't add up
+				if (m_count == m_period)
+				{
+					m_sum = TValue();
+					for (std::size_t i = 0; i < m_period; ++i)
+					{
+						m_sum += m_window[i];
+					}
+				}
+			}
+			return isReady();
+		}
+
+		TValue value() const
+		{
+			return m_sum / static_cast<TValue>(m_period);
+		}
+
+		bool isReady() const
+		{
+			return m_count == m_period;
+		}
+
+		void reset()
+		{
+			m_sum = TValue();
+			m_position = 0;
+			m_count = 0;
+		}
+
+	private:
+		const std::size_t m_period;
+		std::array<TValue, MaxPeriod> m_window;
+		TValue m_sum;
+		std::size_t m_position;
+		std::size_t m_count;
+
+};
+
+// ---------------------------------------------------------------------------
+
+// the first value is the sma of the first period inputs
+template<typename TValue>
+class KEma
+{
+	public:
+		typedef TValue value_t;
+
+		explicit KEma(const std::size_t period)
+			: m_period(period)
+			, m_alpha(TValue(2) / static_cast<TValue>(period + 1))
+		{
+			if (period == 0)
+			{
+				throw std::invalid_argument("incorrect period of ema");
+			}
+			reset();
+		}
+
+		bool update(const TValue input)
+		{
+			if (m_count < m_period)
+			{
+				m_value += input;
+				if (++m_count == m_period)
+				{
+					m_value /= static_cast<TValue>(m_period);
+				}
+			}
+			else
+			{
+				m_value += m_alpha * (input - m_value);
+			}
+			return isReady();
+		}
+
+		TValue value() const
+		{
+			return m_value;
+		}
+
+		bool isReady() const
+		{
+			return m_count == m_period;
+		}
+
+		void reset()
+		{
+			m_value = TValue();
+			m_count = 0;
+		}
+
+	private:
+		const std::size_t m_period;
+		const TValue m_alpha;
+		TValue m_value;
+		std::size_t m_count;
+
+};
+
+// ---------------------------------------------------------------------------
+
+// the smoothing of Wilder: the first average is the mean of period inputs,
+// then avg = (avg * (period - 1) + input) / period; it is the base of rsi and
+// atr
+template<typename TValue>
+class KWilderAverage
+{
+	public:
+		typedef TValue value_t;
+
+		explicit KWilderAverage(const std::size_t period)
+			: m_period(period)
+		{
+			if (period == 0)
+			{
+				throw std::invalid_argument("incorrect period of wilder average");
+			}
+			reset();
+		}
+
+		bool update(const TValue input)
+		{
+			if (m_count < m_period)
+			{
+				m_value += input;
+				if (++m_count == m_period)
+				{
+					m_value /= static_cast<TValue>(m_period);
+				}
+			}
+			else
+			{
+				m_value += (input - m_value) / static_cast<TValue>(m_period);
+			}
+			return isReady();
+		}
+
+		TValue value() const
+		{
+			return m_value;
+		}
+
+		bool isReady() const
+		{
+			return m_count == m_period;
+		}
+
+		void reset()
+		{
+			m_value = TValue();
+			m_count = 0;
+		}
+
+	private:
+		const std::size_t m_period;
+		TValue m_value;
+		std::size_t m_count;
+
+};
+
+// ---------------------------------------------------------------------------
+
+// 0 - 100, ready after period changes of the input
+template<typename TValue>
+class KRsi
+{
+	public:
+		typedef TValue value_t;
+
+		explicit KRsi(const std::size_t period = 14)
+			: m_gain(period)
+			, m_loss(period)
+		{
+			reset();
+		}
+
+		bool update(const TValue input)
+		{
+			if (m_hasPrevious)
+			{
+				const TValue change = input - m_previous;
+				m_gain.update((TValue() < change) ? change : TValue());
+				m_loss.update((change < TValue()) ? -change : TValue());
+			}
+			m_previous = input;
+			m_hasPrevious = true;
+			return isReady();
+		}
+
+		TValue value() const
+		{
+			const TValue hundred = TValue(100);
+			const TValue loss = m_loss.value();
+			const TValue result = (loss == TValue()) ? hundred : hundred - hundred / (TValue(1) + m_gain.value() / loss);
+			return result;
+		}
+
+		bool isReady() const
+		{
+			return m_loss.isReady();
+		}
+
+		void reset()
+		{
+			m_gain.reset();
+			m_loss.reset();
+			m_previous = TValue();
+			m_hasPrevious = false;
+		}
+
+	private:
+		KWilderAverage<TValue> m_gain;
+		KWilderAverage<TValue> m_loss;
+		TValue m_previous;
+		bool m_hasPrevious;
+
+};
+
+// ---------------------------------------------------------------------------
+
+// the average true range, its input are bars or high, low and close
+template<typename TValue>
+class KAtr
+{
+	public:
+		typedef TValue value_t;
+
+		explicit KAtr(const std::size_t period = 14)
+			: m_average(period)
+		{
+			reset();
+		}
+
+		bool update(const TValue high, const TValue low, const TValue close)
+		{
+			TValue range = high - low;
+			if (m_hasPrevious)
+			{
+				range = std::max(range, std::max(std::abs(high - m_previousClose), std::abs(low - m_previousClose)));
+			}
+			m_previousClose = close;
+			m_hasPrevious = true;
+			return m_average.update(range);
+		}
+
+		bool update(const SBar& bar)
+		{
+			return update(
+				static_cast<TValue>(bar.m_high),
+				static_cast<TValue>(bar.m_low),
+				static_cast<TValue>(bar.m_close));
+		}
+
+		TValue value() const
+		{
+			return m_average.value();
+		}
+
+		bool isReady() const
+		{
+			return m_average.isReady();
+		}
+
+		void reset()
+		{
+			m_average.reset();
+			m_previousClose = TValue();
+			m_hasPrevious = false;
+		}
+
+	private:
+		KWilderAverage<TValue> m_average;
+		TValue m_previousClose;
+		bool m_hasPrevious;
+
+};
+
+// ---------------------------------------------------------------------------
+
+// the sma with bands of deviations standard deviations, value() is the
+// middle band
+template<typename TValue, std::size_t MaxPeriod = 256>
+class KBollinger
+{
+	public:
+		typedef TValue value_t;
+
+		explicit KBollinger(const std::size_t period = 20, const TValue deviations = TValue(2))
+			: m_period(period)
+			, m_deviations(deviations)
+		{
+			if ((period == 0) || (MaxPeriod < period))
+			{
+				throw std::invalid_argument("incorrect period of bollinger bands");
+			}
+			reset();
+		}
+
+		bool update(const TValue input)
+		{
+			// the sums are of the distances from a reference close to the
+			// values, so the variance doesn't drown in the rounding of squares
+			// of whole prices
+			if (m_count == 0)
+			{
+				m_reference = input;
+			}
+
+			const TValue shifted = input - m_reference;
+			if (m_count == m_period)
+			{
+				const TValue oldest = m_window[m_position] - m_reference;
+				m_sum -= oldest;
+				m_squareSum -= oldest * oldest;
+			}
+			else
+			{
+				++m_count;
+			}
+			m_window[m_position] = input;
+			m_sum += shifted;
+			m_squareSum += shifted * shifted;
+
+			if (++m_position == m_period)
+			{
+				m_position = 0;
+				if (m_count == m_period)
+				{
+					resync();
+				}
+			}
+			return isReady();
+		}
+
+		TValue value() const
+		{
+			return middle();
+		}
+
+		TValue middle() const
+		{
+			return m_reference + m_sum / static_cast<TValue>(m_period);
+		}
+
+		TValue deviation() const
+		{
+			const TValue count = static_cast<TValue>(m_period);
+			const TValue mean = m_sum / count;
+			const TValue variance = m_squareSum / count - mean * mean;
+			return (TValue() < variance) ? std::sqrt(variance) : TValue();
+		}
+
+		TValue upper() const
+		{
+			return middle() + m_deviations * deviation();
+		}
+
+		TValue lower() const
+		{
+			return middle() - m_deviations * deviation();
+		}
+
+		bool isReady() const
+		{
+			return m_count == m_period;
+		}
+
+		void reset()
+		{
+			m_reference = TValue();
+			m_sum = TValue();
+			m_squareSum = TValue();
+			m_position = 0;
+			m_count = 0;
+		}
+
+	private:
+		// the exact sums once per period around the current mean
+		void resync()
+		{
+			m_reference = middle();
+			m_sum = TValue();
+			m_squareSum = TValue();
+			for (std::size_t i = 0; i < m_period; ++i)
+			{
+				const TValue shifted = m_window[i] - m_reference;
+				m_sum += shifted;
+				m_squareSum += shifted * shifted;
+			}
+		}
+
+	private:
+		const std::size_t m_period;
+		const TValue m_deviations;
+		std::array<TValue, MaxPeriod> m_window;
+		TValue m_reference;
+		TValue m_sum;
+		TValue m_squareSum;
+		std::size_t m_position;
+		std::size_t m_count;
+
+};
+
+// ---------------------------------------------------------------------------
+
+// the volume weighted average price since the start of the session, the
+// sessions start at multiples of sessionLength (by default days)
+template<typename TValue>
+class KVwap
+{
+	public:
+		typedef TValue value_t;
+
+		explicit KVwap(const datetime_t sessionLength = 24 * 60 * 60)
+			: m_sessionLength(sessionLength)
+		{
+			if (sessionLength <= 0)
+			{
+				throw std::invalid_argument("incorrect session of vwap");
+			}
+			reset();
+		}
+
+		bool update(const datetime_t time, const TValue price, const TValue volume)
+		{
+			const datetime_t session = time / m_sessionLength;
+			if (session != m_session)
+			{
+				m_priceVolume = TValue();
+				m_volume = TValue();
+				m_session = session;
+			}
+			m_priceVolume += price * volume;
+			m_volume += volume;
+			return isReady();
+		}
+
+		// the typical price (high + low + close) / 3 weighted by the tick
+		// volume
+		bool update(const SBar& bar)
+		{
+			const TValue typicalPrice = static_cast<TValue>((bar.m_high + bar.m_low + bar.m_close) / 3);
+			return update(bar.m_openTime, typicalPrice, static_cast<TValue>(bar.m_tickVolume));
+		}
+
+		TValue value() const
+		{
+			return m_priceVolume / m_volume;
+		}
+
+		bool isReady() const
+		{
+			return TValue() < m_volume;
+		}
+
+		void reset()
+		{
+			m_priceVolume = TValue();
+			m_volume = TValue();
+			m_session = std::numeric_limits<datetime_t>::min();
+		}
+
+	private:
+		const datetime_t m_sessionLength;
+		TValue m_priceVolume;
+		TValue m_volume;
+		datetime_t m_session;
+
+};
+
+// ---------------------------------------------------------------------------
+
+// feeds the values of the first indicator into the second one, e.g.
+//     KChain<KRsi<double>, KEma<double>> smoothedRsi(KRsi<double>(14), KEma<double>(5));
+// the input is the one of the first indicator
+template<typename TFirst, typename TSecond>
+class KChain
+{
+	public:
+		typedef typename TSecond::value_t value_t;
+
+		KChain(const TFirst& first, const TSecond& second)
+			: m_first(first)
+			, m_second(second)
+		{
+		}
+
+		template<typename... TInputs>
+		bool update(const TInputs&... inputs)
+		{
+			if (m_first.update(inputs...))
+			{
+				m_second.update(m_first.value());
+			}
+			return isReady();
+		}
+
+		value_t value() const
+		{
+			return m_second.value();
+		}
+
+		bool isReady() const
+		{
+			return m_second.isReady();
+		}
+
+		void reset()
+		{
+			m_first.reset();
+			m_second.reset();
+		}
+
+		const TFirst& first() const
+		{
+			return m_first;
+		}
+
+		const TSecond& second() const
+		{
+			return m_second;
+		}
+
+	private:
+		TFirst m_first;
+		TSecond m_second;
+
+};
+
+template<typename TFirst, typename TSecond>
+KChain<TFirst, TSecond> chain(const TFirst& first, const TSecond& second)
+{
+	return KChain<TFirst, TSecond>(first, second);
+}
+
+} // namespace fx
+
+#endif
@@ -0,0 +1,73 @@
+// author: Darek Slusarczyk alias marines marinesovitch 2012-2013, 2022
+#ifndef INC_BACKEND_MONTECARLO_H
+#define INC_BACKEND_MONTECARLO_H
+
+#include "common/baseTypes.h"
+
+namespace fx
+{
+
+namespace montecarlo
+{
+
+// how the sequences of trades are made of the real one
+enum EMethod
+{
+	// the trades drawn with replacement, so both the profit and the drawdown
+	// vary
+	Bootstrap,
+	// the same trades in random order, so only the drawdown varies
+	Shuffle
+};
+
+bool parse(const std::string& name, EMethod* method);
+const std::string& name(const EMethod method);
+
+} // namespace montecarlo
+
+// ---------------------------------------------------------------------------
+
+struct SMonteCarloParams
+{
+	// 0 disables the simulation
+	std::size_t m_runCount = 1000;
+	montecarlo::EMethod m_method = montecarlo::Bootstrap;
+	uint64_t m_seed = 0;
+};
+
+// ---------------------------------------------------------------------------
+
+struct SMonteCarloDistribution
+{
+	double m_mean = 0;
+	double m_p5 = 0;
+	double m_p25 = 0;
+	double m_median = 0;
+	double m_p75 = 0;
+	double m_p95 = 0;
+};
+
+struct SMonteCarloReport
+{
+	public:
+		void print(std::ostream& os) const;
+
+	public:
+		montecarlo::EMethod m_method = montecarlo::Bootstrap;
+		std::size_t m_runCount = 0;
+		std::size_t m_tradeCount = 0;
+		volume_t m_initialBalance = 0;
+
+		SMonteCarloDistribution m_netProfit;
+		SMonteCarloDistribution m_maxDrawdown;
+		SMonteCarloDistribution m_maxDrawdownPercent;
+		// the share of runs which end with a loss
+		double m_lossProbability = 0;
+
+		double m_seconds = 0;
+
+};
+
+} // namespace fx
+
+#endif
@@ -0,0 +1,100 @@
+// author: Darek Slusarczyk alias marines marinesovitch 2012-2013, 2022
+#ifndef INC_BACKEND_OPTIMIZER_H
+#define INC_BACKEND_OPTIMIZER_H
+
+#include "backtest.h"
+
+namespace fx
+{
+
+namespace optimizer
+{
+
+// the results are ranked by the metric, the best first
+enum EMetric
+{
+	Profit,
+	ProfitFactor,
+	// the lowest max drawdown is the best
+	Drawdown,
+	// net profit / max drawdown
+	Recovery,
+	WinRate
+};
+
+bool parse(const std::string& name, EMetric* metric);
+const std::string& name(const EMetric metric);
+
+// how the parameter sets are chosen from the ranges
+enum ESampling
+{
+	// all the combinations
+	Grid,
+	// each value drawn independently
+	Random,
+	// the range of each parameter is split into as many strata as there are
+	// samples and each stratum is used exactly once
+	LatinHypercube
+};
+
+bool parse(const std::string& name, ESampling* sampling);
+
+} // namespace optimizer
+
+// ---------------------------------------------------------------------------
+
+struct SOptimizerParams
+{
+	SOptimizerParams();
+
+	SBacktestParams m_backtest;
+	optimizer::ESampling m_sampling = optimizer::Grid;
+	// the number of parameter sets for random and latin hypercube sampling
+	std::size_t m_sampleCount = 100;
+	uint64_t m_seed = 0;
+	optimizer::EMetric m_metric = optimizer::Profit;
+	// 0 means all the cores
+	unsigned int m_threadCount = 0;
+};
+
+// ---------------------------------------------------------------------------
+
+struct SOptimizerResult
+{
+	// the command the strategy got, i.e. its parameters
+	std::string m_strategyCmdLine;
+	// the summary only
+	SBacktestReport m_report;
+	double m_score = 0;
+	// not empty if the strategy refused the parameters, such results are
+	// ranked last
+	std::string m_error;
+};
+
+// ---------------------------------------------------------------------------
+
+struct SOptimizerReport
+{
+	public:
+		// the best count results and the totals
+		void printTop(std::ostream& os, const std::size_t count) const;
+		// all the results as csv, throws std::runtime_error
+		void save(const std::string& path) const;
+
+	public:
+		std::string m_symbol;
+		std::string m_strategy;
+		uint64_t m_tickCount = 0;
+		optimizer::EMetric m_metric = optimizer::Profit;
+
+		// sorted by score, the best first
+		std::vector<SOptimizerResult> m_results;
+
+		unsigned int m_threadCount = 0;
+		double m_seconds = 0;
+
+};
+
+} // namespace fx
+
+#endif
@@ -0,0 +1,67 @@
+// author: Darek Slusarczyk alias marines marinesovitch 2012-2013, 2022
+#ifndef INC_BACKEND_ORDERCACHE_H
+#define INC_BACKEND_ORDERCACHE_H
+
+#include "common/order.h"
+
+namespace fx
+{
+
+// the orders matched by a query, the empty symbol, the status Unknown and the
+// type None match any order
+struct SOrderFilter
+{
+	public:
+		SOrderFilter();
+		SOrderFilter(
+			const std::string& symbol,
+			const SOrder::EStatus status = SOrder::Unknown,
+			const SOrder::EType type = SOrder::None);
+
+		bool matches(const SOrder& order) const;
+
+	public:
+		std::string m_symbol;
+		SOrder::EStatus m_status = SOrder::Unknown;
+		SOrder::EType m_type = SOrder::None;
+
+};
+
+// ---------------------------------------------------------------------------
+
+// the last known state of the orders of an account, as they come from the
+// order channel, so the orders may be queried without a round trip to
+// MetaTrader; it is updated by the order loop and queried by the executor
+// and the strategies; the recently closed orders are kept, so their tickets
+// are still recognized, the older ones are dropped
+struct IOrderCache
+{
+	public:
+		virtual ~IOrderCache();
+
+	public:
+		// the order replaces the previous state of its ticket
+		virtual void update(const SOrder& order) = 0;
+		virtual void clear() = 0;
+
+		// the cache is complete once the order channel brought the end of a
+		// dump of all the orders of the account, until then an unknown
+		// ticket may be just not loaded yet
+		virtual void setComplete() = 0;
+		virtual bool isComplete() const = 0;
+
+		virtual std::size_t size() const = 0;
+		virtual bool get(const ticket_t ticket, SOrder* order) const = 0;
+		// the matching orders sorted by ticket, returns their count
+		virtual std::size_t find(const SOrderFilter& filter, std::vector<SOrder>* orders) const = 0;
+		virtual std::size_t count(const SOrderFilter& filter) const = 0;
+
+		// checks whether the tickets may be closed or modified: the closed
+		// ones are refused, the unknown ones only if the cache is complete
+		virtual bool validateTickets(const tickets_t& tickets, std::string* error) const = 0;
+
+};
+
+} // namespace fx
+
+#endif
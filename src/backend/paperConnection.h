@@ -0,0 +1,53 @@
+// author: Darek Slusarczyk alias marines marinesovitch 2012-2013, 2022
+#ifndef INC_BACKEND_PAPERCONNECTION_H
+#define INC_BACKEND_PAPERCONNECTION_H
+
+#include "connection.h"
+#include "traderSink.h"
+
+namespace fx
+{
+
+struct SPaperStats
+{
+	public:
+		void print(std::ostream& os) const;
+
+	public:
+		volume_t m_balance = 0;
+		volume_t m_equity = 0;
+		std::size_t m_orderCount = 0;
+
+		uint64_t m_tickCount = 0;
+		uint64_t m_commandCount = 0;
+		// the time the simulated broker spent on a tick
+		double m_lastTickSeconds = 0.0;
+		double m_maxTickSeconds = 0.0;
+		double m_totalTickSeconds = 0.0;
+};
+
+// ---------------------------------------------------------------------------
+
+// paper trading: the connection of a trader which executes its commands on
+// the execution simulator instead of MetaTrader; it is the sink of the live
+// connection, so the ticks are passed to the simulator first, then to the
+// trader; the orders of the simulator go to the trader the same way as the
+// ones of the order loop, while the live orders of the account are dropped
+struct IPaperConnection : public IConnection, public ITraderSink
+{
+	public:
+		virtual ~IPaperConnection();
+
+	public:
+		// the connection the ticks come from, the commands never reach it
+		virtual void setLiveConnection(HConnection connection) = 0;
+
+		virtual SPaperStats getStats() const = 0;
+
+};
+
+typedef std::shared_ptr<IPaperConnection> HPaperConnection;
+
+} // namespace fx
+
+#endif
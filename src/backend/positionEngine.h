@@ -0,0 +1,38 @@
+// author: Darek Slusarczyk alias marines marinesovitch 2012-2013, 2022
+#ifndef INC_BACKEND_POSITIONENGINE_H
+#define INC_BACKEND_POSITIONENGINE_H
+
+#include "common/position.h"
+
+namespace fx
+{
+
+struct SOrder;
+struct STick;
+
+// the positions of an account kept up to date by the order and tick loops,
+// every order update and every tick costs O(1), nothing is rescanned; the
+// same order may come many times (e.g. after a reconnection), only its last
+// state counts
+struct IPositionEngine
+{
+	public:
+		virtual ~IPositionEngine();
+
+	public:
+		virtual void onOrder(const SOrder& order) = 0;
+		virtual void onTick(const STick& tick) = 0;
+		virtual void clear() = 0;
+
+		// returns false if the symbol has never had any order
+		virtual bool getPosition(const std::string& symbol, SPosition* position) const = 0;
+		// the positions of all the symbols which ever had an order, sorted
+		// by symbol
+		virtual void getPositions(std::vector<SPosition>* positions) const = 0;
+		virtual SAccountPosition getAccountPosition() const = 0;
+
+};
+
+} // namespace fx
+
+#endif
@@ -0,0 +1,91 @@
+// author: Darek Slusarczyk alias marines marinesovitch 2012-2013, 2022
+#ifndef INC_BACKEND_RISKGUARD_H
+#define INC_BACKEND_RISKGUARD_H
+
+#include "common/baseTypes.h"
+
+namespace fx
+{
+
+class KCommand;
+struct STick;
+struct SOrder;
+struct SPosition;
+struct SAccountPosition;
+
+// the limits of the orders sent to MetaTrader, 0 turns a limit off
+struct SRiskLimits
+{
+	public:
+		void print(std::ostream& os) const;
+
+	public:
+		// the lots of a single order
+		volume_t m_maxOrderLots = 10;
+		// the net lots of a symbol after the order, an order which reduces
+		// them is always allowed
+		volume_t m_maxSymbolLots = 50;
+		// the lots of all the open orders of the account after the order
+		volume_t m_maxAccountLots = 100;
+		// the open and pending orders of the account
+		std::size_t m_maxOrderCount = 200;
+		// how far the prices of an order may be from the middle of the last
+		// quote, as a fraction of it; the stop loss and take profit have to
+		// be also on the proper side of the open price
+		double m_priceBand = 0.05;
+};
+
+// ---------------------------------------------------------------------------
+
+struct SRiskStats
+{
+	uint64_t m_checkCount = 0;
+	uint64_t m_refusedCount = 0;
+	// the orders passed but not reported or refused yet
+	std::size_t m_reservedCount = 0;
+};
+
+// ---------------------------------------------------------------------------
+
+// checks the commands on their way to MetaTrader; the tick loop passes the
+// quotes and the order loop the positions, they are kept in atomics, so
+// they are read without locks; a new order which passes reserves its count
+// and lots until its report or refusal arrives, so the orders in flight are
+// counted too; the new orders are checked and reserved under a mutex, else
+// two of them could pass the same limit together, the other commands pass
+// without a lock
+struct IRiskGuard
+{
+	public:
+		virtual ~IRiskGuard();
+
+	public:
+		virtual void setLimits(const SRiskLimits& limits) = 0;
+		virtual SRiskLimits getLimits() const = 0;
+
+		virtual void onTick(const STick& tick) = 0;
+		// the position of the symbol of the changed order and the totals of
+		// the account after the change
+		virtual void onPosition(const SPosition& position, const SAccountPosition& account) = 0;
+		// the first report of an order, it releases the reservation of the
+		// command which opened it
+		virtual void onNewOrder(const SOrder& order) = 0;
+		// the result of a command executed by MetaTrader, a refused new
+		// order releases its reservation
+		virtual void onCmdResult(const KCommand& command, const bool success) = 0;
+		// the command which passed the check couldn't be sent
+		virtual void onCmdLost(const KCommand& command) = 0;
+		// the cmd channel closed, the orders in flight won't be reported, so
+		// all the reservations are released
+		virtual void onDisconnected() = 0;
+
+		// returns false with the reason if the command breaks a limit; only
+		// new orders are checked and reserved, the other commands pass
+		virtual bool check(const KCommand& command, std::string* error) = 0;
+		virtual SRiskStats getStats() const = 0;
+
+};
+
+} // namespace fx
+
+#endif
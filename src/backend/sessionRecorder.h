@@ -0,0 +1,39 @@
+// author: Darek Slusarczyk alias marines marinesovitch 2012-2013, 2022
+#ifndef INC_BACKEND_SESSIONRECORDER_H
+#define INC_BACKEND_SESSIONRECORDER_H
+
+#include "common/notes.h"
+#include "common/types.h"
+
+namespace fx
+{
+
+struct SSymbolInfo;
+struct SOrder;
+
+// captures the traffic of all channels (tick, symbol, order, cmd and notes)
+// with timestamps, methods are called concurrently by the channel loops
+struct ISessionRecorder
+{
+	public:
+		virtual ~ISessionRecorder();
+
+	public:
+		virtual void recordAccount(const account_key_t& key, const SAccountInfo& accountInfo) = 0;
+		virtual void recordNote(const account_key_t& key, const note::EKind noteKind, const std::string& symbol) = 0;
+
+		virtual void recordTick(const account_key_t& key, const STick& tick) = 0;
+		virtual void recordSymbol(const account_key_t& key, const SSymbolInfo& symbolInfo) = 0;
+		virtual void recordOrder(const account_key_t& key, const SOrder& order) = 0;
+		virtual void recordCommand(const account_key_t& key, const std::string& command) = 0;
+		virtual void recordCmdResult(const account_key_t& key, const std::string& output) = 0;
+
+		virtual void printStats(std::ostream& os) const = 0;
+
+};
+
+typedef std::shared_ptr<ISessionRecorder> HSessionRecorder;
+
+} // namespace fx
+
+#endif
@@ -0,0 +1,42 @@
+// author: Darek Slusarczyk alias marines marinesovitch 2012-2013, 2022
+#ifndef INC_BACKEND_SESSIONREPLAYER_H
+#define INC_BACKEND_SESSIONREPLAYER_H
+
+#include "common/notes.h"
+#include "common/types.h"
+
+namespace fx
+{
+
+struct ITraderSink;
+
+// the part of backend which receives the replayed traffic
+struct ISessionReplayTarget
+{
+	// returns the key of the given account, registers it if it is unknown yet;
+	// an account connected by MetaTrader is not replayed into, the key is
+	// null then
+	virtual account_key_t replayAccount(const SAccountInfo& accountInfo) = 0;
+	virtual void replayNote(const account_key_t& key, const note::EKind noteKind, const std::string& symbol) = 0;
+	// null if the account got connected by MetaTrader meanwhile
+	virtual ITraderSink* replaySink(const account_key_t& key) = 0;
+};
+
+struct ISessionReplayer
+{
+	public:
+		virtual ~ISessionReplayer();
+
+	public:
+		// replays the session in a separate thread
+		virtual void run() = 0;
+		virtual void stop() = 0;
+		virtual bool isRunning() const = 0;
+
+};
+
+typedef std::shared_ptr<ISessionReplayer> HSessionReplayer;
+
+} // namespace fx
+
+#endif
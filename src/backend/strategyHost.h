@@ -0,0 +1,28 @@
+// author: Darek Slusarczyk alias marines marinesovitch 2012-2013, 2022
+#ifndef INC_BACKEND_STRATEGYHOST_H
+#define INC_BACKEND_STRATEGYHOST_H
+
+#include "common/smartTypes.h"
+
+namespace fx
+{
+
+struct IOrderCache;
+struct IPositionEngine;
+
+// the environment of a strategy, live it is the trader of account which
+// sends the commands to MetaTrader, in backtest it is the simulator; the
+// results come back to the strategy as ITradingStrategy::onOrder
+struct IStrategyHost
+{
+	virtual void executeCommand( HCommand command ) = 0;
+	// the orders known to the host, so a strategy may query them without
+	// waiting for MetaTrader
+	virtual const IOrderCache& getOrders() const = 0;
+	// the positions made of those orders, valued by the last ticks
+	virtual const IPositionEngine& getPositions() const = 0;
+};
+
+} // namespace fx
+
+#endif
@@ -0,0 +1,89 @@
+// author: Darek Slusarczyk alias marines marinesovitch 2012-2013, 2022
+#ifndef INC_BACKEND_STRATEGYPOOL_H
+#define INC_BACKEND_STRATEGYPOOL_H
+
+#include "bar.h"
+#include "common/smartTypes.h"
+
+namespace fx
+{
+
+struct STick;
+struct SOrder;
+
+struct SStrategyStats
+{
+	std::string m_symbol;
+	std::string m_strategy;
+	unsigned int m_worker = 0;
+	// ticks, bars and orders passed to the strategy
+	uint64_t m_eventCount = 0;
+	double m_seconds = 0.0;
+	double m_maxSeconds = 0.0;
+	// the exceptions thrown by the strategy, e.g. by refused commands
+	uint64_t m_errorCount = 0;
+};
+
+struct SStrategyWorkerStats
+{
+	uint64_t m_eventCount = 0;
+	std::size_t m_queueDepth = 0;
+	std::size_t m_maxQueueDepth = 0;
+	std::size_t m_queueCapacity = 0;
+	// how many times a producer waited for a place in the full queue
+	uint64_t m_stallCount = 0;
+};
+
+struct SStrategyPoolStats
+{
+	public:
+		void print(std::ostream& os) const;
+
+	public:
+		std::vector<SStrategyWorkerStats> m_workers;
+		std::vector<SStrategyStats> m_strategies;
+
+};
+
+// ---------------------------------------------------------------------------
+
+// runs the strategies of an account on a fixed pool of worker threads, so a
+// slow strategy doesn't hold up the channel loops: the symbols are sharded
+// over the workers, each worker has a lock-free queue of the ticks, bars and
+// orders of its symbols and calls their strategies in the order of the
+// queue; the strategies of a worker are called only by it or by the executor
+// (set, remove, commands), so they needn't be thread-safe
+struct IStrategyPool
+{
+	public:
+		virtual ~IStrategyPool();
+
+	public:
+		// called by the channel loops, they never block unless the queue of
+		// the worker is full; tickCount is the count of ticks of the symbol
+		// including this one (ITickStore::append), the bars closed by a tick
+		// are pushed before it with its count
+		virtual void pushTick(const STick& tick, const uint64_t tickCount) = 0;
+		virtual void pushBar(
+			const std::string& symbol,
+			const timeframe::ETimeframe timeframe,
+			const SBar& bar,
+			const uint64_t tickCount) = 0;
+		virtual void pushOrder(const SOrder& order) = 0;
+
+		// called by the executor, the name is copied under the lock of the
+		// worker, the strategy may be replaced meanwhile
+		virtual std::string getStrategy(const std::string& symbol) const = 0;
+		// the strategy warms up with the ticks of the symbol kept in the tick
+		// store, then it gets the ticks pushed after them
+		virtual void setStrategy(const std::string& symbol, HTradingStrategy strategy) = 0;
+		virtual void removeStrategy(const std::string& symbol) = 0;
+		virtual void executeStrategyCommand(const std::string& symbol, std::istringstream& cmdLine) = 0;
+
+		virtual void getStats(SStrategyPoolStats* stats) const = 0;
+
+};
+
+} // namespace fx
+
+#endif
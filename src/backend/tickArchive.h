@@ -0,0 +1,72 @@
+// author: Darek Slusarczyk alias marines marinesovitch 2012-2013, 2022
+#ifndef INC_BACKEND_TICKARCHIVE_H
+#define INC_BACKEND_TICKARCHIVE_H
+
+#include "common/baseTypes.h"
+
+namespace fx
+{
+
+struct STick;
+
+struct STickRecord
+{
+	datetime_t m_time;
+	price_t m_bid;
+	price_t m_ask;
+	price_t m_last;
+};
+
+// ---------------------------------------------------------------------------
+
+// persists the ticks of an account into segment files per symbol and day:
+// <directory>/<symbol>/<yyyymmdd>-<part>.fxtick, a segment is split into
+// parts when it is full or the archive is restarted; the tick loop only
+// puts the tick into a queue, the files are written, flushed and rolled
+// over by a background thread
+struct ITickArchive
+{
+	public:
+		virtual ~ITickArchive();
+
+	public:
+		// never blocks, if the queue is full the tick is dropped and counted
+		virtual void append(const STick& tick) = 0;
+
+		// writes the queued ticks and closes all segments
+		virtual void close() = 0;
+
+		virtual void printStats(std::ostream& os) const = 0;
+
+};
+
+typedef std::shared_ptr<ITickArchive> HTickArchive;
+
+// ---------------------------------------------------------------------------
+
+// a closed segment mapped for reading, the records are scanned in place
+struct ITickSegment
+{
+	public:
+		virtual ~ITickSegment();
+
+	public:
+		virtual const std::string& getSymbol() const = 0;
+		// the start of the day of the segment
+		virtual datetime_t getDay() const = 0;
+
+		virtual std::size_t size() const = 0;
+		virtual const STickRecord* begin() const = 0;
+		virtual const STickRecord* end() const = 0;
+
+		// the first record not earlier than the given time, found with the
+		// sparse time index of the segment
+		virtual const STickRecord* lowerBound(const datetime_t time) const = 0;
+
+};
+
+typedef std::shared_ptr<ITickSegment> HTickSegment;
+
+} // namespace fx
+
+#endif
@@ -0,0 +1,45 @@
+// author: Darek Slusarczyk alias marines marinesovitch 2012-2013, 2022
+#ifndef INC_BACKEND_TICKFEED_H
+#define INC_BACKEND_TICKFEED_H
+
+#include "common/baseTypes.h"
+
+namespace fx
+{
+
+struct ITickFeedSink
+{
+	// the ask and last of the ticks made of bars are 0
+	virtual void onTick(const datetime_t time, const price_t bid, const price_t ask, const price_t last) = 0;
+};
+
+// ---------------------------------------------------------------------------
+
+// the recorded ticks of a symbol mapped for reading, it may be replayed many
+// times and from many threads at once, the data are shared between them
+struct ITickFeed
+{
+	public:
+		virtual ~ITickFeed();
+
+	public:
+		virtual const std::string& getSymbol() const = 0;
+		// the number of ticks passed by replay
+		virtual uint64_t size() const = 0;
+
+		// the time of the first and of the last tick
+		virtual datetime_t getFirstTime() const = 0;
+		virtual datetime_t getLastTime() const = 0;
+
+		virtual void replay(ITickFeedSink* sink) const = 0;
+		// only the ticks in [from, to), the ticks made of a bar are passed if
+		// the bar opens in the range
+		virtual void replay(ITickFeedSink* sink, const datetime_t from, const datetime_t to) const = 0;
+
+};
+
+typedef std::shared_ptr<ITickFeed> HTickFeed;
+
+} // namespace fx
+
+#endif
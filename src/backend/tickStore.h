@@ -0,0 +1,62 @@
+// author: Darek Slusarczyk alias marines marinesovitch 2012-2013, 2022
+#ifndef INC_BACKEND_TICKSTORE_H
+#define INC_BACKEND_TICKSTORE_H
+
+#include "common/baseTypes.h"
+
+namespace fx
+{
+
+struct STick;
+
+// a copy of a range of ticks of a single symbol, from the oldest to the
+// newest one, the columns are kept separately, the buffers are reused by
+// subsequent queries, so the same series passed again doesn't allocate
+struct STickSeries
+{
+	public:
+		std::size_t size() const;
+		bool empty() const;
+		void clear();
+
+	public:
+		std::vector<datetime_t> m_times;
+		std::vector<price_t> m_bids;
+		std::vector<price_t> m_asks;
+		std::vector<price_t> m_lasts;
+		// the number of ticks of the symbol appended up to the newest one of
+		// the series, it tells where the series ends in the stream of ticks
+		uint64_t m_endCount = 0;
+
+};
+
+// ---------------------------------------------------------------------------
+
+// the recent ticks of all symbols of an account, each symbol has its own
+// ring of fixed capacity, appending is O(1) and queries never block it: a
+// reader copies the ticks and drops the ones overwritten meanwhile
+struct ITickStore
+{
+	public:
+		virtual ~ITickStore();
+
+	public:
+		// called by the tick loop of the account, returns the number of ticks
+		// of the symbol appended so far including this one
+		virtual uint64_t append(const STick& tick) = 0;
+
+		virtual std::size_t capacity() const = 0;
+		// number of ticks appended since start, including the overwritten ones
+		virtual uint64_t tickCount(const std::string& symbol) const = 0;
+
+		// both return false if there are no ticks of the symbol
+		virtual bool getLastTicks(const std::string& symbol, const std::size_t count, STickSeries* series) const = 0;
+		virtual bool getTicksSince(const std::string& symbol, const datetime_t since, STickSeries* series) const = 0;
+
+};
+
+typedef std::shared_ptr<ITickStore> HTickStore;
+
+} // namespace fx
+
+#endif
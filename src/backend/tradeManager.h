@@ -8,6 +8,10 @@
 namespace fx
 {
 
+struct ICopyTrader;
+struct SExecutionParams;
+struct SPaperStats;
+
 struct ITradeManager
 {
 	public: 
@@ -16,6 +20,15 @@ struct ITradeManager
 	public: 
 		virtual void run() = 0;
 		virtual HTrader getTrader(const account_key_t& key) const = 0;
+		// mirrors the orders of the master account on the followers
+		virtual ICopyTrader& getCopyTrader() = 0;
+
+		// paper trading: the accounts connected later execute their commands
+		// on the simulated broker driven by their live ticks, it is expected
+		// to be set before the communicator runs
+		virtual void setPaperTrading(const SExecutionParams& params) = 0;
+		// false if the account trades live
+		virtual bool getPaperStats(const account_key_t& key, SPaperStats* stats) const = 0;
 
 };
 
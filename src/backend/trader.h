@@ -3,6 +3,17 @@
 #define INC_BACKEND_TRADER_H
 
 #include "traderSink.h"
+#include "tickStore.h"
+#include "tickArchive.h"
+#include "orderCache.h"
+#include "positionEngine.h"
+#include "equityTracker.h"
+#include "riskGuard.h"
+#include "trailingStops.h"
+#include "conditionalOrders.h"
+#include "alertEngine.h"
+#include "executionAlgos.h"
+#include "strategyPool.h"
 #include "common/smartTypes.h"
 
 namespace fx
@@ -15,14 +26,46 @@ struct ITrader : public ITraderSink
 
 	public:
 		virtual void setConnection( HConnection connection ) = 0;
+		virtual HConnection getConnection() const = 0;
+		// throws std::invalid_argument if the command breaks the risk limits
 		virtual void executeCommand( HCommand command ) = 0;
+		// gets the orders of the account first, before the trader handles
+		// them, nullptr means none
+		virtual void setOrderObserver( IOrderObserver* observer ) = 0;
+		// the orders of the account known from the order channel
+		virtual const IOrderCache& getOrders() const = 0;
+		// the positions of the account derived from its orders and ticks
+		virtual const IPositionEngine& getPositions() const = 0;
+		// the equity and drawdown of the session with its recent history
+		virtual const IEquityTracker& getEquity() const = 0;
+		// checks the new orders of both the user and the strategies
+		virtual IRiskGuard& getRiskGuard() = 0;
+		// the stop losses moved by the backend on the ticks
+		virtual ITrailingStops& getTrailingStops() = 0;
+		// the virtual stops, OCO and bracket orders fired by the backend
+		virtual IConditionalOrders& getConditionalOrders() = 0;
+		// the fired alerts are printed by the trader
+		virtual IAlertEngine& getAlerts() = 0;
+		// the large orders sliced into children over time
+		virtual IExecutionAlgos& getExecutionAlgos() = 0;
 
 		virtual void showTicks(const bool show) = 0;
+		// recent ticks of all symbols of the account
+		virtual const ITickStore& getTickStore() const = 0;
 
-		virtual const std::string& getStrategy( const std::string& symbol ) const = 0;
+		// the incoming ticks are appended to the archive, if it is set
+		virtual void setTickArchive( HTickArchive archive ) = 0;
+		virtual HTickArchive getTickArchive() const = 0;
+
+		virtual std::string getStrategy( const std::string& symbol ) const = 0;
+		// the strategy warms up with the ticks of the symbol kept in the tick
+		// store, then it gets the live ticks starting from the next one
 		virtual void setStrategy( const std::string& symbol, HTradingStrategy strategy ) = 0;
 		virtual void removeStrategy( const std::string& symbol ) = 0;
 		virtual void executeStrategyCommand( const std::string& symbol, std::istringstream& cmdLine ) = 0;
+		// the strategies run on the workers of the trader, not on the
+		// channel loops
+		virtual void getStrategyStats( SStrategyPoolStats* stats ) const = 0;
 
 };
 
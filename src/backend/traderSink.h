@@ -3,6 +3,7 @@
 #define INC_BACKEND_TRADERSINK_H
 
 #include "common/baseTypes.h"
+#include "common/smartTypes.h"
 
 namespace fx
 {
@@ -19,7 +20,22 @@ struct ITraderSink
 	virtual void onTick(const STick& tick) = 0;
 	virtual void onSymbol(const SSymbolInfo& symbolInfo) = 0;
 	virtual void onOrder(const SOrder& order) = 0;
-	virtual void onCmdResult(const std::string& output) = 0;
+	// the result of the execution of the command by MetaTrader, the command
+	// is null if it isn't known, like in a replayed session
+	virtual void onCmdResult(HCommand command, const std::string& output) = 0;
+	// the cmd channel closed, the commands sent to MetaTrader won't get
+	// their results
+	virtual void onDisconnected() = 0;
+};
+
+// ---------------------------------------------------------------------------
+
+// gets the orders of an account from its order loop, before the trader
+// handles them, and the results of its commands
+struct IOrderObserver
+{
+	virtual void onOrder(const account_key_t& key, const SOrder& order) = 0;
+	virtual void onCmdResult(const account_key_t& key, const KCommand& command, const bool success) = 0;
 };
 
 } // namespace fx
@@ -2,11 +2,15 @@
 #ifndef INC_BACKEND_TRADINGSTRATEGY_H
 #define INC_BACKEND_TRADINGSTRATEGY_H
 
+#include "bar.h"
+
 namespace fx
 {
 
 struct STick;
 struct SOrder;
+struct STickSeries;
+struct IStrategyHost;
 
 struct ITradingStrategy
 {
@@ -14,9 +18,25 @@ struct ITradingStrategy
 
 	virtual const std::string& getName() const = 0;
 
+	// the host is set before the first tick, the strategy sends its commands
+	// through it
+	virtual void setHost(IStrategyHost* host) = 0;
+
+	// called once before the first live tick with the recent ticks of the
+	// symbol; a strategy may initialize its state from the columns at once
+	// (see indicatorBatch.h) and return true, or return false to get the
+	// ticks replayed by onTick and onBar; the commands sent during the
+	// warm-up are dropped
+	virtual bool warmUp(const STickSeries& history) = 0;
+
 	virtual void onTick(const STick& tick) = 0;
 	virtual void onOrder(const SOrder& order) = 0;
 
+	// bars of the given timeframes are passed to onBar once they are closed,
+	// before the tick which closed them is passed to onTick
+	virtual timeframe::mask_t getBarTimeframes() const = 0;
+	virtual void onBar(const timeframe::ETimeframe timeframe, const SBar& bar) = 0;
+
 	virtual void executeCommand(std::istringstream& cmdLine) = 0;
 };
 
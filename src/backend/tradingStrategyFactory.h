@@ -13,6 +13,7 @@ struct ITradingStrategyFactory
 	virtual ~ITradingStrategyFactory();
 
 	virtual void getNames(cpp::strings_t* strategies) const = 0;
+	// the optimizer calls it from many threads at once
 	virtual HTradingStrategy create(const std::string& name) = 0;
 };
 
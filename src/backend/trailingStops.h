@@ -0,0 +1,69 @@
+// author: Darek Slusarczyk alias marines marinesovitch 2012-2013, 2022
+#ifndef INC_BACKEND_TRAILINGSTOPS_H
+#define INC_BACKEND_TRAILINGSTOPS_H
+
+#include "common/baseTypes.h"
+
+namespace fx
+{
+
+struct SOrder;
+struct STick;
+
+// the stop loss of an open order follows the price at the given distance,
+// it is moved only when it can move by at least the step
+struct STrailingRule
+{
+	ticket_t m_ticket;
+	std::string m_symbol;
+	bool m_buy = true;
+	price_t m_distance = 0;
+	price_t m_step = 0;
+	// the last stop loss requested or reported by MetaTrader, 0 if none
+	price_t m_stopLoss = 0;
+};
+
+// ---------------------------------------------------------------------------
+
+struct STrailingStats
+{
+	std::size_t m_ruleCount = 0;
+	uint64_t m_tickCount = 0;
+	// the rules whose stop was moved by a tick and the commands sent
+	uint64_t m_triggerCount = 0;
+};
+
+// ---------------------------------------------------------------------------
+
+// keeps the trailing rules of the orders of an account and moves their stop
+// losses by set_stop_loss sent through the host; the rules of each symbol
+// are sorted by the price which triggers them, separately for buys and
+// sells, so a tick only visits the rules it moves; a rule is removed when
+// its order is closed
+struct ITrailingStops
+{
+	public:
+		virtual ~ITrailingStops();
+
+	public:
+		// the order has to be an open buy or sell, a rule of the same ticket
+		// is replaced; the step 0 means a tenth of the distance
+		virtual bool addRule(
+			const SOrder& order,
+			const price_t distance,
+			const price_t step,
+			std::string* error) = 0;
+		virtual bool removeRule(const ticket_t ticket) = 0;
+		// sorted by ticket
+		virtual void getRules(std::vector<STrailingRule>* rules) const = 0;
+
+		virtual void onTick(const STick& tick) = 0;
+		virtual void onOrder(const SOrder& order) = 0;
+
+		virtual STrailingStats getStats() const = 0;
+
+};
+
+} // namespace fx
+
+#endif
@@ -0,0 +1,76 @@
+// author: Darek Slusarczyk alias marines marinesovitch 2012-2013, 2022
+#ifndef INC_BACKEND_WALKFORWARD_H
+#define INC_BACKEND_WALKFORWARD_H
+
+#include "monteCarlo.h"
+#include "optimizer.h"
+
+namespace fx
+{
+
+struct SWalkForwardParams
+{
+	// the parameters are optimized in each in-sample window with these
+	// params, the out-of-sample windows use its backtest params
+	SOptimizerParams m_optimizer;
+	// in seconds, each out-of-sample window follows its in-sample one and
+	// the next pair of windows starts by the out-of-sample length later
+	datetime_t m_inSample = 28 * 24 * 60 * 60;
+	datetime_t m_outOfSample = 7 * 24 * 60 * 60;
+	// all the in-sample windows start at the first day, so they grow
+	bool m_anchored = false;
+	// of the trades of all the out-of-sample windows
+	SMonteCarloParams m_monteCarlo;
+};
+
+// ---------------------------------------------------------------------------
+
+struct SWalkForwardWindow
+{
+	datetime_t m_inSampleFrom = 0;
+	datetime_t m_outOfSampleFrom = 0;
+	datetime_t m_outOfSampleTo = 0;
+	// the best parameters of the in-sample window
+	SOptimizerResult m_inSample;
+	// the best parameters run out of sample, with the trades
+	SOptimizerResult m_outOfSample;
+};
+
+// ---------------------------------------------------------------------------
+
+struct SWalkForwardReport
+{
+	public:
+		// the windows and the totals
+		void print(std::ostream& os) const;
+		// the windows as csv, throws std::runtime_error
+		void save(const std::string& path) const;
+
+	public:
+		std::string m_symbol;
+		std::string m_strategy;
+		optimizer::EMetric m_metric = optimizer::Profit;
+
+		std::vector<SWalkForwardWindow> m_windows;
+
+		// of the best parameters over all the in-sample windows and of all
+		// the out-of-sample windows
+		volume_t m_inSampleProfit = 0;
+		volume_t m_outOfSampleProfit = 0;
+		std::size_t m_outOfSampleTradeCount = 0;
+		// the out-of-sample profit per day relative to the in-sample one,
+		// well below 1 is a sign of overfitting
+		double m_efficiency = 0;
+
+		SMonteCarloReport m_monteCarlo;
+
+		// all the backtests
+		std::size_t m_runCount = 0;
+		unsigned int m_threadCount = 0;
+		double m_seconds = 0;
+
+};
+
+} // namespace fx
+
+#endif
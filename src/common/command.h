@@ -3,13 +3,12 @@
 #define INC_COMMON_COMMAND_TYPES_H
 
 #include "types.h"
+#include "order.h"
 #include "cpp/types.h"
 
 namespace fx
 {
 
-struct SNewOrder;
-struct SModifyOrder;
 struct ICommandVisitor;
 
 class KCommand
@@ -56,6 +55,7 @@ class KCommand
 
 		std::string toString() const;
 
+		EOperation operation() const;
 		const std::string& name() const;
 		const cpp::strings_t& args() const;
 		const tickets_t& tickets() const;
@@ -91,6 +91,13 @@ class KCmdOpen : public KCommand
 {
 	public:
 		KCmdOpen(const SNewOrder& newOrder);
+
+		// the order is kept unformatted too, so the risk checks needn't
+		// parse the args
+		const SNewOrder& newOrder() const;
+
+	private:
+		const SNewOrder m_newOrder;
 };
 
 class KCmdClose : public KCommand
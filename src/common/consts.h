@@ -30,7 +30,12 @@ const int MaxCmdArgCount = 16;
 const int MaxCmdArgLen = 128;
 const int MaxCmdTicketCount = 32 * 1024;
 
-extern const std::string CmdSendSuccess;
+// the result of a command executed by MetaTrader without an error, else
+// the result is the list of errors
+extern const std::string CmdResultSuccess;
+// the result of a command whose output didn't come back on the cmd channel,
+// it might have been executed or not
+extern const std::string CmdResultLost;
 
 extern const std::string CmdExit;
 
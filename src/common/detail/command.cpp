@@ -207,6 +207,11 @@ std::string KCommand::toString() const
 	return result;
 }
 
+KCommand::EOperation KCommand::operation() const
+{
+	return m_operation;
+}
+
 const std::string& KCommand::name() const
 {
 	const std::string& result = s_operation_conv.to_str(m_operation);
@@ -268,7 +273,13 @@ KCmdGet::KCmdGet(const tickets_t& tickets)
 
 KCmdOpen::KCmdOpen(const SNewOrder& newOrder)
 	: KCommand(Open, newOrder2args(newOrder))
+	, m_newOrder(newOrder)
+{
+}
+
+const SNewOrder& KCmdOpen::newOrder() const
 {
+	return m_newOrder;
 }
 
 KCmdClose::KCmdClose(const tickets_t& tickets)
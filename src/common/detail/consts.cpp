@@ -18,7 +18,8 @@ const std::string CmdPipeName = "cmd";
 const std::string PipePrefix = "pipe";
 const std::string MailSlotPrefix = "mailslot";
 
-const std::string CmdSendSuccess = "cmd sent successfully";
+const std::string CmdResultSuccess = "success";
+const std::string CmdResultLost = "lost";
 
 const std::string CmdExit = "exit";
 
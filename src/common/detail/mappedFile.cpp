@@ -0,0 +1,249 @@
+// author: Darek Slusarczyk alias marines marinesovitch 2012-2013, 2022
+#include "ph.h"
+#include "mappedFile.h"
+
+namespace fx
+{
+
+namespace
+{
+
+DWORD highPart(const uint64_t value)
+{
+	return static_cast<DWORD>(value >> 32);
+}
+
+DWORD lowPart(const uint64_t value)
+{
+	return static_cast<DWORD>(value & 0xFFFFFFFF);
+}
+
+uint64_t allocationGranularity()
+{
+	static const uint64_t s_granularity = []()
+	{
+		SYSTEM_INFO systemInfo;
+		::GetSystemInfo(&systemInfo);
+		return static_cast<uint64_t>(systemInfo.dwAllocationGranularity);
+	}();
+	return s_granularity;
+}
+
+} // anonymous namespace
+
+// ---------------------------------------------------------------------------
+
+KMappedFile::KMappedFile()
+	: m_file(INVALID_HANDLE_VALUE)
+	, m_mapping(nullptr)
+	, m_writable(false)
+	, m_fileSize(0)
+	, m_viewBase(nullptr)
+	, m_viewBaseSize(0)
+	, m_view(nullptr)
+{
+}
+
+KMappedFile::~KMappedFile()
+{
+	close();
+}
+
+// ---------------------------------------------------------------------------
+
+bool KMappedFile::create(const std::string& path, const uint64_t size)
+{
+	assert(!isOpen() && (0 < size));
+	m_path = path;
+	m_writable = true;
+	m_file = ::CreateFile(
+		path.c_str(),
+		GENERIC_READ | GENERIC_WRITE,
+		FILE_SHARE_READ,
+		nullptr,
+		CREATE_ALWAYS,
+		FILE_ATTRIBUTE_NORMAL,
+		nullptr);
+	if (m_file == INVALID_HANDLE_VALUE)
+	{
+		return false;
+	}
+
+	// the mapping extends the file to its size
+	m_mapping = ::CreateFileMapping(m_file, nullptr, PAGE_READWRITE, highPart(size), lowPart(size), nullptr);
+	if (m_mapping == nullptr)
+	{
+		close();
+		return false;
+	}
+
+	m_viewBase = static_cast<char*>(::MapViewOfFile(m_mapping, FILE_MAP_WRITE, 0, 0, static_cast<std::size_t>(size)));
+	if (m_viewBase == nullptr)
+	{
+		close();
+		return false;
+	}
+
+	m_fileSize = size;
+	m_viewBaseSize = static_cast<std::size_t>(size);
+	m_view = m_viewBase;
+	return true;
+}
+
+bool KMappedFile::open(const std::string& path)
+{
+	assert(!isOpen());
+	m_path = path;
+	m_writable = false;
+	m_file = ::CreateFile(
+		path.c_str(),
+		GENERIC_READ,
+		FILE_SHARE_READ,
+		nullptr,
+		OPEN_EXISTING,
+		FILE_ATTRIBUTE_NORMAL,
+		nullptr);
+	if (m_file == INVALID_HANDLE_VALUE)
+	{
+		return false;
+	}
+
+	LARGE_INTEGER fileSize;
+	if (!::GetFileSizeEx(m_file, &fileSize))
+	{
+		close();
+		return false;
+	}
+	m_fileSize = static_cast<uint64_t>(fileSize.QuadPart);
+
+	// an empty file cannot be mapped, but it is still valid
+	if (0 < m_fileSize)
+	{
+		m_mapping = ::CreateFileMapping(m_file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+		if (m_mapping == nullptr)
+		{
+			close();
+			return false;
+		}
+	}
+	return true;
+}
+
+const char* KMappedFile::mapView(const uint64_t offset, const std::size_t size)
+{
+	assert(isOpen() && !m_writable);
+	if ((m_mapping == nullptr) || (m_fileSize <= offset))
+	{
+		return nullptr;
+	}
+
+	const uint64_t granularity = allocationGranularity();
+	const uint64_t baseOffset = offset - (offset % granularity);
+	const uint64_t end = std::min(offset + size, m_fileSize);
+	const std::size_t baseSize = static_cast<std::size_t>(end - baseOffset);
+
+	unmapView();
+	m_viewBase = static_cast<char*>(::MapViewOfFile(
+		m_mapping, FILE_MAP_READ, highPart(baseOffset), lowPart(baseOffset), baseSize));
+	if (m_viewBase == nullptr)
+	{
+		return nullptr;
+	}
+
+	m_viewBaseSize = baseSize;
+	m_view = m_viewBase + (offset - baseOffset);
+	return m_view;
+}
+
+const char* KMappedFile::mapAll()
+{
+	const char* result = mapView(0, static_cast<std::size_t>(m_fileSize));
+	return result;
+}
+
+bool KMappedFile::flush()
+{
+	assert(m_writable);
+	const bool result = (m_viewBase != nullptr)
+		&& ::FlushViewOfFile(m_viewBase, m_viewBaseSize)
+		&& ::FlushFileBuffers(m_file);
+	return result;
+}
+
+void KMappedFile::close(const uint64_t finalSize)
+{
+	assert(m_writable && (finalSize <= m_fileSize));
+	unmapView();
+	if (m_mapping != nullptr)
+	{
+		::CloseHandle(m_mapping);
+		m_mapping = nullptr;
+	}
+
+	if (m_file != INVALID_HANDLE_VALUE)
+	{
+		LARGE_INTEGER position;
+		position.QuadPart = static_cast<int64_t>(finalSize);
+		if (::SetFilePointerEx(m_file, position, nullptr, FILE_BEGIN))
+		{
+			::SetEndOfFile(m_file);
+		}
+		m_fileSize = finalSize;
+	}
+	close();
+}
+
+void KMappedFile::close()
+{
+	unmapView();
+	if (m_mapping != nullptr)
+	{
+		::CloseHandle(m_mapping);
+		m_mapping = nullptr;
+	}
+
+	if (m_file != INVALID_HANDLE_VALUE)
+	{
+		::CloseHandle(m_file);
+		m_file = INVALID_HANDLE_VALUE;
+	}
+}
+
+// ---------------------------------------------------------------------------
+
+bool KMappedFile::isOpen() const
+{
+	const bool result = (m_file != INVALID_HANDLE_VALUE);
+	return result;
+}
+
+const std::string& KMappedFile::path() const
+{
+	return m_path;
+}
+
+uint64_t KMappedFile::fileSize() const
+{
+	return m_fileSize;
+}
+
+char* KMappedFile::data() const
+{
+	assert(m_writable);
+	return m_view;
+}
+
+// ---------------------------------------------------------------------------
+
+void KMappedFile::unmapView()
+{
+	if (m_viewBase != nullptr)
+	{
+		::UnmapViewOfFile(m_viewBase);
+		m_viewBase = nullptr;
+		m_viewBaseSize = 0;
+		m_view = nullptr;
+	}
+}
+
+} // namespace fx
@@ -112,6 +112,21 @@ SOrder::SOrder(
 
 // ---------------------------------------------------------------------------
 
+SOrder SOrder::makeDumpEnd()
+{
+	SOrder result;
+	result.m_symbolName[0] = 0;
+	return result;
+}
+
+bool SOrder::isDumpEnd() const
+{
+	const bool result = !m_ticket.isValid();
+	return result;
+}
+
+// ---------------------------------------------------------------------------
+
 SOrder::EStatus SOrder::str2status(const std::string& statusStr)
 {
 	const SOrder::EStatus result = s_status_conv.from_str(statusStr);
@@ -0,0 +1,47 @@
+// author: Darek Slusarczyk alias marines marinesovitch 2012-2013, 2022
+#include "ph.h"
+#include "position.h"
+
+namespace fx
+{
+
+SPosition::SPosition()
+{
+	m_symbolName[0] = 0;
+}
+
+bool SPosition::isFlat() const
+{
+	return m_openCount == 0;
+}
+
+std::string SPosition::toString() const
+{
+	std::ostringstream os;
+	os << m_symbolName << ' '
+		<< m_openCount << ' '
+		<< m_netLots << ' '
+		<< m_averagePrice << ' '
+		<< m_buyLots << ' '
+		<< m_buyPrice << ' '
+		<< m_sellLots << ' '
+		<< m_sellPrice << ' '
+		<< m_realizedProfit << ' '
+		<< m_unrealizedProfit;
+	return os.str();
+}
+
+// ---------------------------------------------------------------------------
+
+std::string SAccountPosition::toString() const
+{
+	std::ostringstream os;
+	os << m_symbolCount << ' '
+		<< m_openCount << ' '
+		<< m_grossLots << ' '
+		<< m_realizedProfit << ' '
+		<< m_unrealizedProfit;
+	return os.str();
+}
+
+} // namespace fx
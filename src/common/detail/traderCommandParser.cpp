@@ -4,6 +4,7 @@
 #include "commandParserBase.h"
 #include "command.h"
 #include "order.h"
+#include "cpp/allocTracker.h"
 
 namespace fx
 {
@@ -36,6 +37,12 @@ class KTraderCommandParser : public KCommandParserBase
 		HCommand parseCommandGetSymbols();
 		HCommand parseCommandShowTicks();
 		HCommand parseCommandHideTicks();
+
+	private:
+		typedef HCommand (KTraderCommandParser::*parse_command_t)();
+		// built at the start, so it doesn't count into the allocations of the
+		// first parsed command
+		static const std::map<KCommand::EOperation, parse_command_t> s_cmdParsers;
 };
 
 // ---------------------------------------------------------------------------
@@ -75,24 +82,23 @@ KCommand::EOperation KTraderCommandParser::parseOperation()
 	return operation;
 }
 
+const std::map<KCommand::EOperation, KTraderCommandParser::parse_command_t> KTraderCommandParser::s_cmdParsers = {
+	{KCommand::ListSymbols, &KTraderCommandParser::parseCommandListSymbols},
+	{KCommand::Get, &KTraderCommandParser::parseCommandGet},
+	{KCommand::Open, &KTraderCommandParser::parseCommandOpen},
+	{KCommand::Close, &KTraderCommandParser::parseCommandClose},
+	{KCommand::CloseAll, &KTraderCommandParser::parseCommandCloseAll},
+	{KCommand::Modify, &KTraderCommandParser::parseCommandModify},
+	{KCommand::SetStopLoss, &KTraderCommandParser::parseCommandSetStopLoss},
+	{KCommand::SetTakeProfit, &KTraderCommandParser::parseCommandSetTakeProfit},
+
+	{KCommand::GetSymbols, &KTraderCommandParser::parseCommandGetSymbols},
+	{KCommand::ShowTicks, &KTraderCommandParser::parseCommandShowTicks},
+	{KCommand::HideTicks, &KTraderCommandParser::parseCommandHideTicks},
+};
+
 HCommand KTraderCommandParser::parseCommand(const KCommand::EOperation operation)
 {
-	typedef HCommand (KTraderCommandParser::*parse_command_t)();
-	static const std::map<KCommand::EOperation, parse_command_t> s_cmdParsers = {
-		{KCommand::ListSymbols, &KTraderCommandParser::parseCommandListSymbols},
-		{KCommand::Get, &KTraderCommandParser::parseCommandGet},
-		{KCommand::Open, &KTraderCommandParser::parseCommandOpen},
-		{KCommand::Close, &KTraderCommandParser::parseCommandClose},
-		{KCommand::CloseAll, &KTraderCommandParser::parseCommandCloseAll},
-		{KCommand::Modify, &KTraderCommandParser::parseCommandModify},
-		{KCommand::SetStopLoss, &KTraderCommandParser::parseCommandSetStopLoss},
-		{KCommand::SetTakeProfit, &KTraderCommandParser::parseCommandSetTakeProfit},
-
-		{KCommand::GetSymbols, &KTraderCommandParser::parseCommandGetSymbols},
-		{KCommand::ShowTicks, &KTraderCommandParser::parseCommandShowTicks},
-		{KCommand::HideTicks, &KTraderCommandParser::parseCommandHideTicks},
-	};
-
 	auto cit = s_cmdParsers.find(operation);
 	assert(cit != s_cmdParsers.cend());
 	parse_command_t parser = cit->second;
@@ -181,6 +187,10 @@ HCommand KTraderCommandParser::parseCommandHideTicks()
 
 HCommand parseTraderCommand(const std::string& commandStr, std::string* error)
 {
+	// the stream with command line, the command itself with its arguments,
+	// measured up to 8 for an order and 11 for a get of 64 tickets, the vector of
+	// tickets grows by half with msvc
+	CPP_ALLOC_PROBE("parseTraderCommand", 24);
 	HCommand result;
 	try
 	{
@@ -196,6 +206,7 @@ HCommand parseTraderCommand(const std::string& commandStr, std::string* error)
 
 HCommand parseTraderCommand(const KCommand::EOperation operation, std::istringstream& cmdLine)
 {
+	CPP_ALLOC_PROBE("parseTraderCommand operation", 16);
 	KTraderCommandParser parser(cmdLine);
 	HCommand result = parser.run(operation);
 	return result;
@@ -0,0 +1,64 @@
+// author: Darek Slusarczyk alias marines marinesovitch 2012-2013, 2022
+#ifndef INC_COMMON_MAPPEDFILE_H
+#define INC_COMMON_MAPPEDFILE_H
+
+namespace fx
+{
+
+// a file mapped into memory, either created for writing and mapped as a
+// whole, or opened for reading and mapped by views, which may be moved over
+// the file to scan files bigger than the address space
+class KMappedFile
+{
+	public:
+		KMappedFile();
+		~KMappedFile();
+
+		KMappedFile(const KMappedFile&) = delete;
+		KMappedFile& operator=(const KMappedFile&) = delete;
+
+	public:
+		// creates the file (an existing one is truncated) of the given size
+		bool create(const std::string& path, const uint64_t size);
+		bool open(const std::string& path);
+
+		// maps the range of the file opened for reading, the previous view is
+		// unmapped, returns nullptr if the range is beyond the end of file
+		const char* mapView(const uint64_t offset, const std::size_t size);
+		const char* mapAll();
+
+		// writes the dirty pages of the created file
+		bool flush();
+
+		// the created file is truncated to the given size
+		void close(const uint64_t finalSize);
+		void close();
+
+	public:
+		bool isOpen() const;
+		const std::string& path() const;
+		uint64_t fileSize() const;
+
+		// the mapped memory of the created file
+		char* data() const;
+
+	private:
+		void unmapView();
+
+	private:
+		std::string m_path;
+		HANDLE m_file;
+		HANDLE m_mapping;
+		bool m_writable;
+		uint64_t m_fileSize;
+
+		// the real view starts at the allocation granularity boundary
+		char* m_viewBase;
+		std::size_t m_viewBaseSize;
+		char* m_view;
+
+};
+
+} // namespace fx
+
+#endif
@@ -80,6 +80,11 @@ struct SOrder
 		static std::string serialize(const SOrder& order);
 		static SOrder deserialize(const std::string& strOrder);
 
+		// follows all the orders of the account on the order channel, so its
+		// reader knows the whole account once it gets there; it has no ticket
+		static SOrder makeDumpEnd();
+		bool isDumpEnd() const;
+
 };
 
 // ---------------------------------------------------------------------------
@@ -1,24 +1,69 @@
 // author: Darek Slusarczyk alias marines marinesovitch 2012-2013, 2022
-#include "ph.h"
-//
-//namespace fx
-//{
-//
-//class Position
-//{
-//	public enum EType
-//	{
-//		Unknown,
-//		Short,
-//		Long
-//	}
-//
-//	public EType Type { get; set; }
-//
-//	public int Size { get; set; }
-//
-//	public Price Price { get; set; }
-//
-//}
-//
-//}
+#ifndef INC_COMMON_POSITION_H
+#define INC_COMMON_POSITION_H
+
+#include "types.h"
+
+namespace fx
+{
+
+// the open market orders of a symbol seen as a single position; the buys and
+// sells are kept separately, because the account may hedge, the net lots are
+// the difference of them; the profits are in the account currency, so they
+// may be summed over the symbols, the realized one comes from the closed
+// orders (with commission and swap), the unrealized one from the last
+// prices
+struct SPosition
+{
+	public:
+		SPosition();
+
+		bool isFlat() const;
+		std::string toString() const;
+
+	public:
+		char m_symbolName[consts::MaxSymbolNameLen];
+
+		std::size_t m_openCount = 0;
+		// the pending orders are not a part of the position, only counted
+		std::size_t m_pendingCount = 0;
+		volume_t m_buyLots = 0;
+		price_t m_buyPrice = 0;
+		volume_t m_sellLots = 0;
+		price_t m_sellPrice = 0;
+
+		// positive for long, negative for short
+		volume_t m_netLots = 0;
+		// the price at which the net position breaks even, 0 if it is flat
+		price_t m_averagePrice = 0;
+
+		volume_t m_realizedProfit = 0;
+		volume_t m_unrealizedProfit = 0;
+
+};
+
+// ---------------------------------------------------------------------------
+
+// the positions of all symbols of an account
+struct SAccountPosition
+{
+	public:
+		std::string toString() const;
+
+	public:
+		std::size_t m_symbolCount = 0;
+		std::size_t m_openCount = 0;
+		std::size_t m_pendingCount = 0;
+		volume_t m_grossLots = 0;
+		volume_t m_realizedProfit = 0;
+		volume_t m_unrealizedProfit = 0;
+
+		// incremented by every change, so the copies taken by different
+		// threads may be ordered
+		uint64_t m_version = 0;
+
+};
+
+} // namespace fx
+
+#endif
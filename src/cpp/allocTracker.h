@@ -0,0 +1,99 @@
+// author: Darek Slusarczyk alias marines marinesovitch 2012-2013, 2022
+#ifndef INC_CPP_ALLOCTRACKER_H
+#define INC_CPP_ALLOCTRACKER_H
+
+// opt-in heap allocation accounting: if cpp is built with CPP_TRACK_ALLOCATIONS
+// the global operator new/delete are replaced with versions which count the
+// allocations of the calling thread, otherwise the counters stay at zero and
+// CPP_ALLOC_PROBE expands to nothing
+
+namespace cpp
+{
+
+struct SAllocStats
+{
+	uint64_t m_allocs = 0;
+	uint64_t m_bytes = 0;
+	uint64_t m_frees = 0;
+};
+
+// counters of the calling thread since its start
+SAllocStats threadAllocStats();
+
+bool isAllocTrackingEnabled();
+
+// ---------------------------------------------------------------------------
+
+// statistics of a single probed place in the code, budget is the max number
+// of allocations per one pass, the first pass which exceeds it is reported on
+// cerr, all of them are counted
+class KAllocSite
+{
+	public:
+		KAllocSite(const char* name, const uint64_t budget);
+
+	public:
+		void onPass(const SAllocStats& stats);
+		void print(std::ostream& os) const;
+
+		bool isWithinBudget() const;
+
+	private:
+		const char* m_name;
+		const uint64_t m_budget;
+
+		std::atomic<uint64_t> m_passes = 0;
+		std::atomic<uint64_t> m_allocs = 0;
+		std::atomic<uint64_t> m_bytes = 0;
+		std::atomic<uint64_t> m_maxAllocs = 0;
+		std::atomic<uint64_t> m_overBudget = 0;
+
+};
+
+// prints all sites registered in the current module (exe/dll), a site is
+// registered on its first pass
+void printAllocSites(std::ostream& os);
+
+// prints the sites like printAllocSites, returns false if any of them went
+// over its budget
+bool checkAllocSites(std::ostream& os);
+
+// ---------------------------------------------------------------------------
+
+// counts allocations made by the current thread in its scope
+class KAllocProbe
+{
+	public:
+		KAllocProbe(KAllocSite* site);
+		~KAllocProbe();
+
+		KAllocProbe(const KAllocProbe&) = delete;
+		KAllocProbe& operator=(const KAllocProbe&) = delete;
+
+	private:
+		KAllocSite& m_site;
+		const SAllocStats m_start;
+
+};
+
+} // namespace cpp
+
+// ---------------------------------------------------------------------------
+#ifdef CPP_TRACK_ALLOCATIONS
+// ---------------------------------------------------------------------------
+
+#define CPP_ALLOC_PROBE(name, budget) \
+	static cpp::KAllocSite s_allocSite(name, budget); \
+	cpp::KAllocProbe allocProbe(&s_allocSite)
+
+// ---------------------------------------------------------------------------
+#else
+// ---------------------------------------------------------------------------
+
+#define CPP_ALLOC_PROBE(name, budget) ( ( void ) ( 0 ) )
+
+// ---------------------------------------------------------------------------
+#endif // CPP_TRACK_ALLOCATIONS
+// ---------------------------------------------------------------------------
+
+#endif
@@ -0,0 +1,247 @@
+// author: Darek Slusarczyk alias marines marinesovitch 2012-2013, 2022
+#include "ph.h"
+#include "allocTracker.h"
+#include "streams.h"
+#include <new>
+
+namespace cpp
+{
+
+namespace
+{
+
+// trivial type, so it doesn't need dynamic initialization and may be touched
+// safely by operator new/delete at any stage of the thread life
+thread_local SAllocStats t_allocStats;
+
+class KAllocSites
+{
+	public:
+		static KAllocSites& get();
+
+	public:
+		void add(KAllocSite* site);
+		bool print(std::ostream& os) const;
+
+	private:
+		mutable std::mutex m_mutex;
+		std::vector<KAllocSite*> m_sites;
+
+};
+
+// ---------------------------------------------------------------------------
+
+KAllocSites& KAllocSites::get()
+{
+	static KAllocSites s_sites;
+	return s_sites;
+}
+
+void KAllocSites::add(KAllocSite* site)
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+	m_sites.push_back(site);
+}
+
+bool KAllocSites::print(std::ostream& os) const
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+	bool result = true;
+	for (const KAllocSite* site : m_sites)
+	{
+		site->print(os);
+		if (!site->isWithinBudget())
+		{
+			result = false;
+		}
+	}
+	return result;
+}
+
+} // anonymous namespace
+
+// ---------------------------------------------------------------------------
+
+SAllocStats threadAllocStats()
+{
+	return t_allocStats;
+}
+
+bool isAllocTrackingEnabled()
+{
+#ifdef CPP_TRACK_ALLOCATIONS
+	return true;
+#else
+	return false;
+#endif
+}
+
+// ---------------------------------------------------------------------------
+
+KAllocSite::KAllocSite(const char* name, const uint64_t budget)
+	: m_name(name)
+	, m_budget(budget)
+{
+	KAllocSites::get().add(this);
+}
+
+void KAllocSite::onPass(const SAllocStats& stats)
+{
+	++m_passes;
+	m_allocs += stats.m_allocs;
+	m_bytes += stats.m_bytes;
+
+	bool newMax = false;
+	uint64_t maxAllocs = m_maxAllocs;
+	while ((maxAllocs < stats.m_allocs) && !newMax)
+	{
+		newMax = m_maxAllocs.compare_exchange_weak(maxAllocs, stats.m_allocs);
+	}
+
+	if ((m_budget < stats.m_allocs) && (m_overBudget++ == 0))
+	{
+		// the probed code runs in the hot paths, so the further breaches are
+		// only counted
+		cerr << m_name << ": " << stats.m_allocs << " allocations ("
+			<< stats.m_bytes << " bytes) exceed budget " << m_budget << std::endl;
+	}
+}
+
+void KAllocSite::print(std::ostream& os) const
+{
+	const uint64_t passes = m_passes;
+	const double avgAllocs = (0 < passes) ? (static_cast<double>(m_allocs) / passes) : 0.0;
+	const double avgBytes = (0 < passes) ? (static_cast<double>(m_bytes) / passes) : 0.0;
+	os << m_name << ": " << passes << " passes, "
+		<< std::fixed << std::setprecision(2) << avgAllocs << " allocs (" << avgBytes << " bytes) avg, "
+		<< m_maxAllocs << " max, budget " << m_budget << std::defaultfloat;
+	if (!isWithinBudget())
+	{
+		os << ", " << m_overBudget << " passes over budget";
+	}
+	os << std::endl;
+}
+
+bool KAllocSite::isWithinBudget() const
+{
+	const bool result = (m_overBudget == 0);
+	return result;
+}
+
+void printAllocSites(std::ostream& os)
+{
+	KAllocSites::get().print(os);
+}
+
+bool checkAllocSites(std::ostream& os)
+{
+	const bool result = KAllocSites::get().print(os);
+	return result;
+}
+
+// ---------------------------------------------------------------------------
+
+KAllocProbe::KAllocProbe(KAllocSite* site)
+	: m_site(*site)
+	, m_start(t_allocStats)
+{
+}
+
+KAllocProbe::~KAllocProbe()
+{
+	SAllocStats stats;
+	stats.m_allocs = t_allocStats.m_allocs - m_start.m_allocs;
+	stats.m_bytes = t_allocStats.m_bytes - m_start.m_bytes;
+	stats.m_frees = t_allocStats.m_frees - m_start.m_frees;
+	m_site.onPass(stats);
+}
+
+} // namespace cpp
+
+// ---------------------------------------------------------------------------
+#ifdef CPP_TRACK_ALLOCATIONS
+// ---------------------------------------------------------------------------
+
+// the replacements are linked into every module which uses any probe, aligned
+// variants are left to the runtime and are not counted
+
+namespace
+{
+
+void* trackedAlloc(std::size_t size)
+{
+	cpp::t_allocStats.m_allocs += 1;
+	cpp::t_allocStats.m_bytes += size;
+	void* result = std::malloc(size != 0 ? size : 1);
+	return result;
+}
+
+void trackedFree(void* ptr)
+{
+	if (ptr != nullptr)
+	{
+		cpp::t_allocStats.m_frees += 1;
+		std::free(ptr);
+	}
+}
+
+} // anonymous namespace
+
+void* operator new(std::size_t size)
+{
+	void* result = trackedAlloc(size);
+	if (result == nullptr)
+	{
+		throw std::bad_alloc();
+	}
+	return result;
+}
+
+void* operator new[](std::size_t size)
+{
+	return operator new(size);
+}
+
+void* operator new(std::size_t size, const std::nothrow_t&) noexcept
+{
+	return trackedAlloc(size);
+}
+
+void* operator new[](std::size_t size, const std::nothrow_t&) noexcept
+{
+	return trackedAlloc(size);
+}
+
+void operator delete(void* ptr) noexcept
+{
+	trackedFree(ptr);
+}
+
+void operator delete[](void* ptr) noexcept
+{
+	trackedFree(ptr);
+}
+
+void operator delete(void* ptr, std::size_t) noexcept
+{
+	trackedFree(ptr);
+}
+
+void operator delete[](void* ptr, std::size_t) noexcept
+{
+	trackedFree(ptr);
+}
+
+void operator delete(void* ptr, const std::nothrow_t&) noexcept
+{
+	trackedFree(ptr);
+}
+
+void operator delete[](void* ptr, const std::nothrow_t&) noexcept
+{
+	trackedFree(ptr);
+}
+
+// ---------------------------------------------------------------------------
+#endif // CPP_TRACK_ALLOCATIONS
+// ---------------------------------------------------------------------------
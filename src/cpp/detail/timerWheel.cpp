@@ -0,0 +1,94 @@
+// author: Darek Slusarczyk alias marines marinesovitch 2012-2013, 2022
+#include "ph.h"
+#include "timerWheel.h"
+
+namespace cpp
+{
+
+KTimerWheel::KTimerWheel(
+	const clock_t::duration resolution,
+	const std::size_t slotCount,
+	const clock_t::time_point start)
+	: m_resolution(resolution)
+	, m_start(start)
+	, m_slots(slotCount)
+{
+}
+
+KTimerWheel::timer_id_t KTimerWheel::schedule(const clock_t::time_point due, const uint64_t payload)
+{
+	// the first tick which ends not earlier than due, a timer due now or in
+	// the past waits for the next tick
+	const clock_t::duration offset = (std::max)(due - m_start, clock_t::duration::zero());
+	const uint64_t dueTick = static_cast<uint64_t>((offset + m_resolution - clock_t::duration(1)) / m_resolution);
+	const uint64_t ticksAhead = (dueTick > m_current) ? (dueTick - m_current) : 1;
+
+	const std::size_t slotCount = m_slots.size();
+	const std::size_t slot = static_cast<std::size_t>((m_current + ticksAhead) % slotCount);
+	const timer_id_t id = m_nextId++;
+	slot_t& timers = m_slots[slot];
+	timers.push_back(STimer{ id, payload, (ticksAhead - 1) / slotCount });
+	m_id2location.emplace(id, SLocation{ slot, std::prev(timers.end()) });
+	return id;
+}
+
+bool KTimerWheel::cancel(const timer_id_t id)
+{
+	auto it = m_id2location.find(id);
+	if (it == m_id2location.end())
+	{
+		return false;
+	}
+
+	m_slots[it->second.m_slot].erase(it->second.m_it);
+	m_id2location.erase(it);
+	return true;
+}
+
+void KTimerWheel::advance(const clock_t::time_point now, std::vector<uint64_t>* expired)
+{
+	const uint64_t nowTick = static_cast<uint64_t>((now - m_start) / m_resolution);
+	while (m_current < nowTick)
+	{
+		++m_current;
+		if (m_id2location.empty())
+		{
+			// nothing to expire, the wheel just catches up with the time
+			m_current = nowTick;
+			break;
+		}
+
+		slot_t& timers = m_slots[static_cast<std::size_t>(m_current % m_slots.size())];
+		for (auto it = timers.begin(); it != timers.end(); )
+		{
+			if (it->m_rounds == 0)
+			{
+				expired->push_back(it->m_payload);
+				m_id2location.erase(it->m_id);
+				it = timers.erase(it);
+			}
+			else
+			{
+				--it->m_rounds;
+				++it;
+			}
+		}
+	}
+}
+
+bool KTimerWheel::empty() const
+{
+	return m_id2location.empty();
+}
+
+std::size_t KTimerWheel::size() const
+{
+	return m_id2location.size();
+}
+
+KTimerWheel::clock_t::duration KTimerWheel::resolution() const
+{
+	return m_resolution;
+}
+
+} // namespace cpp
@@ -0,0 +1,172 @@
+// author: Darek Slusarczyk alias marines marinesovitch 2012-2013, 2022
+#include "ph.h"
+#include "workStealingPool.h"
+
+namespace cpp
+{
+
+KWorkStealingPool::KWorkStealingPool(const unsigned int workerCount)
+	: m_failed(false)
+{
+	const unsigned int count = (workerCount != 0) ? workerCount : std::max(1u, std::thread::hardware_concurrency());
+	for (unsigned int i = 0; i < count; ++i)
+	{
+		m_ranges.emplace_back(new SRange());
+	}
+
+	// the worker 0 is the thread calling run
+	for (unsigned int i = 1; i < count; ++i)
+	{
+		m_threads.emplace_back(&KWorkStealingPool::workerLoop, this, i);
+	}
+}
+
+KWorkStealingPool::~KWorkStealingPool()
+{
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		m_stop = true;
+	}
+	m_onJob.notify_all();
+	for (std::thread& thread : m_threads)
+	{
+		thread.join();
+	}
+}
+
+unsigned int KWorkStealingPool::size() const
+{
+	return static_cast<unsigned int>(m_ranges.size());
+}
+
+void KWorkStealingPool::run(const std::size_t count, const task_t& task)
+{
+	const std::size_t workerCount = m_ranges.size();
+	for (std::size_t i = 0; i < workerCount; ++i)
+	{
+		SRange& range = *m_ranges[i];
+		std::lock_guard<std::mutex> lock(range.m_mutex);
+		range.m_begin = count * i / workerCount;
+		range.m_end = count * (i + 1) / workerCount;
+	}
+
+	m_failed = false;
+	m_error = nullptr;
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		m_task = &task;
+		m_busyCount = static_cast<unsigned int>(m_threads.size());
+		++m_generation;
+	}
+	m_onJob.notify_all();
+
+	work(0);
+
+	std::unique_lock<std::mutex> lock(m_mutex);
+	m_onIdle.wait(lock, [this]{ return m_busyCount == 0; });
+	m_task = nullptr;
+	if (m_error)
+	{
+		std::rethrow_exception(m_error);
+	}
+}
+
+// ---------------------------------------------------------------------------
+
+void KWorkStealingPool::workerLoop(const unsigned int worker)
+{
+	uint64_t generation = 0;
+	for (;;)
+	{
+		{
+			std::unique_lock<std::mutex> lock(m_mutex);
+			m_onJob.wait(lock, [&]{ return m_stop || (generation != m_generation); });
+			if (m_stop)
+			{
+				return;
+			}
+			generation = m_generation;
+		}
+
+		work(worker);
+
+		{
+			std::lock_guard<std::mutex> lock(m_mutex);
+			--m_busyCount;
+		}
+		m_onIdle.notify_one();
+	}
+}
+
+void KWorkStealingPool::work(const unsigned int worker)
+{
+	std::size_t index = 0;
+	while (popOwn(worker, &index) || steal(worker, &index))
+	{
+		if (m_failed)
+		{
+			continue;
+		}
+
+		try
+		{
+			(*m_task)(index, worker);
+		}
+		catch (...)
+		{
+			std::lock_guard<std::mutex> lock(m_mutex);
+			if (!m_error)
+			{
+				m_error = std::current_exception();
+			}
+			m_failed = true;
+		}
+	}
+}
+
+bool KWorkStealingPool::popOwn(const unsigned int worker, std::size_t* index)
+{
+	SRange& range = *m_ranges[worker];
+	std::lock_guard<std::mutex> lock(range.m_mutex);
+	if (range.m_begin == range.m_end)
+	{
+		return false;
+	}
+	*index = range.m_begin++;
+	return true;
+}
+
+bool KWorkStealingPool::steal(const unsigned int worker, std::size_t* index)
+{
+	const std::size_t workerCount = m_ranges.size();
+	for (std::size_t i = 1; i < workerCount; ++i)
+	{
+		SRange& victim = *m_ranges[(worker + i) % workerCount];
+		std::size_t begin = 0;
+		std::size_t end = 0;
+		{
+			std::lock_guard<std::mutex> lock(victim.m_mutex);
+			if (victim.m_begin == victim.m_end)
+			{
+				continue;
+			}
+			// the back half, the victim keeps at least one index if it has
+			// more than one
+			begin = victim.m_end - (victim.m_end - victim.m_begin) / 2 - ((victim.m_end - victim.m_begin) == 1 ? 1 : 0);
+			end = victim.m_end;
+			victim.m_end = begin;
+		}
+
+		// only the owner refills its range and it is empty, so nobody else
+		// writes it now
+		SRange& own = *m_ranges[worker];
+		std::lock_guard<std::mutex> lock(own.m_mutex);
+		*index = begin;
+		own.m_begin = begin + 1;
+		own.m_end = end;
+		return true;
+	}
+	return false;
+}
+
+} // namespace cpp
@@ -0,0 +1,136 @@
+// author: Darek Slusarczyk alias marines marinesovitch 2012-2013, 2022
+#ifndef INC_CPP_MPSCQUEUE_H
+#define INC_CPP_MPSCQUEUE_H
+
+#include "types.h"
+
+namespace cpp
+{
+
+// a bounded lock-free queue of many producers and a single consumer, after
+// D. Vyukov: each cell has a sequence number which tells whether it is free
+// for the producer of a given position or filled for the consumer of it;
+// producers claim positions with a CAS on the tail, the consumer owns the
+// head; the cells are allocated once, so pushing and popping never touch the
+// heap; the order of items of a single producer is kept
+template<typename TItem>
+class KMpscQueue
+{
+	public:
+		// capacity is rounded up to power of 2
+		explicit KMpscQueue(const std::size_t capacity)
+			: m_capacity(roundUp(capacity))
+			, m_mask(m_capacity - 1)
+			, m_cells(new SCell[m_capacity])
+		{
+			for (std::size_t i = 0; i < m_capacity; ++i)
+			{
+				m_cells[i].m_sequence.store(i, std::memory_order_relaxed);
+			}
+		}
+
+		KMpscQueue(const KMpscQueue&) = delete;
+		KMpscQueue& operator=(const KMpscQueue&) = delete;
+
+	public:
+		// returns false if the queue is full
+		bool tryPush(const TItem& item)
+		{
+			uint64_t position = m_tail.load(std::memory_order_relaxed);
+			SCell* cell = nullptr;
+			for (;;)
+			{
+				cell = &m_cells[position & m_mask];
+				const uint64_t sequence = cell->m_sequence.load(std::memory_order_acquire);
+				const int64_t difference = static_cast<int64_t>(sequence - position);
+				if (difference == 0)
+				{
+					if (m_tail.compare_exchange_weak(position, position + 1, std::memory_order_relaxed))
+					{
+						break;
+					}
+				}
+				else if (difference < 0)
+				{
+					return false;
+				}
+				else
+				{
+					position = m_tail.load(std::memory_order_relaxed);
+				}
+			}
+
+			cell->m_item = item;
+			cell->m_sequence.store(position + 1, std::memory_order_release);
+			return true;
+		}
+
+		// may be called only by the consumer, returns false if the queue is
+		// empty or the oldest item isn't completely pushed yet
+		bool tryPop(TItem* item)
+		{
+			const uint64_t position = m_head.load(std::memory_order_relaxed);
+			SCell& cell = m_cells[position & m_mask];
+			const uint64_t sequence = cell.m_sequence.load(std::memory_order_acquire);
+			if (sequence != position + 1)
+			{
+				return false;
+			}
+
+			*item = cell.m_item;
+			cell.m_sequence.store(position + m_capacity, std::memory_order_release);
+			m_head.store(position + 1, std::memory_order_relaxed);
+			return true;
+		}
+
+		// approximate if called while the queue is used
+		std::size_t size() const
+		{
+			const uint64_t head = m_head.load(std::memory_order_relaxed);
+			const uint64_t tail = m_tail.load(std::memory_order_relaxed);
+			const std::size_t result = (head < tail) ? static_cast<std::size_t>(tail - head) : 0;
+			return result;
+		}
+
+		bool empty() const
+		{
+			return size() == 0;
+		}
+
+		std::size_t capacity() const
+		{
+			return m_capacity;
+		}
+
+	private:
+		struct SCell
+		{
+			std::atomic<uint64_t> m_sequence;
+			TItem m_item;
+		};
+
+		static std::size_t roundUp(const std::size_t value)
+		{
+			std::size_t result = 2;
+			while (result < value)
+			{
+				result <<= 1;
+			}
+			return result;
+		}
+
+	private:
+		const std::size_t m_capacity;
+		const uint64_t m_mask;
+		std::unique_ptr<SCell[]> m_cells;
+
+		// on separate cache lines, so the producers don't slow down the
+		// consumer
+		alignas(64) std::atomic<uint64_t> m_tail = 0;
+		alignas(64) std::atomic<uint64_t> m_head = 0;
+
+};
+
+} // namespace cpp
+
+#endif
@@ -0,0 +1,75 @@
+// author: Darek Slusarczyk alias marines marinesovitch 2012-2013, 2022
+#ifndef INC_CPP_TIMERWHEEL_H
+#define INC_CPP_TIMERWHEEL_H
+
+#include <chrono>
+#include <list>
+#include <unordered_map>
+
+namespace cpp
+{
+
+// a hashed timing wheel: the time is divided into ticks of the resolution,
+// a timer is put into the slot of the tick it is due in, with the count of
+// the full turns of the wheel it has to wait; scheduling and cancelling are
+// O(1), advancing visits only the slots of the passed ticks; a timer never
+// expires earlier than it is due, but up to a tick later; it is not
+// synchronized
+class KTimerWheel
+{
+	public:
+		typedef std::chrono::steady_clock clock_t;
+		typedef uint64_t timer_id_t;
+
+		KTimerWheel(
+			const clock_t::duration resolution,
+			const std::size_t slotCount,
+			const clock_t::time_point start = clock_t::now());
+
+		KTimerWheel(const KTimerWheel&) = delete;
+		KTimerWheel& operator=(const KTimerWheel&) = delete;
+
+	public:
+		// the payload is returned by advance when the timer expires
+		timer_id_t schedule(const clock_t::time_point due, const uint64_t payload);
+		bool cancel(const timer_id_t id);
+
+		// moves the wheel up to now and appends the payloads of the expired
+		// timers in the order they were due
+		void advance(const clock_t::time_point now, std::vector<uint64_t>* expired);
+
+		bool empty() const;
+		std::size_t size() const;
+		clock_t::duration resolution() const;
+
+	private:
+		struct STimer
+		{
+			timer_id_t m_id;
+			uint64_t m_payload;
+			uint64_t m_rounds;
+		};
+
+		typedef std::list<STimer> slot_t;
+
+		struct SLocation
+		{
+			std::size_t m_slot;
+			slot_t::iterator m_it;
+		};
+
+	private:
+		const clock_t::duration m_resolution;
+		const clock_t::time_point m_start;
+		std::vector<slot_t> m_slots;
+		// the last tick visited by advance
+		uint64_t m_current = 0;
+
+		timer_id_t m_nextId = 1;
+		std::unordered_map<timer_id_t, SLocation> m_id2location;
+
+};
+
+} // namespace cpp
+
+#endif
@@ -0,0 +1,70 @@
+// author: Darek Slusarczyk alias marines marinesovitch 2012-2013, 2022
+#ifndef INC_CPP_WORKSTEALINGPOOL_H
+#define INC_CPP_WORKSTEALINGPOOL_H
+
+#include <functional>
+
+namespace cpp
+{
+
+// a pool of threads for loops of independent tasks: each worker gets a
+// contiguous range of indices and takes them from its front, a worker which
+// runs out of work steals the back half of the range of another one, so the
+// tasks of different duration are balanced without a shared queue; the
+// thread calling run works too
+class KWorkStealingPool
+{
+	public:
+		// 0 means one worker per hardware thread
+		explicit KWorkStealingPool(const unsigned int workerCount = 0);
+		~KWorkStealingPool();
+
+		KWorkStealingPool(const KWorkStealingPool&) = delete;
+		KWorkStealingPool& operator=(const KWorkStealingPool&) = delete;
+
+	public:
+		// the number of workers including the calling thread
+		unsigned int size() const;
+
+		typedef std::function<void(const std::size_t index, const unsigned int worker)> task_t;
+
+		// calls task for each index in [0, count) and returns when all of
+		// them are done; worker is in [0, size()), so the task may use it to
+		// pick the state of the worker; if a task throws, the remaining ones
+		// are skipped and the first exception is rethrown; it is not
+		// reentrant
+		void run(const std::size_t count, const task_t& task);
+
+	private:
+		struct alignas(64) SRange
+		{
+			std::mutex m_mutex;
+			std::size_t m_begin = 0;
+			std::size_t m_end = 0;
+		};
+
+		void workerLoop(const unsigned int worker);
+		void work(const unsigned int worker);
+		bool popOwn(const unsigned int worker, std::size_t* index);
+		bool steal(const unsigned int worker, std::size_t* index);
+
+	private:
+		std::vector<std::unique_ptr<SRange>> m_ranges;
+		std::vector<std::thread> m_threads;
+
+		std::mutex m_mutex;
+		std::condition_variable m_onJob;
+		std::condition_variable m_onIdle;
+		uint64_t m_generation = 0;
+		unsigned int m_busyCount = 0;
+		bool m_stop = false;
+
+		const task_t* m_task = nullptr;
+		std::atomic<bool> m_failed;
+		std::exception_ptr m_error;
+
+};
+
+} // namespace cpp
+
+#endif
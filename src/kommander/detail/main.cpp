@@ -2,6 +2,8 @@
 #include "ph.h"
 #include "backend/instance.h"
 #include "backend/executor.h"
+#include "backend/executionSimulator.h"
+#include "backend/tradeManager.h"
 #include "cpp/strUtils.h"
 
 namespace fx
@@ -10,9 +12,77 @@ namespace fx
 namespace
 {
 
-void runAppLoop()
+const std::string OptPaper = "--paper";
+
+// --paper [spread=price] [slippage=price] [latency=seconds] [commission=money]
+// [contract=size]
+bool parseOptions(int argc, char* argv[], std::unique_ptr<SExecutionParams>* paperParams, std::string* error)
+{
+	int index = 1;
+	if (index == argc)
+	{
+		return true;
+	}
+
+	if (argv[index] != OptPaper)
+	{
+		*error = "unknown option " + std::string(argv[index]);
+		return false;
+	}
+
+	paperParams->reset(new SExecutionParams());
+	SExecutionParams& params = **paperParams;
+	for (++index; index < argc; ++index)
+	{
+		const std::string arg = argv[index];
+		const std::size_t separator = arg.find('=');
+		const std::string name = arg.substr(0, separator);
+		const std::string value = (separator != std::string::npos) ? arg.substr(separator + 1) : std::string();
+		try
+		{
+			if (name == "spread")
+			{
+				params.m_spread = std::stod(value);
+			}
+			else if (name == "slippage")
+			{
+				params.m_slippage = std::stod(value);
+			}
+			else if (name == "latency")
+			{
+				params.m_latency = std::stoll(value);
+			}
+			else if (name == "commission")
+			{
+				params.m_commission = std::stod(value);
+			}
+			else if (name == "contract")
+			{
+				params.m_contractSize = std::stod(value);
+			}
+			else
+			{
+				*error = "unknown option of paper trading " + arg;
+				return false;
+			}
+		}
+		catch (std::logic_error&)
+		{
+			*error = "incorrect value " + arg;
+			return false;
+		}
+	}
+	return true;
+}
+
+void runAppLoop(const SExecutionParams* paperParams)
 {
 	KInstance instance( &std::cout, &std::cerr );
+	if (paperParams != nullptr)
+	{
+		instance.tradeManager().setPaperTrading(*paperParams);
+		std::cout << "paper trading" << std::endl;
+	}
 	instance.run();
 
 	IExecutor& executor = instance.executor();
@@ -43,7 +113,14 @@ void runAppLoop()
 
 } // namespace fx
 
-int main()
+int main(int argc, char* argv[])
 {
-	fx::runAppLoop();
+	std::unique_ptr<fx::SExecutionParams> paperParams;
+	std::string error;
+	if (!fx::parseOptions(argc, argv, &paperParams, &error))
+	{
+		std::cerr << error << std::endl;
+		return 1;
+	}
+	fx::runAppLoop(paperParams.get());
 }
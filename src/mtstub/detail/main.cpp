@@ -1,67 +1,51 @@
 // author: Darek Slusarczyk alias marines marinesovitch 2012-2013, 2022
 #include "ph.h"
+#include "stubOptions.h"
+#include "priceModel.h"
+#include "tickGenerator.h"
+#include "simulatedBroker.h"
 #include "adapter/adapter.h"
 #include "cpp/strUtils.h"
-#include <random>
 
 namespace
 {
 
-const wchar_t* Symbol = L"EURPLN";
+const wchar_t* Broker = L"FakeBroker";
+const int64_t BaseAccountLogin = 12345678;
 
-void generateTicks()
-{
-	constexpr double MinExchangeRate = 4.23;
-	constexpr double MaxExchangeRate = 4.25;
+typedef std::vector<HANDLE> handles_t;
 
-	std::random_device rd;
-	std::default_random_engine eng(rd());
-	std::uniform_real_distribution<double> distr(MinExchangeRate, MaxExchangeRate);
+std::atomic<bool> s_stopCmdLoop = false;
 
-	while (true)
-	{
-		const long time = static_cast<long>(std::time(nullptr));
-		const double bid = distr(eng);
-		const double ask = bid + distr(eng) / 1000.0;
-		const double last = (bid + ask + distr(eng)) / 3.0;
-		DumpTick(Symbol, time, bid, ask, last);
-		std::this_thread::sleep_for(std::chrono::seconds(1));
-	}
-}
-
-bool executeCommand(const wchar_t* wcmd, const int argCount, fx::MqlStr args[], const int ticketCount, int tickets[])
+bool executeCommand(
+	fx::KSimulatedBroker* broker,
+	const wchar_t* wcmd,
+	const int argCount,
+	fx::MqlStr args[],
+	const int ticketCount,
+	int tickets[])
 {
 	const std::string& cmd = cpp::su::w2str(wcmd);
-	std::cout << cmd;
 
+	cpp::strings_t cmdArgs;
+	cmdArgs.reserve(argCount);
 	for (int i = 0; i < argCount; ++i)
 	{
 		const wchar_t* arg = args[i].m_data;
-		std::cout << ' ' << cpp::su::w2str(arg);
+		cmdArgs.push_back(cpp::su::w2str(arg));
 	}
 
-	if (0 < ticketCount)
-	{
-		std::cout << " --";
+	const cpp::ints_t cmdTickets(tickets, tickets + ticketCount);
 
-		for (int i = 0; i < ticketCount; ++i)
-		{
-			const int ticket = tickets[i];
-			std::cout << ' ' << ticket;
-		}
-	}
-
-	std::cout << std::endl;
-
-	OnCommandCompleted(L"error - not implemented");
+	const std::string& result = broker->executeCommand(cmd, cmdArgs, cmdTickets);
+	OnCommandCompleted(cpp::su::str2w(result).c_str());
 
 	return true;
 }
 
-void cmdLoop()
+void cmdLoop(const fx::SStubOptions& options, fx::KSimulatedBroker* broker)
 {
 	const int MaxCmdArgCount = GetMaxCmdArgCount();
-	typedef wchar_t* wchars_t;
 	fx::MqlStr* cmdArgs = new fx::MqlStr[MaxCmdArgCount];
 
 	int cmdArgCount = 0;
@@ -79,18 +63,16 @@ void cmdLoop()
 	int MaxCmdTicketCount = GetMaxCmdTicketCount();
 	int* cmdTickets = new int[MaxCmdTicketCount];
 
-	std::wstring CmdResult;
-
 	wchar_t* cmd = new wchar_t[MaxCmdStringLen];
 
 	bool run = true;
-	while (run)
+	while (run && !s_stopCmdLoop)
 	{
 		while(GetCommand(cmd, &cmdArgCount, cmdArgs, &cmdTicketCount, cmdTickets))
 		{
-			run = executeCommand(cmd, cmdArgCount, cmdArgs, cmdTicketCount, cmdTickets);
+			run = executeCommand(broker, cmd, cmdArgCount, cmdArgs, cmdTicketCount, cmdTickets);
 		}
-		const std::chrono::milliseconds dura(1000);
+		const std::chrono::milliseconds dura(options.m_cmdPollInterval);
 		std::this_thread::sleep_for(dura);
 	}
 
@@ -103,21 +85,106 @@ void cmdLoop()
 	delete[] cmdArgs;
 }
 
+// mtfxcolt.dll serves a single account per process, so the master process
+// starts one more mtstub process per each further account
+handles_t spawnAccountProcesses(const fx::SStubOptions& options)
+{
+	char exePath[MAX_PATH] = { 0 };
+	GetModuleFileNameA(nullptr, exePath, MAX_PATH);
+
+	std::string args;
+	for (const std::string& arg : options.m_rawArgs)
+	{
+		args += ' ' + arg;
+	}
+
+	handles_t result;
+	for (int i = 1; i < options.m_accountCount; ++i)
+	{
+		std::string cmdLine = '"' + std::string(exePath) + '"' + args + " --account-index " + std::to_string(i);
+		STARTUPINFOA startupInfo = { 0 };
+		startupInfo.cb = sizeof(startupInfo);
+		PROCESS_INFORMATION processInfo = { 0 };
+		if (CreateProcessA(exePath, &cmdLine[0], nullptr, nullptr, FALSE, 0, nullptr, nullptr, &startupInfo, &processInfo))
+		{
+			CloseHandle(processInfo.hThread);
+			result.push_back(processInfo.hProcess);
+		}
+		else
+		{
+			std::cerr << "cannot start process for account " << i << ", error " << GetLastError() << std::endl;
+		}
+	}
+	return result;
 }
 
-int main()
+void waitForAccountProcesses(const handles_t& processes)
 {
-	//std::thread noteSlotThread(&cmdLoop);
-	//noteSlotThread.detach();
+	for (HANDLE process : processes)
+	{
+		WaitForSingleObject(process, INFINITE);
+		CloseHandle(process);
+	}
+}
+
+unsigned int makeSeed(const fx::SStubOptions& options)
+{
+	unsigned int result = 0;
+	if (options.m_seed == 0)
+	{
+		std::random_device rd;
+		result = rd();
+	}
+	else
+	{
+		// the same seed would give all accounts the very same prices
+		result = options.m_seed + options.accountIndex();
+	}
+	return result;
+}
+
+}
+
+int main(int argc, char* argv[])
+{
+	fx::SStubOptions options;
+	std::string error;
+	if (!fx::parseStubOptions(argc, argv, &options, &error))
+	{
+		std::cerr << error << std::endl;
+		fx::printStubUsage(std::cerr);
+		return 1;
+	}
+
+	handles_t accountProcesses;
+	if (options.isMaster())
+	{
+		accountProcesses = spawnAccountProcesses(options);
+	}
+
+	fx::KPriceModel priceModel(options.m_symbolCount, options.m_volatility, options.m_spread, makeSeed(options));
 
-	const wchar_t* broker = L"FakeBroker";
-	const fx::account_login_t accountLogin(12345678);
-	RegisterSymbol(broker, accountLogin, Symbol);
+	const fx::account_login_t accountLogin(BaseAccountLogin + options.accountIndex());
+	for (int i = 0; i < priceModel.symbolCount(); ++i)
+	{
+		RegisterSymbol(Broker, accountLogin, priceModel.symbol(i).c_str());
+	}
+
+	fx::KSimulatedBroker broker(options, priceModel);
+	std::thread cmdThread(&cmdLoop, std::cref(options), &broker);
 
-	std::thread ticksThread(generateTicks);
-	ticksThread.detach();
+	fx::KTickGenerator tickGenerator(options, &priceModel, &broker);
+	tickGenerator.run();
 
-	cmdLoop();
+	s_stopCmdLoop = true;
+	cmdThread.join();
+	broker.report();
+
+	for (int i = 0; i < priceModel.symbolCount(); ++i)
+	{
+		UnregisterSymbol(priceModel.symbol(i).c_str());
+	}
 
-	UnregisterSymbol(Symbol);
+	waitForAccountProcesses(accountProcesses);
+	return 0;
 }
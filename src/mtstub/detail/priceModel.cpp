@@ -0,0 +1,135 @@
+// author: Darek Slusarczyk alias marines marinesovitch 2012-2013, 2022
+#include "ph.h"
+#include "priceModel.h"
+#include "cpp/strUtils.h"
+#include <cmath>
+
+namespace fx
+{
+
+namespace
+{
+
+struct SSymbolSeed
+{
+	const char* m_name;
+	double m_price;
+	int m_digits;
+};
+
+const SSymbolSeed SymbolSeeds[] = {
+	{ "EURUSD", 1.0220, 5 },
+	{ "GBPUSD", 1.2020, 5 },
+	{ "USDJPY", 136.50, 3 },
+	{ "USDCHF", 0.9640, 5 },
+	{ "EURPLN", 4.7400, 5 },
+	{ "AUDUSD", 0.6930, 5 },
+	{ "USDCAD", 1.2950, 5 },
+	{ "EURGBP", 0.8500, 5 },
+	{ "EURJPY", 139.50, 3 },
+	{ "USDPLN", 4.6400, 5 },
+	{ "NZDUSD", 0.6240, 5 },
+	{ "EURCHF", 0.9850, 5 },
+	{ "GBPJPY", 164.10, 3 },
+	{ "CHFJPY", 141.60, 3 },
+	{ "AUDJPY", 94.600, 3 },
+	{ "EURCAD", 1.3230, 5 }
+};
+
+const int SymbolSeedCount = sizeof(SymbolSeeds) / sizeof(SymbolSeeds[0]);
+
+const double SecondsPerDay = 24.0 * 60.0 * 60.0;
+
+// chance the spread gets widened on a tick, and how much at most
+const double SpreadWideningChance = 0.02;
+const double MaxSpreadWidening = 4.0;
+
+} // anonymous namespace
+
+// ---------------------------------------------------------------------------
+
+KPriceModel::KPriceModel(
+	const int symbolCount,
+	const double dailyVolatility,
+	const double spreadPoints,
+	const unsigned int seed)
+	: m_engine(seed)
+	, m_normal(0.0, 1.0)
+	, m_uniform(0.0, 1.0)
+	, m_volatility(dailyVolatility / 100.0 / std::sqrt(SecondsPerDay))
+{
+	m_symbols.resize(symbolCount);
+	for (int i = 0; i < symbolCount; ++i)
+	{
+		initSymbol(i, spreadPoints);
+	}
+}
+
+int KPriceModel::symbolCount() const
+{
+	const int result = static_cast<int>(m_symbols.size());
+	return result;
+}
+
+const std::wstring& KPriceModel::symbol(const int index) const
+{
+	const SSymbol& symbol = m_symbols[index];
+	return symbol.m_name;
+}
+
+SQuote KPriceModel::next(const int index, const double elapsedSeconds)
+{
+	SSymbol& symbol = m_symbols[index];
+
+	const double step = m_volatility * std::sqrt(elapsedSeconds) * m_normal(m_engine);
+	symbol.m_mid *= std::exp(step);
+
+	double spread = symbol.m_spread;
+	if (m_uniform(m_engine) < SpreadWideningChance)
+	{
+		spread *= 1.0 + m_uniform(m_engine) * MaxSpreadWidening;
+	}
+
+	SQuote& quote = symbol.m_quote;
+	quote.m_bid = round(symbol.m_mid - spread / 2.0, symbol.m_point);
+	quote.m_ask = std::max(round(symbol.m_mid + spread / 2.0, symbol.m_point), quote.m_bid + symbol.m_point);
+	quote.m_last = (m_uniform(m_engine) < 0.5) ? quote.m_bid : quote.m_ask;
+	return quote;
+}
+
+std::mt19937& KPriceModel::engine()
+{
+	return m_engine;
+}
+
+void KPriceModel::initSymbol(const int index, const double spreadPoints)
+{
+	SSymbol& symbol = m_symbols[index];
+	const SSymbolSeed& seed = SymbolSeeds[index % SymbolSeedCount];
+	if (index < SymbolSeedCount)
+	{
+		symbol.m_name = cpp::su::str2w(seed.m_name);
+	}
+	else
+	{
+		// more symbols than the real ones, so make up synthetic names, e.g. SYN0042
+		std::ostringstream os;
+		os << "SYN" << std::setw(4) << std::setfill('0') << index;
+		symbol.m_name = cpp::su::str2w(os.str());
+	}
+
+	symbol.m_point = std::pow(10.0, -seed.m_digits);
+	symbol.m_spread = spreadPoints * symbol.m_point;
+
+	// spread the initial prices of synthetic symbols a bit
+	const double shift = (index < SymbolSeedCount) ? 1.0 : (0.9 + 0.2 * m_uniform(m_engine));
+	symbol.m_mid = seed.m_price * shift;
+}
+
+double KPriceModel::round(const double value, const double point)
+{
+	const double result = std::floor(value / point + 0.5) * point;
+	return result;
+}
+
+} // namespace fx
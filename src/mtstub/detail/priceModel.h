@@ -0,0 +1,66 @@
+// author: Darek Slusarczyk alias marines marinesovitch 2012-2013, 2022
+#ifndef INC_MTSTUB_PRICEMODEL_H
+#define INC_MTSTUB_PRICEMODEL_H
+
+#include "common/baseTypes.h"
+#include <random>
+
+namespace fx
+{
+
+struct SQuote
+{
+	price_t m_bid = 0.0;
+	price_t m_ask = 0.0;
+	price_t m_last = 0.0;
+};
+
+// geometric random walk of mid price per symbol, the step depends on the real
+// time elapsed since the previous tick of the symbol, so the shape of the price
+// curve doesn't depend on the tick rate
+class KPriceModel
+{
+	public:
+		KPriceModel(
+			const int symbolCount,
+			const double dailyVolatility,
+			const double spreadPoints,
+			const unsigned int seed);
+
+	public:
+		int symbolCount() const;
+		const std::wstring& symbol(const int index) const;
+
+		SQuote next(const int index, const double elapsedSeconds);
+
+		std::mt19937& engine();
+
+	private:
+		struct SSymbol
+		{
+			std::wstring m_name;
+			double m_mid;
+			double m_point;
+			double m_spread;
+			SQuote m_quote;
+		};
+		typedef std::vector<SSymbol> symbols_t;
+
+		void initSymbol(const int index, const double spreadPoints);
+		static double round(const double value, const double point);
+
+	private:
+		std::mt19937 m_engine;
+		std::normal_distribution<double> m_normal;
+		std::uniform_real_distribution<double> m_uniform;
+
+		// volatility per second, as a fraction of price
+		const double m_volatility;
+
+		symbols_t m_symbols;
+
+};
+
+} // namespace fx
+
+#endif
@@ -0,0 +1,573 @@
+// author: Darek Slusarczyk alias marines marinesovitch 2012-2013, 2022
+#include "ph.h"
+#include "simulatedBroker.h"
+#include "stubOptions.h"
+#include "adapter/adapter.h"
+#include "cpp/strUtils.h"
+
+namespace fx
+{
+
+namespace
+{
+
+const std::string CmdNameListSymbols = "list_symbols";
+const std::string CmdNameGet = "get";
+const std::string CmdNameOpen = "open";
+const std::string CmdNameClose = "close";
+const std::string CmdNameCloseAll = "close_all";
+const std::string CmdNameModify = "modify";
+const std::string CmdNameSetStopLoss = "set_stop_loss";
+const std::string CmdNameSetTakeProfit = "set_take_profit";
+
+const std::string CmdResultSuccess = "success";
+
+// error codes the same as in MetaTrader
+// https://docs.mql4.com/constants/errorswarnings/errorcodes
+const int ErrInvalidTradeParameters = 3;
+const int ErrInvalidStops = 130;
+const int ErrInvalidTradeVolume = 131;
+const int ErrOffQuotes = 136;
+const int ErrInvalidFunctionParamValue = 4051;
+const int ErrUnknownSymbol = 4106;
+const int ErrInvalidTicket = 4108;
+
+const int FirstTicket = 100000;
+
+// profit is counted in the quote currency of a symbol, as if one lot was
+// always 100000 units of the base currency
+const double ContractSize = 100000.0;
+
+static const std::map<std::string, SOrder::EType> s_str2type =
+{
+	{"Buy", SOrder::Buy},
+	{"Sell", SOrder::Sell},
+	{"BuyLimit", SOrder::BuyLimit},
+	{"SellLimit", SOrder::SellLimit},
+	{"BuyStop", SOrder::BuyStop},
+	{"SellStop", SOrder::SellStop}
+};
+
+SOrder::EType getTypeArg(const cpp::strings_t& args, const std::size_t index)
+{
+	SOrder::EType result = SOrder::None;
+	if (index < args.size())
+	{
+		auto it = s_str2type.find(args[index]);
+		if (it != s_str2type.end())
+		{
+			result = it->second;
+		}
+	}
+	return result;
+}
+
+// like StringToDouble in MQL, incorrect or missing value gives 0
+double getDoubleArg(const cpp::strings_t& args, const std::size_t index)
+{
+	const double result = (index < args.size()) ? std::strtod(args[index].c_str(), nullptr) : 0.0;
+	return result;
+}
+
+datetime_t getDateTimeArg(const cpp::strings_t& args, const std::size_t index)
+{
+	const datetime_t result = (index < args.size()) ? std::strtoll(args[index].c_str(), nullptr, 10) : 0;
+	return result;
+}
+
+bool isBuySide(const SOrder::EType type)
+{
+	const bool result = (type == SOrder::Buy) || (type == SOrder::BuyLimit) || (type == SOrder::BuyStop);
+	return result;
+}
+
+datetime_t currentTime()
+{
+	const datetime_t result = static_cast<datetime_t>(std::time(nullptr));
+	return result;
+}
+
+} // anonymous namespace
+
+// ---------------------------------------------------------------------------
+
+KSimulatedBroker::KSimulatedBroker(const SStubOptions& options, const KPriceModel& priceModel)
+	: m_options(options)
+	, m_priceModel(priceModel)
+	, m_quotes(priceModel.symbolCount())
+	, m_symbolTickets(priceModel.symbolCount())
+	, m_nextTicket(FirstTicket)
+	, m_engine(std::random_device()())
+	, m_latencyDistr(-1.0, 1.0)
+{
+	for (int i = 0; i < priceModel.symbolCount(); ++i)
+	{
+		const std::string& symbol = cpp::su::w2str(priceModel.symbol(i));
+		m_symbol2index[symbol] = i;
+	}
+}
+
+// ---------------------------------------------------------------------------
+
+std::string KSimulatedBroker::executeCommand(
+	const std::string& cmd,
+	const cpp::strings_t& args,
+	const cpp::ints_t& tickets)
+{
+	simulateLatency();
+
+	std::lock_guard<std::mutex> lock(m_mutex);
+	m_cmdResult.clear();
+	++m_cmdCount;
+
+	if (cmd == CmdNameListSymbols)
+	{
+		executeListSymbols();
+	}
+	else if (cmd == CmdNameGet)
+	{
+		executeGet(tickets);
+	}
+	else if (cmd == CmdNameOpen)
+	{
+		executeOpen(args);
+	}
+	else if (cmd == CmdNameModify)
+	{
+		executeModify(args, tickets);
+	}
+	else if (cmd == CmdNameSetStopLoss)
+	{
+		executeSetStopLoss(args, tickets);
+	}
+	else if (cmd == CmdNameSetTakeProfit)
+	{
+		executeSetTakeProfit(args, tickets);
+	}
+	else if (cmd == CmdNameClose)
+	{
+		executeClose(tickets);
+	}
+	else if (cmd == CmdNameCloseAll)
+	{
+		executeCloseAll();
+	}
+	else
+	{
+		addError("unknown command " + cmd, ErrInvalidFunctionParamValue);
+	}
+
+	const std::string& result = m_cmdResult.empty() ? CmdResultSuccess : m_cmdResult;
+	return result;
+}
+
+void KSimulatedBroker::onQuote(const int symbolIndex, const SQuote& quote)
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+	m_quotes[symbolIndex] = quote;
+
+	std::set<int>& tickets = m_symbolTickets[symbolIndex];
+	if (tickets.empty())
+	{
+		return;
+	}
+
+	const datetime_t now = currentTime();
+	for (auto ticketIt = tickets.begin(); ticketIt != tickets.end(); )
+	{
+		// move to the next ticket before the order gets closed and erased
+		const int ticket = *ticketIt++;
+		auto it = m_orders.find(ticket);
+		assert(it != m_orders.end());
+		SBookOrder& order = it->second;
+		if (isPending(order))
+		{
+			if ((order.m_expirationTime != 0) && (order.m_expirationTime <= now))
+			{
+				close(it, marketClosePrice(order), now);
+			}
+			else if (isTriggered(order, quote))
+			{
+				fill(&order, now);
+				dumpOrder(order);
+			}
+		}
+		else
+		{
+			price_t closePrice = 0.0;
+			if (isStopped(order, quote, &closePrice))
+			{
+				close(it, closePrice, now);
+			}
+		}
+	}
+}
+
+void KSimulatedBroker::report() const
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+	std::cout << "account " << m_options.accountIndex() << " [broker] "
+		<< m_cmdCount << " commands, "
+		<< m_openedCount << " orders opened, "
+		<< m_closedCount << " closed, "
+		<< m_orders.size() << " in book, "
+		<< m_errorCount << " errors" << std::endl;
+}
+
+// ---------------------------------------------------------------------------
+
+void KSimulatedBroker::simulateLatency()
+{
+	if (m_options.m_latency == 0)
+	{
+		return;
+	}
+
+	// executeCommand is called from one thread only, so the engine doesn't need the lock
+	const double jitter = m_options.m_latencyJitter * m_latencyDistr(m_engine);
+	const double latency = std::max(m_options.m_latency + jitter, 0.0);
+	std::this_thread::sleep_for(std::chrono::duration<double, std::milli>(latency));
+}
+
+// ---------------------------------------------------------------------------
+
+void KSimulatedBroker::executeListSymbols()
+{
+	for (int i = 0; i < m_priceModel.symbolCount(); ++i)
+	{
+		DumpSymbol(m_priceModel.symbol(i).c_str());
+	}
+}
+
+void KSimulatedBroker::executeGet(const cpp::ints_t& tickets)
+{
+	if (tickets.empty())
+	{
+		for (const auto& entry : m_orders)
+		{
+			dumpOrder(entry.second);
+		}
+		DumpOrdersEnd();
+	}
+	else
+	{
+		for (const int ticket : tickets)
+		{
+			auto it = m_orders.find(ticket);
+			if (it != m_orders.end())
+			{
+				dumpOrder(it->second);
+			}
+		}
+	}
+}
+
+void KSimulatedBroker::executeOpen(const cpp::strings_t& args)
+{
+	SBookOrder order;
+
+	const std::string& symbol = (0 < args.size()) ? args[0] : std::string();
+	auto symbolIt = m_symbol2index.find(symbol);
+	if (symbolIt == m_symbol2index.end())
+	{
+		addError("OrderSend error", ErrUnknownSymbol);
+		return;
+	}
+	order.m_symbolIndex = symbolIt->second;
+
+	if (m_quotes[order.m_symbolIndex].m_ask == 0.0)
+	{
+		// no tick of the symbol has been generated yet
+		addError("OrderSend error", ErrOffQuotes);
+		return;
+	}
+
+	order.m_type = getTypeArg(args, 1);
+	if (order.m_type == SOrder::None)
+	{
+		addError("OrderSend error", ErrInvalidTradeParameters);
+		return;
+	}
+
+	order.m_lots = getDoubleArg(args, 2);
+	if (order.m_lots <= 0.0)
+	{
+		addError("OrderSend error", ErrInvalidTradeVolume);
+		return;
+	}
+
+	order.m_openPrice = getDoubleArg(args, 3);
+	order.m_stopLoss = getDoubleArg(args, 4);
+	order.m_takeProfit = getDoubleArg(args, 5);
+	order.m_expirationTime = getDateTimeArg(args, 6);
+
+	const datetime_t now = currentTime();
+	if (isPending(order))
+	{
+		if (order.m_openPrice <= 0.0)
+		{
+			addError("OrderSend error", ErrInvalidTradeParameters);
+			return;
+		}
+	}
+	else
+	{
+		fill(&order, now);
+	}
+
+	const price_t price = order.m_openPrice;
+	const bool buySide = isBuySide(order.m_type);
+	const bool stopsValid = buySide
+		? (((order.m_stopLoss == 0.0) || (order.m_stopLoss < price)) && ((order.m_takeProfit == 0.0) || (price < order.m_takeProfit)))
+		: (((order.m_stopLoss == 0.0) || (price < order.m_stopLoss)) && ((order.m_takeProfit == 0.0) || (order.m_takeProfit < price)));
+	if (!stopsValid)
+	{
+		addError("OrderSend error", ErrInvalidStops);
+		return;
+	}
+
+	order.m_ticket = m_nextTicket++;
+	m_symbolTickets[order.m_symbolIndex].insert(order.m_ticket);
+	const SBookOrder& bookOrder = m_orders[order.m_ticket] = order;
+	dumpOrder(bookOrder);
+}
+
+void KSimulatedBroker::executeModify(const cpp::strings_t& args, const cpp::ints_t& tickets)
+{
+	const price_t openPrice = getDoubleArg(args, 0);
+	const price_t stopLoss = getDoubleArg(args, 1);
+	const price_t takeProfit = getDoubleArg(args, 2);
+	const datetime_t expirationTime = getDateTimeArg(args, 3);
+	for (const int ticket : tickets)
+	{
+		auto it = m_orders.find(ticket);
+		if (it == m_orders.end())
+		{
+			addError("OrderModify error " + std::to_string(ticket), ErrInvalidTicket);
+			continue;
+		}
+
+		SBookOrder& order = it->second;
+		if (isPending(order))
+		{
+			// 0 means the value is not changed
+			if (openPrice != 0.0)
+			{
+				order.m_openPrice = openPrice;
+			}
+			if (expirationTime != 0)
+			{
+				order.m_expirationTime = expirationTime;
+			}
+		}
+		order.m_stopLoss = stopLoss;
+		order.m_takeProfit = takeProfit;
+		dumpOrder(order);
+	}
+}
+
+void KSimulatedBroker::executeSetStopLoss(const cpp::strings_t& args, const cpp::ints_t& tickets)
+{
+	if (args.size() != 1)
+	{
+		addError("ExecuteSetStopLossCommand incorrect arguments", ErrInvalidFunctionParamValue);
+		return;
+	}
+
+	const price_t stopLoss = getDoubleArg(args, 0);
+	for (const int ticket : tickets)
+	{
+		auto it = m_orders.find(ticket);
+		if (it != m_orders.end())
+		{
+			SBookOrder& order = it->second;
+			order.m_stopLoss = stopLoss;
+			dumpOrder(order);
+		}
+		else
+		{
+			addError("ExecuteSetStopLossCommand OrderModify failure " + std::to_string(ticket), ErrInvalidTicket);
+		}
+	}
+}
+
+void KSimulatedBroker::executeSetTakeProfit(const cpp::strings_t& args, const cpp::ints_t& tickets)
+{
+	if (args.size() != 1)
+	{
+		addError("ExecuteSetTakeProfitCommand incorrect arguments", ErrInvalidFunctionParamValue);
+		return;
+	}
+
+	const price_t takeProfit = getDoubleArg(args, 0);
+	for (const int ticket : tickets)
+	{
+		auto it = m_orders.find(ticket);
+		if (it != m_orders.end())
+		{
+			SBookOrder& order = it->second;
+			order.m_takeProfit = takeProfit;
+			dumpOrder(order);
+		}
+		else
+		{
+			addError("ExecuteSetTakeProfitCommand OrderModify failure " + std::to_string(ticket), ErrInvalidTicket);
+		}
+	}
+}
+
+void KSimulatedBroker::executeClose(const cpp::ints_t& tickets)
+{
+	const datetime_t now = currentTime();
+	for (const int ticket : tickets)
+	{
+		auto it = m_orders.find(ticket);
+		if (it != m_orders.end())
+		{
+			close(it, marketClosePrice(it->second), now);
+		}
+		else
+		{
+			addError("InternalOrderClose error " + std::to_string(ticket), ErrInvalidTicket);
+		}
+	}
+}
+
+void KSimulatedBroker::executeCloseAll()
+{
+	const datetime_t now = currentTime();
+	while (!m_orders.empty())
+	{
+		auto it = m_orders.begin();
+		close(it, marketClosePrice(it->second), now);
+	}
+}
+
+// ---------------------------------------------------------------------------
+
+bool KSimulatedBroker::isPending(const SBookOrder& order) const
+{
+	const bool result = (order.m_type != SOrder::Buy) && (order.m_type != SOrder::Sell);
+	return result;
+}
+
+bool KSimulatedBroker::isTriggered(const SBookOrder& order, const SQuote& quote) const
+{
+	bool result = false;
+	switch (order.m_type)
+	{
+		case SOrder::BuyLimit:
+			result = (quote.m_ask <= order.m_openPrice);
+			break;
+
+		case SOrder::BuyStop:
+			result = (order.m_openPrice <= quote.m_ask);
+			break;
+
+		case SOrder::SellLimit:
+			result = (order.m_openPrice <= quote.m_bid);
+			break;
+
+		case SOrder::SellStop:
+			result = (quote.m_bid <= order.m_openPrice);
+			break;
+
+		default:
+			assert(!"unexpected order type!");
+	}
+	return result;
+}
+
+bool KSimulatedBroker::isStopped(const SBookOrder& order, const SQuote& quote, price_t* closePrice) const
+{
+	bool result = false;
+	if (order.m_type == SOrder::Buy)
+	{
+		*closePrice = quote.m_bid;
+		result = ((order.m_stopLoss != 0.0) && (quote.m_bid <= order.m_stopLoss))
+			|| ((order.m_takeProfit != 0.0) && (order.m_takeProfit <= quote.m_bid));
+	}
+	else
+	{
+		*closePrice = quote.m_ask;
+		result = ((order.m_stopLoss != 0.0) && (order.m_stopLoss <= quote.m_ask))
+			|| ((order.m_takeProfit != 0.0) && (quote.m_ask <= order.m_takeProfit));
+	}
+	return result;
+}
+
+// ---------------------------------------------------------------------------
+
+void KSimulatedBroker::fill(SBookOrder* order, const datetime_t now)
+{
+	const SQuote& quote = m_quotes[order->m_symbolIndex];
+	const bool buySide = isBuySide(order->m_type);
+	order->m_type = buySide ? SOrder::Buy : SOrder::Sell;
+	order->m_openPrice = buySide ? quote.m_ask : quote.m_bid;
+	order->m_openTime = now;
+	++m_openedCount;
+}
+
+void KSimulatedBroker::close(orders_t::iterator it, const price_t closePrice, const datetime_t now)
+{
+	SBookOrder& order = it->second;
+	order.m_closePrice = closePrice;
+	order.m_closeTime = now;
+	dumpOrder(order);
+
+	m_symbolTickets[order.m_symbolIndex].erase(order.m_ticket);
+	m_orders.erase(it);
+	++m_closedCount;
+}
+
+price_t KSimulatedBroker::marketClosePrice(const SBookOrder& order) const
+{
+	const SQuote& quote = m_quotes[order.m_symbolIndex];
+	const price_t result = isBuySide(order.m_type) ? quote.m_bid : quote.m_ask;
+	return result;
+}
+
+double KSimulatedBroker::profit(const SBookOrder& order) const
+{
+	double result = 0.0;
+	if (!isPending(order))
+	{
+		const price_t closePrice = (order.m_closeTime != 0) ? order.m_closePrice : marketClosePrice(order);
+		const double priceDiff = (order.m_type == SOrder::Buy)
+			? (closePrice - order.m_openPrice)
+			: (order.m_openPrice - closePrice);
+		result = priceDiff * order.m_lots * ContractSize;
+	}
+	return result;
+}
+
+// ---------------------------------------------------------------------------
+
+void KSimulatedBroker::dumpOrder(const SBookOrder& order) const
+{
+	const price_t closePrice = (order.m_closeTime != 0) ? order.m_closePrice : marketClosePrice(order);
+	DumpOrder(
+		m_priceModel.symbol(order.m_symbolIndex).c_str(),
+		ticket_t(order.m_ticket),
+		order.m_type,
+		order.m_lots,
+		order.m_openPrice,
+		closePrice,
+		order.m_stopLoss,
+		order.m_takeProfit,
+		order.m_openTime,
+		order.m_expirationTime,
+		order.m_closeTime,
+		0.0,
+		0.0,
+		profit(order));
+}
+
+void KSimulatedBroker::addError(const std::string& description, const int errorCode)
+{
+	// the same format as AddToCmdResult in fxcolt.mq4
+	m_cmdResult += description + " (errorCode: " + std::to_string(errorCode) + ");";
+	++m_errorCount;
+}
+
+} // namespace fx
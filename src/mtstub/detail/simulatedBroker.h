@@ -0,0 +1,105 @@
+// author: Darek Slusarczyk alias marines marinesovitch 2012-2013, 2022
+#ifndef INC_MTSTUB_SIMULATEDBROKER_H
+#define INC_MTSTUB_SIMULATEDBROKER_H
+
+#include "priceModel.h"
+#include "common/order.h"
+#include "cpp/types.h"
+
+namespace fx
+{
+
+struct SStubOptions;
+
+// in-memory order book of a fake account, it executes commands sent by
+// kommander against the prices generated by mtstub in a similar way as
+// fxcolt.mq4 does against a real MetaTrader terminal
+class KSimulatedBroker
+{
+	public:
+		KSimulatedBroker(const SStubOptions& options, const KPriceModel& priceModel);
+
+	public:
+		// returns the result passed to OnCommandCompleted
+		std::string executeCommand(
+			const std::string& cmd,
+			const cpp::strings_t& args,
+			const cpp::ints_t& tickets);
+
+		// called by tick generator, it triggers pending orders, stop losses,
+		// take profits and expirations
+		void onQuote(const int symbolIndex, const SQuote& quote);
+
+		void report() const;
+
+	private:
+		struct SBookOrder
+		{
+			int m_symbolIndex = -1;
+			int m_ticket = 0;
+			SOrder::EType m_type = SOrder::None;
+			volume_t m_lots = 0.0;
+			price_t m_openPrice = 0.0;
+			price_t m_closePrice = 0.0;
+			price_t m_stopLoss = 0.0;
+			price_t m_takeProfit = 0.0;
+			datetime_t m_openTime = 0;
+			datetime_t m_expirationTime = 0;
+			datetime_t m_closeTime = 0;
+		};
+		typedef std::map<int, SBookOrder> orders_t;
+
+		void simulateLatency();
+
+		void executeListSymbols();
+		void executeGet(const cpp::ints_t& tickets);
+		void executeOpen(const cpp::strings_t& args);
+		void executeModify(const cpp::strings_t& args, const cpp::ints_t& tickets);
+		void executeSetStopLoss(const cpp::strings_t& args, const cpp::ints_t& tickets);
+		void executeSetTakeProfit(const cpp::strings_t& args, const cpp::ints_t& tickets);
+		void executeClose(const cpp::ints_t& tickets);
+		void executeCloseAll();
+
+		bool isPending(const SBookOrder& order) const;
+		bool isTriggered(const SBookOrder& order, const SQuote& quote) const;
+		bool isStopped(const SBookOrder& order, const SQuote& quote, price_t* closePrice) const;
+
+		void fill(SBookOrder* order, const datetime_t now);
+		void close(orders_t::iterator it, const price_t closePrice, const datetime_t now);
+		price_t marketClosePrice(const SBookOrder& order) const;
+		double profit(const SBookOrder& order) const;
+
+		void dumpOrder(const SBookOrder& order) const;
+		void addError(const std::string& description, const int errorCode);
+
+	private:
+		const SStubOptions& m_options;
+		const KPriceModel& m_priceModel;
+
+		std::map<std::string, int> m_symbol2index;
+		std::vector<SQuote> m_quotes;
+
+		// tickets of pending and open orders per symbol, to not scan the whole
+		// book on each tick
+		std::vector<std::set<int>> m_symbolTickets;
+
+		orders_t m_orders;
+		int m_nextTicket;
+
+		std::mt19937 m_engine;
+		std::uniform_real_distribution<double> m_latencyDistr;
+
+		std::string m_cmdResult;
+
+		long long m_cmdCount = 0;
+		long long m_openedCount = 0;
+		long long m_closedCount = 0;
+		long long m_errorCount = 0;
+
+		mutable std::mutex m_mutex;
+
+};
+
+} // namespace fx
+
+#endif
@@ -0,0 +1,257 @@
+// author: Darek Slusarczyk alias marines marinesovitch 2012-2013, 2022
+#include "ph.h"
+#include "stubOptions.h"
+
+namespace fx
+{
+
+namespace
+{
+
+const std::string OptAccounts = "--accounts";
+const std::string OptAccountIndex = "--account-index";
+const std::string OptSymbols = "--symbols";
+const std::string OptRate = "--rate";
+const std::string OptPoisson = "--poisson";
+const std::string OptDuration = "--duration";
+const std::string OptWarmup = "--warmup";
+const std::string OptVolatility = "--volatility";
+const std::string OptSpread = "--spread";
+const std::string OptReport = "--report";
+const std::string OptSeed = "--seed";
+const std::string OptLatency = "--latency";
+const std::string OptLatencyJitter = "--latency-jitter";
+const std::string OptCmdPoll = "--cmd-poll";
+const std::string OptHelp = "--help";
+
+// ---------------------------------------------------------------------------
+
+class KStubOptionsParser
+{
+	public:
+		KStubOptionsParser(int argc, char* argv[], SStubOptions* options);
+
+	public:
+		void run();
+
+	private:
+		void parseOption(const std::string& option);
+
+		std::string getNextArg(const std::string& option);
+		int parseInt(const std::string& option, const int minValue);
+		double parseDouble(const std::string& option, const double minValue);
+
+	private:
+		const int m_argc;
+		char** m_argv;
+		int m_index = 1;
+		SStubOptions& m_options;
+
+};
+
+// ---------------------------------------------------------------------------
+
+KStubOptionsParser::KStubOptionsParser(int argc, char* argv[], SStubOptions* options)
+	: m_argc(argc)
+	, m_argv(argv)
+	, m_options(*options)
+{
+}
+
+void KStubOptionsParser::run()
+{
+	while (m_index < m_argc)
+	{
+		const std::string option(m_argv[m_index++]);
+		parseOption(option);
+	}
+
+	if ((m_options.m_accountIndex != -1) && (m_options.m_accountCount <= m_options.m_accountIndex))
+	{
+		throw std::invalid_argument("account index out of range");
+	}
+}
+
+void KStubOptionsParser::parseOption(const std::string& option)
+{
+	if (option == OptAccounts)
+	{
+		m_options.m_accountCount = parseInt(option, 1);
+	}
+	else if (option == OptAccountIndex)
+	{
+		m_options.m_accountIndex = parseInt(option, 0);
+		// the index is set by the master process only, so don't pass it further
+		return;
+	}
+	else if (option == OptSymbols)
+	{
+		m_options.m_symbolCount = parseInt(option, 1);
+	}
+	else if (option == OptRate)
+	{
+		m_options.m_tickRate = parseDouble(option, 0.001);
+	}
+	else if (option == OptPoisson)
+	{
+		m_options.m_arrival = SStubOptions::Poisson;
+	}
+	else if (option == OptDuration)
+	{
+		m_options.m_duration = parseInt(option, 0);
+	}
+	else if (option == OptWarmup)
+	{
+		m_options.m_warmup = parseInt(option, 0);
+	}
+	else if (option == OptVolatility)
+	{
+		m_options.m_volatility = parseDouble(option, 0.0);
+	}
+	else if (option == OptSpread)
+	{
+		m_options.m_spread = parseDouble(option, 0.0);
+	}
+	else if (option == OptReport)
+	{
+		m_options.m_reportInterval = parseInt(option, 0);
+	}
+	else if (option == OptSeed)
+	{
+		m_options.m_seed = static_cast<unsigned int>(parseInt(option, 0));
+	}
+	else if (option == OptLatency)
+	{
+		m_options.m_latency = parseInt(option, 0);
+	}
+	else if (option == OptLatencyJitter)
+	{
+		m_options.m_latencyJitter = parseInt(option, 0);
+	}
+	else if (option == OptCmdPoll)
+	{
+		m_options.m_cmdPollInterval = parseInt(option, 1);
+	}
+	else if (option == OptHelp)
+	{
+		throw std::invalid_argument("usage");
+	}
+	else
+	{
+		throw std::invalid_argument("unknown option " + option);
+	}
+
+	// store the option with its value (if any) to forward it to the child processes
+	m_options.m_rawArgs.push_back(option);
+	const bool hasValue = (option != OptPoisson);
+	if (hasValue)
+	{
+		m_options.m_rawArgs.push_back(m_argv[m_index - 1]);
+	}
+}
+
+std::string KStubOptionsParser::getNextArg(const std::string& option)
+{
+	if (m_argc <= m_index)
+	{
+		throw std::invalid_argument("missing value of option " + option);
+	}
+	const std::string result(m_argv[m_index++]);
+	return result;
+}
+
+int KStubOptionsParser::parseInt(const std::string& option, const int minValue)
+{
+	const std::string& valueStr = getNextArg(option);
+	std::size_t idx = 0;
+	int result = 0;
+	try
+	{
+		result = std::stoi(valueStr, &idx);
+	}
+	catch (std::exception&)
+	{
+		idx = 0;
+	}
+
+	if ((idx != valueStr.length()) || (result < minValue))
+	{
+		throw std::invalid_argument("incorrect value of " + option + ": '" + valueStr + "'");
+	}
+	return result;
+}
+
+double KStubOptionsParser::parseDouble(const std::string& option, const double minValue)
+{
+	const std::string& valueStr = getNextArg(option);
+	std::size_t idx = 0;
+	double result = 0.0;
+	try
+	{
+		result = std::stod(valueStr, &idx);
+	}
+	catch (std::exception&)
+	{
+		idx = 0;
+	}
+
+	if ((idx != valueStr.length()) || (result < minValue))
+	{
+		throw std::invalid_argument("incorrect value of " + option + ": '" + valueStr + "'");
+	}
+	return result;
+}
+
+} // anonymous namespace
+
+// ---------------------------------------------------------------------------
+
+bool SStubOptions::isMaster() const
+{
+	const bool result = (m_accountIndex == -1);
+	return result;
+}
+
+int SStubOptions::accountIndex() const
+{
+	const int result = isMaster() ? 0 : m_accountIndex;
+	return result;
+}
+
+// ---------------------------------------------------------------------------
+
+bool parseStubOptions(int argc, char* argv[], SStubOptions* options, std::string* error)
+{
+	bool result = false;
+	try
+	{
+		KStubOptionsParser parser(argc, argv, options);
+		parser.run();
+		result = true;
+	}
+	catch (std::exception& e)
+	{
+		*error = e.what();
+	}
+	return result;
+}
+
+void printStubUsage(std::ostream& os)
+{
+	os << "mtstub [options]\n"
+		<< "  " << OptAccounts << " N        number of fake accounts (default 1)\n"
+		<< "  " << OptSymbols << " M         number of symbols per account (default 1)\n"
+		<< "  " << OptRate << " R            target ticks per second per account (default 1)\n"
+		<< "  " << OptPoisson << "            bursty Poisson arrivals instead of uniform ones\n"
+		<< "  " << OptDuration << " S        run for S seconds after warmup, 0 means forever (default 0)\n"
+		<< "  " << OptWarmup << " S          don't count ticks of the first S seconds (default 0)\n"
+		<< "  " << OptVolatility << " V      daily volatility of prices in percents (default 0.5)\n"
+		<< "  " << OptSpread << " P          average spread in points (default 15)\n"
+		<< "  " << OptReport << " S          print rates every S seconds, 0 disables (default 1)\n"
+		<< "  " << OptSeed << " N            seed of the price model, 0 means random (default 0)\n"
+		<< "  " << OptLatency << " MS        simulated execution latency of commands (default 0)\n"
+		<< "  " << OptLatencyJitter << " MS random variation of the execution latency (default 0)\n"
+		<< "  " << OptCmdPoll << " MS       interval of polling commands (default 1000)\n";
+}
+
+} // namespace fx
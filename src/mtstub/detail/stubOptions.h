@@ -0,0 +1,66 @@
+// author: Darek Slusarczyk alias marines marinesovitch 2012-2013, 2022
+#ifndef INC_MTSTUB_STUBOPTIONS_H
+#define INC_MTSTUB_STUBOPTIONS_H
+
+#include "cpp/types.h"
+
+namespace fx
+{
+
+struct SStubOptions
+{
+	enum EArrival
+	{
+		Uniform,
+		Poisson
+	};
+
+	// number of fake accounts, each one is served by a separate mtstub process
+	// because mtfxcolt.dll (like MetaTrader) handles a single account per process
+	int m_accountCount = 1;
+
+	// index of account served by this process, -1 means the master process
+	int m_accountIndex = -1;
+
+	int m_symbolCount = 1;
+
+	// target rate of ticks per second per account (all its symbols together)
+	double m_tickRate = 1.0;
+	EArrival m_arrival = Uniform;
+
+	// both in seconds, duration 0 means run until the process is killed
+	int m_duration = 0;
+	int m_warmup = 0;
+
+	// daily volatility of the random walk in percents
+	double m_volatility = 0.5;
+
+	// average spread in points
+	double m_spread = 15.0;
+
+	// in seconds, 0 disables the intermediate reports
+	int m_reportInterval = 1;
+
+	unsigned int m_seed = 0;
+
+	// simulated execution latency of commands and its random variation, in
+	// milliseconds
+	int m_latency = 0;
+	int m_latencyJitter = 0;
+
+	// in milliseconds, fxcolt.mq4 polls commands once per second
+	int m_cmdPollInterval = 1000;
+
+	// arguments to pass to the child processes
+	cpp::strings_t m_rawArgs;
+
+	bool isMaster() const;
+	int accountIndex() const;
+};
+
+bool parseStubOptions(int argc, char* argv[], SStubOptions* options, std::string* error);
+void printStubUsage(std::ostream& os);
+
+} // namespace fx
+
+#endif
@@ -0,0 +1,194 @@
+// author: Darek Slusarczyk alias marines marinesovitch 2012-2013, 2022
+#include "ph.h"
+#include "tickGenerator.h"
+#include "adapter/adapter.h"
+
+namespace fx
+{
+
+namespace
+{
+
+// if the generator is late more than that, then the overdue ticks are dropped
+// instead of being sent in a burst, so the backend is not flooded after e.g.
+// the process was preempted
+const std::chrono::milliseconds MaxLag(100);
+
+// Sleep is too coarse for short waits, so yield the cpu below that threshold
+const std::chrono::milliseconds SleepThreshold(2);
+
+template <typename Duration>
+double toSeconds(const Duration& duration)
+{
+	const double result = std::chrono::duration<double>(duration).count();
+	return result;
+}
+
+template <typename Duration>
+double toMicroseconds(const Duration& duration)
+{
+	const double result = std::chrono::duration<double, std::micro>(duration).count();
+	return result;
+}
+
+} // anonymous namespace
+
+// ---------------------------------------------------------------------------
+
+void KTickGenerator::SStats::reset()
+{
+	*this = SStats();
+}
+
+void KTickGenerator::SStats::add(const SStats& stats)
+{
+	m_ticks += stats.m_ticks;
+	m_drops += stats.m_drops;
+	m_dumpTime += stats.m_dumpTime;
+	m_maxDumpTime = std::max(m_maxDumpTime, stats.m_maxDumpTime);
+}
+
+// ---------------------------------------------------------------------------
+
+KTickGenerator::KTickGenerator(const SStubOptions& options, KPriceModel* priceModel, KSimulatedBroker* broker)
+	: m_options(options)
+	, m_priceModel(*priceModel)
+	, m_broker(*broker)
+	, m_uniformInterval(std::chrono::duration_cast<duration_t>(std::chrono::duration<double>(1.0 / options.m_tickRate)))
+	, m_poissonDistr(options.m_tickRate)
+	, m_symbolDistr(0, priceModel->symbolCount() - 1)
+{
+}
+
+void KTickGenerator::run()
+{
+	const time_point_t start = clock_t::now();
+	const time_point_t warmupEnd = start + std::chrono::seconds(m_options.m_warmup);
+	const bool infinite = (m_options.m_duration == 0);
+	const time_point_t end = warmupEnd + std::chrono::seconds(m_options.m_duration);
+	const duration_t reportInterval = std::chrono::seconds(m_options.m_reportInterval);
+
+	m_lastTickTimes.assign(m_priceModel.symbolCount(), start);
+
+	bool warmedUp = (m_options.m_warmup == 0);
+	time_point_t lastReport = start;
+	time_point_t next = start;
+	while (infinite || (next < end))
+	{
+		waitUntil(next);
+		const time_point_t now = clock_t::now();
+
+		if (!warmedUp && (warmupEnd <= now))
+		{
+			warmedUp = true;
+			m_current.reset();
+			lastReport = now;
+		}
+
+		while (MaxLag < now - next)
+		{
+			next += nextInterval();
+			++m_current.m_drops;
+		}
+
+		sendTick(now);
+		next += nextInterval();
+
+		if ((0 < m_options.m_reportInterval) && (reportInterval <= now - lastReport))
+		{
+			report(warmedUp ? "run" : "warmup", m_current, now - lastReport);
+			if (warmedUp)
+			{
+				m_total.add(m_current);
+			}
+			m_current.reset();
+			lastReport = now;
+		}
+	}
+
+	m_total.add(m_current);
+	report("total", m_total, clock_t::now() - warmupEnd);
+}
+
+KTickGenerator::duration_t KTickGenerator::nextInterval()
+{
+	if (m_options.m_arrival == SStubOptions::Uniform)
+	{
+		return m_uniformInterval;
+	}
+	else
+	{
+		const std::chrono::duration<double> interval(m_poissonDistr(m_priceModel.engine()));
+		const duration_t result = std::chrono::duration_cast<duration_t>(interval);
+		return result;
+	}
+}
+
+int KTickGenerator::nextSymbol()
+{
+	int result = 0;
+	if (m_options.m_arrival == SStubOptions::Uniform)
+	{
+		result = m_nextSymbol;
+		m_nextSymbol = (m_nextSymbol + 1) % m_priceModel.symbolCount();
+	}
+	else
+	{
+		result = m_symbolDistr(m_priceModel.engine());
+	}
+	return result;
+}
+
+void KTickGenerator::waitUntil(const time_point_t& deadline)
+{
+	for (time_point_t now = clock_t::now(); now < deadline; now = clock_t::now())
+	{
+		const duration_t remaining = deadline - now;
+		if (SleepThreshold < remaining)
+		{
+			std::this_thread::sleep_for(remaining - SleepThreshold);
+		}
+		else
+		{
+			std::this_thread::yield();
+		}
+	}
+}
+
+void KTickGenerator::sendTick(const time_point_t& now)
+{
+	const int symbolIndex = nextSymbol();
+	const double elapsed = toSeconds(now - m_lastTickTimes[symbolIndex]);
+	m_lastTickTimes[symbolIndex] = now;
+
+	const SQuote& quote = m_priceModel.next(symbolIndex, elapsed);
+	const datetime_t time = static_cast<datetime_t>(std::time(nullptr));
+	const std::wstring& symbol = m_priceModel.symbol(symbolIndex);
+
+	const time_point_t dumpStart = clock_t::now();
+	DumpTick(symbol.c_str(), time, quote.m_bid, quote.m_ask, quote.m_last);
+	const duration_t dumpTime = clock_t::now() - dumpStart;
+
+	m_broker.onQuote(symbolIndex, quote);
+
+	++m_current.m_ticks;
+	m_current.m_dumpTime += dumpTime;
+	m_current.m_maxDumpTime = std::max(m_current.m_maxDumpTime, dumpTime);
+}
+
+void KTickGenerator::report(const char* label, const SStats& stats, const duration_t& period) const
+{
+	const double seconds = toSeconds(period);
+	const double rate = (0.0 < seconds) ? (stats.m_ticks / seconds) : 0.0;
+	const double avgDumpTime = (0 < stats.m_ticks) ? (toMicroseconds(stats.m_dumpTime) / stats.m_ticks) : 0.0;
+
+	std::ostringstream os;
+	os << std::fixed << std::setprecision(1)
+		<< "account " << m_options.accountIndex() << " [" << label << "] " << seconds << "s: "
+		<< rate << " ticks/s (target " << m_options.m_tickRate << "), "
+		<< stats.m_ticks << " ticks, " << stats.m_drops << " drops, "
+		<< "DumpTick avg " << avgDumpTime << "us max " << toMicroseconds(stats.m_maxDumpTime) << "us";
+	std::cout << os.str() << std::endl;
+}
+
+} // namespace fx
@@ -0,0 +1,66 @@
+// author: Darek Slusarczyk alias marines marinesovitch 2012-2013, 2022
+#ifndef INC_MTSTUB_TICKGENERATOR_H
+#define INC_MTSTUB_TICKGENERATOR_H
+
+#include "stubOptions.h"
+#include "priceModel.h"
+#include "simulatedBroker.h"
+#include <chrono>
+
+namespace fx
+{
+
+class KTickGenerator
+{
+	public:
+		KTickGenerator(const SStubOptions& options, KPriceModel* priceModel, KSimulatedBroker* broker);
+
+	public:
+		// returns after the configured duration, or never if it is 0
+		void run();
+
+	private:
+		typedef std::chrono::steady_clock clock_t;
+		typedef clock_t::time_point time_point_t;
+		typedef clock_t::duration duration_t;
+
+		struct SStats
+		{
+			long long m_ticks = 0;
+			long long m_drops = 0;
+			duration_t m_dumpTime = duration_t::zero();
+			duration_t m_maxDumpTime = duration_t::zero();
+
+			void reset();
+			void add(const SStats& stats);
+		};
+
+		duration_t nextInterval();
+		int nextSymbol();
+
+		void waitUntil(const time_point_t& deadline);
+		void sendTick(const time_point_t& now);
+
+		void report(const char* label, const SStats& stats, const duration_t& period) const;
+
+	private:
+		const SStubOptions& m_options;
+		KPriceModel& m_priceModel;
+		KSimulatedBroker& m_broker;
+
+		const duration_t m_uniformInterval;
+		std::exponential_distribution<double> m_poissonDistr;
+		std::uniform_int_distribution<int> m_symbolDistr;
+		int m_nextSymbol = 0;
+
+		std::vector<time_point_t> m_lastTickTimes;
+
+		// statistics since the end of warmup, and since the last report
+		SStats m_total;
+		SStats m_current;
+
+};
+
+} // namespace fx
+
+#endif